@@ -231,14 +231,31 @@ namespace
     auto constexpr ReplyPrefix = "\033]314;"sv; // DCS 314 ;
     auto constexpr ReplySuffix = "\033\\"sv;    // ST
 
-    // Reads a *single* response chunk.
-    bool readCaptureChunk(TTY& _input, timeval* _timeout, string& _reply)
+    // Reads a *single* response chunk into @p _payload.
+    //
+    // As the terminal may reply a capture in many chunks, a single read may return
+    // more than one chunk, or only parts of it. Any excess input is kept in @p _buffer
+    // to be consumed by the next call.
+    bool readCaptureChunk(TTY& _input, timeval* _timeout, string& _buffer, string& _payload)
     {
         timeval timeout = *_timeout;
         // Response is of format: OSC 314 ; <screen capture> ST`
-        long long int n = 0;
         while (true)
         {
+            if (_buffer.size() >= ReplyPrefix.size()
+                && !crispy::startsWith(string_view(_buffer), ReplyPrefix))
+            {
+                cerr << fmt::format("Invalid response from terminal received. Does not start with expected reply prefix.\n");
+                return false;
+            }
+
+            if (auto const end = _buffer.find(ReplySuffix, ReplyPrefix.size()); end != string::npos)
+            {
+                _payload.assign(_buffer, ReplyPrefix.size(), end - ReplyPrefix.size());
+                _buffer.erase(0, end + ReplySuffix.size());
+                return true;
+            }
+
             int rv = _input.wait(&timeout);
             if (rv < 0)
             {
@@ -247,11 +264,11 @@ namespace
             }
             else if (rv == 0)
             {
-                cerr << "VTE did not respond to CAPTURE `CSI > Ps ; Ps t`.\n";
+                cerr << "VTE did not respond to CAPTURE `CSI > Ps ; Ps ; Ps t`.\n";
                 return false;
             }
 
-            char buf[4096];
+            char buf[64 * 1024];
             rv = _input.read(buf, sizeof(buf));
             if (rv < 0)
             {
@@ -259,19 +276,7 @@ namespace
                 return false;
             }
 
-            copy_n(buf, rv, back_inserter(_reply));
-
-            if (n == 0 && !crispy::startsWith(string_view(_reply), ReplyPrefix))
-            {
-                cerr << fmt::format("Invalid response from terminal received. Does not start with expected reply prefix.\n");
-                return false;
-            }
-            n++;
-
-            if (!crispy::endsWith(string_view(_reply), ReplySuffix))
-                continue;
-
-            return true;
+            copy_n(buf, rv, back_inserter(_buffer));
         }
     }
 }
@@ -304,8 +309,8 @@ bool captureScreen(CaptureSettings const& _settings)
                             _settings.outputFile.data());
 
     // request screen capture
-    string reply;
-    reply.reserve(numColumns * std::max(_settings.lineCount, numLines));
+    string buffer;
+    string payload;
 
     reference_wrapper<ostream> output(cout);
     unique_ptr<ostream> customOutput;
@@ -316,22 +321,20 @@ bool captureScreen(CaptureSettings const& _settings)
         output = *customOutput;
     }
 
-    tty.write(fmt::format("\033[>{};{}t",
+    tty.write(fmt::format("\033[>{};{};{}t",
                           _settings.logicalLines ? '1' : '0',
-                          _settings.lineCount));
+                          _settings.lineCount,
+                          _settings.chunkSize));
 
     while (true)
     {
-        if (!readCaptureChunk(tty, &timeout, reply))
+        if (!readCaptureChunk(tty, &timeout, buffer, payload))
             return false;
 
-        auto const payload = string_view(reply.data() + ReplyPrefix.size(),
-                                         reply.size() - ReplyPrefix.size() - ReplySuffix.size());
         if (payload.empty())
             return true;
 
-        output.get().write(payload.data(), payload.size());
-        reply.clear();
+        output.get().write(payload.data(), static_cast<std::streamsize>(payload.size()));
     }
 }
 
@@ -24,6 +24,7 @@ struct CaptureSettings
     std::string outputFile;             // -o <outputfile>
     int verbosityLevel = 0;             // -v, -q (XXX intentionally not parsed currently!)
     int lineCount = 0;                  // (use terminal default)
+    unsigned chunkSize = 0;             // --chunk-size <bytes> (use terminal default)
 };
 
 bool captureScreen(CaptureSettings const& _settings);
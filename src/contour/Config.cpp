@@ -1092,6 +1092,17 @@ TerminalProfile loadTerminalProfile(UsedKeys& _usedKeys,
             errorlog().write("Unknown text shaping method: {}", strValue);
     }
 
+    strValue = "wait";
+    tryLoadChild(_usedKeys, _doc, basePath, "font.rasterization", strValue);
+    {
+        if (strValue == "wait")
+            profile.fonts.glyphRasterization = terminal::renderer::GlyphRasterization::Wait;
+        else if (strValue == "deferred")
+            profile.fonts.glyphRasterization = terminal::renderer::GlyphRasterization::Deferred;
+        else
+            errorlog().write("Unknown glyph rasterization: {}", strValue);
+    }
+
     bool onlyMonospace = true;
     tryLoadChild(_usedKeys, _doc, basePath, "font.only_monospace", onlyMonospace);
 
@@ -1190,6 +1201,10 @@ TerminalProfile loadTerminalProfile(UsedKeys& _usedKeys,
     tryLoadChild(_usedKeys, _doc, basePath, "cursor.blinking_interval", uintValue);
     profile.cursorBlinkInterval = chrono::milliseconds(uintValue);
 
+    uintValue = static_cast<unsigned>(profile.echoWindow.count());
+    tryLoadChild(_usedKeys, _doc, basePath, "echo_window", uintValue);
+    profile.echoWindow = chrono::milliseconds(uintValue);
+
     return profile;
 }
 
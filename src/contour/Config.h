@@ -123,6 +123,7 @@ struct TerminalProfile {
     bool maximized = false;
     bool fullscreen = false;
     double refreshRate = 0.0; // 0=auto
+    std::chrono::milliseconds echoWindow = std::chrono::milliseconds(100); // 0=disabled
 
     terminal::PageSize terminalSize = {terminal::LineCount(10), terminal::ColumnCount(40)};
     terminal::VTType terminalId = terminal::VTType::VT525;
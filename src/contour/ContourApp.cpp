@@ -18,11 +18,14 @@
 #include "shell_integration_zsh.h"
 
 #include <terminal/Capabilities.h>
+#include <terminal/Functions.h>
 #include <terminal/Parser.h>
+#include <terminal/logging.h>
 
 #include <crispy/App.h>
 #include <crispy/StackTrace.h>
 #include <crispy/debuglog.h>
+#include <crispy/trace.h>
 #include <crispy/utils.h>
 
 #include <fmt/format.h>
@@ -45,6 +48,7 @@ using std::bind;
 using std::cerr;
 using std::cout;
 using std::make_unique;
+using std::ifstream;
 using std::ofstream;
 using std::string;
 using std::string_view;
@@ -234,10 +238,12 @@ ContourApp::ContourApp() :
     link("contour.capture", bind(&ContourApp::captureAction, this));
     link("contour.list-debug-tags", bind(&ContourApp::listDebugTagsAction, this));
     link("contour.set.profile", bind(&ContourApp::profileAction, this));
+    link("contour.dump-state", bind(&ContourApp::dumpStateAction, this));
     link("contour.parser-table", bind(&ContourApp::parserTableAction, this));
     link("contour.generate.terminfo", bind(&ContourApp::terminfoAction, this));
     link("contour.generate.config", bind(&ContourApp::configAction, this));
     link("contour.generate.integration", bind(&ContourApp::integrationAction, this));
+    link("contour.trace.decode", bind(&ContourApp::traceDecodeAction, this));
 }
 
 template <typename Callback>
@@ -295,6 +301,7 @@ int ContourApp::captureAction()
     captureSettings.logicalLines = parameters().get<bool>("contour.capture.logical");
     captureSettings.timeout = parameters().get<double>("contour.capture.timeout");
     captureSettings.lineCount = parameters().get<unsigned>("contour.capture.lines");
+    captureSettings.chunkSize = parameters().get<unsigned>("contour.capture.chunk-size");
     captureSettings.outputFile = parameters().get<string>("contour.capture.to");
 
     if (contour::captureScreen(captureSettings))
@@ -303,6 +310,50 @@ int ContourApp::captureAction()
         return EXIT_FAILURE;
 }
 
+int ContourApp::traceDecodeAction()
+{
+    auto const inputFileName = parameters().get<string>("contour.trace.decode.from");
+    auto input = ifstream(inputFileName, std::ios::binary);
+    if (!input.good())
+    {
+        std::cerr << fmt::format("Could not open trace file {}.\n", inputFileName);
+        return EXIT_FAILURE;
+    }
+
+    auto const trace = crispy::trace::decode(input);
+    if (!trace)
+    {
+        std::cerr << fmt::format("Could not decode trace file {}.\n", inputFileName);
+        return EXIT_FAILURE;
+    }
+
+    auto const describe = [&](crispy::trace::record const& _record) -> string {
+        if (trace->event_name(_record.event) == "vt.sequence")
+        {
+            for (terminal::FunctionDefinition const& function: terminal::functions())
+                if (function.id() == _record.value)
+                    return fmt::format("{} (result: {})", function.mnemonic, _record.argument);
+        }
+        return fmt::format("{} {}", _record.value, _record.argument);
+    };
+
+    return withOutput(parameters(), "contour.trace.decode.to", [&](auto& _stream) {
+        for (auto const& thread: trace->threads)
+        {
+            auto const startTime = !thread.records.empty() ? thread.records.front().timestamp : 0;
+            for (auto const& record: thread.records)
+            {
+                _stream << fmt::format("[{}] {:>12.3f}us {:<12} {}\n",
+                                       thread.thread_index,
+                                       static_cast<double>(record.timestamp - startTime) / 1000.0,
+                                       trace->event_name(record.event),
+                                       describe(record));
+            }
+        }
+        return EXIT_SUCCESS;
+    });
+}
+
 int ContourApp::parserTableAction()
 {
     terminal::parser::dot(std::cout, terminal::parser::ParserTable::get());
@@ -323,6 +374,13 @@ int ContourApp::profileAction()
     return EXIT_SUCCESS;
 }
 
+int ContourApp::dumpStateAction()
+{
+    // DUMPSTATE (OSC 888)
+    cout << "\033]888\033\\";
+    return EXIT_SUCCESS;
+}
+
 crispy::cli::Command ContourApp::parameterDefinition() const
 {
     return CLI::Command{
@@ -394,9 +452,29 @@ crispy::cli::Command ContourApp::parameterDefinition() const
                     CLI::Option{"logical", CLI::Value{false}, "Tells the terminal to use logical lines for counting and capturing."},
                     CLI::Option{"timeout", CLI::Value{1.0}, "Sets timeout seconds to wait for terminal to respond.", "SECONDS"},
                     CLI::Option{"lines", CLI::Value{0u}, "The number of lines to capture", "COUNT"},
+                    CLI::Option{"chunk-size", CLI::Value{0u}, "Maximum number of bytes the terminal replies per capture chunk. Larger chunks may speed up capturing large buffers.", "BYTES"},
                     CLI::Option{"to", CLI::Value{""s}, "Output file name to store the screen capture to. If - (dash) is given, the capture will be written to standard output.", "FILE", CLI::Presence::Required},
                 }
             },
+            CLI::Command{
+                "trace",
+                "Structured event trace utilities.",
+                CLI::OptionList{},
+                CLI::CommandList{
+                    CLI::Command{
+                        "decode",
+                        "Decodes a binary trace file (as written via `contour terminal trace FILE`) into human readable text.",
+                        CLI::OptionList{
+                            CLI::Option{"from", CLI::Value{""s}, "Binary trace file to decode.", "FILE", CLI::Presence::Required},
+                            CLI::Option{"to", CLI::Value{"-"s}, "Output file name to write the decoded trace to. If - (dash) is given, the output will be written to standard output.", "FILE"},
+                        }
+                    }
+                }
+            },
+            CLI::Command{
+                "dump-state",
+                "Tells the currently attached terminal to dump its internal state, including VT sequence usage metrics, into its local state directory."
+            },
             CLI::Command{
                 "set",
                 "Sets various aspects of the connected terminal.",
@@ -32,9 +32,11 @@ class ContourApp : public crispy::App
     int listDebugTagsAction();
     int parserTableAction();
     int profileAction();
+    int dumpStateAction();
     int terminfoAction();
     int configAction();
     int integrationAction();
+    int traceDecodeAction();
 };
 
 }
@@ -17,13 +17,19 @@
 #include <contour/Config.h>
 #include <contour/Controller.h>
 #include <contour/opengl/TerminalWidget.h>
+
+#include <text_shaper/open_shaper.h>
 #endif
 
 #if defined(CONTOUR_FRONTEND_GUI)
+#include <QtCore/QStandardPaths>
 #include <QtWidgets/QApplication>
 #include <QSurfaceFormat>
 #endif
 
+#include <crispy/stdfs.h>
+#include <crispy/trace.h>
+
 #include <iostream>
 
 using std::bind;
@@ -65,6 +71,7 @@ crispy::cli::Command ContourGuiApp::parameterDefinition() const
                 CLI::Option{"config", CLI::Value{contour::config::defaultConfigFilePath()}, "Path to configuration file to load at startup.", "FILE"},
                 CLI::Option{"profile", CLI::Value{""s}, "Terminal Profile to load (overriding config).", "NAME"},
                 CLI::Option{"debug", CLI::Value{""s}, "Enables debug logging, using a comma (,) seperated list of tags.", "TAGS"},
+                CLI::Option{"trace", CLI::Value{""s}, "Enables structured event tracing and writes the binary trace to the given file upon exit. Use `contour trace decode` to read it.", "FILE"},
                 CLI::Option{"live-config", CLI::Value{false}, "Enables live config reloading."},
                 CLI::Option{"working-directory", CLI::Value{""s}, "Sets initial working directory (overriding config).", "DIRECTORY"},
             },
@@ -111,6 +118,10 @@ int terminalGUI(int argc, char const* argv[], CLI::FlagStore const& _flags)
         }
     }
 
+    auto const traceFileName = _flags.get<string>("contour.terminal.trace");
+    if (!traceFileName.empty())
+        crispy::trace::enable(true);
+
     auto const configPath = QString::fromStdString(_flags.get<string>("contour.terminal.config"));
 
     auto config =
@@ -176,6 +187,10 @@ int terminalGUI(int argc, char const* argv[], CLI::FlagStore const& _flags)
 
     QSurfaceFormat::setDefaultFormat(contour::opengl::TerminalWidget::surfaceFormat());
 
+    // Persist fontconfig's font resolutions, as these dominate the startup time with many fonts installed.
+    if (auto const cacheHome = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation); !cacheHome.isEmpty())
+        text::open_shaper::set_font_cache_file((FileSystem::path(cacheHome.toStdString()) / "contour" / "font-cache.txt").string());
+
     contour::Controller controller(argv[0], config, liveConfig, profileName);
     controller.start();
 
@@ -188,6 +203,9 @@ int terminalGUI(int argc, char const* argv[], CLI::FlagStore const& _flags)
     controller.exit();
     controller.wait();
 
+    if (!traceFileName.empty() && !crispy::trace::dump(traceFileName))
+        cerr << "Could not write trace file " << traceFileName << '\n';
+
     // printf("\r%s", TBC);
     return rv;
 }
@@ -172,11 +172,6 @@ void TerminalSession::bufferChanged(terminal::ScreenType _type)
 
 void TerminalSession::screenUpdated()
 {
-#if defined(CONTOUR_VT_METRICS)
-    // TODO
-    // for (auto const& command : _commands)
-    //     terminalMetrics_(command);
-#endif
     if (profile_.autoScrollOnUpdate && terminal().viewport().scrolled())
         terminal().viewport().scrollToBottom();
 
@@ -191,13 +186,13 @@ void TerminalSession::renderBufferUpdated()
     display_->renderBufferUpdated();
 }
 
-void TerminalSession::requestCaptureBuffer(int _absoluteStartLine, int _lineCount)
+void TerminalSession::requestCaptureBuffer(int _lineCount, bool _logicalLines, size_t _chunkSize)
 {
-    display_->post([this, _absoluteStartLine, _lineCount]()
+    display_->post([this, _lineCount, _logicalLines, _chunkSize]()
     {
         if (display_->requestPermission(profile_.permissions.captureBuffer, "capture screen buffer"))
         {
-            terminal_.screen().captureBuffer(_absoluteStartLine, _lineCount);
+            terminal_.captureBuffer(_lineCount, _logicalLines, _chunkSize);
         }
     });
 }
@@ -495,7 +490,7 @@ void TerminalSession::operator()(actions::FollowHyperlink)
     };
     if (terminal().screen().contains(currentMousePosition))
     {
-        if (auto hyperlink = terminal().screen().at(currentMousePositionRel).hyperlink(); hyperlink != nullptr)
+        if (auto hyperlink = terminal().screen().hyperlinkAt(currentMousePositionRel); hyperlink != nullptr)
         {
             followHyperlink(*hyperlink);
             return;
@@ -585,10 +580,12 @@ void TerminalSession::operator()(actions::ResetFontSize)
 
 void TerminalSession::operator()(actions::ScreenshotVT)
 {
-    auto _l = lock_guard{ terminal() };
-    auto const screenshot = terminal().screen().screenshot();
+    auto const grid = [&]() {
+        auto _l = lock_guard{ terminal() };
+        return terminal().screen().grid().snapshot();
+    }();
     ofstream ofs{ "screenshot.vt", ios::trunc | ios::binary };
-    ofs << screenshot;
+    terminal::Screen::screenshot(grid, [&](char const* _data, size_t _size) { ofs.write(_data, static_cast<std::streamsize>(_size)); });
 }
 
 void TerminalSession::operator()(actions::ScrollDown)
@@ -808,10 +805,11 @@ void TerminalSession::configureTerminal()
 
     screen.setMaxHistoryLineCount(profile_.maxHistoryLineCount);
     terminal_.setCursorBlinkingInterval(profile_.cursorBlinkInterval);
+    terminal_.setEchoWindow(profile_.echoWindow);
     terminal_.setCursorDisplay(profile_.cursorDisplay);
     terminal_.setCursorShape(profile_.cursorShape);
-    terminal_.screen().colorPalette() = profile_.colors;
     terminal_.screen().defaultColorPalette() = profile_.colors;
+    terminal_.screen().setColorPalette(profile_.colors);
 }
 
 void TerminalSession::configureDisplay()
@@ -70,7 +70,7 @@ class TerminalSession: public terminal::Terminal::Events
 
     // Terminal::Events
     //
-    void requestCaptureBuffer(int _absoluteStartLine, int _lineCount) override;
+    void requestCaptureBuffer(int _lineCount, bool _logicalLines, size_t _chunkSize) override;
     void bell() override;
     void bufferChanged(terminal::ScreenType) override;
     void renderBufferUpdated() override;
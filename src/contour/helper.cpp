@@ -25,6 +25,7 @@
 #include <QtWidgets/QMessageBox>
 
 #include <array>
+#include <atomic>
 #include <algorithm>
 #include <mutex>
 
@@ -49,6 +50,61 @@ using crispy::Zero;
 
 namespace contour {
 
+namespace
+{
+    /// Approximates the process start, as it is initialized before main() is entered.
+    auto const startTime = steady_clock::now();
+
+    struct StartupTimings
+    {
+        std::mutex lock;
+        array<optional<steady_clock::duration>, 2> phases{};
+        std::atomic<bool> reported{false};
+    };
+
+    StartupTimings& startupTimings()
+    {
+        static StartupTimings timings;
+        return timings;
+    }
+
+    double milliseconds(steady_clock::duration _duration) noexcept
+    {
+        return std::chrono::duration<double, std::milli>(_duration).count();
+    }
+}
+
+void recordStartupPhase(StartupPhase _phase, steady_clock::duration _duration)
+{
+    auto& timings = startupTimings();
+    auto const _l = scoped_lock{timings.lock};
+    auto& phase = timings.phases.at(static_cast<size_t>(_phase));
+    if (!phase.has_value())
+        phase = _duration;
+}
+
+void reportStartupTimings()
+{
+    auto& timings = startupTimings();
+    if (timings.reported)
+        return;
+
+    auto const firstFrame = steady_clock::now() - startTime;
+    auto const _l = scoped_lock{timings.lock};
+    if (timings.reported.exchange(true))
+        return;
+
+    auto const phase = [&](StartupPhase _phase) {
+        return timings.phases.at(static_cast<size_t>(_phase)).value_or(steady_clock::duration::zero());
+    };
+
+    debuglog(StartupTag).write("Startup timings: font resolution {:.2f} ms, GL initialization {:.2f} ms, "
+                               "first frame presented after {:.2f} ms.",
+                               milliseconds(phase(StartupPhase::FontResolution)),
+                               milliseconds(phase(StartupPhase::GLInitialization)),
+                               milliseconds(firstFrame));
+}
+
 bool sendKeyEvent(QKeyEvent* _event, TerminalSession& _session)
 {
     using terminal::Key;
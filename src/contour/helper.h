@@ -21,6 +21,7 @@
 #include <QtGui/QKeyEvent>
 
 #include <cctype>
+#include <chrono>
 #include <map>
 #include <string>
 #include <string_view>
@@ -151,6 +152,20 @@ void spawnNewTerminal(std::string const& _programPath,
 auto const inline KeyboardTag = crispy::debugtag::make("system.keyboard", "Logs OS keyboard related debug information.");
 auto const inline WindowTag = crispy::debugtag::make("system.window", "Logs system window debug events.");
 auto const inline WidgetTag = crispy::debugtag::make("system.widget", "Logs system widget related debug information.");
+auto const inline StartupTag = crispy::debugtag::make("system.startup", "Logs the time spent in each startup phase until the first frame has been presented.");
+
+/// Phases of the startup whose durations are reported once the first frame has been presented.
+enum class StartupPhase
+{
+    FontResolution,
+    GLInitialization,
+};
+
+/// Records the time spent in the given startup phase. Only the first recording of each phase is kept.
+void recordStartupPhase(StartupPhase _phase, std::chrono::steady_clock::duration _duration);
+
+/// Logs the startup timing report, if not done yet, once the first frame has been presented.
+void reportStartupTimings();
 
 #define CHECKED_GL(code) \
     do { \
@@ -92,8 +92,22 @@ struct OpenGLRenderer::TextureScheduler : public atlas::AtlasBackend
         }
     };
 
+    /// Texture upload whose pixel data has been copied into the staging buffer.
+    ///
+    /// The target location is copied, too, as the texture may be evicted from its atlas
+    /// before the upload is flushed.
+    struct PendingUpload
+    {
+        atlas::AtlasID atlas;
+        crispy::Point offset;       // target position within the atlas
+        ImageSize bitmapSize;
+        size_t dataOffset;          // byte offset of the pixel data into the staging buffer
+        atlas::Format format;
+    };
+
     std::vector<atlas::CreateAtlas> createAtlases;
-    std::vector<atlas::UploadTexture> uploadTextures;
+    std::vector<PendingUpload> pendingUploads;
+    std::vector<uint8_t> stagingBuffer;     // pixel data of all pending uploads, tightly packed
     std::vector<RenderBatch> renderBatches;
     std::vector<atlas::AtlasID> destroyAtlases;
 
@@ -126,7 +140,13 @@ struct OpenGLRenderer::TextureScheduler : public atlas::AtlasBackend
 
     void uploadTexture(atlas::UploadTexture _texture) override
     {
-        uploadTextures.emplace_back(std::move(_texture));
+        atlas::TextureInfo const& texture = _texture.texture.get();
+        pendingUploads.emplace_back(PendingUpload{texture.atlas,
+                                                  texture.offset,
+                                                  texture.bitmapSize,
+                                                  stagingBuffer.size(),
+                                                  _texture.format});
+        stagingBuffer.insert(stagingBuffer.end(), _texture.data.begin(), _texture.data.end());
     }
 
     void renderTexture(atlas::RenderTexture _render) override
@@ -350,6 +370,9 @@ void OpenGLRenderer::initializeTextureRendering()
     CHECKED_GL( glBindBuffer(GL_ARRAY_BUFFER, vbo_) );
     CHECKED_GL( glBufferData(GL_ARRAY_BUFFER, 0/* sizeof(GLfloat) * 6 * 11 * 200 * 100*/, nullptr, GL_STREAM_DRAW) );
 
+    // staging buffer for texture uploads
+    CHECKED_GL( glGenBuffers(1, &pbo_) );
+
     // 0 (vec3): vertex buffer
     CHECKED_GL( glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, BufferStride, VertexOffset) );
     CHECKED_GL( glEnableVertexAttribArray(0) );
@@ -375,6 +398,7 @@ OpenGLRenderer::~OpenGLRenderer()
 {
     CHECKED_GL( glDeleteVertexArrays(1, &rectVAO_) );
     CHECKED_GL( glDeleteBuffers(1, &rectVBO_) );
+    CHECKED_GL( glDeleteBuffers(1, &pbo_) );
 }
 
 void OpenGLRenderer::initialize()
@@ -474,38 +498,56 @@ void OpenGLRenderer::createAtlas(atlas::CreateAtlas const& _param)
     atlasMap_.insert(pair{_param.atlas, textureId});
 }
 
-void OpenGLRenderer::uploadTexture(atlas::UploadTexture const& _param)
+void OpenGLRenderer::flushUploads()
 {
-    auto const& texture = _param.texture.get();
-    auto const key = texture.atlas;
-    [[maybe_unused]] auto const textureIdIter = atlasMap_.find(key);
-    assert(textureIdIter != atlasMap_.end() && "Texture ID not found in atlas map!");
-    auto const textureId = atlasMap_.at(key);
-    auto const x0 = texture.offset.x;
-    auto const y0 = texture.offset.y;
-    //auto const z0 = texture.z;
+    auto& pendingUploads = textureScheduler_->pendingUploads;
+    auto& stagingBuffer = textureScheduler_->stagingBuffer;
+
+    uploadStatistics_ = UploadStatistics{};
+    if (pendingUploads.empty())
+        return;
 
-    //debuglog(OpenGLRendererTag).write("({}): {}", textureId, _param);
+    // Group uploads by atlas to keep texture rebinds at a minimum.
+    std::stable_sort(pendingUploads.begin(), pendingUploads.end(), [](auto const& a, auto const& b) {
+        return a.atlas < b.atlas;
+    });
+
+    // Transfer the pixel data of all pending uploads in one go, orphaning the previous frame's storage.
+    // The following glTexSubImage2D calls then source from the staging buffer on the GPU side.
+    CHECKED_GL( glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_) );
+    CHECKED_GL( glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(stagingBuffer.size()), stagingBuffer.data(), GL_STREAM_DRAW) );
+
+    // Staged bitmaps are tightly packed, regardless of their format.
+    CHECKED_GL( glPixelStorei(GL_UNPACK_ALIGNMENT, 1) );
 
     auto constexpr target = GL_TEXTURE_2D;
     auto constexpr levelOfDetail = 0;
-    //auto constexpr depth = 1;
     auto constexpr type = GL_UNSIGNED_BYTE;
 
-    bindTexture(textureId);
-
-    switch (_param.format)
+    for (auto const& upload: pendingUploads)
     {
-        case atlas::Format::RGB:
-        case atlas::Format::Red:
-            CHECKED_GL( glPixelStorei(GL_UNPACK_ALIGNMENT, 1) );
-            break;
-        case atlas::Format::RGBA:
-            CHECKED_GL( glPixelStorei(GL_UNPACK_ALIGNMENT, 4) );
-            break;
+        [[maybe_unused]] auto const textureIdIter = atlasMap_.find(upload.atlas);
+        assert(textureIdIter != atlasMap_.end() && "Texture ID not found in atlas map!");
+        bindTexture(atlasMap_.at(upload.atlas));
+
+        auto const x0 = upload.offset.x;
+        auto const y0 = upload.offset.y;
+        auto const pixels = reinterpret_cast<void const*>(upload.dataOffset);
+        CHECKED_GL( glTexSubImage2D(target, levelOfDetail, x0, y0, *upload.bitmapSize.width, *upload.bitmapSize.height, glFormat(upload.format), type, pixels) );
     }
 
-    CHECKED_GL( glTexSubImage2D(target, levelOfDetail, x0, y0, *texture.bitmapSize.width, *texture.bitmapSize.height, glFormat(_param.format), type, _param.data.data()) );
+    CHECKED_GL( glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0) );
+
+    uploadStatistics_.textureCount = pendingUploads.size();
+    uploadStatistics_.byteCount = stagingBuffer.size();
+    uploadStatistics_.transferCount = 1;
+
+    debuglog(OpenGLRendererTag).write("Uploaded {} textures ({} bytes) via staging buffer.",
+                                      uploadStatistics_.textureCount,
+                                      uploadStatistics_.byteCount);
+
+    pendingUploads.clear();
+    stagingBuffer.clear();
 }
 
 GLuint OpenGLRenderer::textureAtlasID(atlas::AtlasID _atlasID) const noexcept
@@ -662,7 +704,7 @@ void OpenGLRenderer::executeRenderTextures()
 
     // debuglog(OpenGLRendererTag).write(
     //     "OpenGLRenderer::executeRenderTextures() upload={} render={}",
-    //     textureScheduler_->uploadTextures.size(),
+    //     textureScheduler_->pendingUploads.size(),
     //     textureScheduler_->renderTextures.size()
     // );
 
@@ -672,9 +714,7 @@ void OpenGLRenderer::executeRenderTextures()
     textureScheduler_->createAtlases.clear();
 
     // potentially upload any new textures
-    for (auto const& params: textureScheduler_->uploadTextures)
-        uploadTexture(params);
-    textureScheduler_->uploadTextures.clear();
+    flushUploads();
 
     // upload vertices and render
     for (size_t i = 0; i < textureScheduler_->renderBatches.size(); ++i)
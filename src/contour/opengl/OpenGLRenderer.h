@@ -68,6 +68,15 @@ class OpenGLRenderer final :
 
     std::optional<AtlasTextureInfo> readAtlas(atlas::TextureAtlasAllocator const& _allocator, atlas::AtlasID _instanceId) override;
 
+    struct UploadStatistics {
+        size_t textureCount = 0;    // number of textures uploaded
+        size_t byteCount = 0;       // number of bytes transferred
+        size_t transferCount = 0;   // number of host-to-GPU buffer transfers
+    };
+
+    /// @returns texture upload statistics of the most recently executed frame.
+    UploadStatistics const& uploadStatistics() const noexcept { return uploadStatistics_; }
+
   private:
     // private helper methods
     //
@@ -84,7 +93,7 @@ class OpenGLRenderer final :
 
     void executeRenderTextures();
     void createAtlas(atlas::CreateAtlas const& _param);
-    void uploadTexture(atlas::UploadTexture const& _param);
+    void flushUploads();
     void renderTexture(atlas::RenderTexture const& _param);
     void destroyAtlas(atlas::AtlasID _atlasID);
 
@@ -110,6 +119,7 @@ class OpenGLRenderer final :
     //
     GLuint vao_{};              // Vertex Array Object, covering all buffer objects
     GLuint vbo_{};              // Buffer containing the vertex coordinates
+    GLuint pbo_{};              // Pixel buffer object, staging all texture uploads of a frame
     //TODO: GLuint ebo_{};
     std::unordered_map<atlas::AtlasID, GLuint> atlasMap_; // maps atlas IDs to texture IDs
     GLuint currentTextureId_ = std::numeric_limits<GLuint>::max();
@@ -117,6 +127,7 @@ class OpenGLRenderer final :
     atlas::TextureAtlasAllocator monochromeAtlasAllocator_;
     atlas::TextureAtlasAllocator coloredAtlasAllocator_;
     atlas::TextureAtlasAllocator lcdAtlasAllocator_;
+    UploadStatistics uploadStatistics_;
 
     // private data members for rendering filled rectangles
     //
@@ -95,6 +95,9 @@ using actions::Action;
 
 namespace // {{{
 {
+    /// How often to check whether glyphs rasterized in the background are ready to be shown.
+    auto constexpr GlyphRasterizationPollInterval = std::chrono::milliseconds(4);
+
 #if !defined(NDEBUG) && defined(GL_DEBUG_OUTPUT) && defined(CONTOUR_DEBUG_OPENGL)
     void glMessageCallback(
         GLenum _source,
@@ -294,6 +297,8 @@ TerminalWidget::TerminalWidget(
                               geometry().bottom(),
                               geometry().right());
 
+    recordStartupPhase(StartupPhase::FontResolution, renderer_.fontLoadTime());
+
     setMouseTracking(true);
     setFormat(surfaceFormat());
 
@@ -421,6 +426,8 @@ QSize TerminalWidget::sizeHint() const
 
 void TerminalWidget::initializeGL()
 {
+    auto const start = steady_clock::now();
+
     initializeOpenGLFunctions();
 
     renderTarget_ = make_unique<terminal::renderer::opengl::OpenGLRenderer>(
@@ -432,6 +439,8 @@ void TerminalWidget::initializeGL()
 
     renderer_.setRenderTarget(*renderTarget_);
 
+    recordStartupPhase(StartupPhase::GLInitialization, steady_clock::now() - start);
+
     // {{{ some info
     static bool infoPrinted = false;
     if (!infoPrinted)
@@ -559,7 +568,12 @@ void TerminalWidget::paintGL()
 
         glClear(GL_COLOR_BUFFER_BIT);
 
-        renderer_.render(terminal(), steady_clock::now(), renderingPressure_);
+        auto const now = steady_clock::now();
+
+        // Sends the mouse moves coalesced since the last frame.
+        terminal().flushPendingInput(now);
+
+        renderer_.render(terminal(), now, renderingPressure_);
     }
     catch (exception const& e)
     {
@@ -569,6 +583,9 @@ void TerminalWidget::paintGL()
 
 void TerminalWidget::onFrameSwapped()
 {
+    terminal().framePresented(renderer_.lastFrameID(), steady_clock::now());
+    reportStartupTimings();
+
     for (;;)
     {
         auto state = state_.load();
@@ -589,6 +606,12 @@ void TerminalWidget::onFrameSwapped()
                 [[fallthrough]];
             case State::CleanIdle:
                 renderingPressure_ = false;
+                if (renderer_.rasterizingGlyphs())
+                {
+                    // Renders again to show the glyphs the last frame has left blank.
+                    updateTimer_.start(GlyphRasterizationPollInterval);
+                    return;
+                }
                 if (profile_.cursorDisplay == terminal::CursorDisplay::Blink
                         && terminal().screen().cursor().visible)
                     updateTimer_.start(terminal().nextRender(steady_clock::now()));
@@ -771,6 +794,12 @@ void TerminalWidget::dumpState()
         fs << screenStateDump;
     }
 
+    {
+        auto const vtMetricsFilePath = targetDir / "vt-metrics.txt";
+        auto fs = ofstream{vtMetricsFilePath.string(), ios::trunc};
+        terminal().screen().vtMetrics().dump(fs);
+    }
+
     enum class ImageBufferFormat { RGBA, RGB, Alpha };
 
     auto screenshotSaver = [](FileSystem::path const& _filename, ImageBufferFormat _format) {
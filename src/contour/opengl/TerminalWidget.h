@@ -20,7 +20,6 @@
 #include <contour/helper.h>
 
 #include <terminal/Color.h>
-#include <terminal/Metrics.h>
 #include <terminal/primitives.h>
 #include <terminal_renderer/Renderer.h>
 
@@ -233,9 +232,6 @@ public:
 #if defined(CONTOUR_PERF_STATS)
     std::atomic<uint64_t> renderCount_ = 0;
 #endif
-#if defined(CONTOUR_VT_METRICS)
-    terminal::Metrics terminalMetrics_{};
-#endif
 
     PermissionCache rememberedPermissions_;
 
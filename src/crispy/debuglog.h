@@ -123,7 +123,7 @@ namespace debugtag
     inline bool enabled(tag_id _tag) noexcept
     {
         assert(_tag.value < store().size());
-        return store().at(_tag.value).enabled;
+        return store()[_tag.value].enabled;
     }
 }
 
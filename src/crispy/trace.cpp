@@ -0,0 +1,283 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/trace.h>
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <mutex>
+
+using std::lock_guard;
+using std::make_shared;
+using std::mutex;
+using std::nullopt;
+using std::optional;
+using std::shared_ptr;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace crispy::trace {
+
+namespace
+{
+    // Binary dump layout (host byte order):
+    //
+    //   Magic        := 'C' 'T' 'R' 'C'
+    //   Header       := Magic u32:version u32:recordSize
+    //   EventTable   := u32:count (u16:nameLength name-bytes)*
+    //   ThreadTable  := u32:count (u32:threadIndex u64:recordCount record*)*
+    //   File         := Header EventTable ThreadTable
+    constexpr char Magic[4] = {'C', 'T', 'R', 'C'};
+    constexpr uint32_t Version = 1;
+
+    struct registry {
+        mutex lock;
+        vector<shared_ptr<ring_buffer>> buffers; // Kept alive beyond thread exit, so they can still be dumped.
+        vector<ring_buffer*> idle;               // Buffers of exited threads, to be reused by new threads.
+        size_t capacity = 64 * 1024;
+    };
+
+    registry& global_registry()
+    {
+        static registry instance;
+        return instance;
+    }
+
+    template <typename T>
+    void write_value(std::ostream& _output, T _value)
+    {
+        _output.write(reinterpret_cast<char const*>(&_value), sizeof(_value));
+    }
+
+    template <typename T>
+    bool read_value(std::istream& _input, T& _value)
+    {
+        return static_cast<bool>(_input.read(reinterpret_cast<char*>(&_value), sizeof(_value)));
+    }
+
+    /// @returns the number of bytes left to be read, or std::nullopt if the stream is not seekable.
+    optional<uint64_t> remaining_bytes(std::istream& _input)
+    {
+        auto const current = _input.tellg();
+        if (current == std::istream::pos_type(-1))
+            return nullopt;
+
+        _input.seekg(0, std::ios::end);
+        auto const end = _input.tellg();
+        _input.seekg(current);
+        if (end == std::istream::pos_type(-1) || !_input)
+            return nullopt;
+
+        return static_cast<uint64_t>(end - current);
+    }
+
+    /// Reads @p _count records, growing @p _records only as far as the input actually provides them,
+    /// such that a corrupt record count cannot cause an excessive allocation.
+    bool read_records(std::istream& _input, uint64_t _count, vector<record>& _records)
+    {
+        if (auto const available = remaining_bytes(_input); available && _count > *available / sizeof(record))
+            return false;
+
+        auto constexpr ChunkSize = uint64_t{64 * 1024}; // records per read, if the size is unknown
+        while (_records.size() < _count)
+        {
+            auto const offset = _records.size();
+            auto const n = std::min(_count - offset, ChunkSize);
+            _records.resize(offset + n);
+            if (!_input.read(reinterpret_cast<char*>(_records.data() + offset),
+                             static_cast<std::streamsize>(n * sizeof(record))))
+                return false;
+        }
+        return true;
+    }
+}
+
+ring_buffer::ring_buffer(uint32_t _threadIndex, size_t _capacity):
+    threadIndex_{ _threadIndex },
+    mask_{ _capacity - 1 },
+    slots_{ std::make_unique<slot[]>(_capacity) }
+{
+    assert(_capacity != 0 && (_capacity & (_capacity - 1)) == 0);
+}
+
+vector<record> ring_buffer::snapshot() const
+{
+    auto const head = total();
+    auto const count = std::min<uint64_t>(head, capacity());
+    auto output = vector<record>{};
+    output.reserve(count);
+    for (auto i = head - count; i != head; ++i)
+    {
+        auto const& slot = slots_[i & mask_];
+
+        auto const sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * i + 2)
+            continue; // already overwritten by a newer record
+
+        uint64_t words[WordCount];
+        for (size_t k = 0; k < WordCount; ++k)
+            words[k] = slot.words[k].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+            continue; // overwritten while being read
+
+        auto& entry = output.emplace_back();
+        std::memcpy(&entry, words, sizeof(record));
+    }
+    return output;
+}
+
+ring_buffer& detail::create_local_buffer()
+{
+    auto& reg = global_registry();
+    auto const _l = lock_guard{reg.lock};
+
+    if (!reg.idle.empty() && reg.idle.back()->capacity() == reg.capacity)
+    {
+        auto& buffer = *reg.idle.back();
+        reg.idle.pop_back();
+        return buffer;
+    }
+
+    auto const threadIndex = static_cast<uint32_t>(reg.buffers.size());
+    reg.buffers.emplace_back(make_shared<ring_buffer>(threadIndex, reg.capacity));
+    return *reg.buffers.back();
+}
+
+void detail::release_local_buffer(ring_buffer& _buffer) noexcept
+{
+    auto& reg = global_registry();
+    auto const _l = lock_guard{reg.lock};
+
+    if (_buffer.capacity() == reg.capacity)
+        reg.idle.push_back(&_buffer);
+    else
+        reg.buffers.erase(std::remove_if(reg.buffers.begin(), reg.buffers.end(),
+                                         [&](auto const& x) { return x.get() == &_buffer; }),
+                          reg.buffers.end());
+}
+
+vector<event_info>& events()
+{
+    static vector<event_info> store;
+    return store;
+}
+
+event_id make(string_view _name, string_view _description)
+{
+    assert(std::none_of(events().begin(), events().end(), [&](event_info const& x) { return x.name == _name; }));
+    events().emplace_back(event_info{string(_name), string(_description)});
+    return event_id{ static_cast<uint16_t>(events().size() - 1) };
+}
+
+void set_buffer_capacity(size_t _capacity)
+{
+    assert(_capacity != 0 && (_capacity & (_capacity - 1)) == 0);
+    auto& reg = global_registry();
+    auto const _l = lock_guard{reg.lock};
+    reg.capacity = _capacity;
+}
+
+bool dump(std::ostream& _output)
+{
+    _output.write(Magic, sizeof(Magic));
+    write_value<uint32_t>(_output, Version);
+    write_value<uint32_t>(_output, sizeof(record));
+
+    write_value<uint32_t>(_output, static_cast<uint32_t>(events().size()));
+    for (event_info const& event: events())
+    {
+        write_value<uint16_t>(_output, static_cast<uint16_t>(event.name.size()));
+        _output.write(event.name.data(), static_cast<std::streamsize>(event.name.size()));
+    }
+
+    auto& reg = global_registry();
+    auto const _l = lock_guard{reg.lock};
+    write_value<uint32_t>(_output, static_cast<uint32_t>(reg.buffers.size()));
+    for (shared_ptr<ring_buffer> const& buffer: reg.buffers)
+    {
+        auto const records = buffer->snapshot();
+        write_value<uint32_t>(_output, buffer->thread_index());
+        write_value<uint64_t>(_output, records.size());
+        _output.write(reinterpret_cast<char const*>(records.data()),
+                      static_cast<std::streamsize>(records.size() * sizeof(record)));
+    }
+
+    return static_cast<bool>(_output);
+}
+
+bool dump(string const& _fileName)
+{
+    auto output = std::ofstream(_fileName, std::ios::binary | std::ios::trunc);
+    if (!output.good())
+        return false;
+    return dump(output);
+}
+
+string_view trace_file::event_name(uint16_t _event) const noexcept
+{
+    if (_event < event_names.size())
+        return event_names[_event];
+    return "?";
+}
+
+optional<trace_file> decode(std::istream& _input)
+{
+    char magic[sizeof(Magic)] = {};
+    if (!_input.read(magic, sizeof(magic)) || !std::equal(std::begin(magic), std::end(magic), std::begin(Magic)))
+        return nullopt;
+
+    uint32_t version = 0;
+    uint32_t recordSize = 0;
+    if (!read_value(_input, version) || version != Version)
+        return nullopt;
+    if (!read_value(_input, recordSize) || recordSize != sizeof(record))
+        return nullopt;
+
+    auto output = trace_file{};
+
+    uint32_t eventCount = 0;
+    if (!read_value(_input, eventCount))
+        return nullopt;
+    for (uint32_t i = 0; i < eventCount; ++i)
+    {
+        uint16_t length = 0;
+        if (!read_value(_input, length))
+            return nullopt;
+        auto name = string(length, '\0');
+        if (!_input.read(name.data(), length))
+            return nullopt;
+        output.event_names.emplace_back(std::move(name));
+    }
+
+    uint32_t threadCount = 0;
+    if (!read_value(_input, threadCount))
+        return nullopt;
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        auto thread = trace_file::thread_records{};
+        uint64_t recordCount = 0;
+        if (!read_value(_input, thread.thread_index) || !read_value(_input, recordCount))
+            return nullopt;
+        if (!read_records(_input, recordCount, thread.records))
+            return nullopt;
+        output.threads.emplace_back(std::move(thread));
+    }
+
+    return output;
+}
+
+} // end namespace
@@ -0,0 +1,192 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Structured, low overhead event tracing.
+ *
+ * Unlike debuglog(), trace points do not format any text at the call site. An enabled trace
+ * point stores a fixed size binary record into a per-thread ring buffer, which can later be
+ * dumped into a compact binary file and decoded offline (see `contour trace decode`).
+ *
+ * When tracing is compiled in (CRISPY_TRACING) but disabled at runtime, the cost of a
+ * trace point is a single relaxed atomic load plus a predictable branch.
+ * When tracing is not compiled in, trace points vanish completely.
+ */
+namespace crispy::trace {
+
+/// Identifies a kind of trace event, as created via make().
+struct event_id { uint16_t value; };
+
+struct event_info {
+    std::string name;
+    std::string description;
+};
+
+/// A single trace record as stored in the ring buffer and in the binary dump.
+struct record {
+    uint64_t timestamp; //!< nanoseconds since the steady clock's epoch
+    uint16_t event;     //!< event_id::value
+    uint16_t reserved;
+    uint32_t value;     //!< event specific primary value (e.g. a function id or byte count)
+    uint64_t argument;  //!< event specific secondary value
+};
+static_assert(sizeof(record) == 24);
+
+/// Single-producer ring buffer of trace records, one instance per thread.
+///
+/// The owning thread appends without taking any lock. Readers (dump()) may run concurrently
+/// and will see a snapshot of the most recent records, skipping those that are overwritten
+/// while being read.
+class ring_buffer {
+  public:
+    ring_buffer(uint32_t _threadIndex, size_t _capacity);
+
+    void push(record const& _record) noexcept
+    {
+        auto const head = head_.load(std::memory_order_relaxed);
+        auto& slot = slots_[head & mask_];
+
+        uint64_t words[WordCount];
+        std::memcpy(words, &_record, sizeof(record));
+
+        slot.sequence.store(2 * head + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WordCount; ++i)
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        slot.sequence.store(2 * head + 2, std::memory_order_release);
+
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    uint32_t thread_index() const noexcept { return threadIndex_; }
+    size_t capacity() const noexcept { return mask_ + 1; }
+
+    /// @returns the total number of records ever pushed into this buffer.
+    uint64_t total() const noexcept { return head_.load(std::memory_order_acquire); }
+
+    /// @returns the most recent records in chronological order.
+    std::vector<record> snapshot() const;
+
+  private:
+    static constexpr size_t WordCount = sizeof(record) / sizeof(uint64_t);
+
+    /// Record storage guarded by a sequence lock, which is odd while the record is being written
+    /// and 2 * (n + 1) once it holds the n-th record pushed.
+    struct slot {
+        std::atomic<uint64_t> sequence;
+        std::array<std::atomic<uint64_t>, WordCount> words;
+    };
+
+    uint32_t threadIndex_;
+    size_t mask_;
+    std::unique_ptr<slot[]> slots_;
+    std::atomic<uint64_t> head_ = 0;
+};
+
+namespace detail
+{
+    inline std::atomic<bool> enabled_flag = false;
+
+    ring_buffer& create_local_buffer();
+
+    /// Hands the buffer of an exiting thread on to the next thread that starts tracing.
+    void release_local_buffer(ring_buffer& _buffer) noexcept;
+
+    struct local_buffer_handle {
+        ring_buffer& buffer = create_local_buffer();
+        ~local_buffer_handle() { release_local_buffer(buffer); }
+    };
+
+    inline ring_buffer& local_buffer()
+    {
+        thread_local local_buffer_handle handle;
+        return handle.buffer;
+    }
+}
+
+/// @returns all registered trace events, indexed by event_id::value.
+std::vector<event_info>& events();
+
+/// Registers a new trace event kind.
+event_id make(std::string_view _name, std::string_view _description);
+
+/// Number of records each thread's ring buffer can hold before the oldest get overwritten.
+/// Must be a power of two and only takes effect for threads that have not yet traced anything.
+void set_buffer_capacity(size_t _capacity);
+
+inline bool enabled() noexcept { return detail::enabled_flag.load(std::memory_order_relaxed); }
+
+inline void enable(bool _enabled = true) noexcept { detail::enabled_flag.store(_enabled, std::memory_order_relaxed); }
+
+/// Unconditionally records the given event into the calling thread's ring buffer.
+inline void emit(event_id _event, uint32_t _value, uint64_t _argument = 0) noexcept
+{
+    auto const now = std::chrono::steady_clock::now().time_since_epoch();
+    detail::local_buffer().push(record{
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()),
+        _event.value,
+        0,
+        _value,
+        _argument
+    });
+}
+
+/// Writes all currently buffered records of all threads in binary form to @p _output.
+bool dump(std::ostream& _output);
+
+/// Writes all currently buffered records of all threads in binary form to the given file.
+bool dump(std::string const& _fileName);
+
+/// Decoded contents of a binary trace dump.
+struct trace_file {
+    struct thread_records {
+        uint32_t thread_index;
+        std::vector<record> records;
+    };
+
+    std::vector<std::string> event_names;
+    std::vector<thread_records> threads;
+
+    /// @returns the name of the given event id or "?" if unknown.
+    std::string_view event_name(uint16_t _event) const noexcept;
+};
+
+/// Decodes a binary trace dump as created by dump().
+std::optional<trace_file> decode(std::istream& _input);
+
+} // end namespace
+
+#if defined(CRISPY_TRACING)
+    #define CRISPY_TRACE(_event, ...)                                                       \
+        do {                                                                                \
+            if (::crispy::trace::enabled())                                                 \
+                ::crispy::trace::emit((_event), __VA_ARGS__);                               \
+        } while (0)
+#else
+    #define CRISPY_TRACE(_event, ...) do {} while (0)
+#endif
@@ -0,0 +1,166 @@
+/**
+ * This file is part of the "contour" project.
+ *   Copyright (c) 2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/trace.h>
+#include <catch2/catch_all.hpp>
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+using namespace crispy;
+
+namespace
+{
+    auto const TestEvent = trace::make("test.event", "Test event.");
+    auto const OtherEvent = trace::make("test.other", "Other test event.");
+
+    trace::trace_file::thread_records const* findThreadWith(trace::trace_file const& _file, uint32_t _value)
+    {
+        for (auto const& thread: _file.threads)
+            for (auto const& record: thread.records)
+                if (record.value == _value)
+                    return &thread;
+        return nullptr;
+    }
+}
+
+TEST_CASE("trace.disabled", "[trace]")
+{
+    trace::enable(false);
+    CRISPY_TRACE(TestEvent, 0xDEAD);
+
+    auto buffer = std::stringstream{};
+    REQUIRE(trace::dump(buffer));
+    auto const file = trace::decode(buffer);
+    REQUIRE(file.has_value());
+    CHECK(findThreadWith(*file, 0xDEAD) == nullptr);
+}
+
+TEST_CASE("trace.dump_and_decode", "[trace]")
+{
+    trace::enable(true);
+    CRISPY_TRACE(TestEvent, 0x1001, 42);
+    CRISPY_TRACE(OtherEvent, 0x1002);
+    std::thread([]() { CRISPY_TRACE(OtherEvent, 0x2001, 7); }).join();
+    trace::enable(false);
+
+    auto buffer = std::stringstream{};
+    REQUIRE(trace::dump(buffer));
+
+    auto const file = trace::decode(buffer);
+    REQUIRE(file.has_value());
+    CHECK(file->event_name(TestEvent.value) == "test.event");
+    CHECK(file->event_name(OtherEvent.value) == "test.other");
+
+    auto const* mainThread = findThreadWith(*file, 0x1001);
+    REQUIRE(mainThread != nullptr);
+    auto const& records = mainThread->records;
+    REQUIRE(records.size() >= 2);
+    auto const& a = records[records.size() - 2];
+    auto const& b = records[records.size() - 1];
+    CHECK(a.event == TestEvent.value);
+    CHECK(a.argument == 42);
+    CHECK(b.event == OtherEvent.value);
+    CHECK(b.value == 0x1002);
+    CHECK(a.timestamp <= b.timestamp);
+
+    // Records of other threads are kept in their own buffers, even after the thread exited.
+    auto const* otherThread = findThreadWith(*file, 0x2001);
+    REQUIRE(otherThread != nullptr);
+    CHECK(otherThread->thread_index != mainThread->thread_index);
+}
+
+TEST_CASE("trace.ring_buffer_wraps", "[trace]")
+{
+    auto buffer = trace::ring_buffer(0, 4);
+    for (uint32_t i = 0; i < 10; ++i)
+        buffer.push(trace::record{i, 0, 0, i, 0});
+
+    auto const records = buffer.snapshot();
+    REQUIRE(records.size() == 4);
+    CHECK(records.front().value == 6);
+    CHECK(records.back().value == 9);
+    CHECK(buffer.total() == 10);
+}
+
+TEST_CASE("trace.decode_rejects_garbage", "[trace]")
+{
+    auto input = std::stringstream{"definitely not a trace file"};
+    CHECK_FALSE(trace::decode(input).has_value());
+}
+
+TEST_CASE("trace.decode_rejects_excessive_record_count", "[trace]")
+{
+    auto input = std::stringstream{};
+    auto const write = [&](auto _value) { input.write(reinterpret_cast<char const*>(&_value), sizeof(_value)); };
+    input.write("CTRC", 4);
+    write(uint32_t{1});                     // version
+    write(uint32_t{sizeof(trace::record)});
+    write(uint32_t{0});                     // event count
+    write(uint32_t{1});                     // thread count
+    write(uint32_t{0});                     // thread index
+    write(uint64_t{1} << 60);               // record count, with no records following
+    CHECK_FALSE(trace::decode(input).has_value());
+}
+
+TEST_CASE("trace.buffers_are_recycled", "[trace]")
+{
+    auto const threadCount = []() {
+        auto buffer = std::stringstream{};
+        trace::dump(buffer);
+        return trace::decode(buffer).value().threads.size();
+    };
+
+    trace::enable(true);
+    std::thread([]() { CRISPY_TRACE(TestEvent, 0x3001); }).join();
+    auto const before = threadCount();
+
+    // Threads that start tracing after another one exited reuse its buffer.
+    std::thread([]() { CRISPY_TRACE(TestEvent, 0x3002); }).join();
+    std::thread([]() { CRISPY_TRACE(TestEvent, 0x3003); }).join();
+    trace::enable(false);
+
+    CHECK(threadCount() == before);
+}
+
+TEST_CASE("trace.snapshot_while_writing", "[trace]")
+{
+    auto buffer = trace::ring_buffer(0, 64);
+    auto done = std::atomic<bool>{false};
+
+    auto writer = std::thread([&]() {
+        for (uint32_t i = 0; !done; ++i)
+            buffer.push(trace::record{i, 0, 0, i, uint64_t(i) * 3});
+    });
+
+    while (buffer.total() < 2 * buffer.capacity())
+        std::this_thread::yield();
+
+    // Snapshots only contain completely written records, in order.
+    for (int round = 0; round < 100; ++round)
+    {
+        auto const records = buffer.snapshot();
+        REQUIRE(records.size() <= buffer.capacity());
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            REQUIRE(records[i].argument == uint64_t(records[i].value) * 3);
+            REQUIRE(records[i].timestamp == records[i].value);
+            if (i != 0)
+                REQUIRE(records[i - 1].value < records[i].value);
+        }
+    }
+
+    done = true;
+    writer.join();
+}
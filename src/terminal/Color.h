@@ -180,7 +180,7 @@ constexpr bool operator!=(Color a, Color b) noexcept
 constexpr bool isUndefined(Color _color) noexcept { return _color.type == ColorType::Undefined; }
 constexpr bool isDefaultColor(Color _color) noexcept { return _color.type == ColorType::Default; }
 
-constexpr bool isIndexedColor(Color _color) noexcept { return _color.type == ColorType::Undefined; }
+constexpr bool isIndexedColor(Color _color) noexcept { return _color.type == ColorType::Indexed; }
 constexpr bool isBrightColor(Color _color) noexcept { return _color.type == ColorType::Bright; }
 constexpr bool isRGBColor(Color _color) noexcept { return _color.type == ColorType::RGB; }
 
@@ -0,0 +1,163 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Color.h>
+#include <terminal/Grid.h>
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace terminal {
+
+/// Fully resolved RGB colors of a single grid cell.
+struct ResolvedColors
+{
+    RGBColor foreground;
+    RGBColor background;
+    RGBColor underline;
+};
+
+/// Packs a Color into a single integer that is unique for every color value.
+///
+/// Unlike operator==(Color, Color), this does also take all RGB components into account.
+constexpr uint32_t packColor(Color _color) noexcept
+{
+    if (_color.type == ColorType::RGB)
+        return (static_cast<uint32_t>(_color.type) << 24)
+             | (static_cast<uint32_t>(_color.rgb.red) << 16)
+             | (static_cast<uint32_t>(_color.rgb.green) << 8)
+             | static_cast<uint32_t>(_color.rgb.blue);
+
+    return (static_cast<uint32_t>(_color.type) << 24) | _color.index;
+}
+
+/**
+ * Caches the RGB colors that GraphicsAttributes resolve to against a given ColorPalette.
+ *
+ * Resolving a cell's colors involves mapping indexed/bright/default colors through the palette
+ * and applying faint, inverse and reverse-video logic. Most screens only use a handful of
+ * distinct attribute combinations, so this direct-mapped cache turns the per-cell color
+ * resolution into a table lookup.
+ *
+ * The cache is keyed by the color relevant parts of the attributes and the reverse-video state.
+ * It is invalidated as a whole whenever the palette generation (see Screen::colorPaletteGeneration())
+ * passed to get() differs from the one the cache was filled with.
+ */
+class ResolvedColorCache {
+  public:
+    static constexpr size_t DefaultCapacity = 1024;
+
+    /// @param _capacity number of cache slots, must be a power of two.
+    explicit ResolvedColorCache(size_t _capacity = DefaultCapacity):
+        entries_(_capacity)
+    {
+        assert(_capacity != 0 && (_capacity & (_capacity - 1)) == 0);
+    }
+
+    ResolvedColors const& get(ColorPalette const& _palette,
+                              uint64_t _paletteGeneration,
+                              GraphicsAttributes const& _attributes,
+                              bool _reverseVideo) noexcept
+    {
+        if (_paletteGeneration != generation_)
+            clear(_paletteGeneration);
+
+        auto const key = makeKey(_attributes, _reverseVideo);
+        Entry& entry = entries_[hash(key) & (entries_.size() - 1)];
+
+        if (entry.valid && entry.key == key)
+        {
+            ++hits_;
+            return entry.colors;
+        }
+
+        ++misses_;
+        auto const [fg, bg] = _attributes.makeColors(_palette, _reverseVideo);
+        entry.key = key;
+        entry.valid = true;
+        entry.colors = ResolvedColors{fg, bg, _attributes.getUnderlineColor(_palette)};
+        return entry.colors;
+    }
+
+    /// Drops all cached entries and associates the cache with the given palette generation.
+    void clear(uint64_t _paletteGeneration) noexcept
+    {
+        for (Entry& entry: entries_)
+            entry.valid = false;
+        generation_ = _paletteGeneration;
+    }
+
+    uint64_t hits() const noexcept { return hits_; }
+    uint64_t misses() const noexcept { return misses_; }
+    size_t capacity() const noexcept { return entries_.size(); }
+
+  private:
+    /// Only these style flags have an effect on the resolved colors.
+    static constexpr auto ColorRelevantStyles = static_cast<uint32_t>(CellFlags::Bold)
+                                              | static_cast<uint32_t>(CellFlags::Faint)
+                                              | static_cast<uint32_t>(CellFlags::Inverse);
+
+    struct Key
+    {
+        uint32_t foreground = 0;
+        uint32_t background = 0;
+        uint32_t underline = 0;
+        uint32_t flags = 0; // color relevant styles plus reverse-video bit
+
+        constexpr bool operator==(Key const& _other) const noexcept
+        {
+            return foreground == _other.foreground
+                && background == _other.background
+                && underline == _other.underline
+                && flags == _other.flags;
+        }
+    };
+
+    struct Entry
+    {
+        Key key{};
+        bool valid = false;
+        ResolvedColors colors{};
+    };
+
+    static constexpr Key makeKey(GraphicsAttributes const& _attributes, bool _reverseVideo) noexcept
+    {
+        return Key{
+            packColor(_attributes.foregroundColor),
+            packColor(_attributes.backgroundColor),
+            packColor(_attributes.underlineColor),
+            (static_cast<uint32_t>(_attributes.styles) & ColorRelevantStyles)
+                | (_reverseVideo ? 0x8000'0000u : 0u)
+        };
+    }
+
+    static constexpr size_t hash(Key const& _key) noexcept
+    {
+        // Cheap multiplicative mixing; good enough to spread the few live keys across the slots.
+        uint64_t h = _key.foreground;
+        h = h * 0x9E3779B97F4A7C15ull ^ _key.background;
+        h = h * 0x9E3779B97F4A7C15ull ^ _key.underline;
+        h = h * 0x9E3779B97F4A7C15ull ^ _key.flags;
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+
+    std::vector<Entry> entries_;
+    uint64_t generation_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+} // end namespace
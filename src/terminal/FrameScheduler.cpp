@@ -0,0 +1,162 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/FrameScheduler.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+
+using namespace std;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+namespace terminal {
+
+// {{{ LatencyHistogram
+void LatencyHistogram::record(chrono::steady_clock::duration _latency) noexcept
+{
+    auto const us = static_cast<uint64_t>(max(duration_cast<microseconds>(_latency).count(), int64_t(0)));
+
+    auto index = size_t{0};
+    while (index + 1 < BucketCount && us >= upperBound(index) * 1000u)
+        ++index;
+
+    ++buckets_[index];
+    ++count_;
+    totalMicroseconds_ += us;
+
+    auto currentMax = maxMicroseconds_.load();
+    while (currentMax < us && !maxMicroseconds_.compare_exchange_weak(currentMax, us))
+        ;
+}
+
+string LatencyHistogram::summary() const
+{
+    auto const n = count();
+    auto result = fmt::format("{} samples, avg {:.2f} ms, max {:.2f} ms",
+                              n,
+                              n ? static_cast<double>(totalMicroseconds_.load()) / static_cast<double>(n) / 1000.0 : 0.0,
+                              static_cast<double>(maxMicroseconds_.load()) / 1000.0);
+
+    for (size_t i = 0; i < BucketCount; ++i)
+    {
+        if (upperBound(i))
+            result += fmt::format(", <{}ms: {}", upperBound(i), bucket(i));
+        else
+            result += fmt::format(", >={}ms: {}", upperBound(i - 1), bucket(i));
+    }
+
+    return result;
+}
+// }}}
+
+// {{{ FrameScheduler
+void FrameScheduler::setRefreshRate(double _refreshRate) noexcept
+{
+    auto const interval = chrono::duration<double>(1.0 / max(_refreshRate, 1.0));
+    refreshInterval_ = max(duration_cast<duration>(interval).count(), duration::rep(1));
+}
+
+int64_t FrameScheduler::periodOf(duration::rep _time) const noexcept
+{
+    auto const elapsed = _time - phase_.load();
+    auto const interval = refreshInterval_.load();
+    return elapsed >= 0 ? elapsed / interval
+                        : (elapsed - interval + 1) / interval;
+}
+
+bool FrameScheduler::frameDue(time_point _now) const noexcept
+{
+    return fastTrack_ || periodOf(_now.time_since_epoch().count()) > periodOf(lastFrame_.load());
+}
+
+FrameScheduler::duration FrameScheduler::timeUntilNextFrame(time_point _now) const noexcept
+{
+    if (frameDue(_now))
+        return duration::zero();
+
+    auto const nextFrame = phase_.load() + (periodOf(lastFrame_.load()) + 1) * refreshInterval_.load();
+    return duration(max(nextFrame - _now.time_since_epoch().count(), duration::rep(0)));
+}
+
+void FrameScheduler::frameIssued(time_point _now) noexcept
+{
+    lastFrame_ = _now.time_since_epoch().count();
+    fastTrack_ = false;
+}
+
+void FrameScheduler::framePresented([[maybe_unused]] uint64_t _frameID, time_point _now) noexcept
+{
+    phase_ = _now.time_since_epoch().count();
+
+#if defined(CONTOUR_PERF_STATS)
+    auto const responseFrameID = responseFrameID_.load();
+    if (!responseFrameID || _frameID < responseFrameID)
+        return;
+
+    inputLatency_.record(_now - time_point(duration(inputTime_.load())));
+    presentLatency_.record(_now - time_point(duration(refreshTime_.load())));
+    inputTime_ = NoTime;
+    outputAfterInput_ = false;
+    responseFrameID_ = 0;
+#endif
+}
+
+void FrameScheduler::inputReceived(time_point _now) noexcept
+{
+    echoInputTime_ = _now.time_since_epoch().count();
+
+#if defined(CONTOUR_PERF_STATS)
+    // Only the oldest input event that has not been responded to yet is measured.
+    auto expected = NoTime;
+    inputTime_.compare_exchange_strong(expected, _now.time_since_epoch().count());
+#endif
+}
+
+bool FrameScheduler::outputReceived(time_point _now) noexcept
+{
+    auto const now = _now.time_since_epoch().count();
+
+#if defined(CONTOUR_PERF_STATS)
+    if (auto const inputTime = inputTime_.load(); inputTime != NoTime && !outputAfterInput_.exchange(true))
+    {
+        outputTime_ = now;
+        responseLatency_.record(duration(now - inputTime));
+    }
+#endif
+
+    // Only the first output after an input event is considered its echo.
+    auto const echoInputTime = echoInputTime_.exchange(NoTime);
+    auto const echoWindow = echoWindow_.load();
+    if (echoWindow == 0 || echoInputTime == NoTime || now - echoInputTime > echoWindow)
+        return false;
+
+    fastTrack_ = true;
+    return true;
+}
+
+void FrameScheduler::frameRefreshed([[maybe_unused]] uint64_t _frameID, [[maybe_unused]] time_point _now) noexcept
+{
+#if defined(CONTOUR_PERF_STATS)
+    auto expected = uint64_t{0};
+    if (outputAfterInput_ && responseFrameID_.compare_exchange_strong(expected, _frameID))
+    {
+        refreshTime_ = _now.time_since_epoch().count();
+        refreshLatency_.record(_now - time_point(duration(outputTime_.load())));
+    }
+#endif
+}
+// }}}
+
+} // end namespace
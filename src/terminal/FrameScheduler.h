@@ -0,0 +1,162 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace terminal {
+
+/// Histogram of latencies, with buckets of power-of-two milliseconds, i.e. below 1ms, below 2ms,
+/// below 4ms, ..., and one bucket for everything above.
+class LatencyHistogram {
+  public:
+    static constexpr size_t BucketCount = 10;
+
+    void record(std::chrono::steady_clock::duration _latency) noexcept;
+
+    /// @returns the number of recorded latencies.
+    uint64_t count() const noexcept { return count_.load(); }
+
+    /// @returns the number of recorded latencies in the given bucket.
+    uint64_t bucket(size_t _index) const noexcept { return buckets_.at(_index).load(); }
+
+    /// @returns the upper bound of the given bucket in milliseconds (or 0 for the last one, as it is unbound).
+    static constexpr unsigned upperBound(size_t _index) noexcept
+    {
+        return _index + 1 < BucketCount ? 1u << _index : 0;
+    }
+
+    /// @returns a one line summary of all recorded latencies.
+    std::string summary() const;
+
+  private:
+    std::array<std::atomic<uint64_t>, BucketCount> buckets_{};
+    std::atomic<uint64_t> count_ = 0;
+    std::atomic<uint64_t> totalMicroseconds_ = 0;
+    std::atomic<uint64_t> maxMicroseconds_ = 0;
+};
+
+/**
+ * Paces render buffer updates to the display's refresh rate.
+ *
+ * Screen updates are coalesced into at most one frame per refresh period, with refresh periods
+ * being aligned to the points in time frames have been presented on the display (i.e. vblank),
+ * unless the next frame has been fast-tracked, e.g. in order to immediately reflect keyboard input.
+ *
+ * The first output of the application received within the echo window after keyboard input
+ * is considered the echo of that input and therefore fast-tracked, such that typing is not
+ * delayed by the refresh rate throttling.
+ *
+ * When built with CONTOUR_PERF_STATS, the frame scheduler also keeps track of the input-to-photon
+ * latency, that is, the time from a keyboard input event until the first frame containing
+ * the application's response to that input has been presented, along with the latencies
+ * of each stage in between (application response, render buffer refresh, presentation).
+ *
+ * All methods are thread-safe, as frames are presented by the render thread whereas
+ * frames are issued by the terminal thread.
+ */
+class FrameScheduler {
+  public:
+    using clock = std::chrono::steady_clock;
+    using time_point = clock::time_point;
+    using duration = clock::duration;
+
+    static constexpr auto DefaultEchoWindow = std::chrono::milliseconds(100);
+
+    explicit FrameScheduler(double _refreshRate) noexcept
+    {
+        setRefreshRate(_refreshRate);
+        setEchoWindow(DefaultEchoWindow);
+    }
+
+    void setRefreshRate(double _refreshRate) noexcept;
+    duration refreshInterval() const noexcept { return duration(refreshInterval_.load()); }
+
+    /// Sets the time after keyboard input within which output is considered its echo,
+    /// with a zero window disabling the fast-tracking of echoes.
+    void setEchoWindow(duration _window) noexcept { echoWindow_ = _window.count(); }
+    duration echoWindow() const noexcept { return duration(echoWindow_.load()); }
+
+    /// Lets the next frame be issued immediately, regardless of the current refresh period.
+    void fastTrack() noexcept { fastTrack_ = true; }
+    bool fastTracked() const noexcept { return fastTrack_.load(); }
+
+    /// @returns whether or not a frame may be issued at the given time.
+    bool frameDue(time_point _now) const noexcept;
+
+    /// @returns the time left until the next frame may be issued.
+    duration timeUntilNextFrame(time_point _now) const noexcept;
+
+    /// Records a frame (render buffer swap) being issued at the given time.
+    void frameIssued(time_point _now) noexcept;
+
+    /// Aligns the refresh periods to the given frame having been presented on the display.
+    void framePresented(uint64_t _frameID, time_point _now) noexcept;
+
+    // {{{ input-to-photon latency tracking
+    /// Records a keyboard input event to be responded to.
+    void inputReceived(time_point _now) noexcept;
+
+    /// Records output of the application, potentially responding to the last input event.
+    ///
+    /// @returns whether the output is considered the echo of the last input event,
+    ///          having the next frame fast-tracked.
+    bool outputReceived(time_point _now) noexcept;
+
+    /// Records the given frame to reflect the current screen contents.
+    void frameRefreshed(uint64_t _frameID, time_point _now) noexcept;
+
+    /// Latency from keyboard input until its response has been presented on the display.
+    LatencyHistogram const& inputLatency() const noexcept { return inputLatency_; }
+
+    /// Latency from keyboard input until the application's response has been received.
+    LatencyHistogram const& responseLatency() const noexcept { return responseLatency_; }
+
+    /// Latency from the application's response until a render buffer containing it has been refreshed.
+    LatencyHistogram const& refreshLatency() const noexcept { return refreshLatency_; }
+
+    /// Latency from that render buffer's refresh until it has been presented on the display.
+    LatencyHistogram const& presentLatency() const noexcept { return presentLatency_; }
+    // }}}
+
+  private:
+    /// @returns the index of the refresh period the given point in time belongs to.
+    int64_t periodOf(duration::rep _time) const noexcept;
+
+    static constexpr auto NoTime = std::numeric_limits<duration::rep>::min() / 2;
+
+    std::atomic<duration::rep> refreshInterval_{};
+    std::atomic<duration::rep> phase_ = 0;              // point in time of the last presented frame
+    std::atomic<duration::rep> lastFrame_ = NoTime;     // point in time of the last issued frame
+    std::atomic<bool> fastTrack_ = false;
+    std::atomic<duration::rep> echoWindow_{};
+    std::atomic<duration::rep> echoInputTime_ = NoTime; // last input event whose echo is awaited
+
+    std::atomic<duration::rep> inputTime_ = NoTime;     // oldest input event without response yet
+    std::atomic<duration::rep> outputTime_ = NoTime;    // first output responding to that input event
+    std::atomic<duration::rep> refreshTime_ = NoTime;   // refresh of the first frame reflecting the response
+    std::atomic<bool> outputAfterInput_ = false;
+    std::atomic<uint64_t> responseFrameID_ = 0;         // first frame reflecting the response to the input
+    LatencyHistogram inputLatency_;
+    LatencyHistogram responseLatency_;
+    LatencyHistogram refreshLatency_;
+    LatencyHistogram presentLatency_;
+};
+
+} // end namespace
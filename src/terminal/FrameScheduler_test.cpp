@@ -0,0 +1,145 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/FrameScheduler.h>
+#include <catch2/catch_all.hpp>
+
+using namespace terminal;
+using namespace std::chrono_literals;
+
+namespace
+{
+    auto const T0 = FrameScheduler::time_point() + 1h;
+}
+
+TEST_CASE("FrameScheduler.coalescing", "[frame]")
+{
+    auto scheduler = FrameScheduler{100.0}; // 10ms refresh period
+    scheduler.framePresented(0, T0);
+
+    CHECK(scheduler.frameDue(T0));
+    scheduler.frameIssued(T0 + 1ms);
+
+    // At most one frame per refresh period.
+    CHECK(!scheduler.frameDue(T0 + 2ms));
+    CHECK(!scheduler.frameDue(T0 + 9ms));
+    CHECK(scheduler.timeUntilNextFrame(T0 + 4ms) == 6ms);
+
+    // Refresh periods are aligned to the last presented frame rather than the last issued one.
+    CHECK(scheduler.frameDue(T0 + 10ms));
+    scheduler.frameIssued(T0 + 19ms);
+    CHECK(scheduler.frameDue(T0 + 20ms));
+
+    scheduler.framePresented(1, T0 + 25ms);
+    CHECK(scheduler.frameDue(T0 + 25ms));
+    CHECK(scheduler.timeUntilNextFrame(T0 + 25ms) == 0ms);
+}
+
+TEST_CASE("FrameScheduler.fastTrack", "[frame]")
+{
+    auto scheduler = FrameScheduler{100.0};
+    scheduler.framePresented(0, T0);
+    scheduler.frameIssued(T0 + 1ms);
+    REQUIRE(!scheduler.frameDue(T0 + 2ms));
+
+    scheduler.fastTrack();
+    CHECK(scheduler.frameDue(T0 + 2ms));
+    CHECK(scheduler.timeUntilNextFrame(T0 + 2ms) == 0ms);
+
+    // Only the next frame is fast-tracked.
+    scheduler.frameIssued(T0 + 3ms);
+    CHECK(!scheduler.frameDue(T0 + 4ms));
+}
+
+TEST_CASE("FrameScheduler.echo", "[frame]")
+{
+    auto scheduler = FrameScheduler{100.0};
+    scheduler.framePresented(0, T0);
+    scheduler.frameIssued(T0 + 1ms);
+
+    // The first output after keyboard input is fast-tracked as its echo.
+    scheduler.inputReceived(T0 + 2ms);
+    REQUIRE(!scheduler.frameDue(T0 + 3ms));
+    CHECK(scheduler.outputReceived(T0 + 3ms));
+    CHECK(scheduler.frameDue(T0 + 3ms));
+    scheduler.frameIssued(T0 + 3ms);
+
+    // Any further output is throttled again.
+    CHECK(!scheduler.outputReceived(T0 + 4ms));
+    CHECK(!scheduler.frameDue(T0 + 4ms));
+
+    // Output arriving after the echo window is not considered an echo.
+    scheduler.inputReceived(T0 + 5ms);
+    CHECK(!scheduler.outputReceived(T0 + 5ms + FrameScheduler::DefaultEchoWindow + 1ms));
+
+    // Fast-tracking echoes can be disabled.
+    scheduler.setEchoWindow(FrameScheduler::duration::zero());
+    scheduler.inputReceived(T0 + 200ms);
+    CHECK(!scheduler.outputReceived(T0 + 201ms));
+    scheduler.inputReceived(T0 + 300ms);
+    CHECK(!scheduler.outputReceived(T0 + 300ms));
+    CHECK(!scheduler.fastTracked());
+}
+
+#if defined(CONTOUR_PERF_STATS)
+TEST_CASE("FrameScheduler.inputLatency", "[frame]")
+{
+    auto scheduler = FrameScheduler{100.0};
+
+    scheduler.inputReceived(T0);
+    scheduler.inputReceived(T0 + 1ms);      // measured from the first unanswered input event
+    scheduler.frameRefreshed(1, T0 + 1ms);  // not containing any response yet
+    scheduler.outputReceived(T0 + 2ms);
+    scheduler.frameRefreshed(2, T0 + 3ms);
+    scheduler.frameRefreshed(3, T0 + 4ms);
+    scheduler.framePresented(1, T0 + 3ms);
+    CHECK(scheduler.inputLatency().count() == 0);
+
+    scheduler.framePresented(3, T0 + 5ms);
+    REQUIRE(scheduler.inputLatency().count() == 1);
+    CHECK(scheduler.inputLatency().bucket(3) == 1); // 4ms .. 8ms
+
+    // Latencies of each stage in between.
+    REQUIRE(scheduler.responseLatency().count() == 1);
+    CHECK(scheduler.responseLatency().bucket(2) == 1); // 2ms .. 4ms
+    REQUIRE(scheduler.refreshLatency().count() == 1);
+    CHECK(scheduler.refreshLatency().bucket(1) == 1); // 1ms .. 2ms (frame 2)
+    REQUIRE(scheduler.presentLatency().count() == 1);
+    CHECK(scheduler.presentLatency().bucket(2) == 1); // 2ms .. 4ms
+
+    // Output without preceding input is not accounted for.
+    scheduler.outputReceived(T0 + 6ms);
+    scheduler.frameRefreshed(4, T0 + 6ms);
+    scheduler.framePresented(4, T0 + 6ms);
+    CHECK(scheduler.inputLatency().count() == 1);
+    CHECK(scheduler.responseLatency().count() == 1);
+}
+#endif
+
+TEST_CASE("LatencyHistogram", "[frame]")
+{
+    auto histogram = LatencyHistogram{};
+    histogram.record(400us);
+    histogram.record(1ms);
+    histogram.record(3ms);
+    histogram.record(300ms);
+
+    CHECK(histogram.count() == 4);
+    CHECK(histogram.bucket(0) == 1);
+    CHECK(histogram.bucket(1) == 1);
+    CHECK(histogram.bucket(2) == 1);
+    CHECK(histogram.bucket(LatencyHistogram::BucketCount - 1) == 1);
+    CHECK(histogram.summary() == "4 samples, avg 76.10 ms, max 300.00 ms"
+                                 ", <1ms: 1, <2ms: 1, <4ms: 1, <8ms: 0, <16ms: 0, <32ms: 0"
+                                 ", <64ms: 0, <128ms: 0, <256ms: 0, >=256ms: 1");
+}
@@ -43,11 +43,83 @@ using std::stringstream;
 
 namespace terminal {
 
+namespace
+{
+    /// Half-open range of indices into functions().
+    struct FunctionRange
+    {
+        uint16_t begin = 0;
+        uint16_t end = 0;
+    };
+
+    constexpr size_t CategoryCount = 5;
+    constexpr size_t FinalSymbolCount = 128;
+    constexpr size_t OSCCodeCount = 1024; // OSC codes are stored in FunctionDefinition::maximumParameters (10 bits).
+
+    /// Dense lookup tables for select(), generated at compile time from the function definitions.
+    struct DispatchTable
+    {
+        /// Functions sharing the same category and final symbol, indexed by [category][final symbol].
+        ///
+        /// As functions() is sorted by category and final symbol first, these are always contiguous
+        /// and only differ in leader, intermediate or parameter count.
+        std::array<std::array<FunctionRange, FinalSymbolCount>, CategoryCount> controls{};
+
+        /// Index into functions() plus one for each OSC code, or 0 if the code is unknown.
+        std::array<uint16_t, OSCCodeCount> osc{};
+    };
+
+    template <typename Functions>
+    constexpr DispatchTable makeDispatchTable(Functions const& _functions)
+    {
+        auto table = DispatchTable{};
+        for (size_t i = 0; i < _functions.size(); ++i)
+        {
+            FunctionDefinition const& f = _functions[i];
+            if (f.category == FunctionCategory::OSC)
+                table.osc[f.maximumParameters] = static_cast<uint16_t>(i + 1);
+            else
+            {
+                auto& range = table.controls[static_cast<size_t>(f.category)][static_cast<uint8_t>(f.finalSymbol)];
+                if (range.begin == range.end)
+                    range.begin = static_cast<uint16_t>(i);
+                range.end = static_cast<uint16_t>(i + 1);
+            }
+        }
+        return table;
+    }
+
+    constexpr auto dispatchTable = makeDispatchTable(detail::makeFunctions());
+}
+
 FunctionDefinition const* select(FunctionSelector const& _selector) noexcept
 {
     auto static const& funcs = functions();
 
-    //std::cout << fmt::format("select: {}\n", _selector);
+    if (_selector.category == FunctionCategory::OSC)
+    {
+        if (_selector.argc < 0 || static_cast<size_t>(_selector.argc) >= OSCCodeCount)
+            return nullptr;
+        if (auto const i = dispatchTable.osc[static_cast<size_t>(_selector.argc)]; i != 0)
+            return &funcs[i - 1];
+        return nullptr;
+    }
+
+    auto const finalSymbol = static_cast<uint8_t>(_selector.finalSymbol);
+    if (finalSymbol >= FinalSymbolCount)
+        return nullptr;
+
+    auto const range = dispatchTable.controls[static_cast<size_t>(_selector.category)][finalSymbol];
+    for (auto i = range.begin; i != range.end; ++i)
+        if (compare(_selector, funcs[i]) == 0)
+            return &funcs[i];
+
+    return nullptr;
+}
+
+FunctionDefinition const* selectBinarySearch(FunctionSelector const& _selector) noexcept
+{
+    auto static const& funcs = functions();
 
     auto a = size_t{0};
     auto b = funcs.size() - 1;
@@ -56,7 +128,6 @@ FunctionDefinition const* select(FunctionSelector const& _selector) noexcept
         auto const i = (a + b) / 2;
         auto const& I = funcs[i];
         auto const rel = compare(_selector, I);
-        //std::cout << fmt::format(" - a:{:>2} b:{:>2} i:{} rel:{} I: {}\n", a, b, i, rel < 0 ? '<' : rel > 0 ? '>' : '=', I);
         if (rel > 0)
             a = i + 1;
         else if (rel < 0)
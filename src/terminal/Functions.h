@@ -324,7 +324,7 @@ constexpr inline auto WINMANIP    = detail::CSI(std::nullopt, 1, 3, std::nullopt
 constexpr inline auto XTSMGRAPHICS= detail::CSI('?', 2, 4, std::nullopt, 'S', VTType::VT525 /*Xterm*/, "XTSMGRAPHICS", "Setting/getting Sixel/ReGIS graphics settings.");
 constexpr inline auto XTSHIFTESCAPE=detail::CSI('>', 0, 1, std::nullopt, 's', VTType::VT525 /*Xterm*/, "XTSHIFTESCAPE", "Set/reset shift-escape options.");
 constexpr inline auto XTVERSION   = detail::CSI('>', 0, 1, std::nullopt, 'q', VTType::VT525 /*Xterm*/, "XTVERSION", "Query terminal name and version");
-constexpr inline auto CAPTURE     = detail::CSI('>', 0, 2, std::nullopt, 't', VTType::VT525 /*Extension*/, "CAPTURE", "Report screen buffer capture.");
+constexpr inline auto CAPTURE     = detail::CSI('>', 0, 3, std::nullopt, 't', VTType::VT525 /*Extension*/, "CAPTURE", "Report screen buffer capture.");
 
 
 // DCS functions
@@ -366,9 +366,11 @@ constexpr inline auto RCOLORHIGHLIGHTBG = detail::OSC(117, "RCOLORHIGHLIGHTBG",
 constexpr inline auto NOTIFY        = detail::OSC(777, "NOTIFY", "Send Notification.");
 constexpr inline auto DUMPSTATE     = detail::OSC(888, "DUMPSTATE", "Dumps internal state to debug stream.");
 
-inline auto const& functions() noexcept
+namespace detail
 {
-    static auto const funcs = []() constexpr { // {{{
+    /// Builds the table of all known functions, sorted via compare().
+    constexpr auto makeFunctions() noexcept
+    { // {{{
         auto f = std::array{
             // C0
             EOT,
@@ -500,7 +502,12 @@ inline auto const& functions() noexcept
         };
         crispy::sort(f, [](FunctionDefinition const& a, FunctionDefinition const& b) constexpr { return compare(a, b); });
         return f;
-    }();  // }}}
+    } // }}}
+}
+
+inline auto const& functions() noexcept
+{
+    static constexpr auto funcs = detail::makeFunctions();
 
 #if 0
     for (auto [a, b] : crispy::indexed(funcs))
@@ -512,9 +519,19 @@ inline auto const& functions() noexcept
 
 /// Selects a FunctionDefinition based on a FunctionSelector.
 ///
+/// This is a constant time lookup into dense tables that are generated at compile time
+/// from functions().
+///
 /// @return the matching FunctionDefinition or nullptr if none matched.
 FunctionDefinition const* select(FunctionSelector const& _selector) noexcept;
 
+/// Selects a FunctionDefinition based on a FunctionSelector by binary searching functions().
+///
+/// This is the reference implementation of select(), used for testing and benchmarking only.
+///
+/// @return the matching FunctionDefinition or nullptr if none matched.
+FunctionDefinition const* selectBinarySearch(FunctionSelector const& _selector) noexcept;
+
 /// Selects a FunctionDefinition based on given input Escape sequence fields.
 ///
 /// @p _intermediate an optional intermediate character between (0x20 .. 0x2F)
@@ -70,3 +70,33 @@ TEST_CASE("Functions.OSC777", "[Functions]")
     REQUIRE(osc);
     CHECK(*osc == NOTIFY);
 }
+
+TEST_CASE("Functions.select_matches_binary_search", "[Functions]")
+{
+    // The dense dispatch table must resolve every possible selector exactly like the binary search does.
+    auto mismatches = std::vector<std::string>{};
+    auto const verify = [&](FunctionSelector const& _selector) {
+        FunctionDefinition const* expected = selectBinarySearch(_selector);
+        FunctionDefinition const* actual = select(_selector);
+        if ((actual == nullptr) != (expected == nullptr) || (expected && *actual != *expected))
+            mismatches.emplace_back(fmt::format("category:{} leader:{} argc:{} intermediate:{} final:{}",
+                                                _selector.category, int(_selector.leader), _selector.argc,
+                                                int(_selector.intermediate), int(_selector.finalSymbol)));
+    };
+
+    for (auto const category: {FunctionCategory::C0, FunctionCategory::ESC, FunctionCategory::CSI, FunctionCategory::DCS})
+        for (char const leader: {'\0', '<', '=', '>', '?'})
+            for (int intermediate = 0x1F; intermediate <= 0x2F; ++intermediate)
+                for (int finalSymbol = 0; finalSymbol < 0x80; ++finalSymbol)
+                    for (int argc = 0; argc <= 16; ++argc)
+                        verify(FunctionSelector{category,
+                                                leader,
+                                                argc,
+                                                static_cast<char>(intermediate == 0x1F ? 0 : intermediate),
+                                                static_cast<char>(finalSymbol)});
+
+    for (int code = 0; code < 1100; ++code)
+        verify(FunctionSelector{FunctionCategory::OSC, 0, code, 0, 0});
+
+    CHECK(mismatches == std::vector<std::string>{});
+}
@@ -20,9 +20,11 @@
 #include <unicode/convert.h>
 
 #include <algorithm>
+#include <array>
 #include <iostream>
 #include <optional>
 #include <sstream>
+#include <string_view>
 #include <tuple>
 #include <utility>
 
@@ -33,6 +35,7 @@ using std::fill_n;
 using std::for_each;
 using std::front_inserter;
 using std::generate_n;
+using std::max;
 using std::min;
 using std::move;
 using std::next;
@@ -42,6 +45,7 @@ using std::prev;
 using std::reverse;
 using std::rotate;
 using std::string;
+using std::string_view;
 using std::tuple;
 
 #if defined(LIBTERMINAL_EXECUTION_PAR)
@@ -64,6 +68,21 @@ namespace // {{{ helper
             _cell.codepointCount() == 0;
     }
 
+    /// Moves the cells within the given column range from @p _source to @p _target,
+    /// which avoids touching the reference counts of images (as copying would do).
+    void moveColumns(Line& _source, Line& _target, Margin::Range _columns)
+    {
+        auto const first = next(begin(_source), _columns.from - 1);
+        std::move(first, next(first, _columns.length()), next(begin(_target), _columns.from - 1));
+    }
+
+    /// Resets the cells within the given column range in place.
+    void resetColumns(Line& _line, Margin::Range _columns, GraphicsAttributes const& _attributes)
+    {
+        for (Cell& cell: crispy::range(next(begin(_line), _columns.from - 1), next(begin(_line), _columns.to)))
+            cell.reset(_attributes);
+    }
+
     template <typename... Args>
     void logf([[maybe_unused]] Args&&... _args)
     {
@@ -84,29 +103,29 @@ string Cell::toUtf8() const
 // }}}
 // {{{ Line impl
 Line::Line(Buffer&& _init, Flags _flags) :
-    buffer_{ move(_init) },
+    buffer_{ std::make_shared<Buffer>(move(_init)) },
     flags_{ static_cast<unsigned>(_flags) }
 {
 }
 
 Line::Line(iterator const& _begin, iterator const& _end, Flags _flags) :
-    buffer_(_begin, _end),
+    buffer_{ std::make_shared<Buffer>(_begin, _end) },
     flags_{ static_cast<unsigned>(_flags) }
 {
 }
 
 Line::Line(ColumnCount _numCols, Buffer&& _init, Flags _flags) :
-    buffer_{move(_init)},
+    buffer_{ std::make_shared<Buffer>(move(_init)) },
     flags_{ static_cast<unsigned>(_flags) }
 {
-    buffer_.resize(unbox<size_t>(_numCols));
+    buffer_->resize(unbox<size_t>(_numCols));
 }
 
 Line::Line(ColumnCount _numCols, std::string_view const& _s, Flags _flags) :
     Line(_numCols, Cell{}, _flags)
 {
     for (auto const [i, ch] : crispy::indexed(_s))
-        buffer_.at(i).setCharacter(static_cast<char32_t>(ch));
+        buffer_->at(i).setCharacter(static_cast<char32_t>(ch));
 }
 
 string Line::toUtf8() const
@@ -137,23 +156,25 @@ string Line::toUtf8Trimmed() const
 
 void Line::prepend(Buffer const& _cells)
 {
-    buffer_.insert(buffer_.begin(), _cells.begin(), _cells.end());
+    Buffer& buffer = mutableBuffer();
+    buffer.insert(buffer.begin(), _cells.begin(), _cells.end());
 }
 
 void Line::append(Buffer const& _cells)
 {
-    buffer_.insert(buffer_.end(), _cells.begin(), _cells.end());
+    Buffer& buffer = mutableBuffer();
+    buffer.insert(buffer.end(), _cells.begin(), _cells.end());
 }
 
 void Line::append(int _count, Cell const& _initial)
 {
-    fill_n(back_inserter(buffer_), _count, _initial);
+    fill_n(back_inserter(mutableBuffer()), _count, _initial);
 }
 
 crispy::range<Line::const_iterator> Line::trim_blank_right() const
 {
-    auto i = buffer_.cbegin();
-    auto e = buffer_.cend();
+    auto i = buffer_->cbegin();
+    auto e = buffer_->cend();
 
     while (i != e && is_blank(*prev(e)))
         e = prev(e);
@@ -164,8 +185,8 @@ crispy::range<Line::const_iterator> Line::trim_blank_right() const
 Line::Buffer Line::shift_left(int _count, Cell const& _fill)
 {
     auto const actualShiftCount = min(_count, unbox<int>(size()));
-    auto const from = std::begin(buffer_);
-    auto const to = std::next(std::begin(buffer_), actualShiftCount);
+    auto const from = begin();
+    auto const to = std::next(from, actualShiftCount);
 
     auto out = remove(from, to);
     append(actualShiftCount, _fill);
@@ -180,20 +201,20 @@ Line::Buffer Line::shift_left(int _count, Cell const& _fill)
 Line::Buffer Line::remove(iterator const& _from, iterator const& _to)
 {
     auto removedColumns = Buffer(_from, _to);
-    buffer_.erase(_from, _to);
+    mutableBuffer().erase(_from, _to);
     return removedColumns;
 }
 
 void Line::setText(std::string_view _u8string)
 {
     for (auto const [i, ch] : crispy::indexed(unicode::convert_to<char32_t>(_u8string)))
-        buffer_.at(i).setCharacter(ch);
+        mutableBuffer().at(i).setCharacter(ch);
 }
 
 void Line::resize(ColumnCount _size)
 {
     assert(*_size >= 0);
-    buffer_.resize(unbox<size_t>(_size));
+    mutableBuffer().resize(unbox<size_t>(_size));
 }
 
 bool Line::blank() const noexcept
@@ -208,7 +229,7 @@ Line::Buffer Line::reflow(ColumnCount _newColumnCount)
         case Comparison::Equal:
             break;
         case Comparison::Greater:
-            buffer_.resize(unbox<size_t>(_newColumnCount));
+            mutableBuffer().resize(unbox<size_t>(_newColumnCount));
             break;
         case Comparison::Less:
         {
@@ -218,10 +239,11 @@ Line::Buffer Line::reflow(ColumnCount _newColumnCount)
 
             if (wrappable())
             {
-                auto const [reflowStart, reflowEnd] = [this, _newColumnCount]()
+                Buffer& buffer = mutableBuffer();
+                auto const [reflowStart, reflowEnd] = [&buffer, _newColumnCount]()
                 {
-                    auto const reflowStart = next(buffer_.begin(), *_newColumnCount /* - buffer_[_newColumnCount].width()*/);
-                    auto reflowEnd = buffer_.end();
+                    auto const reflowStart = next(buffer.begin(), *_newColumnCount /* - buffer[_newColumnCount].width()*/);
+                    auto reflowEnd = buffer.end();
 
                     while (reflowEnd != reflowStart && is_blank(*prev(reflowEnd)))
                         reflowEnd = prev(reflowEnd);
@@ -230,14 +252,14 @@ Line::Buffer Line::reflow(ColumnCount _newColumnCount)
                 }();
 
                 auto removedColumns = Buffer(reflowStart, reflowEnd);
-                buffer_.erase(reflowStart, buffer_.end());
+                buffer.erase(reflowStart, buffer.end());
                 assert(size() == _newColumnCount);
                 return removedColumns;
             }
             else
             {
-                auto const reflowStart = next(buffer_.cbegin(), *_newColumnCount);
-                buffer_.erase(reflowStart, buffer_.end());
+                Buffer& buffer = mutableBuffer();
+                buffer.erase(next(buffer.cbegin(), *_newColumnCount), buffer.end());
                 assert(size() == _newColumnCount);
                 return {};
             }
@@ -299,42 +321,207 @@ void addNewWrappedLines(Lines& _targetLines,
     }
 }
 
+namespace // {{{ reflow helpers
+{
+    /// Reflows the given lines to a wider @p _newColumnCount by joining wrapped lines
+    /// back into their logical lines and splitting these at the new width.
+    Lines joinWrappedLines(Lines& _lines, ColumnCount _newColumnCount)
+    {
+        Lines grownLines;
+        Line::Buffer logicalLineBuffer; // Temporary state, representing wrapped columns from the line "below".
+        Line::Flags logicalLineFlags = Line::Flags::None;
+
+        [[maybe_unused]] auto i = 1;
+        for (Line& line : _lines)
+        {
+            logf("{:>2}: line: '{}' (wrapped: '{}') {}",
+                 i++,
+                 line.toUtf8(),
+                 Line(Line::Buffer(logicalLineBuffer), line.flags()).toUtf8(),
+                 line.wrapped() ? "WRAPPED" : "");
+
+            if (line.wrapped())
+            {
+                crispy::copy(line.trim_blank_right(), back_inserter(logicalLineBuffer));
+                logf(" - join: '{}'", Line(Line::Buffer(logicalLineBuffer), line.flags()).toUtf8());
+            }
+            else // line is not wrapped
+            {
+                if (!logicalLineBuffer.empty())
+                {
+                    addNewWrappedLines(grownLines, _newColumnCount, move(logicalLineBuffer), logicalLineFlags, true);
+                    logicalLineBuffer.clear();
+                }
+
+                crispy::copy(line, back_inserter(logicalLineBuffer));
+                logicalLineFlags = line.wrappableFlag() | line.markedFlag();
+
+                logf(" - start new logical line: '{}'", line.toUtf8());
+            }
+        }
+
+        if (!logicalLineBuffer.empty())
+        {
+            addNewWrappedLines(grownLines, _newColumnCount, move(logicalLineBuffer), logicalLineFlags, true);
+            logicalLineBuffer.clear();
+        }
+
+        return grownLines;
+    }
+
+    /// Reflows the given lines to a narrower @p _newColumnCount by wrapping the overflowing
+    /// columns of each line into the line below.
+    Lines splitOverflowingLines(Lines& _lines, ColumnCount _newColumnCount)
+    {
+        // {{{ Shrinking progress
+        // -----------------------------------------------------------------------
+        //  (one-by-one)        | (from-5-to-2)
+        // -----------------------------------------------------------------------
+        // "ABCDE"              | "ABCDE"
+        // "abcde"              | "xy   "
+        // ->                   | "abcde"
+        // "ABCD"               | ->
+        // "E   "   Wrapped     | "AB"                  push "AB", wrap "CDE"
+        // "abcd"               | "CD"      Wrapped     push "CD", wrap "E"
+        // "e   "   Wrapped     | "E"       Wrapped     push "E",  inc line
+        // ->                   | "xy"      no-wrapped  push "xy", inc line
+        // "ABC"                | "ab"      no-wrapped  push "ab", wrap "cde"
+        // "DE "    Wrapped     | "cd"      Wrapped     push "cd", wrap "e"
+        // "abc"                | "e "      Wrapped     push "e",  inc line
+        // "de "    Wrapped
+        // ->
+        // "AB"
+        // "DE"     Wrapped
+        // "E "     Wrapped
+        // "ab"
+        // "cd"     Wrapped
+        // "e "     Wrapped
+        // }}}
+
+        Lines shrinkedLines;
+        Line::Buffer wrappedColumns;
+        Line::Flags previousFlags = _lines.front().inheritableFlags();
+
+        int i = 0;
+        for (Line& line : _lines)
+        {
+            logf("shrink line {}: \"{}\" wrapped: \"{}\"",
+                i,
+                line.toUtf8(),
+                Line(Line::Buffer(wrappedColumns), previousFlags).toUtf8()
+            );
+            // do we have previous columns carried?
+            if (!wrappedColumns.empty())
+            {
+                if (line.wrapped() && line.inheritableFlags() == previousFlags)
+                {
+                    assert(previousFlags == line.inheritableFlags());
+                    // Prepend previously wrapped columns into current line.
+                    line.prepend(wrappedColumns);
+                }
+                else
+                {
+                    // Insert NEW line(s) between previous and this line with previously wrapped columns.
+                    addNewWrappedLines(shrinkedLines, _newColumnCount, move(wrappedColumns), previousFlags, false);
+                    previousFlags = line.inheritableFlags();
+                }
+            }
+            else
+            {
+                previousFlags = line.inheritableFlags();
+            }
+
+            wrappedColumns = line.reflow(_newColumnCount);
+
+            logf(" - ADD LINE: '{}' ({}) wrapped: \"{}\"", line.toUtf8(), line.flags(),
+                Line(Line::Buffer(wrappedColumns), Line::Flags::None).toUtf8());
+
+            shrinkedLines.emplace_back(move(line));
+            assert(shrinkedLines.back().size() >= _newColumnCount);
+            i++;
+        }
+        addNewWrappedLines(shrinkedLines, _newColumnCount, move(wrappedColumns), previousFlags, false);
+
+        return shrinkedLines;
+    }
+
+    /// Reflows the given lines, which all share the same width, to @p _newColumnCount.
+    Lines reflowLines(Lines& _lines, ColumnCount _newColumnCount)
+    {
+        switch (crispy::strongCompare(_newColumnCount, _lines.front().size()))
+        {
+            case Comparison::Greater:
+                return joinWrappedLines(_lines, _newColumnCount);
+            case Comparison::Less:
+                return splitOverflowingLines(_lines, _newColumnCount);
+            case Comparison::Equal:
+                break;
+        }
+        return move(_lines);
+    }
+} // }}}
+
 void Grid::setMaxHistoryLineCount(optional<LineCount> _maxHistoryLineCount)
 {
     maxHistoryLineCount_ = _maxHistoryLineCount;
     clampHistory();
 }
 
-// TODO: rename to include word Logical
-/**
- * Computes the relative line number for the bottom-most @p _n logical lines.
- */
 int Grid::computeRelativeLineNumberFromBottom(int _n) const noexcept
 {
-    int logicalLineCount = 0;
-    auto outputRelativePhysicalLine = unbox<int>(screenSize_.lines);
+    // The main page's lines may still change, so they are walked bottom up,
+    // whereas the remaining logical lines are looked up in the scrollback's index.
+    auto logicalLineCount = 0;
+    for (int row = unbox<int>(screenSize_.lines); row > 0; --row)
+        if (!lineAt(row).wrapped() && ++logicalLineCount == _n)
+            return row;
+
+    auto const topMostLine = 1 - unbox<int>(historyLineCount());
+    auto const remaining = _n - logicalLineCount;
+
+    updateLogicalLineIndex();
+    if (remaining <= 0 || static_cast<size_t>(remaining) > logicalLineStarts_.size())
+        return topMostLine;
+
+    auto const serial = logicalLineStarts_[logicalLineStarts_.size() - static_cast<size_t>(remaining)];
+    return topMostLine + static_cast<int>(serial - topLineSerial_);
+}
 
-    auto i = lines_.rbegin();
-    while (i != lines_.rend())
+LogicalLineRange Grid::logicalLineRange(int _absoluteLine) const
+{
+    auto const historyLines = unbox<int>(historyLineCount());
+    auto const totalLines = static_cast<int>(lines_.size());
+    auto const inMainPage = [&](int _line) { return _line >= historyLines; };
+
+    assert(crispy::ascending(0, _absoluteLine, totalLines - 1));
+
+    auto range = LogicalLineRange{_absoluteLine, _absoluteLine};
+
+    while (range.first > 0 && inMainPage(range.first) && absoluteLineAt(range.first).wrapped())
+        --range.first;
+
+    if (!inMainPage(range.first) || !inMainPage(range.last))
+        updateLogicalLineIndex();
+
+    if (!inMainPage(range.first))
     {
-        if (!i->wrapped())
-            logicalLineCount++;
-        outputRelativePhysicalLine--;
-        ++i;
-        if (logicalLineCount == _n)
-            break;
+        // The logical line starts at the last indexed start at or above the given line.
+        auto const i = upper_bound(logicalLineStarts_.begin(), logicalLineStarts_.end(), topLineSerial_ + range.first);
+        range.first = i != logicalLineStarts_.begin() ? static_cast<int>(*prev(i) - topLineSerial_) : 0;
     }
 
-    // XXX If the top-most logical line is reached, we still need to traverse upwards until the
-    // beginning of the top-most logical line (the one that does not have the wrapped-flag set).
-    while (i != lines_.rend() && i->wrapped())
+    if (!inMainPage(range.last))
     {
-        printf("further upwards: l %d, p %d\n", logicalLineCount, outputRelativePhysicalLine);
-        outputRelativePhysicalLine--;
-        ++i;
+        // The logical line ends right above the next indexed start, if any, or otherwise
+        // continues into the main page.
+        auto const i = upper_bound(logicalLineStarts_.begin(), logicalLineStarts_.end(), topLineSerial_ + range.last);
+        range.last = i != logicalLineStarts_.end() ? static_cast<int>(*i - topLineSerial_) - 1 : historyLines - 1;
     }
 
-    return outputRelativePhysicalLine;
+    while (range.last + 1 < totalLines && inMainPage(range.last + 1) && absoluteLineAt(range.last + 1).wrapped())
+        ++range.last;
+
+    return range;
 }
 
 Coordinate Grid::resize(PageSize _newSize, Coordinate _currentCursorPos, bool _wrapPending)
@@ -345,6 +532,8 @@ Coordinate Grid::resize(PageSize _newSize, Coordinate _currentCursorPos, bool _w
         // or create new ones until screenSize_.lines == _newHeight.
 
         auto const extendCount = _newHeight - screenSize_.lines;
+        if (historyLineCount() < extendCount)
+            reflowPendingLines(extendCount - historyLineCount());
         auto const rowsToTakeFromSavedLines = min(extendCount, historyLineCount());
         auto const fillLineCount = extendCount - rowsToTakeFromSavedLines;
         auto const wrappableFlag = lines_.back().wrappableFlag();
@@ -359,6 +548,7 @@ Coordinate Grid::resize(PageSize _newSize, Coordinate _currentCursorPos, bool _w
         );
 
         screenSize_.lines = _newHeight;
+        trimLogicalLineIndex();
 
         return Coordinate{unbox<int>(rowsToTakeFromSavedLines), 0};
     };
@@ -404,48 +594,14 @@ Coordinate Grid::resize(PageSize _newSize, Coordinate _currentCursorPos, bool _w
 
             logf("Growing by {} cols", extendCount);
 
-            Lines grownLines;
-            Line::Buffer logicalLineBuffer; // Temporary state, representing wrapped columns from the line "below".
-            Line::Flags logicalLineFlags = Line::Flags::None;
-
-            [[maybe_unused]] auto i = 1;
-            for (Line& line : lines_)
-            {
-                logf("{:>2}: line: '{}' (wrapped: '{}') {}",
-                     i++,
-                     line.toUtf8(),
-                     Line(Line::Buffer(logicalLineBuffer), line.flags()).toUtf8(),
-                     line.wrapped() ? "WRAPPED" : "");
-                assert(line.size() >= screenSize_.columns);
-
-                if (line.wrapped())
-                {
-                    crispy::copy(line.trim_blank_right(), back_inserter(logicalLineBuffer));
-                    logf(" - join: '{}'", Line(Line::Buffer(logicalLineBuffer), line.flags()).toUtf8());
-                }
-                else // line is not wrapped
-                {
-                    if (!logicalLineBuffer.empty())
-                    {
-                        addNewWrappedLines(grownLines, _newColumnCount, move(logicalLineBuffer), logicalLineFlags, true);
-                        logicalLineBuffer.clear();
-                    }
-
-                    crispy::copy(line, back_inserter(logicalLineBuffer));
-                    logicalLineFlags = line.wrappableFlag() | line.markedFlag();
-
-                    logf(" - start new logical line: '{}'", line.toUtf8());
-                }
-            }
-
-            if (!logicalLineBuffer.empty())
-            {
-                addNewWrappedLines(grownLines, _newColumnCount, move(logicalLineBuffer), logicalLineFlags, true);
-                logicalLineBuffer.clear();
-            }
-
-            lines_ = move(grownLines);
+            deferHistoryReflow();
+            lines_ = joinWrappedLines(lines_, _newColumnCount);
             screenSize_.columns = _newColumnCount;
+            invalidateLogicalLineIndex();
+
+            // Fill up the main page with older lines first, if it became underfull by joining lines.
+            if (*historyLineCount() < 0)
+                reflowPendingLines(LineCount(-*historyLineCount()));
 
             //auto diff = int(lines_.size()) - unbox<int>(screenSize_.lines);
             auto cy = 0;
@@ -472,78 +628,10 @@ Coordinate Grid::resize(PageSize _newSize, Coordinate _currentCursorPos, bool _w
         }
         else
         {
-            // {{{ Shrinking progress
-            // -----------------------------------------------------------------------
-            //  (one-by-one)        | (from-5-to-2)
-            // -----------------------------------------------------------------------
-            // "ABCDE"              | "ABCDE"
-            // "abcde"              | "xy   "
-            // ->                   | "abcde"
-            // "ABCD"               | ->
-            // "E   "   Wrapped     | "AB"                  push "AB", wrap "CDE"
-            // "abcd"               | "CD"      Wrapped     push "CD", wrap "E"
-            // "e   "   Wrapped     | "E"       Wrapped     push "E",  inc line
-            // ->                   | "xy"      no-wrapped  push "xy", inc line
-            // "ABC"                | "ab"      no-wrapped  push "ab", wrap "cde"
-            // "DE "    Wrapped     | "cd"      Wrapped     push "cd", wrap "e"
-            // "abc"                | "e "      Wrapped     push "e",  inc line
-            // "de "    Wrapped
-            // ->
-            // "AB"
-            // "DE"     Wrapped
-            // "E "     Wrapped
-            // "ab"
-            // "cd"     Wrapped
-            // "e "     Wrapped
-            // }}}
-
-            Lines shrinkedLines;
-            Line::Buffer wrappedColumns;
-            Line::Flags previousFlags = lines_.front().inheritableFlags();
-
-            int i = 0;
-            for (Line& line : lines_)
-            {
-                logf("shrink line {}: \"{}\" wrapped: \"{}\"",
-                    i,
-                    line.toUtf8(),
-                    Line(Line::Buffer(wrappedColumns), previousFlags).toUtf8()
-                );
-                // do we have previous columns carried?
-                if (!wrappedColumns.empty())
-                {
-                    if (line.wrapped() && line.inheritableFlags() == previousFlags)
-                    {
-                        assert(previousFlags == line.inheritableFlags());
-                        // Prepend previously wrapped columns into current line.
-                        line.prepend(wrappedColumns);
-                    }
-                    else
-                    {
-                        // Insert NEW line(s) between previous and this line with previously wrapped columns.
-                        addNewWrappedLines(shrinkedLines, _newColumnCount, move(wrappedColumns), previousFlags, false);
-                        previousFlags = line.inheritableFlags();
-                    }
-                }
-                else
-                {
-                    previousFlags = line.inheritableFlags();
-                }
-
-                wrappedColumns = line.reflow(_newColumnCount);
-
-                auto const wrappedLine = Line(Line::Buffer(wrappedColumns), Line::Flags::None);
-                logf(" - ADD LINE: '{}' ({}) wrapped: \"{}\"", line.toUtf8(), line.flags(),
-                    Line(Line::Buffer(wrappedColumns), Line::Flags::None).toUtf8());
-
-                shrinkedLines.emplace_back(move(line));
-                assert(shrinkedLines.back().size() >= _newColumnCount);
-                i++;
-            }
-            addNewWrappedLines(shrinkedLines, _newColumnCount, move(wrappedColumns), previousFlags, false);
-
-            lines_ = move(shrinkedLines);
+            deferHistoryReflow();
+            lines_ = splitOverflowingLines(lines_, _newColumnCount);
             screenSize_.columns = _newColumnCount;
+            invalidateLogicalLineIndex();
 
             return _cursor; // TODO
         }
@@ -580,6 +668,62 @@ Coordinate Grid::resize(PageSize _newSize, Coordinate _currentCursorPos, bool _w
     return cursorPosition;
 }
 
+void Grid::deferHistoryReflow()
+{
+    if (historyLineCount() <= ImmediateReflowLineCount)
+        return;
+
+    // Split at the beginning of the logical line that the immediately reflowed area starts with.
+    auto split = next(lines_.begin(), unbox<long>(historyLineCount() - ImmediateReflowLineCount));
+    while (split != lines_.begin() && split->wrapped())
+        --split;
+
+    pendingReflow_.insert(pendingReflow_.end(),
+                          std::make_move_iterator(lines_.begin()),
+                          std::make_move_iterator(split));
+    lines_.erase(lines_.begin(), split);
+}
+
+LineCount Grid::reflowPendingLines(LineCount _minimum)
+{
+    auto const previousHistoryLineCount = historyLineCount();
+    auto reflowedLineCount = LineCount(0);
+
+    while (!pendingReflow_.empty() && reflowedLineCount < _minimum)
+    {
+        // Reflow the bottom most logical line, which may span multiple (wrapped) lines,
+        // but always share the same width.
+        auto first = prev(pendingReflow_.end());
+        while (first != pendingReflow_.begin() && first->wrapped())
+            --first;
+
+        auto logicalLine = Lines(std::make_move_iterator(first), std::make_move_iterator(pendingReflow_.end()));
+        pendingReflow_.erase(first, pendingReflow_.end());
+
+        auto reflowed = reflowLines(logicalLine, screenSize_.columns);
+        reflowedLineCount += LineCount::cast_from(reflowed.size());
+        lines_.insert(lines_.begin(),
+                      std::make_move_iterator(reflowed.begin()),
+                      std::make_move_iterator(reflowed.end()));
+    }
+
+    // Keep the logical line index valid by indexing the prepended lines, too.
+    topLineSerial_ -= unbox<long>(reflowedLineCount);
+    if (reflowedLineCount <= historyLineCount())
+    {
+        for (int i = unbox<int>(reflowedLineCount) - 1; i >= 0; --i)
+            if (!absoluteLineAt(i).wrapped())
+                logicalLineStarts_.push_front(topLineSerial_ + i);
+        indexedLineCount_ += reflowedLineCount;
+    }
+    else
+        invalidateLogicalLineIndex();
+
+    clampHistory();
+
+    return historyLineCount() - previousHistoryLineCount;
+}
+
 void Grid::appendNewLines(LineCount _count, GraphicsAttributes _attr)
 {
     auto const wrappableFlag = lines_.back().wrappableFlag();
@@ -596,6 +740,7 @@ void Grid::appendNewLines(LineCount _count, GraphicsAttributes _attr)
             line.reset(_attr);
             lines_.emplace_back(move(line));
         }
+        logicalLinesEvicted(_count);
         return;
     }
 
@@ -612,8 +757,12 @@ void Grid::appendNewLines(LineCount _count, GraphicsAttributes _attr)
 
 void Grid::clearHistory()
 {
-    if (*historyLineCount())
-        lines_.erase(begin(lines_), next(begin(lines_), *historyLineCount()));
+    pendingReflow_.clear();
+    if (auto const n = historyLineCount(); *n > 0)
+    {
+        lines_.erase(begin(lines_), next(begin(lines_), *n));
+        logicalLinesEvicted(n);
+    }
 }
 
 void Grid::clampHistory()
@@ -626,6 +775,9 @@ void Grid::clampHistory()
     if (actual < maxHistoryLines)
         return;
 
+    // Lines that are still pending to be reflowed are older than any line in the history.
+    pendingReflow_.clear();
+
     auto const diff = actual - maxHistoryLines;
 
     // any line that moves into history is using the default Wrappable flag.
@@ -642,8 +794,49 @@ void Grid::clampHistory()
     }
 
     lines_.erase(begin(lines_), next(begin(lines_), unbox<long>(diff)));
+    logicalLinesEvicted(diff);
+}
+
+// {{{ logical line index
+void Grid::updateLogicalLineIndex() const
+{
+    trimLogicalLineIndex();
+
+    // Scrollback lines do not change anymore, so only lines newly moved into the scrollback need indexing.
+    auto const historyLines = unbox<int>(historyLineCount());
+    for (auto line = unbox<int>(indexedLineCount_); line < historyLines; ++line)
+        if (!absoluteLineAt(line).wrapped())
+            logicalLineStarts_.push_back(topLineSerial_ + line);
+    indexedLineCount_ = max(indexedLineCount_, historyLineCount());
+}
+
+void Grid::trimLogicalLineIndex() const
+{
+    auto const historyLines = max(historyLineCount(), LineCount(0));
+    if (indexedLineCount_ <= historyLines)
+        return;
+
+    auto const end = topLineSerial_ + unbox<long>(historyLines);
+    while (!logicalLineStarts_.empty() && logicalLineStarts_.back() >= end)
+        logicalLineStarts_.pop_back();
+    indexedLineCount_ = historyLines;
 }
 
+void Grid::logicalLinesEvicted(LineCount _count)
+{
+    topLineSerial_ += unbox<long>(_count);
+    indexedLineCount_ = max(indexedLineCount_ - _count, LineCount(0));
+    while (!logicalLineStarts_.empty() && logicalLineStarts_.front() < topLineSerial_)
+        logicalLineStarts_.pop_front();
+}
+
+void Grid::invalidateLogicalLineIndex() noexcept
+{
+    indexedLineCount_ = LineCount(0);
+    logicalLineStarts_.clear();
+}
+// }}}
+
 void Grid::scrollUp(LineCount _n, GraphicsAttributes const& _defaultAttributes, Margin const& _margin)
 {
     if (_margin.horizontal != Margin::Range{1, unbox<int>(screenSize_.columns)})
@@ -659,40 +852,14 @@ void Grid::scrollUp(LineCount _n, GraphicsAttributes const& _defaultAttributes,
             auto const bottomLine = next(begin(mainPage()), _margin.vertical.to);     // bottom margin's end-line iterator
 
             for (; sourceLine != bottomLine; ++sourceLine, ++targetLine)
-            {
-                copy_n(
-                    next(begin(*sourceLine), _margin.horizontal.from - 1),
-                    _margin.horizontal.length(),
-                    next(begin(*targetLine), _margin.horizontal.from - 1)
-                );
-            }
+                moveColumns(*sourceLine, *targetLine, _margin.horizontal);
         }
 
         // clear bottom n lines in margin.
         auto const topLine = next(begin(mainPage()), _margin.vertical.to - *n);
         auto const bottomLine = next(begin(mainPage()), _margin.vertical.to);     // bottom margin's end-line iterator
-#if 1
         for (Line& line : crispy::range(topLine, bottomLine))
-        {
-            fill_n(
-                next(begin(line), _margin.horizontal.from - 1),
-                _margin.horizontal.length(),
-                Cell{{}, _defaultAttributes}
-            );
-        }
-#else
-        for_each(
-            topLine,
-            bottomLine,
-            [&](Line& line) {
-                fill_n(
-                    next(begin(line), _margin.horizontal.from - 1),
-                    _margin.horizontal.length(),
-                    Cell{{}, _defaultAttributes}
-                );
-            }
-        );
-#endif
+            resetColumns(line, _margin.horizontal, _defaultAttributes);
     }
     else if (_margin.vertical == Margin::Range{1, unbox<int>(screenSize_.lines)})
     {
@@ -703,7 +870,8 @@ void Grid::scrollUp(LineCount _n, GraphicsAttributes const& _defaultAttributes,
     }
     else
     {
-        // scroll up only inside vertical margin with full horizontal extend
+        // scroll up only inside vertical margin with full horizontal extend,
+        // by rotating the lines rather than copying their cells.
         auto const marginHeight = LineCount(_margin.vertical.length());
         auto const n = min(_n, marginHeight);
         if (n < marginHeight)
@@ -719,9 +887,7 @@ void Grid::scrollUp(LineCount _n, GraphicsAttributes const& _defaultAttributes,
             LIBTERMINAL_EXECUTION_COMMA(par)
             next(begin(mainPage()), _margin.vertical.to - *n),
             next(begin(mainPage()), _margin.vertical.to),
-            [&](Line& line) {
-                fill(begin(line), end(line), Cell{{}, _defaultAttributes});
-            }
+            [&](Line& line) { line.reset(_defaultAttributes); }
         );
     }
 }
@@ -736,54 +902,18 @@ void Grid::scrollDown(LineCount v_n, GraphicsAttributes const& _defaultAttribute
         // full "inside" scroll-down
         if (n < marginHeight)
         {
-            auto sourceLine = next(begin(mainPage()), _margin.vertical.to - *n - 1);
-            auto targetLine = next(begin(mainPage()), _margin.vertical.to - 1);
-            auto const sourceEndLine = next(begin(mainPage()), _margin.vertical.from - 1);
-
-            while (sourceLine != sourceEndLine)
-            {
-                copy_n(
-                    next(begin(*sourceLine), _margin.horizontal.from - 1),
-                    _margin.horizontal.length(),
-                    next(begin(*targetLine), _margin.horizontal.from - 1)
-                );
-                --targetLine;
-                --sourceLine;
-            }
-
-            copy_n(
-                next(begin(*sourceLine), _margin.horizontal.from - 1),
-                _margin.horizontal.length(),
-                next(begin(*targetLine), _margin.horizontal.from - 1)
-            );
+            auto sourceLine = next(begin(mainPage()), _margin.vertical.to - *n);    // past the bottom source line
+            auto targetLine = next(begin(mainPage()), _margin.vertical.to);         // past the bottom target line
+            auto const topLine = next(begin(mainPage()), _margin.vertical.from - 1);
 
-            for_each(
-                next(begin(mainPage()), _margin.vertical.from - 1),
-                next(begin(mainPage()), _margin.vertical.from - 1 + *n),
-                [&](Line& line) {
-                    fill_n(
-                        next(begin(line), _margin.horizontal.from - 1),
-                        _margin.horizontal.length(),
-                        Cell{{}, _defaultAttributes}
-                    );
-                }
-            );
-        }
-        else
-        {
-            // clear everything in margin
-            for_each(
-                next(begin(mainPage()), _margin.vertical.from - 1),
-                next(begin(mainPage()), _margin.vertical.to),
-                [&](Line& line) {
-                    fill_n(
-                        next(begin(line), _margin.horizontal.from - 1),
-                        _margin.horizontal.length(),
-                        Cell{{}, _defaultAttributes}
-                    );
-                }
-            );
+            while (sourceLine != topLine)
+                moveColumns(*--sourceLine, *--targetLine, _margin.horizontal);
         }
+
+        // clear top n lines in margin (that is, everything if n exceeds the margin).
+        for (Line& line : crispy::range(next(begin(mainPage()), _margin.vertical.from - 1),
+                                        next(begin(mainPage()), _margin.vertical.from - 1 + *n)))
+            resetColumns(line, _margin.horizontal, _defaultAttributes);
     }
     else if (_margin.vertical == Margin::Range{1, *screenSize_.lines})
     {
@@ -796,18 +926,13 @@ void Grid::scrollDown(LineCount v_n, GraphicsAttributes const& _defaultAttribute
         for_each(
             begin(mainPage()),
             next(begin(mainPage()), *n),
-            [&](Line& line) {
-                fill(
-                    begin(line),
-                    end(line),
-                    Cell{{}, _defaultAttributes}
-                );
-            }
+            [&](Line& line) { line.reset(_defaultAttributes); }
         );
     }
     else
     {
-        // scroll down only inside vertical margin with full horizontal extend
+        // scroll down only inside vertical margin with full horizontal extend,
+        // by rotating the lines rather than copying their cells.
         rotate(
             next(begin(mainPage()), _margin.vertical.from - 1),
             next(begin(mainPage()), _margin.vertical.to - *n),
@@ -817,13 +942,7 @@ void Grid::scrollDown(LineCount v_n, GraphicsAttributes const& _defaultAttribute
         for_each(
             next(begin(mainPage()), _margin.vertical.from - 1),
             next(begin(mainPage()), _margin.vertical.from - 1 + *n),
-            [&](Line& line) {
-                fill(
-                    begin(line),
-                    end(line),
-                    Cell{{}, _defaultAttributes}
-                );
-            }
+            [&](Line& line) { line.reset(_defaultAttributes); }
         );
     }
 }
@@ -886,4 +1005,304 @@ string Grid::renderText() const
 }
 // }}}
 
+// {{{ snapshot
+namespace
+{
+    // Snapshot layout, with all integers being little endian:
+    //
+    //   header:  "CTGS", u8 version, u32 page lines, u32 page columns, u8 reflow on resize,
+    //            u8 has history limit, u32 history limit, u32 pending reflow lines, u32 lines
+    //   lines:   the lines pending reflow, followed by the lines from the top of the history
+    //            to the bottom of the main page, each being: u8 flags, u32 cell count, cells
+    //   cell:    u8 cell header, [graphics attributes], [u8 width], codepoints
+    //   color:   u8 type, followed by u8 red, green, blue for RGB colors, or u8 index otherwise
+    //
+    // Graphics attributes (three colors and u32 styles) are only stored if differing from the
+    // previous cell's, and codepoints take a single byte each if all of the cell's fit into one.
+
+    constexpr auto SnapshotMagic = string_view("CTGS");
+    constexpr uint8_t SnapshotVersion = 1;
+
+    constexpr size_t SnapshotChunkSize = 64 * 1024;
+
+    enum SnapshotCellHeader : uint8_t
+    {
+        CodepointCountMask = 0x0F,
+        AttributesFollow   = 0x10,
+        WidthFollows       = 0x20,
+        NarrowCodepoints   = 0x40,
+    };
+
+    class SnapshotWriter
+    {
+      public:
+        explicit SnapshotWriter(std::ostream& _output): output_{_output}
+        {
+            buffer_.reserve(SnapshotChunkSize + 256);
+        }
+
+        ~SnapshotWriter() { flush(); }
+
+        void bytes(string_view _data) { buffer_ += _data; }
+
+        void u8(uint8_t _value) { buffer_ += static_cast<char>(_value); }
+
+        void u32(uint32_t _value)
+        {
+            for (auto const shift: {0u, 8u, 16u, 24u})
+                u8(static_cast<uint8_t>(_value >> shift));
+        }
+
+        void color(Color _color)
+        {
+            u8(static_cast<uint8_t>(_color.type));
+            if (_color.type == ColorType::RGB)
+            {
+                u8(_color.rgb.red);
+                u8(_color.rgb.green);
+                u8(_color.rgb.blue);
+            }
+            else
+                u8(_color.index);
+        }
+
+        void line(Line const& _line)
+        {
+            u8(static_cast<uint8_t>(_line.flags()));
+            u32(unbox<uint32_t>(_line.size()));
+
+            auto attributes = GraphicsAttributes{};
+            for (Cell const& cell: _line)
+            {
+                auto const codepoints = cell.codepoints();
+                bool const narrow = std::all_of(codepoints.begin(), codepoints.end(),
+                                                [](char32_t _codepoint) { return _codepoint <= 0xFF; });
+
+                auto header = static_cast<uint8_t>(codepoints.size());
+                if (cell.attributes() != attributes)
+                    header |= AttributesFollow;
+                if (cell.width() != 1)
+                    header |= WidthFollows;
+                if (narrow)
+                    header |= NarrowCodepoints;
+                u8(header);
+
+                if (header & AttributesFollow)
+                {
+                    attributes = cell.attributes();
+                    color(attributes.foregroundColor);
+                    color(attributes.backgroundColor);
+                    color(attributes.underlineColor);
+                    u32(static_cast<uint32_t>(attributes.styles));
+                }
+
+                if (header & WidthFollows)
+                    u8(static_cast<uint8_t>(cell.width()));
+
+                for (char32_t const codepoint: codepoints)
+                    if (narrow)
+                        u8(static_cast<uint8_t>(codepoint));
+                    else
+                        u32(static_cast<uint32_t>(codepoint));
+            }
+
+            if (buffer_.size() >= SnapshotChunkSize)
+                flush();
+        }
+
+        void flush()
+        {
+            output_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+            buffer_.clear();
+        }
+
+      private:
+        std::ostream& output_;
+        string buffer_;
+    };
+
+    class SnapshotReader
+    {
+      public:
+        explicit SnapshotReader(string_view _data): data_{_data} {}
+
+        bool good() const noexcept { return good_; }
+
+        string_view bytes(size_t _count)
+        {
+            if (!require(_count))
+                return {};
+            auto const result = data_.substr(0, _count);
+            data_.remove_prefix(_count);
+            return result;
+        }
+
+        uint8_t u8()
+        {
+            if (!require(1))
+                return 0;
+            auto const result = static_cast<uint8_t>(data_[0]);
+            data_.remove_prefix(1);
+            return result;
+        }
+
+        uint32_t u32()
+        {
+            auto result = uint32_t{0};
+            for (auto const shift: {0u, 8u, 16u, 24u})
+                result |= static_cast<uint32_t>(u8()) << shift;
+            return result;
+        }
+
+        Color color()
+        {
+            auto const type = u8();
+            if (type > static_cast<uint8_t>(ColorType::RGB))
+                good_ = false;
+
+            if (static_cast<ColorType>(type) != ColorType::RGB)
+                return Color{static_cast<ColorType>(type), u8()};
+
+            auto rgb = RGBColor{};
+            rgb.red = u8();
+            rgb.green = u8();
+            rgb.blue = u8();
+            return Color{rgb};
+        }
+
+        optional<Line> line(optional<ColumnCount> _columns)
+        {
+            auto const flags = static_cast<Line::Flags>(u8());
+            auto const cellCount = u32();
+            if (!good_ || (_columns.has_value() && cellCount != unbox<uint32_t>(*_columns)))
+                return nullopt;
+
+            // Every cell takes at least one byte, which also guards against bogus cell counts.
+            if (!require(cellCount))
+                return nullopt;
+
+            auto cells = Line::Buffer{};
+            cells.reserve(cellCount);
+            auto attributes = GraphicsAttributes{};
+            for (uint32_t i = 0; i < cellCount && good_; ++i)
+            {
+                auto const header = u8();
+                auto const codepointCount = static_cast<size_t>(header & CodepointCountMask);
+                if (codepointCount > Cell::MaxCodepoints)
+                    return nullopt;
+
+                if (header & AttributesFollow)
+                {
+                    attributes.foregroundColor = color();
+                    attributes.backgroundColor = color();
+                    attributes.underlineColor = color();
+                    attributes.styles = static_cast<CellFlags>(u32());
+                }
+
+                auto const width = header & WidthFollows ? u8() : uint8_t{1};
+
+                auto& cell = cells.emplace_back(Cell{});
+                for (size_t k = 0; k < codepointCount; ++k)
+                {
+                    auto const codepoint = header & NarrowCodepoints ? char32_t{u8()} : static_cast<char32_t>(u32());
+                    if (k == 0)
+                        cell.setCharacter(codepoint);
+                    else
+                        cell.appendCharacter(codepoint);
+                }
+                cell.setWidth(width);
+                cell.setAttributes(attributes);
+            }
+
+            if (!good_)
+                return nullopt;
+
+            return Line(move(cells), flags);
+        }
+
+      private:
+        bool require(size_t _count) noexcept
+        {
+            if (data_.size() < _count)
+                good_ = false;
+            return good_;
+        }
+
+        string_view data_;
+        bool good_ = true;
+    };
+}
+
+void Grid::writeSnapshot(std::ostream& _output) const
+{
+    auto writer = SnapshotWriter(_output);
+
+    writer.bytes(SnapshotMagic);
+    writer.u8(SnapshotVersion);
+    writer.u32(unbox<uint32_t>(screenSize_.lines));
+    writer.u32(unbox<uint32_t>(screenSize_.columns));
+    writer.u8(reflowOnResize_ ? 1 : 0);
+    writer.u8(maxHistoryLineCount_.has_value() ? 1 : 0);
+    writer.u32(maxHistoryLineCount_.has_value() ? unbox<uint32_t>(*maxHistoryLineCount_) : 0);
+    writer.u32(static_cast<uint32_t>(pendingReflow_.size()));
+    writer.u32(static_cast<uint32_t>(lines_.size()));
+
+    for (Line const& line: pendingReflow_)
+        writer.line(line);
+
+    for (Line const& line: lines_)
+        writer.line(line);
+}
+
+optional<Grid> Grid::readSnapshot(std::istream& _input)
+{
+    auto data = std::ostringstream{};
+    data << _input.rdbuf();
+    auto const snapshot = data.str();
+    auto reader = SnapshotReader(snapshot);
+
+    if (reader.bytes(SnapshotMagic.size()) != SnapshotMagic || reader.u8() != SnapshotVersion)
+        return nullopt;
+
+    auto const pageSize = PageSize{LineCount::cast_from(reader.u32()), ColumnCount::cast_from(reader.u32())};
+    auto const reflowOnResize = reader.u8() != 0;
+    auto const hasMaxHistoryLineCount = reader.u8() != 0;
+    auto const maxHistoryLineCount = LineCount::cast_from(reader.u32());
+    auto const pendingReflowLineCount = reader.u32();
+    auto const lineCount = reader.u32();
+
+    if (!reader.good() || *pageSize.lines <= 0 || *pageSize.columns <= 0 || lineCount < unbox<uint32_t>(pageSize.lines))
+        return nullopt;
+
+    auto grid = Grid(pageSize,
+                     reflowOnResize,
+                     hasMaxHistoryLineCount ? optional{maxHistoryLineCount} : nullopt);
+    grid.lines_.clear();
+
+    // Lines pending reflow are still in their previous widths, whereas all others have the page's.
+    for (uint32_t i = 0; i < pendingReflowLineCount; ++i)
+    {
+        auto line = reader.line(nullopt);
+        if (!line.has_value())
+            return nullopt;
+        grid.pendingReflow_.emplace_back(move(*line));
+    }
+
+    for (uint32_t i = 0; i < lineCount; ++i)
+    {
+        auto line = reader.line(pageSize.columns);
+        if (!line.has_value())
+            return nullopt;
+        grid.lines_.emplace_back(move(*line));
+    }
+
+    // Nobody is going to reflow the restored grid's pending lines incrementally,
+    // and the history must obey the restored limit, too.
+    grid.reflowAllPendingLines();
+    grid.clampHistory();
+
+    return grid;
+}
+// }}}
+
 }
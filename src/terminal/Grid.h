@@ -37,6 +37,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <deque>
 #include <functional>
 #include <list>
@@ -48,6 +49,7 @@
 #include <stack>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 namespace terminal {
@@ -242,7 +244,7 @@ class Cell {
         attributes_ = _attributes;
         width_ = 1;
 #if defined(LIBTERMINAL_HYPERLINKS)
-        hyperlink_ = nullptr;
+        hyperlink_ = {};
 #endif
 #if defined(CONTOUR_TERMINAL_CELL_USE_STRING)
         codepoints_.clear();
@@ -255,7 +257,7 @@ class Cell {
     }
 
 #if defined(LIBTERMINAL_HYPERLINKS)
-    void reset(GraphicsAttributes _attribs, HyperlinkRef const& _hyperlink) noexcept
+    void reset(GraphicsAttributes _attribs, HyperlinkId _hyperlink) noexcept
     {
         attributes_ = _attribs;
         width_ = 1;
@@ -328,10 +330,10 @@ class Cell {
     }
 
 #if defined(LIBTERMINAL_HYPERLINKS)
-    void setImage(ImageFragment _imageFragment, HyperlinkRef _hyperlink)
+    void setImage(ImageFragment _imageFragment, HyperlinkId _hyperlink)
     {
         setImage(std::move(_imageFragment));
-        hyperlink_ = std::move(_hyperlink);
+        hyperlink_ = _hyperlink;
     }
 #endif
 #endif
@@ -412,8 +414,8 @@ class Cell {
     std::string toUtf8() const;
 
 #if defined(LIBTERMINAL_HYPERLINKS)
-    HyperlinkRef hyperlink() const noexcept { return hyperlink_; }
-    void setHyperlink(HyperlinkRef const& _hyperlink) { hyperlink_ = _hyperlink; }
+    HyperlinkId hyperlink() const noexcept { return hyperlink_; }
+    void setHyperlink(HyperlinkId _hyperlink) noexcept { hyperlink_ = _hyperlink; }
 #endif
 
   private:
@@ -432,7 +434,7 @@ class Cell {
     GraphicsAttributes attributes_;
 
 #if defined(LIBTERMINAL_HYPERLINKS)
-    HyperlinkRef hyperlink_ = nullptr;
+    HyperlinkId hyperlink_ = {};
 #endif
 
     /// Image fragment to be rendered in this cell.
@@ -473,7 +475,7 @@ class Line { // {{{
     using reverse_iterator = Buffer::reverse_iterator;
 
     Line(ColumnCount _numCols, Cell const& _defaultCell, Flags _flags) :
-        buffer_(unbox<size_t>(_numCols), _defaultCell),
+        buffer_{std::make_shared<Buffer>(unbox<size_t>(_numCols), _defaultCell)},
         flags_{static_cast<unsigned>(_flags)}
     {}
 
@@ -483,24 +485,37 @@ class Line { // {{{
     Line(ColumnCount _numCols, Buffer&& _init, Flags _flags);
     Line(ColumnCount _numCols, std::string_view const& _s, Flags _flags);
 
-    Buffer& buffer() noexcept { return buffer_; }
+    Buffer& buffer() { return mutableBuffer(); }
 
+    // Copying a line shares its cells until either copy gets modified (see mutableBuffer()).
+    // A moved-from line is left with an empty buffer rather than none.
     Line() = default;
     Line(Line const&) = default;
-    Line(Line&&) = default;
+    Line(Line&& _other) noexcept :
+        buffer_{std::exchange(_other.buffer_, emptyBuffer())},
+        flags_{_other.flags_}
+    {}
     Line& operator=(Line const&) = default;
-    Line& operator=(Line&&) = default;
+    Line& operator=(Line&& _other) noexcept
+    {
+        buffer_ = std::exchange(_other.buffer_, emptyBuffer());
+        flags_ = _other.flags_;
+        return *this;
+    }
 
-    void reset(GraphicsAttributes _attributes) noexcept
+    void reset(GraphicsAttributes _attributes)
     {
-        for (Cell& cell: buffer_)
+        for (Cell& cell: mutableBuffer())
             cell.reset(_attributes);
     }
 
-    Buffer* operator->() noexcept { return &buffer_; }
-    Buffer const* operator->() const noexcept { return &buffer_; }
-    auto& operator[](std::size_t _index) { return buffer_[_index]; }
-    auto const& operator[](std::size_t _index) const { return buffer_[_index]; }
+    /// @returns the cells for reading, without copying them even if shared (unlike the non-const accessors).
+    Buffer const& cells() const noexcept { return *buffer_; }
+
+    Buffer* operator->() { return &mutableBuffer(); }
+    Buffer const* operator->() const noexcept { return buffer_.get(); }
+    auto& operator[](std::size_t _index) { return mutableBuffer()[_index]; }
+    auto const& operator[](std::size_t _index) const { return (*buffer_)[_index]; }
 
     void prepend(Buffer const&);
     void append(Buffer const&);
@@ -515,7 +530,7 @@ class Line { // {{{
 
     crispy::range<const_iterator> trim_blank_right() const;
 
-    ColumnCount size() const noexcept { return ColumnCount::cast_from(buffer_.size()); }
+    ColumnCount size() const noexcept { return ColumnCount::cast_from(buffer_->size()); }
 
     bool blank() const noexcept;
 
@@ -524,14 +539,17 @@ class Line { // {{{
     void resize(ColumnCount _size);
     [[nodiscard]] Buffer reflow(ColumnCount _column);
 
-    iterator begin() { return buffer_.begin(); }
-    iterator end() { return buffer_.end(); }
-    const_iterator begin() const { return buffer_.begin(); }
-    const_iterator end() const { return buffer_.end(); }
-    reverse_iterator rbegin() { return buffer_.rbegin(); }
-    reverse_iterator rend() { return buffer_.rend(); }
-    const_iterator cbegin() const { return buffer_.cbegin(); }
-    const_iterator cend() const { return buffer_.cend(); }
+    iterator begin() { return mutableBuffer().begin(); }
+    iterator end() { return mutableBuffer().end(); }
+    const_iterator begin() const { return buffer_->begin(); }
+    const_iterator end() const { return buffer_->end(); }
+    reverse_iterator rbegin() { return mutableBuffer().rbegin(); }
+    reverse_iterator rend() { return mutableBuffer().rend(); }
+    const_iterator cbegin() const { return buffer_->cbegin(); }
+    const_iterator cend() const { return buffer_->cend(); }
+
+    /// Tests whether the cells of this line are shared with a copy of it, e.g. a grid snapshot.
+    bool shared() const noexcept { return buffer_.use_count() > 1; }
 
     bool marked() const noexcept { return isFlagEnabled(Flags::Marked); }
     void setMarked(bool _enable) { setFlag(Flags::Marked, _enable); }
@@ -570,7 +588,27 @@ class Line { // {{{
     bool isFlagEnabled(Flags _flag) const noexcept { return (flags_ & static_cast<unsigned>(_flag)) != 0; }
 
   private:
-    Buffer buffer_;
+    /// @returns the cells for modification, copying them first if shared with another line.
+    ///
+    /// Copies may be released by other threads at any time, but never be created concurrently,
+    /// as these are only taken while holding the terminal's lock.
+    Buffer& mutableBuffer()
+    {
+        if (buffer_.use_count() != 1)
+            buffer_ = std::make_shared<Buffer>(*buffer_);
+        else
+            std::atomic_thread_fence(std::memory_order_acquire); // pairs with the release of the last copy
+        return *buffer_;
+    }
+
+    /// @returns the buffer shared by all moved-from lines, which is copied upon modification as any shared one.
+    static std::shared_ptr<Buffer> emptyBuffer() noexcept
+    {
+        static auto const buffer = std::make_shared<Buffer>();
+        return buffer;
+    }
+
+    std::shared_ptr<Buffer> buffer_ = std::make_shared<Buffer>();
     unsigned flags_;
 };
 
@@ -596,6 +634,14 @@ inline auto end(Line const& _line) { return _line.cend(); }
 inline Line::const_iterator cbegin(Line const& _line) { return _line.cbegin(); }
 inline Line::const_iterator cend(Line const& _line) { return _line.cend(); }
 
+/// Absolute line numbers (inclusive) of the first and last line of a logical line.
+struct LogicalLineRange {
+    int first;
+    int last;
+
+    constexpr int length() const noexcept { return last - first + 1; }
+};
+
 /**
  * Manages the screen grid buffer (main screen + scrollback history).
  *
@@ -621,6 +667,18 @@ inline Line::const_iterator cend(Line const& _line) { return _line.cend(); }
  *       ^                          ^
  *       1                          screenSize.columns
  * </pre>
+ *
+ * <h3>Reflow</h3>
+ *
+ * Upon resize, only the main page and the most recent scrollback lines are reflowed immediately.
+ * Older scrollback lines are kept pending in their previous width and get reflowed incrementally
+ * via reflowPendingLines(), bottom most logical line first, each becoming part of the history then.
+ *
+ * <h3>Logical lines</h3>
+ *
+ * A logical line is a sequence of lines, each but the first one continuing (wrapping) its predecessor.
+ * As scrollback lines do not change anymore, the starts of their logical lines are indexed
+ * (lazily, upon lookup), such that logical lines can be looked up without walking the history.
  */
 class Grid {
   public:
@@ -630,6 +688,14 @@ class Grid {
 
     Grid(): Grid(PageSize{LineCount(25), ColumnCount(80)}, false, LineCount(0)) {}
 
+    /// @returns a consistent copy of this grid, sharing the cells of all lines copy-on-write.
+    ///
+    /// Taking a snapshot merely costs one reference count increment per line, and the cells
+    /// of a line are only copied once the line gets modified while the snapshot is still alive.
+    /// A snapshot can thus be taken while holding the terminal's lock and be read after
+    /// releasing it, without stalling the processing of further output.
+    Grid snapshot() const { return *this; }
+
     PageSize screenSize() const noexcept { return screenSize_; }
 
     /// Resizes the main page area of the grid and adapts the scrollback area's width accordingly.
@@ -652,6 +718,24 @@ class Grid {
         return LineCount::cast_from(lines_.size()) - screenSize_.lines;
     }
 
+    /// @returns number of (older) scrollback lines that have not yet been reflowed to the current
+    ///          page width and are therefore not yet part of the history.
+    LineCount pendingReflowLineCount() const noexcept { return LineCount::cast_from(pendingReflow_.size()); }
+
+    /// Reflows pending scrollback lines, bottom most logical line first, until at least @p _minimum
+    /// lines have been added to the top of the history, or nothing is pending anymore.
+    ///
+    /// @returns the number of lines the history has grown by.
+    LineCount reflowPendingLines(LineCount _minimum);
+
+    /// Reflows all pending scrollback lines at once, e.g. on a snapshot that is about to be
+    /// read in full.
+    void reflowAllPendingLines()
+    {
+        while (!pendingReflow_.empty())
+            reflowPendingLines(pendingReflowLineCount());
+    }
+
     /// Renders the full screen by passing every grid cell to the callback.
     template <typename RendererT>
     void render(RendererT && _render, std::optional<StaticScrollbackPosition> _scrollOffset = std::nullopt) const;
@@ -669,8 +753,13 @@ class Grid {
     /// Converts an absolute line number into a relative line number.
     int toRelativeLine(int _absoluteLine) const noexcept;
 
+    /// @returns the relative line number of the first line of the @p _n-th logical line
+    ///          counted from the bottom, or the top most line if there are less logical lines.
     int computeRelativeLineNumberFromBottom(int _n) const noexcept;
 
+    /// @returns the absolute line range of the logical line that contains the given absolute line.
+    LogicalLineRange logicalLineRange(int _absoluteLine) const;
+
     /// Gets a reference to the cell relative to screen origin (top left, 1:1).
     Cell& at(Coordinate const& _coord) noexcept;
 
@@ -689,6 +778,17 @@ class Grid {
 
     crispy::range<Lines::const_iterator> scrollbackLines() const;
 
+    /// Invokes @p _visitor with each line of this grid, including the scrollback lines
+    /// that are still pending to be reflowed.
+    template <typename F>
+    void forEachLine(F _visitor) const
+    {
+        for (Line const& line: pendingReflow_)
+            _visitor(line);
+        for (Line const& line: lines_)
+            _visitor(line);
+    }
+
     /// Completely deletes all scrollback lines.
     void clearHistory();
 
@@ -715,18 +815,58 @@ class Grid {
     /// Empty cells are represented as strings and lines split by LF.
     std::string renderAllText() const;
 
+    /// Writes a compact binary snapshot of all lines of this grid (including the scrollback lines
+    /// still pending reflow) with their cells' text, width and graphics attributes and their line flags.
+    ///
+    /// Images and hyperlinks are not part of the snapshot, as these are resources of the screen.
+    void writeSnapshot(std::ostream& _output) const;
+
+    /// Restores a grid from a snapshot written by writeSnapshot().
+    ///
+    /// Scrollback lines that were pending reflow are reflowed while loading, and the history
+    /// is clamped to the snapshot's history limit.
+    ///
+    /// @returns the restored grid, or std::nullopt if the snapshot is truncated or malformed.
+    static std::optional<Grid> readSnapshot(std::istream& _input);
+
   private:
     /// Ensures the maxHistoryLineCount attribute will be satisified, potentially deleting any
     /// overflowing history line.
     void clampHistory();
     void appendNewLines(LineCount _count, GraphicsAttributes _attr);
 
+    /// Moves the scrollback lines above the immediately reflowed area into the pending reflow queue.
+    void deferHistoryReflow();
+
+    /// Number of scrollback lines (above the main page) that are reflowed immediately upon resize.
+    static constexpr auto ImmediateReflowLineCount = LineCount(1000);
+
+    /// Extends the logical line index to cover all scrollback lines.
+    void updateLogicalLineIndex() const;
+
+    /// Drops the index entries of lines that have been taken back from the scrollback into the main page.
+    void trimLogicalLineIndex() const;
+
+    /// Adjusts the logical line index after @p _count lines have been removed from the top.
+    void logicalLinesEvicted(LineCount _count);
+
+    /// Resets the logical line index, e.g. after the scrollback lines have been reflowed.
+    void invalidateLogicalLineIndex() noexcept;
+
     // private fields
     //
     PageSize screenSize_;
     bool reflowOnResize_;
     std::optional<LineCount> maxHistoryLineCount_;
     Lines lines_;
+    Lines pendingReflow_; // scrollback lines above lines_ still to be reflowed, in their previous width(s)
+
+    // Logical line index of the scrollback lines, with each line being identified by a serial
+    // number that is not changing while lines are being added to the bottom or evicted from the top.
+    //
+    long topLineSerial_ = 0;                        // serial number of lines_.front()
+    mutable LineCount indexedLineCount_{0};         // number of top most scrollback lines covered by the index
+    mutable std::deque<long> logicalLineStarts_;    // serial numbers of indexed lines that are not wrapped
 };
 
 // {{{ inlines
@@ -793,7 +933,9 @@ inline Cell& Grid::at(Coordinate const& _coord) noexcept
 
 inline Cell const& Grid::at(Coordinate const& _coord) const noexcept
 {
-    return const_cast<Grid&>(*this).at(_coord);
+    assert(crispy::ascending(1, _coord.column, unbox<int>(screenSize_.columns)));
+
+    return lineAt(_coord.row).cells()[static_cast<size_t>(_coord.column - 1)];
 }
 
 inline crispy::range<Lines::const_iterator> Grid::lines(LinePosition _start, LinePosition _end) const
@@ -16,6 +16,7 @@
 #include <catch2/catch_all.hpp>
 #include <fmt/format.h>
 #include <iostream>
+#include <sstream>
 
 using namespace terminal;
 using namespace std::string_view_literals;
@@ -439,3 +440,249 @@ TEST_CASE("Grid.reflow.tripple", "[grid]")
         // }}}
     }
 }
+
+TEST_CASE("Grid.reflow.deferred", "[grid]")
+{
+    // Fills more scrollback than is reflowed immediately upon resize, with each logical line
+    // spanning two grid lines, and ensures the remaining lines are reflowed on request.
+    auto constexpr LogicalLineCount = 1500;
+    auto const fullMargin = Margin{Margin::Range{1, 2}, Margin::Range{1, 4}};
+    auto grid = Grid(PageSize{LineCount(2), ColumnCount(4)}, true, std::nullopt);
+    for (int i = 0; i < LogicalLineCount; ++i)
+    {
+        grid.scrollUp(LineCount(1), GraphicsAttributes{}, fullMargin);
+        grid.lineAt(2).setText(fmt::format("{:04}", i));
+        grid.scrollUp(LineCount(1), GraphicsAttributes{}, fullMargin);
+        grid.lineAt(2).setText("ab");
+        grid.lineAt(2).setWrapped(true);
+    }
+    REQUIRE(grid.historyLineCount() == LineCount(2 * LogicalLineCount)); // including the two initial empty lines
+
+    (void) grid.resize(PageSize{LineCount(2), ColumnCount(8)}, Coordinate{2, 3}, false);
+    logGridText(grid, "after resize 8x2");
+
+    CHECK(grid.pendingReflowLineCount() > LineCount(0));
+    CHECK(grid.renderTextLine(2) == "1499ab  ");
+    CHECK(grid.renderTextLine(1) == "1498ab  ");
+
+    (void) grid.reflowPendingLines(LineCount(1'000'000));
+    CHECK(grid.pendingReflowLineCount() == LineCount(0));
+    CHECK(grid.historyLineCount() == LineCount(LogicalLineCount));
+    for (int i = 0; i < LogicalLineCount; ++i)
+    {
+        INFO(fmt::format("logical line {}", i));
+        CHECK(grid.renderTextLineAbsolute(2 + i) == fmt::format("{:04}ab  ", i));
+        CHECK(!grid.absoluteLineAt(2 + i).wrapped());
+    }
+}
+
+TEST_CASE("Grid.logicalLineRange", "[grid]")
+{
+    // Fills logical lines of varying length into a grid with limited history, such that lines are
+    // being evicted from the top, while the bottom most logical line may span into the main page.
+    auto const fullMargin = Margin{Margin::Range{1, 2}, Margin::Range{1, 4}};
+    auto const isWrapped = [](int _i) { return _i % 3 == 2 || _i % 6 == 1; };
+    auto grid = Grid(PageSize{LineCount(2), ColumnCount(4)}, true, LineCount(20));
+    auto lineCount = 0;
+    auto const appendLines = [&](int _count) {
+        for (int k = 0; k < _count; ++k, ++lineCount)
+        {
+            grid.scrollUp(LineCount(1), GraphicsAttributes{}, fullMargin);
+            grid.lineAt(2).setText(fmt::format("{:04}", lineCount));
+            grid.lineAt(2).setWrapped(isWrapped(lineCount));
+        }
+    };
+
+    // Computes the logical line range by walking the wrapped flags, given the line number
+    // of the top most (absolute) line.
+    auto const expectedRange = [&](int _line, int _topLineNumber) {
+        auto range = LogicalLineRange{_line, _line};
+        while (range.first > 0 && isWrapped(_topLineNumber + range.first))
+            --range.first;
+        while (range.last < 21 && isWrapped(_topLineNumber + range.last + 1))
+            ++range.last;
+        return range;
+    };
+
+    auto const checkRanges = [&]() {
+        auto const topLineNumber = lineCount - 22;
+        REQUIRE(grid.renderTextLineAbsolute(0) == fmt::format("{:04}", topLineNumber));
+        for (int line = 0; line <= 21; ++line)
+        {
+            INFO(fmt::format("line {}", line));
+            auto const actual = grid.logicalLineRange(line);
+            auto const expected = expectedRange(line, topLineNumber);
+            CHECK(actual.first == expected.first);
+            CHECK(actual.last == expected.last);
+        }
+    };
+
+    appendLines(30);
+    logGridText(grid, "after 30 lines");
+    REQUIRE(grid.historyLineCount() == LineCount(20));
+    checkRanges();
+
+    // Evicts some more lines, extending the existing index.
+    appendLines(5);
+    logGridText(grid, "after 35 lines");
+    checkRanges();
+
+    // The bottom most two logical lines start at the second last logical line's first line.
+    auto const bottomMostLogicalLine = grid.logicalLineRange(21);
+    auto const secondLastLogicalLine = grid.logicalLineRange(bottomMostLogicalLine.first - 1);
+    CHECK(grid.computeRelativeLineNumberFromBottom(2) == secondLastLogicalLine.first - unbox<int>(grid.historyLineCount()) + 1);
+}
+
+TEST_CASE("Grid.snapshot", "[grid]")
+{
+    auto const fullMargin = Margin{Margin::Range{1, 2}, Margin::Range{1, 5}};
+    auto grid = Grid(PageSize{LineCount(2), ColumnCount(5)}, true, LineCount(10));
+    grid.lineAt(2).setText("ABCDE");
+    grid.lineAt(2).setMarked(true);
+    grid.scrollUp(LineCount(1), GraphicsAttributes{}, fullMargin);
+    grid.lineAt(2).setText("fgh");
+    grid.lineAt(2).setWrapped(true);
+
+    auto attributes = GraphicsAttributes{};
+    attributes.foregroundColor = RGBColor{0x10, 0x20, 0x30};
+    attributes.backgroundColor = IndexedColor::Blue;
+    attributes.styles = CellFlags::Bold | CellFlags::Underline;
+    grid.at({2, 2}).setAttributes(attributes);
+    grid.at({2, 4}).setCharacter(U'\U0001F600');
+    grid.at({2, 4}).appendCharacter(U'\uFE0F');
+    grid.at({2, 4}).setWidth(2);
+
+    auto snapshot = std::stringstream{};
+    grid.writeSnapshot(snapshot);
+
+    SECTION("round trip") {
+        auto restored = Grid::readSnapshot(snapshot);
+        REQUIRE(restored.has_value());
+        logGridText(*restored, "restored");
+
+        CHECK(restored->screenSize() == grid.screenSize());
+        CHECK(restored->reflowOnResize());
+        CHECK(restored->maxHistoryLineCount() == LineCount(10));
+        REQUIRE(restored->historyLineCount() == LineCount(1));
+        CHECK(restored->renderAllText() == grid.renderAllText());
+        CHECK(restored->lineAt(1).marked());
+        CHECK(!restored->lineAt(1).wrapped());
+        CHECK(restored->lineAt(2).wrapped());
+        CHECK(!restored->lineAt(2).marked());
+
+        CHECK(restored->at({2, 2}).attributes() == attributes);
+        CHECK(restored->at({2, 3}).attributes() == GraphicsAttributes{});
+        CHECK(restored->at({2, 4}).codepoints() == U"\U0001F600\uFE0F");
+        CHECK(restored->at({2, 4}).width() == 2);
+        CHECK(restored->at({1, 1}).attributes() == GraphicsAttributes{});
+    }
+
+    SECTION("truncated") {
+        auto const data = snapshot.str();
+        auto truncated = std::stringstream{data.substr(0, data.size() - 1)};
+        CHECK(!Grid::readSnapshot(truncated).has_value());
+    }
+
+    SECTION("invalid") {
+        auto invalid = std::stringstream{"not a grid snapshot"};
+        CHECK(!Grid::readSnapshot(invalid).has_value());
+    }
+}
+
+TEST_CASE("Grid.snapshot.pending_reflow", "[grid]")
+{
+    // More history lines than are reflowed immediately upon resize (1000 lines).
+    auto const fullMargin = Margin{Margin::Range{1, 2}, Margin::Range{1, 6}};
+    auto grid = Grid(PageSize{LineCount(2), ColumnCount(6)}, true, std::nullopt);
+    for (int i = 0; i < 1200; ++i)
+    {
+        grid.scrollUp(LineCount(1), GraphicsAttributes{}, fullMargin);
+        grid.lineAt(2).setText(fmt::format("{:05}", i));
+    }
+    (void) grid.resize(PageSize{LineCount(2), ColumnCount(3)}, Coordinate{2, 1}, false);
+    REQUIRE(*grid.pendingReflowLineCount() > 0);
+
+    auto snapshot = std::stringstream{};
+    grid.writeSnapshot(snapshot);
+
+    auto reflowed = grid.snapshot();
+    reflowed.reflowAllPendingLines();
+
+    SECTION("reflowed while loading") {
+        auto restored = Grid::readSnapshot(snapshot);
+        REQUIRE(restored.has_value());
+        CHECK(*restored->pendingReflowLineCount() == 0);
+        CHECK(restored->historyLineCount() == reflowed.historyLineCount());
+        CHECK(restored->renderAllText() == reflowed.renderAllText());
+    }
+
+    SECTION("history clamped to the stored limit") {
+        // Patch the header's history limit (at offset 14, after magic, version, page size and reflow flag).
+        auto data = snapshot.str();
+        data[14] = 1;
+        data.replace(15, 4, "\x64\x00\x00\x00"sv); // 100 lines
+        auto patched = std::stringstream{data};
+
+        auto restored = Grid::readSnapshot(patched);
+        REQUIRE(restored.has_value());
+        CHECK(restored->maxHistoryLineCount() == LineCount(100));
+        CHECK(restored->historyLineCount() == LineCount(100));
+        CHECK(restored->lineAt(2).toUtf8() == reflowed.lineAt(2).toUtf8());
+    }
+}
+
+TEST_CASE("Grid.snapshot.copy_on_write", "[grid]")
+{
+    auto const fullMargin = Margin{Margin::Range{1, 2}, Margin::Range{1, 5}};
+    auto grid = Grid(PageSize{LineCount(2), ColumnCount(5)}, true, LineCount(10));
+    grid.lineAt(1).setText("ABCDE");
+    grid.lineAt(2).setText("FGHIJ");
+
+    auto const snapshot = grid.snapshot();
+    CHECK(grid.lineAt(1).shared());
+    CHECK(snapshot.lineAt(2).shared());
+
+    SECTION("modify") {
+        grid.lineAt(1).setText("abc");
+        CHECK(!grid.lineAt(1).shared());
+        CHECK(grid.lineAt(1).toUtf8() == "abcDE");
+        CHECK(snapshot.lineAt(1).toUtf8() == "ABCDE");
+        CHECK(grid.lineAt(2).shared()); // untouched lines remain shared
+    }
+
+    SECTION("scroll") {
+        grid.scrollUp(LineCount(1), GraphicsAttributes{}, fullMargin);
+        grid.lineAt(2).setText("KLMNO");
+        CHECK(grid.renderAllText() == "ABCDE\nFGHIJ\nKLMNO\n");
+        CHECK(snapshot.renderAllText() == "ABCDE\nFGHIJ\n");
+    }
+
+    SECTION("resize") {
+        grid.resize(PageSize{LineCount(2), ColumnCount(3)}, Coordinate{1, 1}, false);
+        CHECK(snapshot.screenSize() == PageSize{LineCount(2), ColumnCount(5)});
+        CHECK(snapshot.renderAllText() == "ABCDE\nFGHIJ\n");
+    }
+
+    SECTION("read") {
+        auto const& constGrid = grid;
+        CHECK(constGrid.at({1, 2}).codepoints() == U"B");
+        CHECK(grid.lineAt(2).cells().back().codepoints() == U"J");
+        CHECK(grid.lineAt(1).shared());
+        CHECK(grid.lineAt(2).shared());
+    }
+
+    SECTION("move") {
+        auto line = std::move(grid.lineAt(1));
+        CHECK(line.toUtf8() == "ABCDE");
+        CHECK(line.shared());
+        CHECK(grid.lineAt(1).size() == ColumnCount(0));
+
+        grid.lineAt(1) = std::move(grid.lineAt(2));
+        CHECK(grid.lineAt(1).toUtf8() == "FGHIJ");
+        CHECK(grid.lineAt(2).size() == ColumnCount(0));
+
+        grid.lineAt(2).append(1, Cell{U'x', GraphicsAttributes{}});
+        CHECK(grid.lineAt(2).toUtf8() == "x");
+        CHECK(snapshot.renderAllText() == "ABCDE\nFGHIJ\n");
+    }
+}
@@ -0,0 +1,140 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Hyperlink.h>
+
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+namespace terminal {
+
+HyperlinkId HyperlinkStorage::add(string const& _userId, string const& _uri)
+{
+    if (!_userId.empty())
+    {
+        if (auto const i = userIds_.find(_userId); i != userIds_.end())
+        {
+            Slot& slot = slots_[i->second];
+            if (slot.info.uri == _uri)
+            {
+                slot.lastUse = ++useCounter_;
+                return HyperlinkId{static_cast<uint32_t>(slot.generation) << 16 | i->second};
+            }
+            // The same ID has been reused for another URI, so only the new one can be referred to by it.
+            userIds_.erase(i);
+        }
+    }
+
+    uint16_t index = 0;
+    if (!freeSlots_.empty())
+    {
+        index = freeSlots_.back();
+        freeSlots_.pop_back();
+    }
+    else if (slots_.size() <= MaxCount)
+    {
+        if (slots_.empty())
+            slots_.emplace_back(); // reserved for "no hyperlink"
+        index = static_cast<uint16_t>(slots_.size());
+        slots_.emplace_back();
+    }
+    else
+    {
+        // All slots are in use because garbage has not been collected in time.
+        // Reuse the least recently used one rather than failing.
+        auto const lru = min_element(next(slots_.begin()), slots_.end(),
+                                     [](Slot const& a, Slot const& b) { return a.lastUse < b.lastUse; });
+        index = static_cast<uint16_t>(distance(slots_.begin(), lru));
+        release(index);
+        freeSlots_.pop_back();
+    }
+
+    Slot& slot = slots_[index];
+    slot.info = HyperlinkInfo{_userId, _uri};
+    slot.used = true;
+    slot.lastUse = ++useCounter_;
+
+    if (!_userId.empty())
+        userIds_[_userId] = index;
+
+    ++count_;
+    memoryUsage_ += memoryUsageOf(slot.info);
+
+    return HyperlinkId{static_cast<uint32_t>(slot.generation) << 16 | index};
+}
+
+void HyperlinkStorage::clear()
+{
+    for (size_t i = 1; i < slots_.size(); ++i)
+        if (slots_[i].used)
+            release(static_cast<uint16_t>(i));
+    userIds_.clear();
+}
+
+size_t HyperlinkStorage::memoryUsageOf(HyperlinkInfo const& _info) noexcept
+{
+    // The ID is accounted twice, as it is also the key of the user ID map.
+    return sizeof(Slot) + 2 * _info.id.size() + _info.uri.size();
+}
+
+void HyperlinkStorage::release(uint16_t _slot)
+{
+    Slot& slot = slots_[_slot];
+    assert(slot.used);
+
+    if (!slot.info.id.empty())
+        if (auto const i = userIds_.find(slot.info.id); i != userIds_.end() && i->second == _slot)
+            userIds_.erase(i);
+
+    memoryUsage_ -= memoryUsageOf(slot.info);
+    --count_;
+
+    slot.info = HyperlinkInfo{};
+    slot.used = false;
+    ++slot.generation; // invalidates all IDs still referring to this slot
+    freeSlots_.push_back(_slot);
+}
+
+void HyperlinkStorage::evict(vector<bool> const& _referenced)
+{
+    for (size_t i = 1; i < slots_.size(); ++i)
+        if (slots_[i].used && !_referenced[i])
+            release(static_cast<uint16_t>(i));
+
+    // Make sure the next garbage collection is not due right after the next few hyperlinks.
+    auto const countLimit = MaxCount - MaxCount / 4;
+    auto const memoryLimit = maxMemory_ - maxMemory_ / 4;
+    if (count_ <= countLimit && memoryUsage_ <= memoryLimit)
+        return;
+
+    auto inUse = vector<uint16_t>{};
+    inUse.reserve(count_);
+    for (size_t i = 1; i < slots_.size(); ++i)
+        if (slots_[i].used)
+            inUse.push_back(static_cast<uint16_t>(i));
+
+    sort(inUse.begin(), inUse.end(), [&](uint16_t a, uint16_t b) {
+        return slots_[a].lastUse < slots_[b].lastUse;
+    });
+
+    for (auto const i: inUse)
+    {
+        if (count_ <= countLimit && memoryUsage_ <= memoryLimit)
+            break;
+        release(i);
+    }
+}
+
+} // end namespace
@@ -13,10 +13,13 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <list>
 #include <memory>
+#include <vector>
 
 namespace terminal {
 
@@ -70,8 +73,109 @@ struct HyperlinkInfo { // TODO: rename to Hyperlink
     }
 };
 
-using HyperlinkRef = std::shared_ptr<HyperlinkInfo>;
-
 bool is_local(HyperlinkInfo const& _hyperlink);
 
+/// Compact reference to a hyperlink within a HyperlinkStorage, as stored in each grid cell.
+///
+/// The lower 16 bits address the slot within the storage and the upper 16 bits carry the slot's
+/// generation, such that cells still referring to an evicted hyperlink do not resolve to
+/// another hyperlink that has been stored into the same slot later on.
+struct HyperlinkId {
+    uint32_t value = 0; // 0 denotes no hyperlink
+
+    constexpr uint16_t slot() const noexcept { return static_cast<uint16_t>(value & 0xFFFF); }
+    constexpr uint16_t generation() const noexcept { return static_cast<uint16_t>(value >> 16); }
+
+    constexpr bool empty() const noexcept { return value == 0; }
+    constexpr explicit operator bool() const noexcept { return value != 0; }
+};
+
+constexpr bool operator==(HyperlinkId _a, HyperlinkId _b) noexcept { return _a.value == _b.value; }
+constexpr bool operator!=(HyperlinkId _a, HyperlinkId _b) noexcept { return _a.value != _b.value; }
+
+/**
+ * Interns the hyperlinks of a screen, such that grid cells only need to carry a HyperlinkId.
+ *
+ * The storage is bounded in memory. Once it is exhausted, the owner is expected to invoke
+ * collectGarbage() with all hyperlink IDs still referenced by any cell, which evicts all other
+ * hyperlinks, and, if that is not sufficient, also the least recently used ones.
+ */
+class HyperlinkStorage {
+  public:
+    static constexpr size_t DefaultMaxMemory = 1024 * 1024;
+    static constexpr size_t MaxCount = 0xFFFF; // slot 0 is reserved for "no hyperlink"
+
+    explicit HyperlinkStorage(size_t _maxMemory = DefaultMaxMemory) noexcept:
+        maxMemory_{_maxMemory}
+    {}
+
+    /// Adds the given hyperlink, or reuses a previously added one with the same (non-empty)
+    /// @p _userId and @p _uri.
+    ///
+    /// @returns the ID to be stored in the cells the hyperlink is applied to.
+    HyperlinkId add(std::string const& _userId, std::string const& _uri);
+
+    /// @returns the hyperlink referred to by @p _id, or nullptr if none or already evicted.
+    HyperlinkInfo* hyperlinkById(HyperlinkId _id) noexcept
+    {
+        if (_id.slot() >= slots_.size())
+            return nullptr;
+        Slot& slot = slots_[_id.slot()];
+        return slot.used && slot.generation == _id.generation() ? &slot.info : nullptr;
+    }
+
+    HyperlinkInfo const* hyperlinkById(HyperlinkId _id) const noexcept
+    {
+        return const_cast<HyperlinkStorage*>(this)->hyperlinkById(_id);
+    }
+
+    /// @returns whether or not garbage should be collected before adding any new hyperlink.
+    bool exhausted() const noexcept { return count_ >= MaxCount || memoryUsage_ >= maxMemory_; }
+
+    /// Evicts all hyperlinks that are not referenced anymore.
+    ///
+    /// If this is not freeing up at least a quarter of the storage, the least recently added
+    /// hyperlinks are evicted, too, even though cells might still refer to them.
+    ///
+    /// @param _enumerateReferences invoked with a callable that must be called with each
+    ///                             hyperlink ID that is still referenced.
+    template <typename F>
+    void collectGarbage(F _enumerateReferences)
+    {
+        auto referenced = std::vector<bool>(slots_.size(), false);
+        _enumerateReferences([&](HyperlinkId _id) {
+            if (hyperlinkById(_id))
+                referenced[_id.slot()] = true;
+        });
+        evict(referenced);
+    }
+
+    void clear();
+
+    size_t size() const noexcept { return count_; }
+    size_t memoryUsage() const noexcept { return memoryUsage_; }
+    size_t maxMemory() const noexcept { return maxMemory_; }
+    void setMaxMemory(size_t _maxMemory) noexcept { maxMemory_ = _maxMemory; }
+
+  private:
+    struct Slot {
+        HyperlinkInfo info;
+        uint16_t generation = 0;
+        bool used = false;
+        uint64_t lastUse = 0;
+    };
+
+    static size_t memoryUsageOf(HyperlinkInfo const& _info) noexcept;
+    void evict(std::vector<bool> const& _referenced);
+    void release(uint16_t _slot);
+
+    std::vector<Slot> slots_;                               // index 0 is never used
+    std::vector<uint16_t> freeSlots_;
+    std::unordered_map<std::string, uint16_t> userIds_;     // OSC 8 id parameter to slot
+    uint64_t useCounter_ = 0;
+    size_t count_ = 0;
+    size_t memoryUsage_ = 0;
+    size_t maxMemory_;
+};
+
 } // end namespace
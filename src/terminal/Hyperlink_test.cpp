@@ -0,0 +1,85 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Hyperlink.h>
+#include <catch2/catch_all.hpp>
+
+#include <fmt/format.h>
+
+using namespace terminal;
+
+TEST_CASE("HyperlinkStorage.add", "[hyperlink]")
+{
+    auto storage = HyperlinkStorage{};
+
+    auto const a = storage.add("", "https://example.com/a");
+    auto const b = storage.add("", "https://example.com/a");
+    CHECK(a);
+    CHECK(b);
+    CHECK(a != b); // hyperlinks without ID are never shared
+    REQUIRE(storage.hyperlinkById(a) != nullptr);
+    CHECK(storage.hyperlinkById(a)->uri == "https://example.com/a");
+
+    auto const c = storage.add("x", "https://example.com/c");
+    CHECK(storage.add("x", "https://example.com/c") == c);
+    CHECK(storage.size() == 3);
+
+    // Reusing an ID for another URI yields a new hyperlink, leaving the previous one intact.
+    auto const d = storage.add("x", "https://example.com/d");
+    CHECK(d != c);
+    CHECK(storage.hyperlinkById(c)->uri == "https://example.com/c");
+    CHECK(storage.hyperlinkById(d)->uri == "https://example.com/d");
+
+    CHECK(storage.hyperlinkById(HyperlinkId{}) == nullptr);
+}
+
+TEST_CASE("HyperlinkStorage.collectGarbage", "[hyperlink]")
+{
+    auto storage = HyperlinkStorage{};
+    auto const a = storage.add("a", "https://example.com/a");
+    auto const b = storage.add("b", "https://example.com/b");
+    auto const c = storage.add("", "https://example.com/c");
+
+    storage.collectGarbage([&](auto _referenced) { _referenced(c); });
+
+    CHECK(storage.size() == 1);
+    CHECK(storage.hyperlinkById(a) == nullptr);
+    CHECK(storage.hyperlinkById(b) == nullptr);
+    CHECK(storage.hyperlinkById(c) != nullptr);
+    CHECK(storage.add("b", "https://example.com/b") != b);
+
+    // Evicted slots are reused, but IDs referring to their previous hyperlinks stay invalid.
+    auto const d = storage.add("a", "https://example.com/d");
+    CHECK(d.slot() == a.slot());
+    CHECK(storage.hyperlinkById(a) == nullptr);
+    CHECK(storage.hyperlinkById(d)->uri == "https://example.com/d");
+}
+
+TEST_CASE("HyperlinkStorage.maxMemory", "[hyperlink]")
+{
+    auto storage = HyperlinkStorage{4096};
+    auto ids = std::vector<HyperlinkId>{};
+    while (!storage.exhausted())
+        ids.push_back(storage.add("", fmt::format("https://example.com/{}", ids.size())));
+    REQUIRE(ids.size() > 4);
+
+    // Even if all hyperlinks are still referenced, the least recently added ones get evicted.
+    storage.collectGarbage([&](auto _referenced) {
+        for (auto const id: ids)
+            _referenced(id);
+    });
+
+    CHECK(storage.memoryUsage() <= 3 * 1024);
+    CHECK(storage.hyperlinkById(ids.front()) == nullptr);
+    CHECK(storage.hyperlinkById(ids.back()) != nullptr);
+}
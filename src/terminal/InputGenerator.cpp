@@ -20,13 +20,12 @@
 
 #include <algorithm>
 #include <array>
+#include <cassert>
+#include <charconv>
 #include <iterator>
 #include <string_view>
-#include <unordered_map>
 #include <utility>
 
-#include <fmt/format.h>
-
 using namespace std;
 
 namespace terminal {
@@ -59,6 +58,48 @@ namespace {
         );
         return result;
     }
+
+    /// Fixed-capacity inline buffer a single input event is encoded into,
+    /// before it is appended to the pending sequence as a whole.
+    class EventBuffer {
+      public:
+        static constexpr size_t Capacity = 64;
+
+        void append(std::string_view _text) noexcept
+        {
+            assert(size_ + _text.size() <= Capacity);
+            std::copy(_text.begin(), _text.end(), data_.data() + size_);
+            size_ += _text.size();
+        }
+
+        void append(char _char) noexcept
+        {
+            assert(size_ < Capacity);
+            data_[size_++] = _char;
+        }
+
+        void append(unsigned _number) noexcept
+        {
+            auto const result = std::to_chars(data_.data() + size_, data_.data() + Capacity, _number);
+            assert(result.ec == std::errc{});
+            size_ = static_cast<size_t>(result.ptr - data_.data());
+        }
+
+        /// Appends the UTF-8 encoding of the given codepoint.
+        void append(char32_t _codepoint) noexcept
+        {
+            uint8_t u8[4];
+            size_t const count = distance(u8, unicode::encoder<char>{}(_codepoint, u8));
+            for (size_t i = 0; i < count; ++i)
+                append(static_cast<char>(u8[i]));
+        }
+
+        std::string_view view() const noexcept { return std::string_view(data_.data(), size_); }
+
+      private:
+        std::array<char, Capacity> data_{};
+        size_t size_ = 0;
+    };
 }
 
 namespace mappings {
@@ -67,17 +108,12 @@ namespace mappings {
         std::string_view const mapping{};
     };
 
-    // TODO: implement constexpr-binary-search by:
-    // - adding operator<(KeyMapping a, KeyMapping b) { return a.key < b.key; }
-    // - constexpr-evaluated sort()ed array returned in lambda-expr to be assigned to these globals here.
-    // - make use of this property and let tryMap() do a std::binary_search()
-
     #define ESC "\x1B"
     #define CSI "\x1B["
     #define SS3 "\x1BO"
 
-    // the modifier parameter is going to be replaced via fmt::format()
-    array<KeyMapping, 30> functionKeysWithModifiers{
+    // the modifier parameter is going to be substituted for the "{}" placeholder
+    constexpr array<KeyMapping, 30> functionKeysWithModifiers{
         // Note, that F1..F4 is using CSI too instead of ESC when used with modifier keys.
         // XXX: Maybe I am blind when reading ctlseqs.txt, but F1..F4 with "1;{}P".. seems not to
         // match what other terminal emulators send out with modifiers and I don't see how to match
@@ -118,7 +154,7 @@ namespace mappings {
         KeyMapping{Key::PageDown, CSI "6;{}~"},
     };
 
-    array<KeyMapping, 22> standard{
+    constexpr array<KeyMapping, 22> standard{
         // cursor keys
         KeyMapping{Key::UpArrow, CSI "A"},
         KeyMapping{Key::DownArrow, CSI "B"},
@@ -149,7 +185,7 @@ namespace mappings {
     };
 
     /// (DECCKM) Cursor key mode: mappings in when cursor key application mode is set.
-    array<KeyMapping, 6> applicationCursorKeys{
+    constexpr array<KeyMapping, 6> applicationCursorKeys{
         KeyMapping{Key::UpArrow, SS3 "A"},
         KeyMapping{Key::DownArrow, SS3 "B"},
         KeyMapping{Key::RightArrow, SS3 "C"},
@@ -158,7 +194,7 @@ namespace mappings {
         KeyMapping{Key::End, SS3 "F"},
     };
 
-    array<KeyMapping, 21> applicationKeypad{
+    constexpr array<KeyMapping, 21> applicationKeypad{
         KeyMapping{Key::Numpad_NumLock, SS3 "P"},
         KeyMapping{Key::Numpad_Divide, SS3 "Q"},
         KeyMapping{Key::Numpad_Multiply, SS3 "Q"},
@@ -191,17 +227,29 @@ namespace mappings {
     #undef CSI
     #undef SS3
 
-    constexpr bool operator==(KeyMapping const& _km, Key _key) noexcept
+    constexpr size_t KeyCount = static_cast<size_t>(Key::Numpad_9) + 1;
+
+    /// Key sequences indexed by key, with an empty sequence for unmapped keys.
+    using KeyTable = array<string_view, KeyCount>;
+
+    template <size_t N>
+    constexpr KeyTable makeKeyTable(array<KeyMapping, N> const& _mappings) noexcept
     {
-        return _km.key == _key;
+        KeyTable table{};
+        for (KeyMapping const& km : _mappings)
+            table[static_cast<size_t>(km.key)] = km.mapping;
+        return table;
     }
 
-    template<size_t N>
-    optional<string_view> tryMap(array<KeyMapping, N> const& _mappings, Key _key) noexcept
+    constexpr KeyTable functionKeysWithModifiersTable = makeKeyTable(functionKeysWithModifiers);
+    constexpr KeyTable standardTable = makeKeyTable(standard);
+    constexpr KeyTable applicationCursorKeysTable = makeKeyTable(applicationCursorKeys);
+    constexpr KeyTable applicationKeypadTable = makeKeyTable(applicationKeypad);
+
+    constexpr optional<string_view> tryMap(KeyTable const& _table, Key _key) noexcept
     {
-        for (KeyMapping const& km : _mappings)
-            if (km.key == _key)
-                return { km.mapping };
+        if (auto const mapping = _table[static_cast<size_t>(_key)]; !mapping.empty())
+            return mapping;
 
         return nullopt;
     }
@@ -308,6 +356,7 @@ void InputGenerator::reset()
     mouseProtocol_ = std::nullopt;
     mouseTransport_ = MouseTransport::Default;
     mouseWheelMode_ = MouseWheelMode::Default;
+    pendingMouseMove_.reset();
 
     // pendingSequence_ = {};
     // currentlyPressedMouseButtons_ = {};
@@ -336,7 +385,7 @@ void InputGenerator::setApplicationKeypadMode(bool _enable)
     debuglog(InputTag).write("set application keypad mode: {} -> {}", _enable, numpadKeysMode_);
 }
 
-bool InputGenerator::generate(u32string const& _characterEvent, Modifier _modifier)
+bool InputGenerator::generate(u32string_view _characterEvent, Modifier _modifier)
 {
     for (char32_t const ch: _characterEvent)
         generate(ch, _modifier);
@@ -345,6 +394,8 @@ bool InputGenerator::generate(u32string const& _characterEvent, Modifier _modifi
 
 bool InputGenerator::generate(char32_t _characterEvent, Modifier _modifier)
 {
+    flushPendingMouseMove();
+
     char const chr = static_cast<char>(_characterEvent);
 
     // See section "Alt and Meta Keys" in ctlseqs.txt from xterm.
@@ -379,33 +430,37 @@ bool InputGenerator::generate(char32_t _characterEvent, Modifier _modifier)
     if (_modifier == Modifier::Control && _characterEvent >= '[' && _characterEvent <= '_')
         return append(static_cast<char>(chr - 'A' + 1)); // remaining C0 characters 0x1B .. 0x1F
 
-    if (_modifier.without(Modifier::Alt).none() || _modifier == Modifier::Shift)
-        return append(unicode::convert_to<char>(_characterEvent));
-
-    if (_characterEvent < 0x7F)
-        append(static_cast<char>(_characterEvent));
-    else
-        append(unicode::convert_to<char>(_characterEvent));
-    return true;
+    EventBuffer event;
+    event.append(_characterEvent);
+    return append(event.view());
 }
 
 bool InputGenerator::generate(Key _key, Modifier _modifier)
 {
+    flushPendingMouseMove();
+
     if (_modifier)
     {
-        if (auto mapping = tryMap(mappings::functionKeysWithModifiers, _key); mapping)
-            return append(fmt::format(*mapping, makeVirtualTerminalParam(_modifier)));
+        if (auto mapping = mappings::tryMap(mappings::functionKeysWithModifiersTable, _key); mapping)
+        {
+            auto const placeholder = mapping->find("{}");
+            EventBuffer event;
+            event.append(mapping->substr(0, placeholder));
+            event.append(static_cast<unsigned>(makeVirtualTerminalParam(_modifier)));
+            event.append(mapping->substr(placeholder + 2));
+            return append(event.view());
+        }
     }
 
     if (applicationCursorKeys())
-        if (auto mapping = tryMap(mappings::applicationCursorKeys, _key); mapping)
+        if (auto mapping = mappings::tryMap(mappings::applicationCursorKeysTable, _key); mapping)
             return append(*mapping);
 
     if (applicationKeypad())
-        if (auto mapping = tryMap(mappings::applicationKeypad, _key); mapping)
+        if (auto mapping = mappings::tryMap(mappings::applicationKeypadTable, _key); mapping)
             return append(*mapping);
 
-    if (auto mapping = tryMap(mappings::standard, _key); mapping)
+    if (auto mapping = mappings::tryMap(mappings::standardTable, _key); mapping)
         return append(*mapping);
 
     return false;
@@ -413,6 +468,8 @@ bool InputGenerator::generate(Key _key, Modifier _modifier)
 
 void InputGenerator::generatePaste(std::string_view const& _text)
 {
+    flushPendingMouseMove();
+
     if (bracketedPaste_)
         append("\033[200~"sv);
 
@@ -424,6 +481,7 @@ void InputGenerator::generatePaste(std::string_view const& _text)
 
 void InputGenerator::swap(Sequence& _other)
 {
+    flushPendingMouseMove();
     std::swap(pendingSequence_, _other);
 }
 
@@ -447,13 +505,15 @@ inline bool InputGenerator::append(uint8_t _byte)
 
 inline bool InputGenerator::append(unsigned int _number)
 {
-    char buf[16];
-    int n = snprintf(buf, sizeof(buf), "%u", _number);
-    return append(string_view(buf, n));
+    EventBuffer event;
+    event.append(_number);
+    return append(event.view());
 }
 
 bool InputGenerator::generateFocusInEvent()
 {
+    flushPendingMouseMove();
+
     if (generateFocusEvents())
     {
         append("\033[I");
@@ -464,6 +524,8 @@ bool InputGenerator::generateFocusInEvent()
 
 bool InputGenerator::generateFocusOutEvent()
 {
+    flushPendingMouseMove();
+
     if (generateFocusEvents())
     {
         append("\033[O");
@@ -474,6 +536,8 @@ bool InputGenerator::generateFocusOutEvent()
 
 bool InputGenerator::generateRaw(std::string_view const& _raw)
 {
+    flushPendingMouseMove();
+
     append(_raw);
     return true;
 }
@@ -481,6 +545,9 @@ bool InputGenerator::generateRaw(std::string_view const& _raw)
 // {{{ mouse handling
 void InputGenerator::setMouseProtocol(MouseProtocol _mouseProtocol, bool _enabled)
 {
+    // A pending mouse move happened before the change, so it is reported as requested back then.
+    flushPendingMouseMove();
+
     if (_enabled)
     {
         mouseWheelMode_ = MouseWheelMode::Default;
@@ -492,6 +559,7 @@ void InputGenerator::setMouseProtocol(MouseProtocol _mouseProtocol, bool _enable
 
 void InputGenerator::setMouseTransport(MouseTransport _mouseTransport)
 {
+    flushPendingMouseMove();
     mouseTransport_ = _mouseTransport;
 }
 
@@ -655,11 +723,12 @@ bool InputGenerator::mouseTransportX10(uint8_t _button, uint8_t _modifier, int _
         uint8_t const button = SkipCount + static_cast<uint8_t>(_button | _modifier);
         uint8_t const row = static_cast<uint8_t>(SkipCount + _row);
         uint8_t const column = static_cast<uint8_t>(SkipCount + _column);
-        append("\033[M");
-        append(button);
-        append(column);
-        append(row);
-        return true;
+        EventBuffer event;
+        event.append("\033[M");
+        event.append(static_cast<char>(button));
+        event.append(static_cast<char>(column));
+        event.append(static_cast<char>(row));
+        return append(event.view());
     }
     else
         return false;
@@ -667,34 +736,39 @@ bool InputGenerator::mouseTransportX10(uint8_t _button, uint8_t _modifier, int _
 
 bool InputGenerator::mouseTransportSGR(uint8_t _button, uint8_t _modifier, int _row, int _column, MouseEventType _eventType)
 {
-    append("\033[<");
-    append(static_cast<unsigned>(_button | _modifier));
-    append(';');
-    append(static_cast<unsigned>(_column));
-    append(';');
-    append(static_cast<unsigned>(_row));
-    append(_eventType != MouseEventType::Release ? 'M' : 'm');
+    EventBuffer event;
+    event.append("\033[<");
+    event.append(static_cast<unsigned>(_button | _modifier));
+    event.append(';');
+    event.append(static_cast<unsigned>(_column));
+    event.append(';');
+    event.append(static_cast<unsigned>(_row));
+    event.append(_eventType != MouseEventType::Release ? 'M' : 'm');
 
-    return true;
+    return append(event.view());
 }
 
 bool InputGenerator::mouseTransportURXVT(uint8_t _button, uint8_t _modifier, int _row, int _column, MouseEventType _eventType)
 {
     if (_eventType == MouseEventType::Press)
     {
-        append("\033[");
-        append(static_cast<unsigned>(_button | _modifier));
-        append(';');
-        append(static_cast<unsigned>(_column));
-        append(';');
-        append(static_cast<unsigned>(_row));
-        append('M');
+        EventBuffer event;
+        event.append("\033[");
+        event.append(static_cast<unsigned>(_button | _modifier));
+        event.append(';');
+        event.append(static_cast<unsigned>(_column));
+        event.append(';');
+        event.append(static_cast<unsigned>(_row));
+        event.append('M');
+        append(event.view());
     }
     return true;
 }
 
 bool InputGenerator::generateMousePress(MouseButton _button, Modifier _modifier, int _row, int _column)
 {
+    flushPendingMouseMove();
+
     currentMousePosition_ = {_row, _column};
 
     switch (mouseWheelMode())
@@ -730,18 +804,17 @@ bool InputGenerator::generateMousePress(MouseButton _button, Modifier _modifier,
     }
 
     if (!isMouseWheel(_button))
-        if (!currentlyPressedMouseButtons_.count(_button))
-            currentlyPressedMouseButtons_.insert(_button);
+        currentlyPressedMouseButtons_.set(static_cast<size_t>(_button));
 
     return generateMouse(_button, _modifier, _row, _column, MouseEventType::Press);
 }
 
 bool InputGenerator::generateMouseRelease(MouseButton _button, Modifier _modifier, int _row, int _column)
 {
-    currentMousePosition_ = {_row, _column};
+    flushPendingMouseMove();
 
-    if (auto i = currentlyPressedMouseButtons_.find(_button); i != currentlyPressedMouseButtons_.end())
-        currentlyPressedMouseButtons_.erase(i);
+    currentMousePosition_ = {_row, _column};
+    currentlyPressedMouseButtons_.reset(static_cast<size_t>(_button));
 
     return generateMouse(_button, _modifier, _row, _column, MouseEventType::Release);
 }
@@ -756,20 +829,35 @@ bool InputGenerator::generateMouseMove(int _row, int _column, Modifier _modifier
 
     currentMousePosition_ = {_row, _column};
 
-    bool const buttonsPressed = !currentlyPressedMouseButtons_.empty();
+    bool const buttonsPressed = currentlyPressedMouseButtons_.any();
 
     bool const report = (mouseProtocol_.value() == MouseProtocol::ButtonTracking && buttonsPressed)
                       || mouseProtocol_.value() == MouseProtocol::AnyEventTracking;
 
-    if (report)
-        return generateMouse(buttonsPressed ? *currentlyPressedMouseButtons_.begin() // what if multiple are pressed?
-                                            : MouseButton::Release,
-                             _modifier,
-                             _row,
-                             _column,
-                             MouseEventType::Drag);
+    if (!report)
+        return false;
 
-    return false;
+    auto const button = [&]() {
+        for (size_t i = 0; i < currentlyPressedMouseButtons_.size(); ++i)
+            if (currentlyPressedMouseButtons_.test(i))
+                return static_cast<MouseButton>(i); // what if multiple are pressed?
+        return MouseButton::Release;
+    }();
+
+    // Only the most recent of consecutive mouse moves is going to be reported.
+    pendingMouseMove_ = MouseMove{button, _modifier, currentMousePosition_};
+    return true;
+}
+
+void InputGenerator::flushPendingMouseMove()
+{
+    if (!pendingMouseMove_.has_value())
+        return;
+
+    auto const move = *pendingMouseMove_;
+    pendingMouseMove_.reset();
+
+    generateMouse(move.button, move.modifier, move.position.row, move.position.column, MouseEventType::Drag);
 }
 // }}}
 
@@ -20,8 +20,9 @@
 #include <crispy/escape.h>
 #include <unicode/convert.h>
 
+#include <array>
+#include <bitset>
 #include <optional>
-#include <set>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -209,6 +210,8 @@ enum class MouseButton {
     WheelDown,
 };
 
+constexpr size_t MouseButtonCount = static_cast<size_t>(MouseButton::WheelDown) + 1;
+
 std::string to_string(MouseButton _button);
 
 enum class MouseTransport {
@@ -267,10 +270,15 @@ class InputGenerator {
     bool generateFocusEvents() const noexcept { return generateFocusEvents_; }
 
     bool generate(char32_t _characterEvent, Modifier _modifier);
-    bool generate(std::u32string const& _characterEvent, Modifier _modifier);
+    bool generate(std::u32string_view _characterEvent, Modifier _modifier);
     bool generate(Key _key, Modifier _modifier);
     void generatePaste(std::string_view const& _text);
     bool generateMousePress(MouseButton _button, Modifier _modifier, int _row, int _column);
+
+    /// Generates a mouse move report, if demanded by the current mouse protocol.
+    ///
+    /// Consecutive mouse moves are coalesced into one report of the most recent position,
+    /// which is generated along with the next input event or swap() at the latest.
     bool generateMouseMove(int _row, int _column, Modifier _modifier);
     bool generateMouseRelease(MouseButton _button, Modifier _modifier, int _row, int _column);
 
@@ -280,12 +288,15 @@ class InputGenerator {
     /// Generates raw input, usually used for sending reply VT sequences.
     bool generateRaw(std::string_view const& _raw);
 
-    /// Swaps out the generated input control sequences.
+    /// Swaps out the generated input control sequences, including a pending mouse move report.
     void swap(Sequence& _other);
 
+    /// @returns whether a mouse move report is pending, i.e. not yet generated.
+    bool mouseMovePending() const noexcept { return pendingMouseMove_.has_value(); }
+
     /// Peeks into the generated output, returning it as string view.
     ///
-    /// @return a view into the generated buffer sequence.
+    /// @return a view into the generated buffer sequence, excluding a pending mouse move report.
     std::string_view peek() const noexcept
     {
         return std::string_view(pendingSequence_.data(), pendingSequence_.size());
@@ -303,6 +314,8 @@ class InputGenerator {
                        int _column,
                        MouseEventType _eventType);
 
+    void flushPendingMouseMove();
+
     bool mouseTransport(uint8_t _button, uint8_t _modifier, int _row, int _column, MouseEventType _type);
     bool mouseTransportX10(uint8_t _button, uint8_t _modifier, int _row, int _column);
     bool mouseTransportSGR(uint8_t _button, uint8_t _modifier, int _row, int _column, MouseEventType _type);
@@ -323,8 +336,15 @@ class InputGenerator {
     MouseWheelMode mouseWheelMode_ = MouseWheelMode::Default;
     Sequence pendingSequence_{};
 
-    std::set<MouseButton> currentlyPressedMouseButtons_{};
+    struct MouseMove {
+        MouseButton button;
+        Modifier modifier;
+        Coordinate position;
+    };
+
+    std::bitset<MouseButtonCount> currentlyPressedMouseButtons_{};
     Coordinate currentMousePosition_{0, 0}; // current mouse position
+    std::optional<MouseMove> pendingMouseMove_{}; // most recent mouse move, not yet reported
 };
 
 inline std::string to_string(InputGenerator::MouseEventType _value)
@@ -104,3 +104,89 @@ TEST_CASE("InputGenerator.all(Ctrl + A..Z)", "[terminal,input]")
         REQUIRE(escape(input.peek()) == escape(c0));
     }
 }
+
+TEST_CASE("InputGenerator.Key with modifier", "[terminal,input]")
+{
+    auto input = InputGenerator{};
+    input.generate(terminal::Key::F5, Modifier::Control);
+    input.generate(terminal::Key::UpArrow, Modifier::Shift);
+    REQUIRE(escape(input.peek()) == escape("\033[15;5~\033[1;2A"));
+}
+
+TEST_CASE("InputGenerator.UTF-8", "[terminal,input]")
+{
+    auto input = InputGenerator{};
+    input.generate(U"ä€\U0001F600", Modifier::None);
+    REQUIRE(escape(input.peek()) == escape("\xC3\xA4\xE2\x82\xAC\xF0\x9F\x98\x80"));
+}
+
+TEST_CASE("InputGenerator.mouse move coalescing", "[terminal,input]")
+{
+    using terminal::MouseButton;
+
+    auto input = InputGenerator{};
+    input.setMouseProtocol(terminal::MouseProtocol::ButtonTracking, true);
+    input.setMouseTransport(terminal::MouseTransport::SGR);
+
+    // Mouse moves without pressed buttons are not reported in button tracking mode.
+    CHECK_FALSE(input.generateMouseMove(2, 3, Modifier::None));
+    CHECK_FALSE(input.mouseMovePending());
+
+    input.generateMousePress(MouseButton::Left, Modifier::None, 2, 3);
+    CHECK(input.generateMouseMove(3, 4, Modifier::None));
+    CHECK(input.generateMouseMove(4, 5, Modifier::None));
+    CHECK(input.generateMouseMove(5, 6, Modifier::None));
+    CHECK(input.mouseMovePending());
+    CHECK(escape(input.peek()) == escape("\033[<0;3;2M"));
+
+    // The most recent mouse move is reported before the next input event.
+    input.generateMouseRelease(MouseButton::Left, Modifier::None, 5, 6);
+    CHECK_FALSE(input.mouseMovePending());
+    CHECK(escape(input.peek()) == escape("\033[<0;3;2M\033[<32;6;5M\033[<0;6;5m"));
+
+    // ... or when swapping out the generated sequences at the latest.
+    input.setMouseProtocol(terminal::MouseProtocol::AnyEventTracking, true);
+    Buffer output;
+    input.swap(output);
+    CHECK(input.generateMouseMove(7, 8, Modifier::None));
+    CHECK(input.generateMouseMove(8, 9, Modifier::None));
+    output.clear();
+    input.swap(output);
+    CHECK_FALSE(input.mouseMovePending());
+    CHECK(escape(string_view(output.data(), output.size())) == escape("\033[<35;9;8M"));
+}
+
+TEST_CASE("InputGenerator.mouse move across mouse mode changes", "[terminal,input]")
+{
+    auto input = InputGenerator{};
+    input.setMouseProtocol(terminal::MouseProtocol::AnyEventTracking, true);
+    input.setMouseTransport(terminal::MouseTransport::SGR);
+
+    SECTION("transport") {
+        // The pending move is reported in the transport that was active when it happened.
+        CHECK(input.generateMouseMove(2, 3, Modifier::None));
+        input.setMouseTransport(terminal::MouseTransport::Default);
+        CHECK_FALSE(input.mouseMovePending());
+        CHECK(escape(input.peek()) == escape("\033[<35;3;2M"));
+    }
+
+    SECTION("protocol disabled") {
+        CHECK(input.generateMouseMove(2, 3, Modifier::None));
+        input.setMouseProtocol(terminal::MouseProtocol::AnyEventTracking, false);
+        CHECK_FALSE(input.mouseMovePending());
+        CHECK(escape(input.peek()) == escape("\033[<35;3;2M"));
+
+        // ... and no further moves are reported afterwards.
+        CHECK_FALSE(input.generateMouseMove(3, 4, Modifier::None));
+        Buffer output;
+        input.swap(output);
+        CHECK(escape(string_view(output.data(), output.size())) == escape("\033[<35;3;2M"));
+    }
+
+    SECTION("reset") {
+        CHECK(input.generateMouseMove(2, 3, Modifier::None));
+        input.reset();
+        CHECK_FALSE(input.mouseMovePending());
+        CHECK(input.peek().empty());
+    }
+}
@@ -0,0 +1,108 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Metrics.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <numeric>
+
+using std::accumulate;
+using std::pair;
+using std::vector;
+
+namespace terminal {
+
+size_t Metrics::indexOf(FunctionDefinition const& _function) noexcept
+{
+    auto const& funcs = functions();
+
+    // Fast path: the definition is a reference into the table itself (as returned by select()).
+    if (&_function >= funcs.data() && &_function < funcs.data() + funcs.size())
+        return static_cast<size_t>(&_function - funcs.data());
+
+    auto const i = std::lower_bound(funcs.begin(), funcs.end(), _function);
+    return static_cast<size_t>(std::distance(funcs.begin(), i));
+}
+
+uint64_t Metrics::bytes(FunctionCategory _category) const noexcept
+{
+    using parser::State;
+    auto const count = [this](State _state) { return states[static_cast<size_t>(_state)]; };
+
+    switch (_category)
+    {
+        case FunctionCategory::C0:
+            return controls;
+        case FunctionCategory::ESC:
+            return count(State::Escape) + count(State::EscapeIntermediate);
+        case FunctionCategory::CSI:
+            return count(State::CSI_Entry) + count(State::CSI_Param)
+                 + count(State::CSI_Intermediate) + count(State::CSI_Ignore);
+        case FunctionCategory::OSC:
+            return count(State::OSC_String);
+        case FunctionCategory::DCS:
+            return count(State::DCS_Entry) + count(State::DCS_Param) + count(State::DCS_Intermediate)
+                 + count(State::DCS_PassThrough) + count(State::DCS_Ignore);
+    }
+    return 0;
+}
+
+uint64_t Metrics::totalSequences() const noexcept
+{
+    return accumulate(sequences.begin(), sequences.end(), uint64_t{0});
+}
+
+vector<pair<FunctionDefinition const*, uint64_t>> Metrics::ordered() const
+{
+    auto const& funcs = functions();
+
+    vector<pair<FunctionDefinition const*, uint64_t>> vec;
+    for (size_t i = 0; i < sequences.size(); ++i)
+        if (sequences[i] != 0)
+            vec.emplace_back(pair{&funcs[i], sequences[i]});
+
+    std::sort(vec.begin(), vec.end(), [](auto const& a, auto const& b) {
+        if (a.second != b.second)
+            return a.second > b.second;
+        return a.first->mnemonic < b.first->mnemonic;
+    });
+    return vec;
+}
+
+void Metrics::dump(std::ostream& _os) const
+{
+    using parser::State;
+
+    _os << "Input (codepoints):\n";
+    _os << fmt::format("    {:<12} {:>14}\n", "Text", text);
+    for (auto const category: {FunctionCategory::C0, FunctionCategory::ESC, FunctionCategory::CSI,
+                               FunctionCategory::OSC, FunctionCategory::DCS})
+        _os << fmt::format("    {:<12} {:>14}\n", category, bytes(category));
+
+    _os << "\nParser state dwell (codepoints):\n";
+    for (auto i = static_cast<size_t>(std::numeric_limits<State>::min()); i < states.size(); ++i)
+        _os << fmt::format("    {:<20} {:>14}\n", static_cast<State>(i), states[i]);
+
+    _os << fmt::format("\nSequences ({} total):\n", totalSequences());
+    for (auto const& [function, count]: ordered())
+        _os << fmt::format("    {:<20} {:>14}    {}\n", function->mnemonic, count, function->comment);
+
+    for (auto const category: {FunctionCategory::C0, FunctionCategory::ESC, FunctionCategory::CSI,
+                               FunctionCategory::OSC, FunctionCategory::DCS})
+        if (auto const count = unknownSequences[static_cast<size_t>(category)]; count != 0)
+            _os << fmt::format("    {:<20} {:>14}\n", fmt::format("unknown {}", category), count);
+}
+
+} // end namespace
@@ -13,40 +13,67 @@
  */
 #pragma once
 
-#include <terminal/Sequencer.h> // Sequence
+#include <terminal/Functions.h>
+#include <terminal/Parser.h> // parser::State
 
-#include <algorithm>
-#include <map>
-#include <string>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace terminal {
 
 /// Used for collecting VT sequence usage metrics.
+///
+/// All counters live in flat arrays, indexed by the position of a FunctionDefinition
+/// within functions() respectively by the parser state, so that collecting them boils down
+/// to a few integer increments and is cheap enough to be always enabled.
 struct Metrics {
-    // XXX Too bad the key is a string.
-    std::map<std::string, uint64_t> sequences;
+    static constexpr size_t FunctionCount = std::tuple_size_v<std::remove_cv_t<std::remove_reference_t<decltype(functions())>>>;
+    static constexpr size_t StateCount = std::numeric_limits<parser::State>::size();
 
-    void operator()(Sequence const& _seq)
-    {
-        sequences[_seq.text()]++;
-    }
+    /// Number of dispatched sequences, indexed by their FunctionDefinition's index in functions().
+    std::array<uint64_t, FunctionCount> sequences{};
+
+    /// Number of sequences that did not match any known FunctionDefinition, per FunctionCategory.
+    std::array<uint64_t, 5> unknownSequences{};
+
+    /// Number of printed text codepoints.
+    uint64_t text = 0;
+
+    /// Number of executed C0 control characters.
+    uint64_t controls = 0;
+
+    /// Number of input codepoints consumed per parser state (see parser::Parser::stateCounters()).
+    ///
+    /// This is the parser's dwell time in each state, measured in input units rather than in
+    /// wall clock time, as reading a clock for every byte would be way too expensive.
+    /// The introducing ESC of 7-bit CSI, OSC and DCS sequences is accounted to the Escape state.
+    std::array<uint64_t, StateCount> states{};
+
+    /// @returns the index of the given function within functions().
+    static size_t indexOf(FunctionDefinition const& _function) noexcept;
+
+    void operator()(FunctionDefinition const& _function) noexcept { ++sequences[indexOf(_function)]; }
+
+    void unknown(FunctionCategory _category) noexcept { ++unknownSequences[static_cast<size_t>(_category)]; }
+
+    /// @returns the number of input codepoints that went into sequences of the given category.
+    uint64_t bytes(FunctionCategory _category) const noexcept;
+
+    /// @returns the total number of dispatched known sequences.
+    uint64_t totalSequences() const noexcept;
+
+    void reset() noexcept { *this = Metrics{}; }
 
     /// @returns an ordered list of collected metrics, with highest frequencey first.
-    std::vector<std::pair<std::string, uint64_t>> ordered() const
-    {
-        std::vector<std::pair<std::string, uint64_t>> vec;
-        for (auto const& [name, freq] : sequences)
-            vec.emplace_back(std::pair{name, freq});
-
-        std::sort(vec.begin(), vec.end(), [](auto const& a, auto const& b) {
-            if (a.second > b.second)
-                return true;
-            if (a.second == b.second)
-                return a.first > b.first;
-            return false;
-        });
-        return vec;
-    }
+    std::vector<std::pair<FunctionDefinition const*, uint64_t>> ordered() const;
+
+    /// Writes a human readable report of all collected metrics.
+    void dump(std::ostream& _os) const;
 };
 
 } // end namespace
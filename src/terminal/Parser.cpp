@@ -82,35 +82,78 @@ inline size_t countAsciiTextChars(uint8_t const* _begin, uint8_t const* _end) no
 
 void Parser::parseFragment(string_view _data)
 {
+    static constexpr char32_t ReplacementCharacter {0xFFFD};
+
     auto input = reinterpret_cast<uint8_t const*>(_data.data());
-    auto end = reinterpret_cast<uint8_t const*>(_data.data() + _data.size());
+    auto const end = reinterpret_cast<uint8_t const*>(_data.data() + _data.size());
 
-    do
+    while (input != end)
     {
-        if (state_ == State::Ground && !utf8DecoderState_.expectedLength)
+        if (utf8DecoderState_.expectedLength || *input >= 0x80)
+        {
+            unicode::ConvertResult const r = unicode::from_utf8(utf8DecoderState_, *input);
+
+            if (std::holds_alternative<unicode::Success>(r))
+                processInput(std::get<unicode::Success>(r).value);
+            else if (std::holds_alternative<unicode::Invalid>(r))
+                processInput(ReplacementCharacter);
+
+            ++input;
+            continue;
+        }
+
+        if (state_ == State::Ground)
         {
             if (auto count = countAsciiTextChars(input, end); count > 0)
             {
+                stateCounters_[static_cast<size_t>(State::Ground)] += count;
                 eventListener_.print(string_view{reinterpret_cast<char const*>(input), count});
                 input += count;
+                continue;
             }
         }
 
-        static constexpr char32_t ReplacementCharacter {0xFFFD};
+        input = processRun(input, end);
+    }
+}
 
-        while (input != end || utf8DecoderState_.expectedLength)
-        {
-            unicode::ConvertResult const r = unicode::from_utf8(utf8DecoderState_, *input);
+auto Parser::processRun(iterator _begin, iterator _end) -> iterator
+{
+    auto const state = state_;
+    auto const& entry = table_(state, *_begin);
 
-            if (std::holds_alternative<unicode::Success>(r))
-                processInput(std::get<unicode::Success>(r).value);
-            else if (std::holds_alternative<unicode::Invalid>(r))
-                processInput(ReplacementCharacter);
+    if (!entry.run())
+    {
+        processInput(*_begin);
+        return _begin + 1;
+    }
 
-            ++input;
-        }
+    auto input = _begin + 1;
+    while (input != _end && *input < 0x80 && table_(state, *input) == entry)
+        ++input;
+
+    auto const run = string_view(reinterpret_cast<char const*>(_begin), static_cast<size_t>(input - _begin));
+    stateCounters_[static_cast<size_t>(state)] += run.size();
+
+    switch (entry.action)
+    {
+        case Action::Print:
+            eventListener_.print(run);
+            break;
+        case Action::Param:
+            eventListener_.param(run);
+            break;
+        case Action::OSC_Put:
+            eventListener_.putOSC(run);
+            break;
+        case Action::Put:
+            eventListener_.put(run);
+            break;
+        default: // Action::Ignore
+            break;
     }
-    while (input != end);
+
+    return input;
 }
 
 // {{{ dot
@@ -709,11 +709,86 @@ constexpr ParserTable ParserTable::get() // {{{
     }
 
     // TODO: verify the above is correct (programatically as much as possible)
-    // TODO: see if we can reduce the preassure on L2 caches (is this even an issue?)
 
     return t;
 } // }}}
 
+/**
+ * Flattened form of the ParserTable, combining the state transition and the action
+ * of a (State, Byte) pair into a single entry, such that each input is looked up only once.
+ *
+ * The rows of the states are padded to a multiple of the cache line size, such that
+ * the entries of a state's 7-bit input span as few cache lines as possible.
+ */
+struct ParserTransitionTable {
+    struct Entry {
+        State next = State::Undefined; ///< state to transition to, or Undefined if the state is kept
+        Action action = Action::Undefined;
+
+        constexpr bool operator==(Entry const& _other) const noexcept
+        {
+            return next == _other.next && action == _other.action;
+        }
+
+        /// Tests whether this entry's action can be applied to a run of inputs at once,
+        /// such as consuming digits into a parameter or passing on a printable run of text.
+        constexpr bool run() const noexcept
+        {
+            if (next != State::Undefined)
+                return false;
+
+            switch (action)
+            {
+                case Action::Ignore:
+                case Action::Print:
+                case Action::Param:
+                case Action::OSC_Put:
+                case Action::Put:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+    };
+
+    static constexpr size_t InputCount = 257;
+    static constexpr size_t CacheLineSize = 64;
+    static constexpr size_t RowSize = (InputCount * sizeof(Entry) + CacheLineSize - 1)
+                                    / CacheLineSize * CacheLineSize / sizeof(Entry);
+
+    alignas(CacheLineSize) std::array<Entry, std::numeric_limits<State>::size() * RowSize> entries{};
+
+    //! actions to be invoked upon state entry
+    std::array<Action, std::numeric_limits<State>::size()> entryEvents{};
+
+    //! actions to be invoked upon state exit
+    std::array<Action, std::numeric_limits<State>::size()> exitEvents{};
+
+    constexpr Entry const& operator()(State _state, size_t _input) const noexcept
+    {
+        return entries[static_cast<size_t>(_state) * RowSize + _input];
+    }
+
+    static constexpr ParserTransitionTable from(ParserTable const& _table);
+};
+
+constexpr ParserTransitionTable ParserTransitionTable::from(ParserTable const& _table)
+{
+    auto t = ParserTransitionTable{};
+
+    for (size_t state = 0; state < std::numeric_limits<State>::size(); ++state)
+    {
+        for (size_t input = 0; input < InputCount; ++input)
+            t.entries[state * RowSize + input] = Entry{_table.transitions[state][input],
+                                                       _table.events[state][input]};
+
+        t.entryEvents[state] = _table.entryEvents[state];
+        t.exitEvents[state] = _table.exitEvents[state];
+    }
+
+    return t;
+}
+
 /**
  * Terminal Parser.
  *
@@ -741,12 +816,33 @@ class Parser {
             processInput(codepoint);
     }
 
+    using StateCounters = std::array<uint64_t, std::numeric_limits<State>::size()>;
+
+    /// @returns the number of input codepoints consumed per state.
+    ///
+    /// A codepoint that causes a transition is accounted to the state being entered,
+    /// or to the state being left if that transition goes back to the ground state,
+    /// such that all bytes of a sequence are accounted to that sequence's states.
+    StateCounters const& stateCounters() const noexcept { return stateCounters_; }
+    void resetStateCounters() noexcept { stateCounters_ = {}; }
+
   private:
     void processInput(char32_t _ch);
+
+    /// Processes the 7-bit input at @p _begin along with all immediately following inputs
+    /// that cause the same action in the current state, without dispatching each one individually.
+    ///
+    /// @returns an iterator to the first input not processed.
+    iterator processRun(iterator _begin, iterator _end);
+
     void handle(ActionClass _actionClass, Action _action, char32_t _char);
 
   private:
+    /// The transition table shared by all parsers.
+    static constexpr ParserTransitionTable table_ = ParserTransitionTable::from(ParserTable::get());
+
     State state_ = State::Ground;
+    StateCounters stateCounters_{};
     unicode::utf8_decoder_state utf8DecoderState_{};
 
     ParserEvents& eventListener_;
@@ -756,22 +852,27 @@ inline void Parser::processInput(char32_t _ch)
 {
     auto const s = static_cast<size_t>(state_);
 
-    ParserTable static constexpr table = ParserTable::get();
-
     auto const ch = _ch < 0xFF ? _ch : static_cast<char32_t>(ParserTable::UnicodeCodepoint::Value);
+    auto const& entry = table_(state_, ch);
 
-    if (auto const t = table.transitions[s][ch]; t != State::Undefined)
+    if (auto const t = entry.next; t != State::Undefined)
     {
+        ++stateCounters_[t != State::Ground ? static_cast<size_t>(t) : s];
+
         // handle(_actionClass, _action, currentChar());
-        handle(ActionClass::Leave, table.exitEvents[s], _ch);
-        handle(ActionClass::Transition, table.events[s][ch], _ch);
+        handle(ActionClass::Leave, table_.exitEvents[s], _ch);
+        handle(ActionClass::Transition, entry.action, _ch);
         state_ = t;
-        handle(ActionClass::Enter, table.entryEvents[static_cast<size_t>(t)], _ch);
+        handle(ActionClass::Enter, table_.entryEvents[static_cast<size_t>(t)], _ch);
     }
-    else if (Action const a = table.events[s][ch]; a != Action::Undefined)
+    else if (Action const a = entry.action; a != Action::Undefined)
+    {
+        ++stateCounters_[s];
         handle(ActionClass::Event, a, _ch);
+    }
     else
     {
+        ++stateCounters_[s];
         if (ch < 128)
             eventListener_.error(fmt::format("Parser Error: Unknown action for state/input pair ({}, '{}' 0x{:02X})", state_, char(ch), static_cast<uint32_t>(ch)));
         else
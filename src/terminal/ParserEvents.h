@@ -82,6 +82,9 @@ class ParserEvents {
      */
     virtual void param(char _char) = 0;
 
+    /// Optimization that passes in a run of parameter characters, i.e. digits and separators.
+    virtual void param(std::string_view _chars) = 0;
+
     /**
      * The final character of an escape sequence has arrived, so determined the control function
      * to be executed from the intermediate character(s) and final character, and execute it.
@@ -113,6 +116,9 @@ class ParserEvents {
      */
     virtual void putOSC(char32_t _char) = 0;
 
+    /// Optimization that passes in a run of ASCII chars between [0x20 .. 0x7F].
+    virtual void putOSC(std::string_view _chars) = 0;
+
     /**
      * This action is called when the OSC string is terminated by ST, CAN, SUB or ESC,
      * to allow the OSC handler to finish neatly.
@@ -136,6 +142,9 @@ class ParserEvents {
      */
     virtual void put(char32_t _char) = 0;
 
+    /// Optimization that passes in a run of 7-bit chars, including C0 controls.
+    virtual void put(std::string_view _chars) = 0;
+
     /**
      * When a device control string is terminated by ST, CAN, SUB or ESC, this action calls the
      * previously selected handler function with an “end of data” parameter. This allows the
@@ -154,13 +163,16 @@ class BasicParserEvents : public ParserEvents {
     void collect(char) override {}
     void collectLeader(char) override {}
     void param(char) override {}
+    void param(std::string_view) override {}
     void dispatchESC(char) override {}
     void dispatchCSI(char) override {}
     void startOSC() override {}
     void putOSC(char32_t) override {}
+    void putOSC(std::string_view) override {}
     void dispatchOSC() override {}
     void hook(char) override {}
     void put(char32_t) override {}
+    void put(std::string_view) override {}
     void unhook() override {}
 };
 } // end namespace terminal
@@ -36,3 +36,75 @@ TEST_CASE("Parser.utf8_single", "[Parser]")
     CHECK(0xF6 == static_cast<unsigned>(textListener.text.at(0)));
 }
 
+
+namespace
+{
+    /// Records all parser events, with runs of input being recorded as their individual inputs.
+    class RecordingParserEvents : public terminal::ParserEvents {
+      public:
+        std::vector<std::string> events;
+
+        void error(string_view const& _msg) override { record("error", _msg); }
+        void print(char32_t _ch) override { record("print", _ch); }
+        void print(string_view _chars) override { recordRun("print", _chars); }
+        void execute(char _ch) override { record("execute", _ch); }
+        void clear() override { record("clear"); }
+        void collect(char _ch) override { record("collect", _ch); }
+        void collectLeader(char _ch) override { record("collectLeader", _ch); }
+        void param(char _ch) override { record("param", _ch); }
+        void param(string_view _chars) override { recordRun("param", _chars); }
+        void dispatchESC(char _ch) override { record("dispatchESC", _ch); }
+        void dispatchCSI(char _ch) override { record("dispatchCSI", _ch); }
+        void startOSC() override { record("startOSC"); }
+        void putOSC(char32_t _ch) override { record("putOSC", _ch); }
+        void putOSC(string_view _chars) override { recordRun("putOSC", _chars); }
+        void dispatchOSC() override { record("dispatchOSC"); }
+        void hook(char _ch) override { record("hook", _ch); }
+        void put(char32_t _ch) override { record("put", _ch); }
+        void put(string_view _chars) override { recordRun("put", _chars); }
+        void unhook() override { record("unhook"); }
+
+      private:
+        void record(string_view _event) { events.emplace_back(_event); }
+        void record(string_view _event, string_view _text) { events.emplace_back(fmt::format("{} {}", _event, _text)); }
+        void record(string_view _event, char32_t _ch) { events.emplace_back(fmt::format("{} {:02X}", _event, unsigned(_ch))); }
+        void recordRun(string_view _event, string_view _chars)
+        {
+            for (char const ch: _chars)
+                record(_event, static_cast<char32_t>(ch));
+        }
+    };
+}
+
+TEST_CASE("Parser.runs", "[Parser]")
+{
+    // Processing the input in runs must be indistinguishable from processing it codepoint by codepoint.
+    auto const input = string(
+        "Hello, \033[1;38:2::255:128:0mWorld\033[0m!\r\n"
+        "\033[?2026h\033[12;34H\033[K\xC3\xB6\033[m"
+        "\033]2;Some \xC3\xA4 title\033\\"
+        "\033]8;;https://example.com\a"
+        "\033P1$r0;1m\033\\"
+        "\033Pq#0;2;0;0;0#1!14~-\033\\"
+        "\033_ignored APC string\033\\"
+        "\033[1;2;3;4;5;6;7;8;9;10;11;12;13;14;15;16;17;18m"
+        "tail"
+    );
+
+    RecordingParserEvents runs;
+    auto runParser = parser::Parser(runs);
+    runParser.parseFragment(input);
+
+    RecordingParserEvents codepoints;
+    auto codepointParser = parser::Parser(codepoints);
+    codepointParser.parseFragment(unicode::from_utf8(input));
+
+    CHECK(runParser.stateCounters() == codepointParser.stateCounters());
+
+    REQUIRE(runs.events.size() == codepoints.events.size());
+    for (size_t i = 0; i < runs.events.size(); ++i)
+    {
+        INFO(fmt::format("event {}", i));
+        CHECK(runs.events[i] == codepoints.events[i]);
+    }
+}
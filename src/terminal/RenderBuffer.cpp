@@ -14,35 +14,18 @@
 #include <terminal/RenderBuffer.h>
 #include <crispy/debuglog.h>
 
-#include <mutex>
-
 #include <fmt/format.h>
 
 namespace terminal {
 
-bool RenderDoubleBuffer::swapBuffers(std::chrono::steady_clock::time_point _now) noexcept
+void RenderTripleBuffer::swapBuffers(std::chrono::steady_clock::time_point _now) noexcept
 {
-    // If the terminal thread (writer) cannot try_lock (w/o wait time)
-    // the front buffer, it'll just flush back buffer instead of swapping
-    // buffers as the front buffer is apparently still in use by the
-    // renderer thread and we want to avoid render-thread imposed
-    // wait times in the terminal thread as much as possible.
-
-    if (!readerLock.try_lock())
-        return false;
-
-    auto const _l = std::lock_guard<decltype(readerLock)>(readerLock, std::adopt_lock);
-
-    for (;;)
-    {
-        auto current = currentBackBufferIndex.load();
-        if (currentBackBufferIndex.compare_exchange_weak(current, (current + 1) % 2))
-            break;
-    }
+    // Hand over the freshly filled back buffer and continue with whichever buffer was published before,
+    // as that one is not in use by the reader.
+    backIndex_ = published_.exchange(static_cast<uint8_t>(backIndex_ | FreshFlag)) & IndexMask;
 
     lastUpdate = _now;
     state = RenderBufferState::WaitingForRefresh;
-    return true;
 }
 
 }
@@ -15,9 +15,9 @@
 
 #include <terminal/Grid.h>
 
+#include <array>
 #include <atomic>
 #include <chrono>
-#include <mutex>
 #include <optional>
 #include <vector>
 
@@ -50,35 +50,24 @@ struct RenderBuffer
     void clear() { screen.clear(); cursor.reset(); }
 };
 
-/// Lock-guarded handle to a read-only RenderBuffer object.
+/// Handle to the read-only RenderBuffer object most recently published to the reader.
 ///
-/// @see RenderBuffer
+/// The referenced buffer is not touched by the writer until the reader acquires the next one.
+///
+/// @see RenderTripleBuffer
 struct RenderBufferRef
 {
     RenderBuffer const& buffer;
-    std::mutex& guard;
 
     RenderBuffer const& get() const noexcept { return buffer; }
-
-    RenderBufferRef(RenderBuffer const& _buf, std::mutex& _lock):
-        buffer{_buf}, guard{_lock}
-    {
-        guard.lock();
-    }
-
-    ~RenderBufferRef()
-    {
-        guard.unlock();
-    }
 };
 
-/// Reflects the current state of a RenderDoubleBuffer object.
+/// Reflects the current state of a RenderTripleBuffer object.
 ///
 enum class RenderBufferState
 {
     WaitingForRefresh,
-    RefreshBuffersAndTrySwap,
-    TrySwapBuffers
+    RefreshBuffersAndTrySwap
 };
 
 constexpr std::string_view to_string(RenderBufferState _state) noexcept
@@ -87,27 +76,33 @@ constexpr std::string_view to_string(RenderBufferState _state) noexcept
     {
         case RenderBufferState::WaitingForRefresh: return "WaitingForRefresh";
         case RenderBufferState::RefreshBuffersAndTrySwap: return "RefreshBuffersAndTrySwap";
-        case RenderBufferState::TrySwapBuffers: return "TrySwapBuffers";
     }
     return "INVALID";
 }
 
-struct RenderDoubleBuffer
+/// Lock-free triple buffer for handing off render buffers from the writer to the reader (render thread).
+///
+/// The writer always owns a back buffer to fill and the reader always owns a front buffer to read from,
+/// whereas the third buffer holds the most recently published one, to be picked up by the reader
+/// with its next frame. Thus, neither side ever has to wait for the other.
+///
+/// Writing (filling and publishing the back buffer) must be serialized by the caller,
+/// which is done by holding the terminal's lock.
+struct RenderTripleBuffer
 {
-    std::mutex mutable readerLock;
-    std::atomic<size_t> currentBackBufferIndex = 0;
-    std::array<RenderBuffer, 2> buffers{};
+    std::array<RenderBuffer, 3> buffers{};
     std::atomic<RenderBufferState> state = RenderBufferState::WaitingForRefresh;
     std::chrono::steady_clock::time_point lastUpdate{};
 
-    RenderBuffer& backBuffer() noexcept { return buffers[currentBackBufferIndex]; }
+    RenderBuffer& backBuffer() noexcept { return buffers[backIndex_]; }
 
-    RenderBufferRef frontBuffer() const
+    /// Acquires the most recently published buffer, releasing the one acquired before.
+    /// May only be invoked by the reader.
+    RenderBufferRef frontBuffer() const noexcept
     {
-        // if (state == RenderBufferState::TrySwapBuffers)
-        //     const_cast<RenderDoubleBuffer*>(this)->swapBuffers(lastUpdate);
-        RenderBuffer const& frontBuffer = buffers.at((currentBackBufferIndex + 1) % 2);
-        return RenderBufferRef(frontBuffer, readerLock);
+        if (published_.load() & FreshFlag)
+            frontIndex_ = published_.exchange(frontIndex_) & IndexMask;
+        return RenderBufferRef{buffers[frontIndex_]};
     }
 
     void clear()
@@ -115,8 +110,16 @@ struct RenderDoubleBuffer
         backBuffer().clear();
     }
 
-    // Swaps front with back buffer. May only be invoked by the writer thread.
-    bool swapBuffers(std::chrono::steady_clock::time_point _now) noexcept;
+    // Publishes the back buffer to the reader. May only be invoked by the writer.
+    void swapBuffers(std::chrono::steady_clock::time_point _now) noexcept;
+
+  private:
+    static constexpr uint8_t IndexMask = 0x03;
+    static constexpr uint8_t FreshFlag = 0x04;  // published buffer not yet picked up by the reader
+
+    uint8_t backIndex_ = 0;                     // owned by the writer
+    mutable std::atomic<uint8_t> published_ = 1;
+    mutable uint8_t frontIndex_ = 2;            // owned by the reader
 };
 
 } // end namespace
@@ -76,6 +76,37 @@ namespace terminal {
 
 namespace // {{{ helper
 {
+    void appendUtf8(string& _output, std::u32string_view _codepoints)
+    {
+        auto encoder = unicode::encoder<char>{};
+        for (char32_t const codepoint: _codepoints)
+        {
+            char bytes[4];
+            _output.append(bytes, static_cast<size_t>(distance(bytes, encoder(codepoint, bytes))));
+        }
+    }
+
+    /// @returns the text of the given line for screen captures, without trailing whitespace.
+    string capturedText(Line const& _line)
+    {
+        auto text = string{};
+        if (_line.blank())
+            return text;
+
+        for (Cell const& cell: _line)
+        {
+            if (!cell.codepointCount())
+                text += ' ';
+            else
+                appendUtf8(text, cell.codepoints());
+        }
+
+        while (!text.empty() && text.back() == ' ')
+            text.pop_back();
+
+        return text;
+    }
+
     std::string vtSequenceParameterString(GraphicsAttributes const& _sgr)
     {
         std::string output;
@@ -438,6 +469,17 @@ void Screen::resizeColumns(ColumnCount _newColumnCount, bool _clear)
     eventListener_.resizeWindow(newSize);
 }
 
+LineCount Screen::reflowPendingHistory(LineCount _minimum)
+{
+    auto const addedLineCount = primaryGrid().reflowPendingLines(_minimum);
+
+    // Lines have been inserted at the front, invalidating line iterators.
+    if (*addedLineCount && isPrimaryScreen())
+        updateCursorIterators();
+
+    return addedLineCount;
+}
+
 void Screen::resize(PageSize _newSize)
 {
     cursor_.position = grid().resize(_newSize, cursor_.position, wrapPending_);
@@ -663,42 +705,87 @@ void Screen::clearAndAdvance(int _offset)
 
 std::string Screen::screenshot(function<string(int)> const& _postLine) const
 {
-    auto result = std::stringstream{};
-    auto writer = VTWriter(result);
+    auto result = string{};
+    screenshot([&](char const* _data, size_t _size) { result.append(_data, _size); }, _postLine);
+    return result;
+}
+
+void Screen::screenshot(ScreenshotWriter const& _writer, function<string(int)> const& _postLine) const
+{
+    screenshot(grid(), _writer, _postLine);
+}
 
-    for (int const absoluteRow : crispy::times(1, *grid().historyLineCount() + *size_.lines))
+void Screen::screenshot(Grid const& _grid, ScreenshotWriter const& _writer, function<string(int)> const& _postLine)
+{
+    // Scrollback lines still pending to be reflowed are not part of the history yet,
+    // so reflow them on a snapshot rather than leaving them out.
+    if (*_grid.pendingReflowLineCount())
     {
-        auto const row = absoluteRow - unbox<int>(grid().historyLineCount());
-        for (int const col: crispy::times(1, *size_.columns))
-        {
-            Cell const& cell = at({row, col});
+        auto reflowed = _grid.snapshot();
+        reflowed.reflowAllPendingLines();
+        screenshot(reflowed, _writer, _postLine);
+        return;
+    }
 
-            if (cell.attributes().styles & CellFlags::Bold)
-                writer.sgr_add(GraphicsRendition::Bold);
-            else
-                writer.sgr_add(GraphicsRendition::Normal);
+    auto const pageSize = _grid.screenSize();
+    auto buffer = string{};
+    buffer.reserve(ScreenshotChunkSize + 4096);
+
+    // The graphics rendition is reset at the end of every line, such that the line feed
+    // does not fill any new line with a non-default background color.
+    auto constexpr DefaultAttributes = GraphicsAttributes{};
+    auto currentAttributes = DefaultAttributes;
+    buffer += "\033[m";
 
-            // TODO: other styles (such as underline, ...)?
+    for (int const absoluteRow : crispy::times(1, *_grid.historyLineCount() + *pageSize.lines))
+    {
+        auto const row = absoluteRow - unbox<int>(_grid.historyLineCount());
+        Line const& line = _grid.lineAt(row);
+
+        auto columnCount = min(unbox<int>(pageSize.columns), unbox<int>(line.size()));
+        if (!_postLine)
+            while (columnCount > 0 && line[static_cast<size_t>(columnCount - 1)].empty()
+                                   && line[static_cast<size_t>(columnCount - 1)].attributes() == DefaultAttributes)
+                --columnCount;
+
+        for (int const col: crispy::times(columnCount))
+        {
+            Cell const& cell = line[static_cast<size_t>(col)];
 
-            writer.setForegroundColor(cell.attributes().foregroundColor);
-            writer.setBackgroundColor(cell.attributes().backgroundColor);
+            if (cell.attributes() != currentAttributes)
+            {
+                buffer += "\033[0;";
+                buffer += vtSequenceParameterString(cell.attributes());
+                buffer += 'm';
+                currentAttributes = cell.attributes();
+            }
 
             if (!cell.codepointCount())
-                writer.write(U' ');
+                buffer += ' ';
             else
-                for (char32_t const ch : cell.codepoints())
-                    writer.write(ch);
+                appendUtf8(buffer, cell.codepoints());
+        }
+
+        if (currentAttributes != DefaultAttributes)
+        {
+            buffer += "\033[m";
+            currentAttributes = DefaultAttributes;
         }
-        writer.sgr_add(GraphicsRendition::Reset);
 
         if (_postLine)
-            writer.write(_postLine(row));
+            buffer += _postLine(row);
 
-        writer.write('\r');
-        writer.write('\n');
+        buffer += "\r\n";
+
+        if (buffer.size() >= ScreenshotChunkSize)
+        {
+            _writer(buffer.data(), buffer.size());
+            buffer.clear();
+        }
     }
 
-    return result.str();
+    if (!buffer.empty())
+        _writer(buffer.data(), buffer.size());
 }
 
 optional<int> Screen::findMarkerBackward(int _currentCursorLine) const
@@ -807,7 +894,7 @@ void Screen::resetSoft()
 #if defined(LIBTERMINAL_HYPERLINKS)
     currentHyperlink_ = {};
 #endif
-    colorPalette_ = defaultColorPalette_;
+    resetColorPalette();
 
     // TODO: DECNKM (Numeric keypad)
     // TODO: DECSCA (Select character attribute)
@@ -844,8 +931,9 @@ void Screen::resetHard()
 
 #if defined(LIBTERMINAL_HYPERLINKS)
     currentHyperlink_ = {};
+    hyperlinks_.clear();
 #endif
-    colorPalette_ = defaultColorPalette_;
+    resetColorPalette();
 
     eventListener_.hardReset();
 }
@@ -1047,11 +1135,6 @@ void Screen::sendTerminalId()
 
 void Screen::clearToEndOfScreen()
 {
-#if defined(LIBTERMINAL_HYPERLINKS)
-    if (isAlternateScreen() && cursor_.position.row == 1 && cursor_.position.column == 1)
-        hyperlinks_.clear();
-#endif
-
     clearToEndOfLine();
 
     for_each(
@@ -1359,23 +1442,40 @@ void Screen::hyperlink(string const& _id, string const& _uri)
 {
 #if defined(LIBTERMINAL_HYPERLINKS)
     if (_uri.empty())
-        currentHyperlink_ = nullptr;
-    else if (_id.empty())
-        currentHyperlink_ = make_shared<HyperlinkInfo>(HyperlinkInfo{_id, _uri});
-    else if (auto i = hyperlinks_.find(_id); i != hyperlinks_.end())
-        currentHyperlink_ = i->second;
-    else
     {
-        currentHyperlink_ = make_shared<HyperlinkInfo>(HyperlinkInfo{_id, _uri});
-        hyperlinks_[_id] = currentHyperlink_;
+        currentHyperlink_ = {};
+        return;
     }
-    // TODO:
-    // Care about eviction.
-    // Move hyperlink store into ScreenBuffer, so it gets reset upon every switch into
-    // alternate screen (not for main screen!)
+
+    if (hyperlinks_.exhausted())
+        collectHyperlinks();
+
+    currentHyperlink_ = hyperlinks_.add(_id, _uri);
 #endif
 }
 
+#if defined(LIBTERMINAL_HYPERLINKS)
+void Screen::collectHyperlinks()
+{
+    auto const countBefore = hyperlinks_.size();
+
+    hyperlinks_.collectGarbage([&](auto _referenced) {
+        _referenced(currentHyperlink_);
+        for (Grid const& grid: grids_)
+            grid.forEachLine([&](Line const& _line) {
+                for (Cell const& cell: _line)
+                    if (cell.hyperlink())
+                        _referenced(cell.hyperlink());
+            });
+    });
+
+    debuglog(TerminalTag).write("Collected {} of {} hyperlinks ({} bytes in use).",
+                              countBefore - hyperlinks_.size(),
+                              countBefore,
+                              hyperlinks_.memoryUsage());
+}
+#endif
+
 void Screen::moveCursorUp(LineCount _n)
 {
     auto const n = min(
@@ -1495,67 +1595,88 @@ void Screen::notify(string const& _title, string const& _content)
     eventListener_.notify(_title, _content);
 }
 
-void Screen::captureBuffer(int _lineCount, bool _logicalLines)
+void Screen::captureBuffer(int _lineCount, bool _logicalLines, size_t _chunkSize)
+{
+    auto capture = beginCapture(_lineCount, _logicalLines);
+    auto text = string{};
+    bool more = true;
+    while (more)
+    {
+        more = captureChunk(capture, _chunkSize, text);
+        replyCaptured(text, _chunkSize, !more);
+    }
+}
+
+BufferCapture Screen::beginCapture(int _lineCount, bool _logicalLines) const
 {
-    // TODO: Unit test case! (for ensuring line numbering and limits are working as expected)
+    auto capture = BufferCapture{grid().snapshot()};
+    capture.logicalLines = _logicalLines;
+    if (_lineCount <= 0)
+        return capture;
 
-    auto capturedBuffer = std::string();
-    auto writer = VTWriter([&](auto buf, auto len) { capturedBuffer += string_view(buf, len); });
+    // Scrollback lines still pending to be reflowed are only reflowed within the snapshot,
+    // such that they can be captured, too, without touching the live grid.
+    Grid& snapshot = capture.grid;
+    snapshot.reflowAllPendingLines();
 
     // TODO: when capturing _lineCount < screenSize.lines, start at the lowest non-empty line.
-    auto const relativeStartLine = _logicalLines ? grid().computeRelativeLineNumberFromBottom(_lineCount)
+    auto const relativeStartLine = _logicalLines ? snapshot.computeRelativeLineNumberFromBottom(_lineCount)
                                                  : unbox<int>(size_.lines) - _lineCount + 1;
     auto const startLine = clamp(
-        1 - unbox<int>(historyLineCount()),
+        1 - unbox<int>(snapshot.historyLineCount()),
         relativeStartLine,
         unbox<int>(size_.lines));
 
-    // dumpState();
-
-    auto const lineCount = unbox<int>(size_.lines) - startLine + 1;
-
-    auto const trimSpaceRight = [](string& value)
-    {
-        while (!value.empty() && value.back() == ' ')
-            value.pop_back();
-    };
+    capture.nextLine = snapshot.toAbsoluteLine(startLine);
+    capture.endLine = snapshot.toAbsoluteLine(unbox<int>(size_.lines)) + 1;
+    return capture;
+}
 
-    for (int const row : crispy::times(startLine, lineCount))
+bool Screen::captureChunk(BufferCapture& _capture, size_t _size, string& _output)
+{
+    for (; _output.size() < _size && _capture.nextLine < _capture.endLine; ++_capture.nextLine)
     {
-        auto const& lineBuffer = grid().lineAt(row);
+        Line const& line = _capture.grid.absoluteLineAt(_capture.nextLine);
 
-        if (_logicalLines && lineBuffer.wrapped() && !capturedBuffer.empty())
-            capturedBuffer.pop_back();
+        if (_capture.logicalLines && line.wrapped() && _capture.pendingNewlines > 0)
+            --_capture.pendingNewlines;
 
-        if (!lineBuffer.blank())
+        if (auto const text = capturedText(line); !text.empty())
         {
-            for (int const col : crispy::times(1, unbox<int>(size_.columns)))
-            {
-                Cell const& cell = at({row, col});
-                if (!cell.codepointCount())
-                    writer.write(U' ');
-                else
-                    for (char32_t const ch : cell.codepoints())
-                        writer.write(ch);
-            }
-            trimSpaceRight(capturedBuffer);
+            _output.append(static_cast<size_t>(_capture.pendingNewlines), '\n');
+            _output += text;
+            _capture.pendingNewlines = 0;
         }
 
-        writer.write('\n');
+        ++_capture.pendingNewlines;
     }
 
-    while (crispy::endsWith(string_view(capturedBuffer), "\n\n"sv)) // TODO: unit test
-        capturedBuffer.pop_back();
+    if (_capture.nextLine < _capture.endLine)
+        return true;
 
-    auto constexpr PageSize = size_t{4096};
-    for (size_t i = 0; i < capturedBuffer.size(); i += PageSize)
+    // Trailing line feeds are collapsed into a single one.
+    if (_capture.pendingNewlines)
+        _output += '\n';
+    _capture.pendingNewlines = 0;
+    return false;
+}
+
+void Screen::replyCaptured(string& _text, size_t _chunkSize, bool _final)
+{
+    auto const text = string_view(_text);
+    auto const chunkSize = max(_chunkSize, size_t{1});
+
+    auto offset = size_t{0};
+    while (text.size() - offset >= chunkSize || (_final && offset < text.size()))
     {
-        auto const start = capturedBuffer.data() + i;
-        auto const count = min(PageSize, capturedBuffer.size() - i);
-        reply("\033]314;{}\033\\", string_view(start, count));
+        auto const chunk = text.substr(offset, chunkSize);
+        reply("\033]314;{}\033\\", chunk);
+        offset += chunk.size();
     }
+    _text.erase(0, offset);
 
-    reply("\033]314;\033\\"); // mark the end
+    if (_final)
+        reply("\033]314;\033\\"); // mark the end
 }
 
 void Screen::cursorForwardTab(TabStopCount _count)
@@ -2454,6 +2575,7 @@ void Screen::resetDynamicColor(DynamicColorName _name)
             colorPalette_.selectionBackground = defaultColorPalette_.selectionBackground;
             break;
     }
+    ++colorPaletteGeneration_;
 }
 
 void Screen::setDynamicColor(DynamicColorName _name, RGBColor const& _value)
@@ -2482,6 +2604,31 @@ void Screen::setDynamicColor(DynamicColorName _name, RGBColor const& _value)
             colorPalette_.selectionBackground = _value;
             break;
     }
+    ++colorPaletteGeneration_;
+}
+
+void Screen::setColorPalette(ColorPalette const& _palette)
+{
+    colorPalette_ = _palette;
+    ++colorPaletteGeneration_;
+}
+
+void Screen::setPaletteColor(uint8_t _index, RGBColor _color)
+{
+    colorPalette_.palette[_index] = _color;
+    ++colorPaletteGeneration_;
+}
+
+void Screen::resetColorPalette()
+{
+    colorPalette_ = defaultColorPalette_;
+    ++colorPaletteGeneration_;
+}
+
+void Screen::resetPaletteColor(uint8_t _index)
+{
+    colorPalette_.palette[_index] = defaultColorPalette_.palette[_index];
+    ++colorPaletteGeneration_;
 }
 
 void Screen::dumpState()
@@ -2527,6 +2674,19 @@ void Screen::dumpState(std::string const& _message, std::ostream& _os) const
     // - ... other output related modes
 }
 
+Metrics Screen::vtMetrics() const noexcept
+{
+    auto metrics = sequencer_.metrics();
+    metrics.states = parser_.stateCounters();
+    return metrics;
+}
+
+void Screen::resetVTMetrics() noexcept
+{
+    sequencer_.resetMetrics();
+    parser_.resetStateCounters();
+}
+
 void Screen::smGraphics(XtSmGraphics::Item _item, XtSmGraphics::Action _action, XtSmGraphics::Value _value)
 {
     using Item = XtSmGraphics::Item;
@@ -49,6 +49,7 @@
 #include <stack>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 namespace terminal {
@@ -118,6 +119,15 @@ struct Cursor
 };
 // }}}
 
+/// State of a screen buffer capture being streamed in chunks (see Screen::beginCapture()).
+struct BufferCapture {
+    Grid grid;                      // snapshot of the grid at the time the capture was started
+    int nextLine = 0;               // absolute line number of the next line to capture
+    int endLine = 0;                // absolute line number past the last line to capture
+    bool logicalLines = false;
+    int pendingNewlines = 0;        // line feeds not yet written, as they may still be joined or trimmed
+};
+
 /**
  * Terminal Screen.
  *
@@ -206,6 +216,23 @@ class Screen : public capabilities::StaticDatabase {
     ///          including initial clear screen, and initial cursor hide.
     std::string screenshot(std::function<std::string(int)> const& _postLine = {}) const;
 
+    using ScreenshotWriter = std::function<void(char const*, size_t)>;
+
+    /// Takes a screenshot like the above, but streams the VT sequences into @p _writer in chunks
+    /// of about ScreenshotChunkSize bytes rather than building the whole screenshot in memory.
+    ///
+    /// Graphics renditions are only emitted where they change, and trailing blank cells are
+    /// omitted (unless @p _postLine is given, in order to keep its output aligned).
+    void screenshot(ScreenshotWriter const& _writer, std::function<std::string(int)> const& _postLine = {}) const;
+
+    /// Takes a screenshot like the above, but of the given grid, e.g. a snapshot (see Grid::snapshot())
+    /// that is being written after releasing the terminal's lock.
+    static void screenshot(Grid const& _grid,
+                           ScreenshotWriter const& _writer,
+                           std::function<std::string(int)> const& _postLine = {});
+
+    static constexpr size_t ScreenshotChunkSize = 64 * 1024;
+
     void setFocus(bool _focused) { focused_ = _focused; }
     bool focused() const noexcept { return focused_; }
 
@@ -283,7 +310,31 @@ class Screen : public capabilities::StaticDatabase {
     void hyperlink(std::string const& _id, std::string const& _uri);      // OSC 8
     void notify(std::string const& _title, std::string const& _content);  // OSC 777
 
-    void captureBuffer(int _numLines, bool _logicalLines);
+    /// Captures the bottom most @p _lineCount lines (or logical lines) of the screen buffer as text and
+    /// replies them in OSC 314 chunks of at most @p _chunkSize bytes each, followed by an empty one.
+    void captureBuffer(int _lineCount, bool _logicalLines, size_t _chunkSize = DefaultCaptureChunkSize);
+
+    /// Starts capturing the screen buffer (see captureBuffer()) to be streamed via captureChunk().
+    ///
+    /// The capture is working on a snapshot of the current grid, taken in O(lines).
+    BufferCapture beginCapture(int _lineCount, bool _logicalLines) const;
+
+    /// Appends the text of the next captured lines to @p _output, until it holds at least @p _size bytes.
+    ///
+    /// As this is only accessing the capture's own grid snapshot, it does not need the screen
+    /// to be locked, and the capture keeps reflecting the screen at the time of beginCapture().
+    ///
+    /// @returns whether there are more lines to capture.
+    static bool captureChunk(BufferCapture& _capture, size_t _size, std::string& _output);
+
+    /// Replies the captured @p _text in OSC 314 chunks of @p _chunkSize bytes.
+    ///
+    /// A remainder shorter than @p _chunkSize is kept in @p _text, unless this is the @p _final call,
+    /// which is then also replying the empty chunk that is marking the end of the capture.
+    void replyCaptured(std::string& _text, size_t _chunkSize, bool _final);
+
+    static constexpr size_t DefaultCaptureChunkSize = 4096;
+    static constexpr size_t MaxCaptureChunkSize = 1024 * 1024;
 
     void setForegroundColor(Color const& _color);
     void setBackgroundColor(Color const& _color);
@@ -342,6 +393,10 @@ class Screen : public capabilities::StaticDatabase {
 
     void dumpState(std::string const& _message, std::ostream& _os) const;
 
+    /// @returns the VT usage metrics collected since construction or the last resetVTMetrics().
+    Metrics vtMetrics() const noexcept;
+    void resetVTMetrics() noexcept;
+
     // reset screen
     void resetSoft();
     void resetHard();
@@ -360,6 +415,13 @@ class Screen : public capabilities::StaticDatabase {
     PageSize size() const noexcept { return size_; }
     void resize(PageSize _newSize);
 
+    /// Reflows (older) scrollback lines of the primary screen that have been left pending by resize().
+    ///
+    /// @returns the number of lines the primary screen's history has grown by at its top.
+    LineCount reflowPendingHistory(LineCount _minimum);
+
+    bool historyReflowPending() const noexcept { return *grids_[0].pendingReflowLineCount() != 0; }
+
     /// Implements semantics for  DECCOLM / DECSCPP.
     void resizeColumns(ColumnCount _newColumnCount, bool _clear);
 
@@ -451,7 +513,7 @@ class Screen : public capabilities::StaticDatabase {
 
     Cell const& currentCell() const noexcept
     {
-        return (*currentLine_)[cursor_.position.column - 1];
+        return currentLine_->cells()[static_cast<size_t>(cursor_.position.column - 1)];
     }
 
     Cell& currentCell() noexcept
@@ -472,6 +534,14 @@ class Screen : public capabilities::StaticDatabase {
     /// Gets a reference to the cell relative to screen origin (top left, 1:1).
     Cell const& at(Coordinate const& _coord) const noexcept { return grid().at(_coord); }
 
+#if defined(LIBTERMINAL_HYPERLINKS)
+    /// @returns the hyperlink of the cell at the given coordinate relative to screen origin, if any.
+    HyperlinkInfo* hyperlinkAt(Coordinate const& _coord) noexcept { return hyperlinks_.hyperlinkById(std::as_const(*this).at(_coord).hyperlink()); }
+
+    HyperlinkStorage& hyperlinks() noexcept { return hyperlinks_; }
+    HyperlinkStorage const& hyperlinks() const noexcept { return hyperlinks_; }
+#endif
+
     bool isPrimaryScreen() const noexcept { return activeGrid_ == &grids_[0]; }
     bool isAlternateScreen() const noexcept { return activeGrid_ == &grids_[1]; }
 
@@ -569,6 +639,7 @@ class Screen : public capabilities::StaticDatabase {
 
     /// @returns true iff given absolute line number is wrapped, false otherwise.
     bool lineWrapped(int _lineNumber) const { return activeGrid_->absoluteLineAt(_lineNumber).wrapped(); }
+    LogicalLineRange logicalLineRange(int _lineNumber) const { return activeGrid_->logicalLineRange(_lineNumber); }
 
     int toAbsoluteLine(int _relativeLine) const noexcept { return activeGrid_->toAbsoluteLine(_relativeLine); }
     Coordinate toAbsolute(Coordinate _coord) const noexcept { return {activeGrid_->toAbsoluteLine(_coord.row), _coord.column}; }
@@ -576,9 +647,26 @@ class Screen : public capabilities::StaticDatabase {
     int toRelativeLine(int _absoluteLine) const noexcept { return activeGrid_->toRelativeLine(_absoluteLine); }
     Coordinate toRelative(Coordinate _coord) const noexcept { return {activeGrid_->toRelativeLine(_coord.row), _coord.column}; }
 
-    ColorPalette& colorPalette() noexcept { return colorPalette_; }
     ColorPalette const& colorPalette() const noexcept { return colorPalette_; }
 
+    /// Replaces the currently active color palette.
+    void setColorPalette(ColorPalette const& _palette);
+
+    /// Changes a single entry of the 256-color palette table (OSC 4).
+    void setPaletteColor(uint8_t _index, RGBColor _color);
+
+    /// Resets the whole color palette to the default color palette (OSC 104).
+    void resetColorPalette();
+
+    /// Resets a single entry of the 256-color palette table to its default (OSC 104).
+    void resetPaletteColor(uint8_t _index);
+
+    /// Generation number of the active color palette.
+    ///
+    /// This number is incremented on every change to the active color palette and can
+    /// be used to invalidate caches that depend on the palette's contents.
+    uint64_t colorPaletteGeneration() const noexcept { return colorPaletteGeneration_; }
+
     ColorPalette& defaultColorPalette() noexcept { return defaultColorPalette_; }
     ColorPalette const& defaultColorPalette() const noexcept { return defaultColorPalette_; }
 
@@ -595,6 +683,11 @@ class Screen : public capabilities::StaticDatabase {
     void writeCharToCurrentAndAdvance(char32_t _codepoint);
     void clearAndAdvance(int _offset);
 
+#if defined(LIBTERMINAL_HYPERLINKS)
+    /// Evicts all hyperlinks no longer referenced by any cell of either screen buffer.
+    void collectHyperlinks();
+#endif
+
     void fail(std::string const& _message) const;
 
     void updateCursorIterators()
@@ -645,6 +738,7 @@ class Screen : public capabilities::StaticDatabase {
 
     ColorPalette defaultColorPalette_;
     ColorPalette colorPalette_;
+    uint64_t colorPaletteGeneration_ = 1;
 
     int maxImageColorRegisters_;
     ImageSize maxImageSize_;
@@ -694,8 +788,8 @@ class Screen : public capabilities::StaticDatabase {
     // Hyperlink related
     //
 #if defined(LIBTERMINAL_HYPERLINKS)
-    HyperlinkRef currentHyperlink_ = {};
-    std::unordered_map<std::string, HyperlinkRef> hyperlinks_; // TODO: use a deque<> instead, always push_back, lookup reverse, evict in front.
+    HyperlinkId currentHyperlink_ = {};
+    HyperlinkStorage hyperlinks_;
 #endif
 
     // experimental features
@@ -43,7 +43,7 @@ class ScreenEvents {
   public:
     virtual ~ScreenEvents() = default;
 
-    virtual void requestCaptureBuffer(int /*_absoluteStartLine*/, int /*_lineCount*/) {}
+    virtual void requestCaptureBuffer(int /*_lineCount*/, bool /*_logicalLines*/, size_t /*_chunkSize*/) {}
     virtual void bell() {}
     virtual void bufferChanged(ScreenType) {}
     virtual void scrollbackBufferCleared() {}
@@ -11,6 +11,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <terminal/ColorCache.h>
 #include <terminal/Screen.h>
 #include <terminal/Viewport.h>
 #include <crispy/escape.h>
@@ -827,6 +828,49 @@ TEST_CASE("ScrollUp", "[screen]")
     }
 }
 
+TEST_CASE("ScrollUp.WithMargins", "[screen]")
+{
+    auto screen = MockScreen{PageSize{LineCount(5), ColumnCount(5)}};
+    screen.write("12345\r\n67890\r\nABCDE\r\nFGHIJ\r\nKLMNO");
+    REQUIRE("12345\n67890\nABCDE\nFGHIJ\nKLMNO\n" == screen.renderText());
+
+    SECTION("scroll fully inside margins") {
+        screen.setMode(DECMode::LeftRightMargin, true);
+        screen.setLeftRightMargin(2, 4);
+        screen.setTopBottomMargin(2, 4);
+        screen.setMode(DECMode::Origin, true);
+
+        SECTION("SU 1") {
+            screen.scrollUp(LineCount(1));
+            CHECK("12345\n6BCD0\nAGHIE\nF   J\nKLMNO\n" == screen.renderText());
+        }
+
+        SECTION("SU 2") {
+            screen.scrollUp(LineCount(2));
+            CHECK("12345\n6GHI0\nA   E\nF   J\nKLMNO\n" == screen.renderText());
+        }
+
+        SECTION("SU 3") {
+            screen.scrollUp(LineCount(3));
+            CHECK("12345\n6   0\nA   E\nF   J\nKLMNO\n" == screen.renderText());
+        }
+    }
+
+    SECTION("vertical margins") {
+        screen.setTopBottomMargin(2, 4);
+
+        SECTION("SU 1") {
+            screen.scrollUp(LineCount(1));
+            CHECK("12345\nABCDE\nFGHIJ\n     \nKLMNO\n" == screen.renderText());
+        }
+
+        SECTION("SU 5") {
+            screen.scrollUp(LineCount(5));
+            CHECK("12345\n     \n     \n     \nKLMNO\n" == screen.renderText());
+        }
+    }
+}
+
 TEST_CASE("ScrollDown", "[screen]")
 {
     auto screen = MockScreen{PageSize{LineCount(5), ColumnCount(5)}};
@@ -1773,6 +1817,161 @@ TEST_CASE("captureBuffer", "[screen]")
         INFO(crispy::escape(screen.replyData));
         CHECK(screen.replyData == "\033]314;12345\n67890\nABCDE\nFGHIJ\nKLMNO\n\033\\\033]314;\033\\");
     }
+    SECTION("lines: 3 (chunk size: 4)") {
+        screen.captureBuffer(3, false, 4);
+        INFO(crispy::escape(screen.replyData));
+        CHECK(screen.replyData == "\033]314;ABCD\033\\"
+                                  "\033]314;E\nFG\033\\"
+                                  "\033]314;HIJ\n\033\\"
+                                  "\033]314;KLMN\033\\"
+                                  "\033]314;O\n\033\\"
+                                  "\033]314;\033\\");
+    }
+    SECTION("consistent across chunks") {
+        auto capture = screen.beginCapture(3, false);
+        auto text = std::string{};
+        REQUIRE(screen.captureChunk(capture, 1, text));
+        CHECK(text == "ABCDE");
+
+        screen.write("\r\nPQRST\033[1;1Hxxxxx");
+        REQUIRE(screen.grid().lineAt(1).toUtf8() == "xxxxx");
+        text.clear();
+        REQUIRE_FALSE(screen.captureChunk(capture, 64, text));
+        CHECK(text == "\nFGHIJ\nKLMNO\n");
+    }
+    SECTION("consistent across resize") {
+        auto capture = screen.beginCapture(3, false);
+        auto text = std::string{};
+        REQUIRE(screen.captureChunk(capture, 1, text));
+        CHECK(text == "ABCDE");
+
+        screen.resize(PageSize{LineCount(3), ColumnCount(4)});
+        REQUIRE_FALSE(screen.captureChunk(capture, 64, text));
+        CHECK(text == "ABCDE\nFGHIJ\nKLMNO\n");
+    }
+}
+
+TEST_CASE("captureBuffer.logical", "[screen]")
+{
+    auto screen = MockScreen{PageSize{LineCount(2), ColumnCount(5)}};
+
+    //           [...   history ...   ...][main page area]
+    screen.write("12345\r\n67890ABCDE\r\nFGHIJ\r\nKLMNO");
+    REQUIRE(screen.grid().lineAt(0).wrapped());
+
+    SECTION("lines: 1") {
+        screen.captureBuffer(1, true);
+        INFO(crispy::escape(screen.replyData));
+        CHECK(screen.replyData == "\033]314;KLMNO\n\033\\\033]314;\033\\");
+    }
+    SECTION("lines: 2") {
+        // The second logical line starts right at the top of the main page,
+        // so the wrapped line above must not be captured along with it.
+        screen.captureBuffer(2, true);
+        INFO(crispy::escape(screen.replyData));
+        CHECK(screen.replyData == "\033]314;FGHIJ\nKLMNO\n\033\\\033]314;\033\\");
+    }
+    SECTION("lines: 3") {
+        screen.captureBuffer(3, true);
+        INFO(crispy::escape(screen.replyData));
+        CHECK(screen.replyData == "\033]314;67890ABCDE\nFGHIJ\nKLMNO\n\033\\\033]314;\033\\");
+    }
+}
+
+TEST_CASE("captureBuffer.pendingReflow", "[screen]")
+{
+    // More history lines than are reflowed immediately upon resize (1000 lines).
+    auto const historyLineCount = 1200;
+
+    auto screen = MockScreen{PageSize{LineCount(2), ColumnCount(6)}};
+    screen.grid().setReflowOnResize(true);
+    for (int i = 0; i < historyLineCount + 2; ++i)
+        screen.write(fmt::format("{:05}\r\n", i));
+    screen.write("LAST");
+
+    screen.resize(PageSize{LineCount(2), ColumnCount(3)});
+    REQUIRE(screen.grid().pendingReflowLineCount() > LineCount(0));
+    auto const pendingLineCount = screen.grid().pendingReflowLineCount();
+
+    SECTION("capture") {
+        auto capture = screen.beginCapture(historyLineCount * 3, true);
+        auto text = std::string{};
+        while (screen.captureChunk(capture, text.size() + 4096, text))
+            ;
+        REQUIRE(text.size() > 12);
+        CHECK(text.substr(0, 12) == "00000\n00001\n");
+        CHECK(text.find(fmt::format("{:05}\n{:05}\n", historyLineCount - 1, historyLineCount)) != std::string::npos);
+    }
+
+    SECTION("screenshot") {
+        auto const screenshot = screen.screenshot();
+        REQUIRE(screenshot.size() > 21);
+        CHECK(screenshot.substr(0, 21) == "\033[m000\r\n00\r\n000\r\n01\r\n");
+    }
+
+    // The live grid is left alone, reflowing it incrementally is up to the terminal.
+    CHECK(screen.grid().pendingReflowLineCount() == pendingLineCount);
+}
+
+TEST_CASE("screenshot", "[screen]")
+{
+    auto screen = MockScreen{PageSize{LineCount(2), ColumnCount(5)}};
+    screen.write("12\r\n\033[31mAB\033[mC\033[44m \033[m\r\nDE");
+
+    SECTION("full") {
+        auto const screenshot = screen.screenshot();
+        INFO(crispy::escape(screenshot));
+        CHECK(screenshot == "\033[m12\r\n"
+                            "\033[0;31;49mAB\033[0;39;49mC\033[0;39;44m \033[m\r\n"
+                            "DE\r\n");
+    }
+
+    SECTION("chunked") {
+        auto chunks = std::vector<std::string>{};
+        screen.screenshot([&](char const* _data, size_t _size) { chunks.emplace_back(_data, _size); });
+        REQUIRE(chunks.size() == 1); // far below the chunk size
+        CHECK(chunks[0] == screen.screenshot());
+    }
+}
+
+TEST_CASE("screenshot.multiple_chunks", "[screen]")
+{
+    auto const pageSize = PageSize{LineCount(10), ColumnCount(80)};
+    auto screen = MockScreen{pageSize};
+
+    // Graphics renditions that are never reset in between, spanning several chunks.
+    screen.write("\033[1;31;44m");
+    for (int i = 0; i < 3000; ++i)
+        screen.write(fmt::format("{:05} {}\r\n", i, std::string(70, 'X')));
+
+    auto chunks = std::vector<std::string>{};
+    screen.screenshot([&](char const* _data, size_t _size) { chunks.emplace_back(_data, _size); });
+    REQUIRE(chunks.size() > 3);
+
+    // Every line starts by (re)establishing the graphics rendition, as it is reset at line ends.
+    REQUIRE(chunks[0].substr(0, 7) == "\033[m\033[0;");
+    auto const sgr = chunks[0].substr(3, chunks[0].find('m', 3) - 2);
+    for (size_t i = 1; i < chunks.size(); ++i)
+    {
+        INFO(fmt::format("chunk {}: {}", i, e(chunks[i].substr(0, 32))));
+        CHECK(chunks[i - 1].size() >= Screen::ScreenshotChunkSize);
+        CHECK(chunks[i - 1].substr(chunks[i - 1].size() - 5) == "\033[m\r\n");
+        CHECK(chunks[i].substr(0, sgr.size()) == sgr);
+    }
+
+    // Replaying the chunks one after another restores the screen, including its history.
+    auto replay = MockScreen{pageSize};
+    for (auto const& chunk: chunks)
+        replay.write(chunk);
+    CHECK(replay.historyLineCount() >= LineCount(3000 - 10));
+    for (int const line: {0, 1000, 2000})
+    {
+        auto const& replayed = replay.grid().absoluteLineAt(line);
+        auto const& original = screen.grid().absoluteLineAt(line);
+        CHECK(replayed.toUtf8() == original.toUtf8());
+        CHECK(replayed[0].attributes() == original[0].attributes());
+        CHECK(replayed[0].attributes().styles & CellFlags::Bold);
+    }
 }
 
 TEST_CASE("render into history", "[screen]")
@@ -2340,6 +2539,69 @@ TEST_CASE("OSC.4")
     }
 }
 
+TEST_CASE("ResolvedColorCache.paletteGeneration", "[screen]")
+{
+    auto screen = MockScreen{PageSize{LineCount(2), ColumnCount(2)}};
+    auto cache = ResolvedColorCache{};
+
+    auto attributes = GraphicsAttributes{};
+    attributes.foregroundColor = Color::Indexed(1);
+
+    auto const initial = cache.get(screen.colorPalette(), screen.colorPaletteGeneration(), attributes, false);
+    CHECK(initial.foreground == screen.colorPalette().indexedColor(1));
+    CHECK(cache.misses() == 1);
+
+    // Same attributes and palette result into a cache hit.
+    (void) cache.get(screen.colorPalette(), screen.colorPaletteGeneration(), attributes, false);
+    CHECK(cache.hits() == 1);
+
+    // Changing the palette via OSC 4 invalidates the cache.
+    auto const generation = screen.colorPaletteGeneration();
+    screen.write("\033]4;1;rgb:ab/cd/ef\033\\");
+    CHECK(screen.colorPaletteGeneration() != generation);
+    auto const updated = cache.get(screen.colorPalette(), screen.colorPaletteGeneration(), attributes, false);
+    CHECK(updated.foreground == RGBColor{0xAB, 0xCD, 0xEF});
+    CHECK(cache.misses() == 2);
+
+    // Reverse video is part of the key.
+    auto const reversed = cache.get(screen.colorPalette(), screen.colorPaletteGeneration(), GraphicsAttributes{}, true);
+    CHECK(reversed.foreground == screen.colorPalette().defaultBackground);
+    CHECK(reversed.background == screen.colorPalette().defaultForeground);
+
+    // RGB colors differing only in their green/blue components must not collide.
+    auto a = GraphicsAttributes{};
+    a.foregroundColor = RGBColor{0x10, 0x20, 0x30};
+    auto b = GraphicsAttributes{};
+    b.foregroundColor = RGBColor{0x10, 0x40, 0x50};
+    CHECK(cache.get(screen.colorPalette(), screen.colorPaletteGeneration(), a, false).foreground == RGBColor{0x10, 0x20, 0x30});
+    CHECK(cache.get(screen.colorPalette(), screen.colorPaletteGeneration(), b, false).foreground == RGBColor{0x10, 0x40, 0x50});
+}
+
+TEST_CASE("Screen.vtMetrics", "[screen]")
+{
+    auto screen = MockScreen{PageSize{LineCount(2), ColumnCount(4)}};
+    screen.write("AB\r\n\033[31mX\033[m\033[1;2H\033]2;hi\033\\");
+
+    auto const metrics = screen.vtMetrics();
+    CHECK(metrics.text == 3);
+    CHECK(metrics.controls == 2);
+    CHECK(metrics.sequences[Metrics::indexOf(SGR)] == 2);
+    CHECK(metrics.sequences[Metrics::indexOf(CUP)] == 1);
+    CHECK(metrics.sequences[Metrics::indexOf(SETWINTITLE)] == 1);
+    CHECK(metrics.totalSequences() == 4);
+    CHECK(metrics.bytes(FunctionCategory::CSI) == 11); // "[31m", "[m", "[1;2H"
+    CHECK(metrics.bytes(FunctionCategory::OSC) == 5);  // "]2;hi", the terminating ST is accounted to ESC
+    CHECK(metrics.states[static_cast<size_t>(parser::State::Ground)] == 5);
+
+    auto const ordered = metrics.ordered();
+    REQUIRE(!ordered.empty());
+    CHECK(*ordered.front().first == SGR);
+
+    screen.resetVTMetrics();
+    CHECK(screen.vtMetrics().totalSequences() == 0);
+    CHECK(screen.vtMetrics().states[static_cast<size_t>(parser::State::Ground)] == 0);
+}
+
 TEST_CASE("XTGETTCAP")
 {
     auto screen = MockScreen{PageSize{LineCount(2), ColumnCount(2)}};
@@ -2584,6 +2846,32 @@ TEST_CASE("DECCRA.Left.intersecting", "[screen]")
 }
 // }}}
 
+TEST_CASE("OSC.8.eviction", "[screen]")
+{
+    auto screen = MockScreen{PageSize{LineCount(2), ColumnCount(4)}};
+    screen.write("\033]8;;https://a/\033\\A\033]8;;\033\\");
+    REQUIRE(screen.hyperlinkAt({1, 1}) != nullptr);
+    CHECK(screen.hyperlinkAt({1, 1})->uri == "https://a/");
+    CHECK(screen.hyperlinkAt({1, 2}) == nullptr);
+
+    // Let the storage be exhausted with two hyperlinks.
+    screen.hyperlinks().setMaxMemory(2 * screen.hyperlinks().memoryUsage());
+    screen.write("\033]8;;https://b/\033\\B\033]8;;\033\\");
+    REQUIRE(screen.hyperlinks().size() == 2);
+    REQUIRE(screen.hyperlinks().exhausted());
+
+    // Overwriting the cell of the first hyperlink leaves it unreferenced.
+    screen.write("\033[1;1HX\033[1;3H");
+    screen.write("\033]8;;https://c/\033\\C\033]8;;\033\\");
+
+    CHECK(screen.hyperlinks().size() == 2);
+    CHECK(screen.hyperlinkAt({1, 1}) == nullptr);
+    REQUIRE(screen.hyperlinkAt({1, 2}) != nullptr);
+    CHECK(screen.hyperlinkAt({1, 2})->uri == "https://b/");
+    REQUIRE(screen.hyperlinkAt({1, 3}) != nullptr);
+    CHECK(screen.hyperlinkAt({1, 3})->uri == "https://c/");
+}
+
 // TODO: SetForegroundColor
 // TODO: SetBackgroundColor
 // TODO: SetGraphicsRendition
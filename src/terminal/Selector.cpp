@@ -24,6 +24,7 @@ namespace terminal {
 Selector::Selector(Mode _mode,
 				   GetCellAt _getCellAt,
                    GetWrappedFlag _wrappedFlag,
+                   GetLogicalLineRange _logicalLineRange,
 				   std::u32string const& _wordDelimiters,
 				   LineCount _totalRowCount,
 				   ColumnCount _columnCount,
@@ -31,6 +32,7 @@ Selector::Selector(Mode _mode,
 	mode_{_mode},
 	getCellAt_{move(_getCellAt)},
     wrapped_{move(_wrappedFlag)},
+    logicalLineRange_{move(_logicalLineRange)},
 	wordDelimiters_{_wordDelimiters},
 	totalRowCount_{_totalRowCount},
     columnCount_{_columnCount},
@@ -44,13 +46,9 @@ Selector::Selector(Mode _mode,
 		swapDirection();
 		extend({from_.row, columnCount_.as<int>()});
 
-        // backward
-        while (from_.row > 0 && wrapped_(from_.row))
-            from_.row--;
-
-        // forward
-        while (to_.row < *_totalRowCount && wrapped_(to_.row + 1))
-            to_.row++;
+        // extend to the full logical line
+        from_.row = logicalLineRange_(from_.row).first;
+        to_.row = logicalLineRange_(to_.row).last;
 	}
 	else if (isWordWiseSelection())
 	{
@@ -81,6 +79,11 @@ Selector::Selector(Mode _mode,
         [screen = std::ref(_screen)](int _line) -> bool {
             return screen.get().lineWrapped(_line);
         },
+        [screen = std::ref(_screen)](int _line) -> LogicalLineRange {
+            auto const& buffer = screen.get();
+            auto const lastLine = unbox<int>(buffer.historyLineCount() + buffer.size().lines) - 1;
+            return buffer.logicalLineRange(clamp(_line, 0, lastLine));
+        },
         _wordDelimiters,
         _screen.size().lines + _screen.historyLineCount(),
         _screen.size().columns,
@@ -136,14 +139,12 @@ bool Selector::extend(Coordinate const& _coord)
             if (coord > start_)
             {
                 to_ = coord;
-                while (to_.row + 1 < *totalRowCount_ && wrapped_(to_.row + 1))
-                    to_.row++;
+                to_.row = logicalLineRange_(to_.row).last;
             }
             else if (coord < start_)
             {
                 from_ = coord;
-                while (from_.row > 0 && wrapped_(from_.row))
-                    from_.row--;
+                from_.row = logicalLineRange_(from_.row).first;
             }
             break;
         case Mode::Linear:
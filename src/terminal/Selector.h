@@ -29,6 +29,7 @@ namespace terminal {
 
 class Screen;
 class Cell;
+struct LogicalLineRange;
 
 /**
  * Selector API.
@@ -76,10 +77,12 @@ class Selector {
     enum class Mode { Linear, LinearWordWise, FullLine, Rectangular };
 	using GetCellAt = std::function<Cell const*(Coordinate)>;
     using GetWrappedFlag = std::function<bool(int)>;
+    using GetLogicalLineRange = std::function<LogicalLineRange(int)>;
 
     Selector(Mode _mode,
 			 GetCellAt _at,
              GetWrappedFlag _wrappedFlag,
+             GetLogicalLineRange _logicalLineRange,
 			 std::u32string const& _wordDelimiters,
 			 LineCount _totalRowCount,
              ColumnCount _columnCount,
@@ -185,6 +188,7 @@ class Selector {
 	Mode mode_;
 	GetCellAt getCellAt_;
     GetWrappedFlag wrapped_;
+    GetLogicalLineRange logicalLineRange_;
 	std::u32string wordDelimiters_;
 	LineCount totalRowCount_;
     ColumnCount columnCount_;
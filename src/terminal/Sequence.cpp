@@ -1,11 +1,9 @@
 #include <terminal/Sequence.h>
 #include <crispy/escape.h>
 
-#include <numeric>
 #include <string>
 #include <sstream>
 
-using std::accumulate;
 using std::string;
 using std::stringstream;
 
@@ -24,7 +22,7 @@ std::string Sequence::raw() const
         case FunctionCategory::OSC: sstr << "\033]"; break;
     }
 
-    if (parameterCount() > 1 || (parameterCount() == 1 && parameters_[0][0] != 0))
+    if (parameterCount() > 1 || (parameterCount() == 1 && param(0) != 0))
     {
         for (auto i = 0u; i < parameterCount(); ++i)
         {
@@ -57,35 +55,18 @@ string Sequence::text() const
     if (leaderSymbol_)
         sstr << ' ' << leaderSymbol_;
 
-    if (parameterCount() > 1 || (parameterCount() == 1 && parameters_[0][0] != 0))
+    if (parameterCount() > 1 || (parameterCount() == 1 && param(0) != 0))
     {
-        sstr << ' ' << accumulate(
-            begin(parameters_), end(parameters_), string{},
-            [](string const& a, auto const& p) -> string {
-                return !a.empty()
-                    ? fmt::format("{};{}",
-                            a,
-                            accumulate(
-                                begin(p), end(p),
-                                string{},
-                                [](string const& x, Sequence::Parameter y) -> string {
-                                    return !x.empty()
-                                        ? fmt::format("{}:{}", x, y)
-                                        : std::to_string(y);
-                                }
-                            )
-                        )
-                    : accumulate(
-                            begin(p), end(p),
-                            string{},
-                            [](string const& x, Sequence::Parameter y) -> string {
-                                return !x.empty()
-                                    ? fmt::format("{}:{}", x, y)
-                                    : std::to_string(y);
-                            }
-                        );
-            }
-        );
+        sstr << ' ';
+        for (size_t i = 0; i < parameterCount(); ++i)
+        {
+            if (i)
+                sstr << ';';
+
+            sstr << param(i);
+            for (size_t k = 0; k < subParameterCount(i); ++k)
+                sstr << ':' << subparam(i, k);
+        }
     }
 
     if (!intermediateCharacters().empty())
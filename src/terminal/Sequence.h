@@ -16,7 +16,9 @@
 #include <terminal/Functions.h>
 // #include <terminal/primitives.h>
 
+#include <array>
 #include <cassert>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -28,12 +30,83 @@ namespace terminal {
 class Sequence {
   public:
     using Parameter = unsigned;
-    using ParameterList = std::vector<std::vector<Parameter>>;
-    using Intermediaries = std::string;
+    using Intermediaries = std::string; // Short enough for CSI to always stay within the small string buffer.
     using DataString = std::string;
 
+    size_t constexpr static MaxParameters = 16;
+    size_t constexpr static MaxSubParameters = 8;
+    size_t constexpr static MaxOscLength = 512;
+
+    /// Fixed capacity storage for a sequence's parameters and their sub-parameters.
+    ///
+    /// All values are stored inline in a single flat array, where the i-th parameter is followed
+    /// by its sub-parameters, so that building up a sequence never allocates.
+    class ParameterList {
+      public:
+        size_t constexpr static Stride = 1 + MaxSubParameters;
+
+        bool empty() const noexcept { return count_ == 0; }
+        size_t size() const noexcept { return count_; }
+        void clear() noexcept { count_ = 0; }
+
+        /// Appends a new parameter, unless the parameter capacity is already exhausted,
+        /// in which case the parameter and its digits are dropped.
+        void addParameter(Parameter _value = 0) noexcept
+        {
+            if (count_ == MaxParameters)
+            {
+                current_ = DiscardSlot;
+                return;
+            }
+            current_ = count_ * Stride;
+            values_[current_] = _value;
+            subCounts_[count_] = 0;
+            ++count_;
+        }
+
+        /// Appends a new sub-parameter to the most recent parameter,
+        /// unless its sub-parameter capacity is already exhausted,
+        /// in which case the sub-parameter and its digits are dropped.
+        void addSubParameter() noexcept
+        {
+            assert(count_ != 0);
+            if (current_ == DiscardSlot)
+                return;
+            auto& subCount = subCounts_[count_ - 1];
+            if (subCount == MaxSubParameters)
+            {
+                current_ = DiscardSlot;
+                return;
+            }
+            ++subCount;
+            current_ = (count_ - 1) * Stride + subCount;
+            values_[current_] = 0;
+        }
+
+        /// Appends a decimal digit to the most recent parameter or sub-parameter.
+        void appendDigit(Parameter _digit) noexcept
+        {
+            assert(count_ != 0);
+            auto& value = values_[current_];
+            value = value * 10 + _digit;
+        }
+
+        Parameter value(size_t _index) const noexcept { return values_[_index * Stride]; }
+        size_t subCount(size_t _index) const noexcept { return subCounts_[_index]; }
+        Parameter subValue(size_t _index, size_t _subIndex) const noexcept { return values_[_index * Stride + 1 + _subIndex]; }
+
+      private:
+        // Receives the digits of parameters and sub-parameters that exceed the capacity.
+        size_t constexpr static DiscardSlot = MaxParameters * Stride;
+
+        std::array<Parameter, MaxParameters * Stride + 1> values_{};
+        std::array<uint8_t, MaxParameters> subCounts_{};
+        size_t count_ = 0;
+        size_t current_ = 0;
+    };
+
   private:
-    FunctionCategory category_;
+    FunctionCategory category_ = FunctionCategory::C0;
     char leaderSymbol_ = 0;
     ParameterList parameters_;
     Intermediaries intermediateCharacters_;
@@ -41,18 +114,6 @@ class Sequence {
     DataString dataString_;
 
   public:
-    size_t constexpr static MaxParameters = 16;
-    size_t constexpr static MaxSubParameters = 8;
-    size_t constexpr static MaxOscLength = 512;
-
-    Sequence()
-    {
-        parameters_.resize(MaxParameters);
-        for (auto& param : parameters_)
-            param.reserve(MaxSubParameters);
-        parameters_.clear();
-    }
-
     // mutators
     //
     void clear()
@@ -91,7 +152,7 @@ class Sequence {
         switch (category_)
         {
             case FunctionCategory::OSC:
-                return FunctionSelector{category_, 0, static_cast<int>(parameters_[0][0]), 0, 0};
+                return FunctionSelector{category_, 0, static_cast<int>(parameters_.value(0)), 0, 0};
             default:
             {
                 // Only support CSI sequences with 0 or 1 intermediate characters.
@@ -112,13 +173,13 @@ class Sequence {
 
     ParameterList const& parameters() const noexcept { return parameters_; }
     size_t parameterCount() const noexcept { return parameters_.size(); }
-    size_t subParameterCount(size_t _index) const noexcept { return parameters_[_index].size() - 1; }
+    size_t subParameterCount(size_t _index) const noexcept { return parameters_.subCount(_index); }
 
     template <typename T = unsigned>
     std::optional<T> param_opt(size_t _index) const noexcept
     {
-        if (_index < parameters_.size() && parameters_[_index][0])
-            return {T(parameters_[_index][0])};
+        if (_index < parameters_.size() && parameters_.value(_index))
+            return {T(parameters_.value(_index))};
         else
             return std::nullopt;
     }
@@ -133,23 +194,22 @@ class Sequence {
     T param(size_t _index) const noexcept
     {
         assert(_index < parameters_.size());
-        assert(0 < parameters_[_index].size());
-        return T(parameters_[_index][0]);
+        return T(parameters_.value(_index));
     }
 
     template <typename T = unsigned>
     T subparam(size_t _index, size_t _subIndex) const noexcept
     {
         assert(_index < parameters_.size());
-        assert(_subIndex + 1 < parameters_[_index].size());
-        return T(parameters_[_index][_subIndex + 1]);
+        assert(_subIndex < parameters_.subCount(_index));
+        return T(parameters_.subValue(_index, _subIndex));
     }
 
     template <typename T = unsigned>
     bool containsParameter(T _value) const noexcept
     {
         for (size_t i = 0; i < parameterCount(); ++i)
-            if (T(parameters_[i][0]) == _value)
+            if (T(parameters_.value(i)) == _value)
                 return true;
         return false;
     }
@@ -241,7 +241,7 @@ namespace impl // {{{ some command generator helpers
                         auto const b = _seq.subparam(i, 3);
                         if (r <= 255 && g <= 255 && b <= 255)
                         {
-                            *pi = i + 1;
+                            *pi = i;
                             return Color{RGBColor{static_cast<uint8_t>(r), static_cast<uint8_t>(g), static_cast<uint8_t>(b)} };
                         }
                     }
@@ -252,7 +252,7 @@ namespace impl // {{{ some command generator helpers
                 case 5: // ":5:P"
                     if (auto const P = _seq.subparam(i, 1); P <= 255)
                     {
-                        *pi = i + 1;
+                        *pi = i;
                         return static_cast<IndexedColor>(P);
                     }
                     break;
@@ -564,7 +564,7 @@ namespace impl // {{{ some command generator helpers
     {
         if (_seq.intermediateCharacters().empty())
         {
-            _screen.colorPalette() = _screen.defaultColorPalette();
+            _screen.resetColorPalette();
             return ApplyResult::Ok;
         }
 
@@ -572,7 +572,7 @@ namespace impl // {{{ some command generator helpers
         if (!index.has_value())
             return ApplyResult::Invalid;
 
-        _screen.colorPalette().palette[*index] = _screen.defaultColorPalette().palette[*index];
+        _screen.resetPaletteColor(*index);
 
         return ApplyResult::Ok;
     }
@@ -586,7 +586,7 @@ namespace impl // {{{ some command generator helpers
                 _screen.reply("\e]4;rgb:{:02x}/{:02x}/{:02x}\\", color.red, color.green, color.blue);
             },
             [&](uint8_t index, RGBColor color) {
-                _screen.colorPalette().palette.at(index) = color;
+                _screen.setPaletteColor(index, color);
             }
         );
 
@@ -725,21 +725,26 @@ namespace impl // {{{ some command generator helpers
 
     ApplyResult CAPTURE(Sequence const& _seq, Screen& _screen)
     {
-        // CSI Mode ; [; Count] t
+        // CSI > Mode ; [Count ; [ChunkSize]] t
         //
         // Mode: 0 = physical lines
         //       1 = logical lines (unwrapped)
         //
         // Count: number of lines to capture from main page aera's bottom upwards
         //        If omitted or 0, the main page area's line count will be used.
+        //
+        // ChunkSize: maximum number of bytes per reply chunk.
+        //            If omitted or 0, a default chunk size will be used.
 
         auto const logicalLines = _seq.param_or(0, 0);
         if (logicalLines != 0 && logicalLines != 1)
             return ApplyResult::Invalid;
 
         auto const lineCount = _seq.param_or(1, *_screen.size().lines);
+        auto const chunkSize = std::min(_seq.param_or<size_t>(2, Screen::DefaultCaptureChunkSize),
+                                        Screen::MaxCaptureChunkSize);
 
-        _screen.eventListener().requestCaptureBuffer(lineCount, logicalLines);
+        _screen.eventListener().requestCaptureBuffer(lineCount, logicalLines, chunkSize);
 
         return ApplyResult::Ok;
     }
@@ -924,6 +929,7 @@ void Sequencer::print(char32_t _char)
 {
     precedingGraphicCharacter_ = _char;
     instructionCounter_++;
+    metrics_.text++;
     screen_.writeText(_char);
 }
 
@@ -934,6 +940,7 @@ void Sequencer::print(string_view _chars)
 
     precedingGraphicCharacter_ = _chars.back();
     instructionCounter_ += _chars.size();
+    metrics_.text += _chars.size();
     screen_.writeText(_chars);
 }
 
@@ -959,31 +966,39 @@ void Sequencer::collectLeader(char _leader)
 
 void Sequencer::param(char _char)
 {
-    if (sequence_.parameters().empty())
-        sequence_.parameters().push_back({0});
+    param(string_view(&_char, 1));
+}
+
+void Sequencer::param(string_view _chars)
+{
+    auto& parameters = sequence_.parameters();
 
-    switch (_char)
+    if (parameters.empty())
+        parameters.addParameter();
+
+    for (char const ch: _chars)
     {
-        case ';':
-            if (sequence_.parameters().size() < Sequence::MaxParameters)
-                sequence_.parameters().push_back({0});
-            break;
-        case ':':
-            if (sequence_.parameters().back().size() < Sequence::MaxParameters)
-                sequence_.parameters().back().push_back({0});
-            break;
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-            sequence_.parameters().back().back() = sequence_.parameters().back().back() * 10 + (_char - U'0');
-            break;
+        switch (ch)
+        {
+            case ';':
+                parameters.addParameter();
+                break;
+            case ':':
+                parameters.addSubParameter();
+                break;
+            case '0':
+            case '1':
+            case '2':
+            case '3':
+            case '4':
+            case '5':
+            case '6':
+            case '7':
+            case '8':
+            case '9':
+                parameters.appendDigit(static_cast<Sequence::Parameter>(ch - '0'));
+                break;
+        }
     }
 }
 
@@ -1015,10 +1030,17 @@ void Sequencer::putOSC(char32_t _char)
             sequence_.intermediateCharacters().push_back(u8[i]);
 }
 
+void Sequencer::putOSC(string_view _chars)
+{
+    auto& text = sequence_.intermediateCharacters();
+    if (text.size() + 1 < Sequence::MaxOscLength)
+        text.append(_chars.substr(0, Sequence::MaxOscLength - 1 - text.size()));
+}
+
 void Sequencer::dispatchOSC()
 {
     auto const [code, skipCount] = parseOSC(sequence_.intermediateCharacters());
-    sequence_.parameters().push_back({static_cast<Sequence::Parameter>(code)});
+    sequence_.parameters().addParameter(static_cast<Sequence::Parameter>(code));
     sequence_.intermediateCharacters().erase(0, skipCount);
     handleSequence();
     sequence_.clear();
@@ -1037,6 +1059,7 @@ void Sequencer::hook(char _finalChar)
 
     if (FunctionDefinition const* funcSpec = sequence_.functionDefinition(); funcSpec != nullptr)
     {
+        metrics_(*funcSpec);
         switch (funcSpec->id())
         {
             case DECSIXEL:
@@ -1056,6 +1079,8 @@ void Sequencer::hook(char _finalChar)
         if (hookedParser_)
             hookedParser_->start();
     }
+    else
+        metrics_.unknown(FunctionCategory::DCS);
 }
 
 void Sequencer::put(char32_t _char)
@@ -1064,6 +1089,13 @@ void Sequencer::put(char32_t _char)
         hookedParser_->pass(_char);
 }
 
+void Sequencer::put(string_view _chars)
+{
+    if (hookedParser_)
+        for (char const ch: _chars)
+            hookedParser_->pass(static_cast<char32_t>(ch));
+}
+
 void Sequencer::unhook()
 {
     if (hookedParser_)
@@ -1207,7 +1239,9 @@ unique_ptr<ParserExtension> Sequencer::hookDECRQSS(Sequence const& /*_seq*/)
 
 void Sequencer::executeControlFunction(char _c0)
 {
+    CRISPY_TRACE(VTExecuteTrace, static_cast<uint8_t>(_c0));
     instructionCounter_++;
+    metrics_.controls++;
     switch (_c0)
     {
         case 0x07: // BEL
@@ -1257,11 +1291,19 @@ void Sequencer::handleSequence()
     instructionCounter_++;
     if (FunctionDefinition const* funcSpec = sequence_.functionDefinition(); funcSpec != nullptr)
     {
+        metrics_(*funcSpec);
         applyAndLog(*funcSpec, sequence_);
         screen_.verifyState();
     }
-    else if (crispy::debugtag::enabled(VTParserTag))
-        debuglog(VTParserTag).write("Unknown VT sequence: {}", sequence_);
+    else
+    {
+        metrics_.unknown(sequence_.category());
+        CRISPY_TRACE(VTUnknownTrace,
+                     static_cast<uint32_t>(sequence_.category()),
+                     static_cast<uint64_t>(static_cast<uint8_t>(sequence_.finalChar())));
+        if (crispy::debugtag::enabled(VTParserTag))
+            debuglog(VTParserTag).write("Unknown VT sequence: {}", sequence_);
+    }
 }
 
 void Sequencer::flushBatchedSequences()
@@ -1288,13 +1330,16 @@ void Sequencer::flushBatchedSequences()
 void Sequencer::applyAndLog(FunctionDefinition const& _function, Sequence const& _seq)
 {
     auto const result = apply(_function, _seq);
+    CRISPY_TRACE(VTSequenceTrace, _function.id(), static_cast<uint64_t>(result));
     switch (result)
     {
         case ApplyResult::Invalid:
-            debuglog(VTParserTag).write("Invalid VT sequence: {}", _seq);
+            if (crispy::debugtag::enabled(VTParserTag))
+                debuglog(VTParserTag).write("Invalid VT sequence: {}", _seq);
             break;
         case ApplyResult::Unsupported:
-            debuglog(VTParserTag).write("Unsupported VT sequence: {}", _seq);
+            if (crispy::debugtag::enabled(VTParserTag))
+                debuglog(VTParserTag).write("Unsupported VT sequence: {}", _seq);
             break;
         case ApplyResult::Ok:
             break;
@@ -17,6 +17,7 @@
 #include <terminal/ParserEvents.h>
 #include <terminal/ParserExtension.h>
 #include <terminal/Functions.h>
+#include <terminal/Metrics.h>
 #include <terminal/Sequence.h>
 #include <terminal/SixelParser.h>
 #include <terminal/primitives.h>
@@ -474,6 +475,10 @@ class Sequencer : public ParserEvents {
     int64_t instructionCounter() const noexcept { return instructionCounter_; }
     void resetInstructionCounter() noexcept { instructionCounter_ = 0; }
 
+    /// VT usage metrics, except for the parser state counters (see Screen::vtMetrics()).
+    Metrics const& metrics() const noexcept { return metrics_; }
+    void resetMetrics() noexcept { metrics_.reset(); }
+
     // ParserEvents
     //
     void error(std::string_view const& _errorString) override;
@@ -484,13 +489,16 @@ class Sequencer : public ParserEvents {
     void collect(char _char) override;
     void collectLeader(char _leader) override;
     void param(char _char) override;
+    void param(std::string_view _chars) override;
     void dispatchESC(char _function) override;
     void dispatchCSI(char _function) override;
     void startOSC() override;
     void putOSC(char32_t _char) override;
+    void putOSC(std::string_view _chars) override;
     void dispatchOSC() override;
     void hook(char _function) override;
     void put(char32_t _char) override;
+    void put(std::string_view _chars) override;
     void unhook() override;
 
   private:
@@ -513,6 +521,7 @@ class Sequencer : public ParserEvents {
     Screen& screen_;
     char32_t precedingGraphicCharacter_ = {};
     int64_t instructionCounter_ = 0;
+    Metrics metrics_{};
     using Batchable = std::variant<char32_t, Sequence, SixelImage>;
     std::vector<Batchable> batchedSequences_;
 
@@ -0,0 +1,139 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Screen.h>
+#include <catch2/catch_all.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string_view>
+
+using namespace std::string_view_literals;
+using namespace terminal;
+
+// {{{ allocation counting
+namespace
+{
+    // The replaced operator new is shared by the whole test binary, so allocations are only
+    // counted while a test explicitly asks for it (see AllocationCounter).
+    std::atomic<bool> countAllocations = false;
+    std::atomic<uint64_t> allocationCount = 0;
+
+    /// Counts the allocations made during its lifetime.
+    class AllocationCounter {
+      public:
+        AllocationCounter() noexcept : start_{allocationCount.load()} { countAllocations = true; }
+        ~AllocationCounter() { countAllocations = false; }
+
+        uint64_t count() const noexcept { return allocationCount.load() - start_; }
+
+      private:
+        uint64_t start_;
+    };
+}
+
+void* operator new(std::size_t _size)
+{
+    if (countAllocations.load(std::memory_order_relaxed))
+        ++allocationCount;
+    if (void* p = std::malloc(_size ? _size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* _pointer) noexcept
+{
+    std::free(_pointer);
+}
+
+void operator delete(void* _pointer, std::size_t) noexcept
+{
+    std::free(_pointer);
+}
+// }}}
+
+TEST_CASE("Sequencer.parameters", "[Sequencer]")
+{
+    auto events = MockScreenEvents{};
+    auto screen = Screen{PageSize{LineCount(2), ColumnCount(4)}, events};
+
+    // More parameters than fit are dropped along with their digits, the rest is kept intact.
+    screen.write("\033[0;0;0;0;0;0;0;0;0;0;0;0;0;0;0;3;1;4m"sv); // 18 parameters
+    CHECK(screen.cursor().graphicsRendition.styles & CellFlags::Italic);
+    CHECK_FALSE(screen.cursor().graphicsRendition.styles & CellFlags::Bold);
+    CHECK_FALSE(screen.cursor().graphicsRendition.styles & CellFlags::Underline);
+
+    // More sub-parameters than fit are dropped, the following parameters are kept intact.
+    screen.write("\033[0;38:5:1:2:3:4:5:6:7:8:9:10;1m"sv); // 11 sub-parameters
+    CHECK(screen.cursor().graphicsRendition.foregroundColor == Color{IndexedColor::Red});
+    CHECK(screen.cursor().graphicsRendition.styles & CellFlags::Bold);
+
+    auto seq = Sequence{};
+    seq.setCategory(FunctionCategory::CSI);
+    seq.parameters().addParameter(38);
+    seq.parameters().addSubParameter();
+    seq.parameters().appendDigit(2);
+    seq.parameters().addSubParameter();
+    seq.parameters().addSubParameter();
+    seq.parameters().appendDigit(1);
+    seq.parameters().appendDigit(2);
+    seq.parameters().addParameter();
+    seq.parameters().appendDigit(7);
+    seq.setFinalChar('m');
+
+    CHECK(seq.parameterCount() == 2);
+    CHECK(seq.param(0) == 38);
+    CHECK(seq.subParameterCount(0) == 3);
+    CHECK(seq.subparam(0, 0) == 2);
+    CHECK(seq.subparam(0, 1) == 0);
+    CHECK(seq.subparam(0, 2) == 12);
+    CHECK(seq.param(1) == 7);
+    CHECK(seq.text() == "CSI 38:2:0:12;7 m");
+
+    for (unsigned i = 0; i < Sequence::MaxSubParameters + 2; ++i)
+    {
+        seq.parameters().addSubParameter();
+        seq.parameters().appendDigit(i);
+    }
+    CHECK(seq.subParameterCount(1) == Sequence::MaxSubParameters);
+    CHECK(seq.subparam(1, Sequence::MaxSubParameters - 1) == Sequence::MaxSubParameters - 1);
+
+    for (unsigned i = 0; i < Sequence::MaxParameters + 2; ++i)
+    {
+        seq.parameters().addParameter();
+        seq.parameters().appendDigit(i % 10);
+    }
+    CHECK(seq.parameterCount() == Sequence::MaxParameters);
+    // The two parameters from above leave room for 14 more, the digits of the dropped ones are ignored.
+    CHECK(seq.param(Sequence::MaxParameters - 1) == 3);
+}
+
+TEST_CASE("Sequencer.csi_does_not_allocate", "[Sequencer]")
+{
+    auto events = MockScreenEvents{};
+    auto screen = Screen{PageSize{LineCount(4), ColumnCount(20)}, events};
+
+    // SGR heavy output, as emitted by tools colorizing every single character with 24-bit colors.
+    auto const chunk = "\033[38;2;255;128;64m\033[48:2::1:2:3m\033[1;4H\033[K\033[2;3r\033[r\033[m"sv;
+
+    screen.write(chunk); // warm up
+    auto const allocations = [&]() {
+        auto const counter = AllocationCounter{};
+        for (int i = 0; i < 100; ++i)
+            screen.write(chunk);
+        return counter.count();
+    }();
+
+    CHECK(allocations == 0);
+}
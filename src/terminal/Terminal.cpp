@@ -22,6 +22,7 @@
 #include <crispy/debuglog.h>
 
 #include <chrono>
+#include <mutex>
 #include <utility>
 
 #include <iostream>
@@ -47,9 +48,10 @@ namespace // {{{ helpers
             value.pop_back();
     }
 
-    tuple<RGBColor, RGBColor> makeColors(ColorPalette const& _colorPalette, Cell const& _cell, bool _reverseVideo, bool _selected)
+    tuple<RGBColor, RGBColor> makeColors(ColorPalette const& _colorPalette, ResolvedColors const& _colors, bool _selected)
     {
-        auto const [fg, bg] = _cell.attributes().makeColors(_colorPalette, _reverseVideo);
+        auto const fg = _colors.foreground;
+        auto const bg = _colors.background;
         if (!_selected)
             return tuple{fg, bg};
 
@@ -58,15 +60,12 @@ namespace // {{{ helpers
         return tuple{a, b};
     }
 
-    void logRenderBufferSwap(bool _success, uint64_t _frameID)
+    void logRenderBufferSwap(uint64_t _frameID)
     {
         if (!crispy::debugtag::enabled(crispy::PerfMetricsTag))
             return;
 
-        if (_success)
-            debuglog(crispy::PerfMetricsTag).write("Render buffer {} swapped.", _frameID);
-        else
-            debuglog(crispy::PerfMetricsTag).write("Render buffer {} swapping failed.", _frameID);
+        debuglog(crispy::PerfMetricsTag).write("Render buffer {} swapped.", _frameID);
     }
 }
 // }}}
@@ -88,7 +87,7 @@ Terminal::Terminal(Pty& _pty,
     changes_{ 0 },
     ptyReadBufferSize_{ _ptyReadBufferSize },
     eventListener_{ _eventListener },
-    refreshInterval_{ static_cast<long long>(1000.0 / _refreshRate) },
+    frameScheduler_{ _refreshRate },
     renderBuffer_{},
     pty_{ _pty },
     cursorDisplay_{ CursorDisplay::Steady }, // TODO: pass via param
@@ -122,6 +121,16 @@ Terminal::~Terminal()
 
     if (screenUpdateThread_)
         screenUpdateThread_->join();
+
+#if defined(CONTOUR_PERF_STATS)
+    if (frameScheduler_.inputLatency().count())
+    {
+        debuglog(crispy::PerfMetricsTag).write("Input-to-photon latency: {}", frameScheduler_.inputLatency().summary());
+        debuglog(crispy::PerfMetricsTag).write("- application response: {}", frameScheduler_.responseLatency().summary());
+        debuglog(crispy::PerfMetricsTag).write("- render buffer refresh: {}", frameScheduler_.refreshLatency().summary());
+        debuglog(crispy::PerfMetricsTag).write("- frame presentation: {}", frameScheduler_.presentLatency().summary());
+    }
+#endif
 }
 
 void Terminal::start()
@@ -131,7 +140,12 @@ void Terminal::start()
 
 void Terminal::setRefreshRate(double _refreshRate)
 {
-    refreshInterval_ = std::chrono::milliseconds(static_cast<long long>(1000.0 / _refreshRate));
+    frameScheduler_.setRefreshRate(_refreshRate);
+}
+
+void Terminal::setEchoWindow(chrono::milliseconds _window)
+{
+    frameScheduler_.setEchoWindow(_window);
 }
 
 void Terminal::mainLoop()
@@ -158,11 +172,20 @@ void Terminal::mainLoop()
 
 bool Terminal::processInputOnce()
 {
+    if (historyReflowPending_)
+        reflowPendingHistory();
+
+    // Wake up in time for the next frame, if there is anything to be rendered.
+    // Only in passive mode this thread issues the frames itself. Otherwise the render thread does,
+    // and the next frame stays due (with no time left until then) until it has done so.
     auto const timeout =
-        renderBuffer_.state == RenderBufferState::WaitingForRefresh && !screenDirty_
+        renderBuffer_.state == RenderBufferState::WaitingForRefresh && !screenDirty_ && !historyReflowPending_
             ? std::chrono::seconds(4)
-            : refreshInterval_ // std::chrono::seconds(0)
-            ;
+#if defined(LIBTERMINAL_PASSIVE_RENDER_BUFFER_UPDATE)
+            : chrono::ceil<chrono::milliseconds>(frameScheduler_.timeUntilNextFrame(steady_clock::now()));
+#else
+            : chrono::ceil<chrono::milliseconds>(frameScheduler_.refreshInterval());
+#endif
 
     auto const bufOpt = pty_.read(ptyReadBufferSize_, timeout);
     if (!bufOpt)
@@ -171,6 +194,7 @@ bool Terminal::processInputOnce()
         return errno == EINTR || errno == EAGAIN;
     }
     auto const buf = *bufOpt;
+    CRISPY_TRACE(PtyReadTrace, static_cast<uint32_t>(buf.size()));
 
     if (buf.empty())
     {
@@ -188,6 +212,37 @@ bool Terminal::processInputOnce()
     return true;
 }
 
+void Terminal::inputSent(Timestamp _now)
+{
+    // The application's response (e.g. its echo) to keyboard input should be visible right away,
+    // which is taken care of once that response has been received (see writeToScreen()).
+    frameScheduler_.inputReceived(_now);
+}
+
+void Terminal::reflowPendingHistory()
+{
+    auto const _l = lock_guard{*this};
+
+    // Selections refer to absolute line numbers, so let's not move lines underneath,
+    // and don't count the blocked reflow as pending work until the selection is gone.
+    if (selector_)
+    {
+        historyReflowPending_ = false;
+        historyReflowBlocked_ = true;
+        return;
+    }
+
+    auto const addedLineCount = screen_.reflowPendingHistory(HistoryReflowBatchLineCount);
+    viewport_.historyLinesPrepended(addedLineCount);
+    historyReflowPending_ = screen_.historyReflowPending();
+}
+
+void Terminal::resumeHistoryReflow() noexcept
+{
+    if (historyReflowBlocked_.exchange(false))
+        historyReflowPending_ = true;
+}
+
 // {{{ RenderBuffer synchronization
 void Terminal::breakLoopAndRefreshRenderBuffer()
 {
@@ -221,8 +276,8 @@ bool Terminal::ensureFreshRenderBuffer(std::chrono::steady_clock::time_point _no
         return false;
     }
 
-    auto const elapsed = _now - renderBuffer_.lastUpdate;
-    auto const avoidRefresh = elapsed < refreshInterval_;
+    // Coalesce screen updates into at most one render buffer swap per display refresh.
+    auto const avoidRefresh = !frameScheduler_.frameDue(_now);
 
     switch (renderBuffer_.state)
     {
@@ -233,34 +288,33 @@ bool Terminal::ensureFreshRenderBuffer(std::chrono::steady_clock::time_point _no
             [[fallthrough]];
         case RenderBufferState::RefreshBuffersAndTrySwap:
             if (!_locked)
-                refreshRenderBuffer(renderBuffer_.backBuffer());
-            else
-                refreshRenderBufferInternal(renderBuffer_.backBuffer());
-            renderBuffer_.state = RenderBufferState::TrySwapBuffers;
-            [[fallthrough]];
-        case RenderBufferState::TrySwapBuffers:
             {
-                [[maybe_unused]] auto const success = renderBuffer_.swapBuffers(_now);
+                auto const _l = lock_guard{*this};
+                publishRenderBuffer(_now);
+            }
+            else
+                publishRenderBuffer(_now);
 
-                #if defined(CONTOUR_PERF_STATS)
-                logRenderBufferSwap(success, lastFrameID_);
-                #endif
+            frameScheduler_.frameIssued(_now);
 
-                #if defined(LIBTERMINAL_PASSIVE_RENDER_BUFFER_UPDATE)
-                // Passively invoked by the terminal thread -> do inform render thread about updates.
-                if (success)
-                    eventListener_.renderBufferUpdated();
-                #endif
-            }
+            #if defined(CONTOUR_PERF_STATS)
+            logRenderBufferSwap(lastFrameID_);
+            #endif
+
+            #if defined(LIBTERMINAL_PASSIVE_RENDER_BUFFER_UPDATE)
+            // Passively invoked by the terminal thread -> do inform render thread about updates.
+            eventListener_.renderBufferUpdated();
+            #endif
             break;
     }
     return true;
 }
 
-void Terminal::refreshRenderBuffer(RenderBuffer& _output)
+void Terminal::publishRenderBuffer(std::chrono::steady_clock::time_point _now)
 {
-    auto const _l = lock_guard{*this};
-    refreshRenderBufferInternal(_output);
+    // The back buffer is exclusively owned by the writer, and writers are serialized by the terminal's lock.
+    refreshRenderBufferInternal(renderBuffer_.backBuffer());
+    renderBuffer_.swapBuffers(_now);
 }
 
 void Terminal::refreshRenderBufferInternal(RenderBuffer& _output)
@@ -281,25 +335,25 @@ void Terminal::refreshRenderBufferInternal(RenderBuffer& _output)
     ++lastFrameID_;
     _output.frameID = lastFrameID_;
 #if defined(CONTOUR_PERF_STATS)
+    frameScheduler_.frameRefreshed(lastFrameID_, steady_clock::now());
     if (crispy::debugtag::enabled(TerminalTag))
         debuglog(TerminalTag).write("{}: Refreshing render buffer.\n", lastFrameID_.load());
 #endif
 
     if (renderHyperlinks)
     {
-        auto& cellAtMouse = screen_.at(currentMousePositionRel);
-        if (cellAtMouse.hyperlink())
-            cellAtMouse.hyperlink()->state = HyperlinkState::Hover; // TODO: Left-Ctrl pressed?
+        if (auto* hyperlink = screen_.hyperlinkAt(currentMousePositionRel))
+            hyperlink->state = HyperlinkState::Hover; // TODO: Left-Ctrl pressed?
     }
 
-    // {{{ void appendCell(pos, cell, fg, bg)
+    // {{{ void appendCell(pos, cell, fg, bg, ul)
     auto const appendCell = [&](Coordinate const& _pos, Cell const& _cell,
-                                RGBColor fg, RGBColor bg)
+                                RGBColor fg, RGBColor bg, RGBColor ul)
     {
         RenderCell cell;
         cell.backgroundColor = bg;
         cell.foregroundColor = fg;
-        cell.decorationColor = _cell.attributes().getUnderlineColor(screen_.colorPalette());
+        cell.decorationColor = ul;
         cell.position = _pos;
         cell.flags = _cell.attributes().styles;
 
@@ -319,13 +373,13 @@ void Terminal::refreshRenderBufferInternal(RenderBuffer& _output)
         }
 #endif
 
-        if (_cell.hyperlink())
+        if (auto const* hyperlink = screen_.hyperlinks().hyperlinkById(_cell.hyperlink()))
         {
-            auto const& color = _cell.hyperlink()->state == HyperlinkState::Hover
+            auto const& color = hyperlink->state == HyperlinkState::Hover
                                 ? screen_.colorPalette().hyperlinkDecoration.hover
                                 : screen_.colorPalette().hyperlinkDecoration.normal;
             // TODO(decoration): Move property into Terminal.
-            auto const decoration = _cell.hyperlink()->state == HyperlinkState::Hover
+            auto const decoration = hyperlink->state == HyperlinkState::Hover
                                     ? CellFlags::Underline          // TODO: decorationRenderer_.hyperlinkHover()
                                     : CellFlags::DottedUnderline;   // TODO: decorationRenderer_.hyperlinkNormal();
             cell.flags |= decoration; // toCellStyle(decoration);
@@ -350,7 +404,11 @@ void Terminal::refreshRenderBufferInternal(RenderBuffer& _output)
         {
             auto const absolutePos = Coordinate{baseLine + (_pos.row - 1), _pos.column};
             auto const selected = isSelectedAbsolute(absolutePos);
-            auto const [fg, bg] = makeColors(screen_.colorPalette(), _cell, reverseVideo, selected);
+            auto const& colors = colorCache_.get(screen_.colorPalette(),
+                                                 screen_.colorPaletteGeneration(),
+                                                 _cell.attributes(),
+                                                 reverseVideo);
+            auto const [fg, bg] = makeColors(screen_.colorPalette(), colors, selected);
 
             auto const cellEmpty = (_cell.codepoints().empty() || _cell.codepoints()[0] == 0x20)
 #if defined(LIBTERMINAL_IMAGES)
@@ -375,7 +433,7 @@ void Terminal::refreshRenderBufferInternal(RenderBuffer& _output)
                     if (!cellEmpty || customBackground)
                     {
                         state = State::Sequence;
-                        appendCell(_pos, _cell, fg, bg);
+                        appendCell(_pos, _cell, fg, bg, colors.underline);
                         _output.screen.back().flags |= CellFlags::CellSequenceStart;
                     }
                     break;
@@ -387,7 +445,7 @@ void Terminal::refreshRenderBufferInternal(RenderBuffer& _output)
                     }
                     else
                     {
-                        appendCell(_pos, _cell, fg, bg);
+                        appendCell(_pos, _cell, fg, bg, colors.underline);
 
                         if (isNewLine)
                             _output.screen.back().flags |= CellFlags::CellSequenceStart;
@@ -400,9 +458,8 @@ void Terminal::refreshRenderBufferInternal(RenderBuffer& _output)
 
     if (renderHyperlinks)
     {
-        auto& cellAtMouse = screen_.at(currentMousePositionRel);
-        if (cellAtMouse.hyperlink())
-            cellAtMouse.hyperlink()->state = HyperlinkState::Inactive;
+        if (auto* hyperlink = screen_.hyperlinkAt(currentMousePositionRel))
+            hyperlink->state = HyperlinkState::Inactive;
     }
 
     _output.cursor = renderCursor();
@@ -418,7 +475,7 @@ optional<RenderCursor> Terminal::renderCursor()
 
     // TODO: check if CursorStyle has changed, and update render context accordingly.
 
-    Cell const& cursorCell = screen_.at(screen_.cursor().position);
+    Cell const& cursorCell = std::as_const(screen_).at(screen_.cursor().position);
 
     auto const shape = screen_.focused() ? cursorShape()
                                          : CursorShape::Rectangle;
@@ -446,7 +503,10 @@ bool Terminal::sendKeyPressEvent(Key _key, Modifier _modifier, Timestamp _now)
     viewport_.scrollToBottom();
     bool const success = inputGenerator_.generate(_key, _modifier);
     if (success)
+    {
         debuglog(InputTag).write("Sending {} {}.", _key, _modifier);
+        inputSent(_now);
+    }
 
     flushInput();
     viewport_.scrollToBottom();
@@ -464,7 +524,10 @@ bool Terminal::sendCharPressEvent(char32_t _value, Modifier _modifier, Timestamp
 
     auto const success = inputGenerator_.generate(_value, _modifier);
     if (success)
+    {
         debuglog(InputTag).write("Sending \"{}\" {}.", crispy::escape(unicode::convert_to<char>(_value)), _modifier);
+        inputSent(_now);
+    }
 
     flushInput();
     viewport_.scrollToBottom();
@@ -530,10 +593,11 @@ bool Terminal::sendMousePressEvent(MouseButton _button, Modifier _modifier, Time
 void Terminal::clearSelection()
 {
     selector_.reset();
+    resumeHistoryReflow();
     breakLoopAndRefreshRenderBuffer();
 }
 
-bool Terminal::sendMouseMoveEvent(int _row, int _column, Modifier _modifier, Timestamp /*_now*/)
+bool Terminal::sendMouseMoveEvent(int _row, int _column, Modifier _modifier, Timestamp _now)
 {
     auto const newPosition = Coordinate{_row, _column};
     bool const positionChanged = newPosition != currentMousePosition_;
@@ -548,8 +612,13 @@ bool Terminal::sendMouseMoveEvent(int _row, int _column, Modifier _modifier, Tim
                                                     currentMousePosition_.column,
                                                     _modifier))
     {
-        debuglog(InputTag).write("Sending mouse move at {}:{} {}.", _row, _column, _modifier);
-        flushInput();
+        // Reports of consecutive mouse moves within the same frame are coalesced,
+        // the held back one being sent along with the next input event or frame.
+        if (_now - lastMouseMoveSent_ >= frameScheduler_.refreshInterval())
+        {
+            debuglog(InputTag).write("Sending mouse move at {}:{} {}.", _row, _column, _modifier);
+            flushPendingInput(_now);
+        }
         return true;
     }
 
@@ -662,6 +731,15 @@ void Terminal::sendRaw(string_view _text)
     flushInput();
 }
 
+void Terminal::flushPendingInput(Timestamp _now)
+{
+    if (!inputGenerator_.mouseMovePending())
+        return;
+
+    lastMouseMoveSent_ = _now;
+    flushInput();
+}
+
 void Terminal::flushInput()
 {
     inputGenerator_.swap(pendingInput_);
@@ -676,8 +754,14 @@ void Terminal::flushInput()
 
 void Terminal::writeToScreen(string_view _data)
 {
-    auto const _l = lock_guard{*this};
-    screen_.write(_data);
+    {
+        auto const _l = lock_guard{*this};
+        screen_.write(_data);
+    }
+
+    // The echo of keyboard input is rendered right away rather than with the next refresh period.
+    if (frameScheduler_.outputReceived(steady_clock::now()))
+        debuglog(TerminalTag).write("Fast-tracking echo of {} bytes.", _data.size());
 }
 
 // TODO: this family of functions seems we don't need anymore
@@ -708,7 +792,7 @@ bool Terminal::updateCursorHoveringState()
         currentMousePosition_.column
     };
 
-    auto const newState = screen_.contains(currentMousePosition_) && screen_.at(relCursorPos).hyperlink();
+    auto const newState = screen_.contains(currentMousePosition_) && screen_.hyperlinkAt(relCursorPos);
     auto const oldState = hoveringHyperlink_.exchange(newState);
     return newState != oldState;
 }
@@ -727,6 +811,7 @@ void Terminal::resizeScreen(PageSize _cells, optional<ImageSize> _pixels)
     auto const _l = lock_guard{*this};
 
     screen_.resize(_cells);
+    historyReflowPending_ = screen_.historyReflowPending();
     if (_pixels)
     {
         auto width = Width(*_pixels->width / _cells.columns.as<unsigned>());
@@ -755,27 +840,50 @@ void Terminal::setWordDelimiters(string const& _wordDelimiters)
 string Terminal::extractSelectionText() const
 {
     using namespace terminal;
+
+    // Only the selection and a snapshot of the grid are taken while holding the lock,
+    // such that extracting the text does not stall the processing of further output.
+    auto _l = std::unique_lock{*this};
+    if (!selector_)
+        return {};
+    auto const selector = *selector_;
+    auto const grid = screen_.grid().snapshot();
+    _l.unlock();
+
+    auto const columnCount = grid.screenSize().columns.as<int>();
+    auto const lineCount = unbox<int>(grid.historyLineCount() + grid.screenSize().lines);
     int lastColumn = 0;
     string text;
     string currentLine;
 
-    renderSelection([&](Coordinate const& _pos, Cell const& _cell) {
-        auto const _lock = scoped_lock{ *this };
-        auto const isNewLine = _pos.column <= lastColumn;
-        auto const isLineWrapped = lineWrapped(_pos.row);
-        bool const touchesRightPage = _pos.row > 0
-            && isSelectedAbsolute({_pos.row - 1, screen_.size().columns.as<int>()});
-        if (isNewLine && (!isLineWrapped || !touchesRightPage))
+    for (auto const& range: selector.selection())
+    {
+        if (range.line < 0 || range.line >= lineCount)
+            continue;
+
+        Line const& line = grid.absoluteLineAt(range.line);
+        bool const touchesRightPage = range.line > 0
+            && selector.state() != Selector::State::Waiting
+            && selector.contains({range.line - 1, columnCount});
+
+        for (auto const col: crispy::times(range.fromColumn, range.length()))
         {
-            // TODO: handle logical line in word-selection (don't include LF in wrapped lines)
-            trimSpaceRight(currentLine);
-            text += currentLine;
-            text += '\n';
-            currentLine.clear();
+            if (col > unbox<int>(line.size()))
+                break;
+
+            auto const isNewLine = col <= lastColumn;
+            if (isNewLine && (!line.wrapped() || !touchesRightPage))
+            {
+                // TODO: handle logical line in word-selection (don't include LF in wrapped lines)
+                trimSpaceRight(currentLine);
+                text += currentLine;
+                text += '\n';
+                currentLine.clear();
+            }
+            currentLine += line[static_cast<size_t>(col - 1)].toUtf8();
+            lastColumn = col;
         }
-        currentLine += _cell.toUtf8();
-        lastColumn = _pos.column;
-    });
+    }
 
     trimSpaceRight(currentLine);
     text += currentLine;
@@ -816,10 +924,29 @@ string Terminal::extractLastMarkRange() const
     return text;
 }
 
+void Terminal::captureBuffer(int _lineCount, bool _logicalLines, size_t _chunkSize)
+{
+    // The terminal is only locked while taking the snapshot of the lines to capture,
+    // so that the terminal can keep processing output while these are being replied.
+    auto capture = [&]() {
+        auto const _l = std::lock_guard{*this};
+        return screen_.beginCapture(_lineCount, _logicalLines);
+    }();
+    auto text = string{};
+    text.reserve(_chunkSize);
+
+    bool more = true;
+    while (more)
+    {
+        more = Screen::captureChunk(capture, _chunkSize, text);
+        screen_.replyCaptured(text, _chunkSize, !more);
+    }
+}
+
 // {{{ ScreenEvents overrides
-void Terminal::requestCaptureBuffer(int _absoluteStartLine, int _lineCount)
+void Terminal::requestCaptureBuffer(int _lineCount, bool _logicalLines, size_t _chunkSize)
 {
-    return eventListener_.requestCaptureBuffer(_absoluteStartLine, _lineCount);
+    return eventListener_.requestCaptureBuffer(_lineCount, _logicalLines, _chunkSize);
 }
 
 void Terminal::bell()
@@ -830,6 +957,7 @@ void Terminal::bell()
 void Terminal::bufferChanged(ScreenType _type)
 {
     selector_.reset();
+    resumeHistoryReflow();
     viewport_.forceScrollToBottom();
     eventListener_.bufferChanged(_type);
 }
@@ -837,6 +965,7 @@ void Terminal::bufferChanged(ScreenType _type)
 void Terminal::scrollbackBufferCleared()
 {
     selector_.reset();
+    resumeHistoryReflow();
     viewport_.scrollToBottom();
     breakLoopAndRefreshRenderBuffer();
 }
@@ -848,12 +977,6 @@ void Terminal::screenUpdated()
     if (!renderBufferUpdateEnabled_)
         return;
 
-    if (renderBuffer_.state == RenderBufferState::TrySwapBuffers)
-    {
-        renderBuffer_.swapBuffers(renderBuffer_.lastUpdate);
-        return;
-    }
-
     screenDirty_ = true;
     eventListener_.screenUpdated();
 }
@@ -987,11 +1110,7 @@ void Terminal::synchronizedOutput(bool _enabled)
     if (_enabled)
         return;
 
-    auto const diff = steady_clock::now() - renderBuffer_.lastUpdate;
-    if (diff < refreshInterval_)
-        return;
-
-    if (renderBuffer_.state == RenderBufferState::TrySwapBuffers)
+    if (!frameScheduler_.frameDue(steady_clock::now()))
         return;
 
     refreshRenderBuffer(steady_clock::now(), true);
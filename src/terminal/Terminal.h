@@ -13,6 +13,8 @@
  */
 #pragma once
 
+#include <terminal/ColorCache.h>
+#include <terminal/FrameScheduler.h>
 #include <terminal/InputGenerator.h>
 #include <terminal/pty/Pty.h>
 #include <terminal/ScreenEvents.h>
@@ -46,7 +48,7 @@ class Terminal : public ScreenEvents {
       public:
         virtual ~Events() = default;
 
-        virtual void requestCaptureBuffer(int /*_absoluteStartLine*/, int /*_lineCount*/) {}
+        virtual void requestCaptureBuffer(int /*_lineCount*/, bool /*_logicalLines*/, size_t /*_chunkSize*/) {}
         virtual void bell() {}
         virtual void bufferChanged(ScreenType) {}
         virtual void renderBufferUpdated() {}
@@ -84,6 +86,19 @@ class Terminal : public ScreenEvents {
 
     void setRefreshRate(double _refreshRate);
 
+    /// Sets the time after keyboard input within which the application's output is considered
+    /// its echo and rendered right away, bypassing the refresh rate throttling (0 disables).
+    void setEchoWindow(std::chrono::milliseconds _window);
+
+    /// Informs the terminal about the given frame having been presented on the display,
+    /// in order to align render buffer updates to the display's refresh.
+    void framePresented(uint64_t _frameID, std::chrono::steady_clock::time_point _now) noexcept
+    {
+        frameScheduler_.framePresented(_frameID, _now);
+    }
+
+    FrameScheduler const& frameScheduler() const noexcept { return frameScheduler_; }
+
     /// Retrieves the time point this terminal instance has been spawned.
     std::chrono::steady_clock::time_point startTime() const noexcept { return startTime_; }
 
@@ -107,6 +122,11 @@ class Terminal : public ScreenEvents {
     void sendPaste(std::string_view _text); // Sends verbatim text in bracketed mode to application.
     void sendRaw(std::string_view _text);   // Sends raw string to the application.
 
+    /// Sends the input that has been held back, i.e. the coalesced mouse moves, to the application.
+    ///
+    /// This is meant to be invoked once per frame by the thread sending the input events.
+    void flushPendingInput(Timestamp _now);
+
     bool applicationCursorKeys() const noexcept { return inputGenerator_.applicationCursorKeys(); }
     bool applicationKeypad() const noexcept { return inputGenerator_.applicationKeypad(); }
     // }}}
@@ -164,19 +184,16 @@ class Terminal : public ScreenEvents {
 
     /// Refreshes the render buffer.
     /// When this function returns, the back buffer is updated
-    /// and it is attempted to swap the back/front buffers.
-    /// but the swap has NOT been invoked yet.
+    /// and published to the reader, unless render buffer updates are currently disabled
+    /// (e.g. due to synchronized output).
     ///
     /// @param _now    the current time
     /// @param _locked whether or not the Terminal object's lock is already held by the caller.
     ///
-    /// @retval true   front buffer now contains the refreshed render buffer.
-    /// @retval false  back buffer contains the refreshed render buffer,
-    ///                and RenderDoubleBuffer::swapBuffers() must again
-    ///                be successfully invoked to swap back/front buffers
-    ///                in order to access the refreshed render buffer.
+    /// @retval true   the refreshed render buffer has been published.
+    /// @retval false  nothing has been published.
     ///
-    /// @see RenderDoubleBuffer::swapBuffers()
+    /// @see RenderTripleBuffer::swapBuffers()
     /// @see renderBuffer()
     ///
     bool refreshRenderBuffer(std::chrono::steady_clock::time_point _now, bool _locked = false);
@@ -189,14 +206,13 @@ class Terminal : public ScreenEvents {
     /// @param _now    the current time
     /// @param _locked whether or not the Terminal object's lock is already held by the caller.
     ///
-    /// @see RenderDoubleBuffer::swapBuffers()
+    /// @see RenderTripleBuffer::swapBuffers()
     /// @see renderBuffer()
     bool ensureFreshRenderBuffer(std::chrono::steady_clock::time_point _now, bool _locked = false);
 
-    /// Aquuires read-access handle to front render buffer.
+    /// Aquuires read-access handle to the most recently published render buffer.
     ///
-    /// This also acquires the reader lock and releases it automatically
-    /// upon RenderBufferRef destruction.
+    /// This is lock-free and must only be called by the (single) render thread.
     ///
     /// @see ensureFreshRenderBuffer()
     /// @see refreshRenderBuffer()
@@ -287,6 +303,10 @@ class Terminal : public ScreenEvents {
     std::string extractSelectionText() const;
     std::string extractLastMarkRange() const;
 
+    /// Captures the screen buffer (see Screen::captureBuffer()), with the terminal being locked
+    /// only while taking a snapshot of the lines to capture, but not while replying them.
+    void captureBuffer(int _lineCount, bool _logicalLines, size_t _chunkSize);
+
     /// Tests whether or not the mouse is currently hovering a hyperlink.
     bool isMouseHoveringHyperlink() const noexcept { return hoveringHyperlink_.load(); }
 
@@ -299,12 +319,25 @@ class Terminal : public ScreenEvents {
   private:
     void flushInput();
     void mainLoop();
-    void refreshRenderBuffer(RenderBuffer& _output); // <- acquires the lock
+    void publishRenderBuffer(std::chrono::steady_clock::time_point _now); // <- requires the lock
     void refreshRenderBufferInternal(RenderBuffer& _output);
     std::optional<RenderCursor> renderCursor();
     void updateCursorVisibilityState(std::chrono::steady_clock::time_point _now) const;
     bool updateCursorHoveringState();
 
+    /// Reflows a batch of the scrollback lines that have been left pending by the last resize.
+    void reflowPendingHistory();
+
+    /// Resumes reflowing the pending scrollback lines, if a selection has blocked it so far.
+    void resumeHistoryReflow() noexcept;
+
+    /// Records keyboard input having been sent to the application, in order to fast-track
+    /// the frame containing its echo.
+    void inputSent(Timestamp _now);
+
+    /// Number of lines reflowed per batch while scrollback lines are pending to be reflowed.
+    static constexpr auto HistoryReflowBatchLineCount = LineCount(4096);
+
     template <typename Renderer, typename... RemainingPasses>
     void renderPass(Renderer const& pass, RemainingPasses... remainingPasses) const
     {
@@ -316,7 +349,7 @@ class Terminal : public ScreenEvents {
 
     // overrides
     //
-    void requestCaptureBuffer(int _absoluteStartLine, int _lineCount) override;
+    void requestCaptureBuffer(int _lineCount, bool _logicalLines, size_t _chunkSize) override;
     void bell() override;
     void bufferChanged(ScreenType) override;
     void scrollbackBufferCleared() override;
@@ -355,9 +388,10 @@ class Terminal : public ScreenEvents {
     int ptyReadBufferSize_;
     Events& eventListener_;
 
-    std::chrono::milliseconds refreshInterval_;
+    FrameScheduler frameScheduler_;
     bool screenDirty_ = false;
-    RenderDoubleBuffer renderBuffer_{};
+    RenderTripleBuffer renderBuffer_{};
+    ResolvedColorCache colorCache_{}; //!< Palette resolved cell colors, only accessed while refreshing the render buffer.
 
     Pty& pty_;
 
@@ -379,6 +413,7 @@ class Terminal : public ScreenEvents {
     Modifier mouseProtocolBypassModifier_ = Modifier::Shift;
     bool respectMouseProtocol_ = true; // shift-click can disable that, button release sets it back to true
     bool leftMouseButtonPressed_ = false; // tracks left-mouse button pressed state (used for cell selection).
+    Timestamp lastMouseMoveSent_{};       // mouse moves are coalesced into at most one report per frame
 
     InputGenerator inputGenerator_;
     InputGenerator::Sequence pendingInput_;
@@ -390,6 +425,8 @@ class Terminal : public ScreenEvents {
     std::unique_ptr<Selector> selector_;
     std::atomic<bool> hoveringHyperlink_ = false;
     std::atomic<bool> renderBufferUpdateEnabled_ = true;
+    std::atomic<bool> historyReflowPending_ = false;
+    std::atomic<bool> historyReflowBlocked_ = false;
 
     std::atomic<uint64_t> lastFrameID_ = 0;
 };
@@ -209,3 +209,84 @@ TEST_CASE("Terminal.SynchronizedOutput", "[terminal]")
     mc.terminal().ensureFreshRenderBuffer(now);
     CHECK("Hello  World" == trimmedTextScreenshot(mc));
 }
+
+TEST_CASE("Terminal.echoWindow", "[terminal]")
+{
+    auto const now = chrono::steady_clock::now();
+    auto mc = MockTerm{ColumnCount(20), LineCount(1)};
+    auto& terminal = mc.terminal();
+    terminal.setRefreshRate(1.0); // such that no other frame is due during this test
+
+    mc.writeToStdout("A");
+    terminal.refreshRenderBuffer(now);
+    REQUIRE("A" == trimmedTextScreenshot(mc));
+
+    SECTION("output without input is throttled") {
+        mc.writeToStdout("B");
+        terminal.ensureFreshRenderBuffer(now);
+        CHECK("A" == trimmedTextScreenshot(mc));
+    }
+
+    SECTION("echo within the window is refreshed right away") {
+        terminal.sendCharPressEvent('B', terminal::Modifier{}, chrono::steady_clock::now());
+        mc.writeToStdout("B");
+        terminal.ensureFreshRenderBuffer(now);
+        CHECK("AB" == trimmedTextScreenshot(mc));
+    }
+
+    SECTION("echo with a zero window is throttled") {
+        terminal.setEchoWindow(chrono::milliseconds(0));
+        terminal.sendCharPressEvent('B', terminal::Modifier{}, chrono::steady_clock::now());
+        mc.writeToStdout("B");
+        terminal.ensureFreshRenderBuffer(now);
+        CHECK("A" == trimmedTextScreenshot(mc));
+    }
+}
+
+TEST_CASE("Terminal.extractSelectionText", "[terminal]")
+{
+    auto mc = MockTerm{ColumnCount(5), LineCount(2)};
+    mc.writeToStdout("12345\r\nABCDE\r\nabcde");
+    REQUIRE(mc.terminal().screen().historyLineCount() == LineCount(1));
+
+    // Selecting from the scrollback into the main page (absolute coordinates).
+    auto selector = std::make_unique<terminal::Selector>(terminal::Selector::Mode::Linear,
+                                                         U" ",
+                                                         mc.terminal().screen(),
+                                                         terminal::Coordinate{0, 3});
+    selector->extend(terminal::Coordinate{1, 2});
+    selector->stop();
+    mc.terminal().setSelector(std::move(selector));
+
+    auto const text = mc.terminal().extractSelectionText();
+
+    CHECK(text == "345\nAB");
+}
+
+TEST_CASE("Terminal.reflowPendingHistory_with_selection", "[terminal]")
+{
+    // Fill more scrollback than is reflowed immediately upon resize.
+    auto mc = MockTerm{ColumnCount(4), LineCount(2)};
+    for (int i = 0; i < 600; ++i)
+        mc.writeToStdout("0000ab\r\n");
+
+    auto selector = std::make_unique<terminal::Selector>(terminal::Selector::Mode::Linear,
+                                                         U" ",
+                                                         mc.terminal().screen(),
+                                                         terminal::Coordinate{0, 1});
+    selector->extend(terminal::Coordinate{1, 2});
+    selector->stop();
+    mc.terminal().setSelector(std::move(selector));
+
+    mc.terminal().resizeScreen(PageSize{LineCount(2), ColumnCount(8)}, std::nullopt);
+    REQUIRE(mc.terminal().screen().historyReflowPending());
+
+    // The selection holds back reflowing the remaining scrollback lines ...
+    mc.writeToStdout("");
+    CHECK(mc.terminal().screen().historyReflowPending());
+
+    // ... until it is gone.
+    mc.terminal().clearSelection();
+    mc.writeToStdout("");
+    CHECK_FALSE(mc.terminal().screen().historyReflowPending());
+}
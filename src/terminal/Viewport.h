@@ -146,6 +146,14 @@ class Viewport
         return false;
     }
 
+    /// Keeps the viewport at its current content after @p _count lines have been
+    /// inserted at the top of the scrollback history.
+    void historyLinesPrepended(LineCount _count) noexcept
+    {
+        if (scrollOffset_)
+            scrollOffset_ = *scrollOffset_ + boxed_cast<StaticScrollbackPosition>(_count);
+    }
+
     bool scrollMarkDown()
     {
         if (scrollingDisabled())
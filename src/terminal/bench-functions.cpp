@@ -0,0 +1,90 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Functions.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <fmt/format.h>
+
+using namespace std;
+using namespace terminal;
+
+namespace
+{
+    /// Builds a sequence mix resembling what full screen applications emit,
+    /// dominated by SGR, followed by cursor positioning and line erasing.
+    vector<FunctionSelector> makeSequenceMix(size_t _count)
+    {
+        struct Weighted { FunctionSelector selector; int weight; };
+        auto const mix = vector<Weighted>{
+            {{FunctionCategory::CSI, 0, 3, 0, 'm'}, 50},     // SGR
+            {{FunctionCategory::CSI, 0, 2, 0, 'H'}, 20},     // CUP
+            {{FunctionCategory::CSI, 0, 1, 0, 'K'}, 12},     // EL
+            {{FunctionCategory::CSI, 0, 1, 0, 'C'}, 4},      // CUF
+            {{FunctionCategory::CSI, 0, 1, 0, 'J'}, 2},      // ED
+            {{FunctionCategory::CSI, 0, 2, 0, 'r'}, 2},      // DECSTBM
+            {{FunctionCategory::CSI, '?', 1, 0, 'h'}, 3},    // DECSM
+            {{FunctionCategory::CSI, '?', 1, 0, 'l'}, 3},    // DECRM
+            {{FunctionCategory::ESC, 0, 0, 0, '7'}, 1},      // DECSC
+            {{FunctionCategory::ESC, 0, 0, 0, '8'}, 1},      // DECRS
+            {{FunctionCategory::OSC, 0, 8, 0, 0}, 1},        // hyperlink
+            {{FunctionCategory::OSC, 0, 2, 0, 0}, 1},        // window title
+        };
+
+        auto weights = vector<int>{};
+        for (auto const& entry: mix)
+            weights.push_back(entry.weight);
+
+        auto rng = mt19937{42};
+        auto distribution = discrete_distribution<size_t>(weights.begin(), weights.end());
+
+        auto output = vector<FunctionSelector>{};
+        output.reserve(_count);
+        for (size_t i = 0; i < _count; ++i)
+            output.push_back(mix[distribution(rng)].selector);
+        return output;
+    }
+
+    template <typename Select>
+    double measure(vector<FunctionSelector> const& _selectors, int _rounds, Select _select, uintptr_t& _checksum)
+    {
+        auto const start = chrono::steady_clock::now();
+        for (int round = 0; round < _rounds; ++round)
+            for (FunctionSelector const& selector: _selectors)
+                _checksum += reinterpret_cast<uintptr_t>(_select(selector));
+        auto const elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start);
+        return elapsed.count() / static_cast<double>(_selectors.size() * static_cast<size_t>(_rounds));
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    auto const rounds = argc > 1 ? atoi(argv[1]) : 100;
+    auto const selectors = makeSequenceMix(100'000);
+
+    auto checksum = uintptr_t{0};
+    auto const binarySearch = measure(selectors, rounds, [](auto const& s) { return selectBinarySearch(s); }, checksum);
+    auto const dispatchTable = measure(selectors, rounds, [](auto const& s) { return terminal::select(s); }, checksum);
+
+    cout << fmt::format("{:>16}: {:>8.2f} ns/lookup\n", "binary search", binarySearch);
+    cout << fmt::format("{:>16}: {:>8.2f} ns/lookup\n", "dispatch table", dispatchTable);
+    cout << fmt::format("{:>16}: {:>8.2f}x\n", "speedup", binarySearch / dispatchTable);
+    cout << fmt::format("{:>16}: {:x}\n", "checksum", checksum);
+
+    return EXIT_SUCCESS;
+}
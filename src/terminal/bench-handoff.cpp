@@ -0,0 +1,143 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Terminal.h>
+#include <terminal/logging.h>
+#include <terminal/pty/MockViewPty.h>
+
+#include <crispy/debuglog.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <fmt/format.h>
+
+using namespace std;
+using std::chrono::steady_clock;
+
+// Measures the parser throughput of the terminal thread while a render thread concurrently
+// hands off render buffers at a given refresh rate, as the GUI does.
+
+namespace
+{
+    class HeadlessBench: public terminal::Terminal::Events
+    {
+      public:
+        explicit HeadlessBench(terminal::PageSize _pageSize):
+            pty_{std::make_unique<terminal::MockViewPty>(_pageSize)},
+            vt_{*pty_, 8192, *this, terminal::LineCount(1000)}
+        {
+            vt_.screen().setMode(terminal::DECMode::AutoWrap, true);
+        }
+
+        terminal::Terminal& terminal() noexcept { return vt_; }
+
+        void write(string const& _data)
+        {
+            pty_->setReadData(_data);
+            do vt_.processInputOnce();
+            while (!pty_->stdoutBuffer().empty());
+        }
+
+      private:
+        std::unique_ptr<terminal::MockViewPty> pty_;
+        terminal::Terminal vt_;
+    };
+
+    string makeChunk(int _columns)
+    {
+        auto text = string{};
+        for (int i = 0; text.size() < 64 * 1024; ++i)
+        {
+            text += fmt::format("\033[3{}m", i % 8);
+            for (int k = 0; k < _columns - 1; ++k)
+                text += static_cast<char>('A' + (i + k) % 26);
+            text += "\r\n";
+        }
+        return text;
+    }
+
+    struct Result {
+        double megabytesPerSecond;
+        uint64_t frames;
+    };
+
+    /// Streams @p _megabytes into the terminal while rendering at @p _refreshRate frames per second
+    /// (or not at all if zero).
+    Result run(terminal::PageSize _pageSize, size_t _megabytes, double _refreshRate)
+    {
+        auto hb = HeadlessBench{_pageSize};
+        auto const chunk = makeChunk(*_pageSize.columns);
+        auto const rounds = _megabytes * 1024 * 1024 / chunk.size();
+
+        auto done = std::atomic<bool>{false};
+        auto frames = uint64_t{0};
+        auto renderThread = std::thread([&]() {
+            if (_refreshRate == 0.0)
+                return;
+            auto const interval = chrono::duration_cast<steady_clock::duration>(chrono::duration<double>(1.0 / _refreshRate));
+            auto nextFrame = steady_clock::now();
+            while (!done)
+            {
+                auto const now = steady_clock::now();
+                hb.terminal().refreshRenderBuffer(now);
+                {
+                    auto const renderBuffer = hb.terminal().renderBuffer();
+                    auto checksum = size_t{0};
+                    for (auto const& cell: renderBuffer.get().screen)
+                        checksum += cell.codepoints.size();
+                    if (checksum != size_t(-1))
+                        ++frames;
+                }
+                nextFrame += interval;
+                this_thread::sleep_until(nextFrame);
+            }
+        });
+
+        auto const start = steady_clock::now();
+        for (size_t i = 0; i < rounds; ++i)
+            hb.write(chunk);
+        auto const elapsed = chrono::duration<double>(steady_clock::now() - start).count();
+
+        done = true;
+        renderThread.join();
+
+        auto const bytes = static_cast<double>(rounds * chunk.size());
+        return Result{bytes / elapsed / (1024.0 * 1024.0), frames};
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    crispy::debugtag::disable(terminal::VTParserTag);
+
+    auto const megabytes = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : size_t{64};
+    auto const pageSize = terminal::PageSize{terminal::LineCount(50), terminal::ColumnCount(200)};
+
+    cout << fmt::format("Streaming {} MB into a {}x{} page.\n\n", megabytes, *pageSize.columns, *pageSize.lines);
+
+    for (double const refreshRate: {0.0, 60.0, 144.0, 1000.0})
+    {
+        auto const result = run(pageSize, megabytes, refreshRate);
+        cout << fmt::format("{:>14}: {:>8.2f} MB/s, {:>6} frames\n",
+                            refreshRate != 0.0 ? fmt::format("{} Hz", refreshRate) : string("no rendering"),
+                            result.megabytesPerSecond,
+                            result.frames);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Parser.h>
+#include <terminal/ParserEvents.h>
+
+#include <unicode/convert.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include <fmt/format.h>
+
+using namespace std;
+using std::chrono::steady_clock;
+
+// Measures the parser throughput on SGR-heavy input, as produced by syntax highlighting
+// or colored log output, both when parsing raw bytes (processing runs of input at once)
+// and when parsing decoded codepoints (dispatching each codepoint individually).
+
+namespace
+{
+    /// Consumes the parser events at minimal cost, such that the parser itself is measured.
+    class CountingParserEvents: public terminal::BasicParserEvents
+    {
+      public:
+        size_t count = 0;
+
+        void print(char32_t) override { ++count; }
+        void print(string_view _chars) override { count += _chars.size(); }
+        void execute(char) override { ++count; }
+        void param(char) override { ++count; }
+        void param(string_view _chars) override { count += _chars.size(); }
+        void dispatchCSI(char) override { ++count; }
+        void putOSC(char32_t) override { ++count; }
+        void putOSC(string_view _chars) override { count += _chars.size(); }
+    };
+
+    /// Generates about 64 KB of short words with changing colors and attributes.
+    string makeChunk()
+    {
+        auto text = string{};
+        for (int i = 0; text.size() < 64 * 1024; ++i)
+        {
+            text += fmt::format("\033[{};38;2;{};{};{}m", i % 10, i % 256, (i * 7) % 256, (i * 13) % 256);
+            text += fmt::format("word{}", i % 100);
+            text += "\033[0m ";
+            if (i % 16 == 15)
+                text += "\r\n";
+        }
+        return text;
+    }
+
+    /// Parses @p _megabytes of @p _chunk, returning the throughput in MB/s.
+    double run(string const& _chunk, size_t _megabytes, function<void(terminal::parser::Parser&)> const& _parse)
+    {
+        auto listener = CountingParserEvents{};
+        auto parser = terminal::parser::Parser{listener};
+        auto const rounds = _megabytes * 1024 * 1024 / _chunk.size();
+
+        auto const start = steady_clock::now();
+        for (size_t i = 0; i < rounds; ++i)
+            _parse(parser);
+        auto const elapsed = chrono::duration<double>(steady_clock::now() - start).count();
+
+        if (listener.count == 0)
+            cerr << "No parser events received.\n";
+
+        auto const bytes = static_cast<double>(rounds * _chunk.size());
+        return bytes / elapsed / (1024.0 * 1024.0);
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    auto const megabytes = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : size_t{256};
+    auto const chunk = makeChunk();
+    auto const codepoints = unicode::from_utf8(chunk);
+
+    cout << fmt::format("Parsing {} MB of SGR-heavy input.\n\n", megabytes);
+
+    auto const runs = run(chunk, megabytes, [&](auto& _parser) { _parser.parseFragment(chunk); });
+    cout << fmt::format("{:>12}: {:>8.2f} MB/s\n", "runs", runs);
+
+    auto const perCodepoint = run(chunk, megabytes, [&](auto& _parser) {
+        _parser.parseFragment(u32string_view(codepoints));
+    });
+    cout << fmt::format("{:>12}: {:>8.2f} MB/s\n", "codepoints", perCodepoint);
+
+    return EXIT_SUCCESS;
+}
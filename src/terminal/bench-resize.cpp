@@ -0,0 +1,87 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Grid.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <fmt/format.h>
+
+using namespace std;
+using namespace terminal;
+
+// Measures the latency of a (reflowing) resize with large scrollback buffers,
+// as well as the time it takes to reflow the remaining scrollback lines afterwards.
+
+namespace
+{
+    auto constexpr PageLines = 50;
+    auto constexpr PageColumns = 120;
+
+    /// Fills the grid's scrollback with @p _count lines, every other one continuing
+    /// the previous one as a wrapped line.
+    void fillHistory(Grid& _grid, int _count)
+    {
+        auto const margin = Margin{Margin::Range{1, PageLines}, Margin::Range{1, PageColumns}};
+        auto const fullText = string(PageColumns, 'X');
+        auto const wrappedText = string(30, 'y');
+        for (int i = 0; i < _count; ++i)
+        {
+            _grid.scrollUp(LineCount(1), GraphicsAttributes{}, margin);
+            auto& line = _grid.lineAt(PageLines);
+            line.setText(i % 2 ? wrappedText : fullText);
+            line.setWrapped(i % 2 != 0);
+        }
+    }
+
+    template <typename F>
+    double measure(F&& _f)
+    {
+        auto const start = chrono::steady_clock::now();
+        _f();
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main()
+{
+    cout << fmt::format("Resizing a {}x{} page between {} and {} columns.\n\n",
+                        PageColumns, PageLines, PageColumns, PageColumns - 20);
+
+    for (int const historyLines: {1'000, 10'000, 100'000})
+    {
+        auto grid = Grid(PageSize{LineCount(PageLines), ColumnCount(PageColumns)}, true, nullopt);
+        fillHistory(grid, historyLines);
+
+        for (int const columns: {PageColumns - 20, PageColumns})
+        {
+            auto const cursor = Coordinate{PageLines, 1};
+            auto const resizeTime = measure([&]() {
+                (void) grid.resize(PageSize{LineCount(PageLines), ColumnCount(columns)}, cursor, false);
+            });
+            auto const pending = grid.pendingReflowLineCount();
+            auto const reflowTime = measure([&]() {
+                while (*grid.pendingReflowLineCount() != 0)
+                    grid.reflowPendingLines(LineCount(4096));
+            });
+
+            cout << fmt::format("{:>8} lines to {:>3} columns: resize {:>9.3f} ms ({:>8} pending), remaining reflow {:>9.3f} ms\n",
+                                historyLines, columns, resizeTime, *pending, reflowTime);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
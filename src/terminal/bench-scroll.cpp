@@ -0,0 +1,135 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Terminal.h>
+#include <terminal/logging.h>
+#include <terminal/pty/MockViewPty.h>
+
+#include <crispy/debuglog.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+using namespace std;
+
+// Measures scrolling within margins, as done by tmux panes, editors with status lines, or pagers,
+// by streaming text into a small scroll region of a tall screen.
+
+namespace
+{
+    auto constexpr PageLines = 200;
+    auto constexpr PageColumns = 80;
+    auto constexpr MarginTop = 91;    // 20 lines scroll region in the middle of the page
+    auto constexpr MarginBottom = 110;
+
+    class HeadlessBench: public terminal::Terminal::Events
+    {
+      public:
+        explicit HeadlessBench(terminal::PageSize _pageSize):
+            pty_{std::make_unique<terminal::MockViewPty>(_pageSize)},
+            vt_{*pty_, 8192, *this, terminal::LineCount(1000)}
+        {
+            vt_.screen().setMode(terminal::DECMode::AutoWrap, true);
+        }
+
+        void write(string const& _data)
+        {
+            pty_->setReadData(_data);
+            do vt_.processInputOnce();
+            while (!pty_->stdoutBuffer().empty());
+        }
+
+      private:
+        std::unique_ptr<terminal::MockViewPty> pty_;
+        terminal::Terminal vt_;
+    };
+
+    struct Test {
+        string name;
+        string setup;       // sent once before measuring
+        string chunk;       // sent repeatedly while measuring
+    };
+
+    string textLines(size_t _count, size_t _width, string const& _lineEnd)
+    {
+        auto text = string{};
+        for (size_t i = 0; i < _count; ++i)
+        {
+            for (size_t k = 0; k < _width; ++k)
+                text += static_cast<char>('A' + (i + k) % 26);
+            text += _lineEnd;
+        }
+        return text;
+    }
+
+    vector<Test> makeTests()
+    {
+        auto const region = fmt::format("\033[{};{}r", MarginTop, MarginBottom);
+        auto const lrRegion = fmt::format("\033[?69h\033[{};{}s", 11, 70);
+
+        return vector<Test>{
+            // LF at the bottom margin, full width (scroll up)
+            {"margin_lines",
+             region + fmt::format("\033[{};1H", MarginBottom),
+             textLines(64, PageColumns - 1, "\r\n")},
+            // RI at the top margin, full width (scroll down)
+            {"margin_reverse_lines",
+             region + fmt::format("\033[{};1H", MarginTop),
+             textLines(64, PageColumns - 1, "\r\033M")},
+            // LF at the bottom margin, within left/right margins (scroll up)
+            {"lr_margin_lines",
+             region + lrRegion + fmt::format("\033[{};11H", MarginBottom),
+             textLines(64, 59, "\r\n")},
+            // RI at the top margin, within left/right margins (scroll down)
+            {"lr_margin_reverse_lines",
+             region + lrRegion + fmt::format("\033[{};11H", MarginTop),
+             textLines(64, 59, "\r\033M")},
+        };
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    crispy::debugtag::disable(terminal::VTParserTag);
+
+    auto const megabytes = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : size_t{32};
+    auto const pageSize = terminal::PageSize{terminal::LineCount(PageLines), terminal::ColumnCount(PageColumns)};
+
+    cout << fmt::format("Scrolling within lines {}..{} of a {}x{} page.\n\n",
+                        MarginTop, MarginBottom, PageColumns, PageLines);
+
+    for (Test const& test: makeTests())
+    {
+        auto hb = HeadlessBench{pageSize};
+        hb.write(test.setup);
+
+        auto const rounds = megabytes * 1024 * 1024 / test.chunk.size();
+        auto const start = chrono::steady_clock::now();
+        for (size_t i = 0; i < rounds; ++i)
+            hb.write(test.chunk);
+        auto const elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        auto const bytes = static_cast<double>(rounds * test.chunk.size());
+        cout << fmt::format("{:>24}: {:>8.3f} s, {:>8.2f} MB/s\n",
+                            test.name,
+                            elapsed,
+                            bytes / elapsed / (1024.0 * 1024.0));
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Grid.h>
+#include <terminal/Screen.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <fmt/format.h>
+
+using namespace std;
+using namespace terminal;
+
+// Measures writing and reading binary grid snapshots with large scrollback buffers,
+// compared to taking a VT screenshot of the same grid.
+
+namespace
+{
+    auto constexpr PageLines = 50;
+    auto constexpr PageColumns = 120;
+
+    /// Fills the grid's scrollback with @p _count lines of text, with the graphics rendition
+    /// changing a few times per line.
+    void fillHistory(Grid& _grid, int _count)
+    {
+        auto const margin = Margin{Margin::Range{1, PageLines}, Margin::Range{1, PageColumns}};
+        auto attributes = GraphicsAttributes{};
+        for (int i = 0; i < _count; ++i)
+        {
+            _grid.scrollUp(LineCount(1), GraphicsAttributes{}, margin);
+            auto& line = _grid.lineAt(PageLines);
+            line.setText(fmt::format("{:08} {}", i, string(PageColumns - 20, 'X')));
+            for (int column = 0; column < PageColumns; column += 20)
+            {
+                attributes.foregroundColor = static_cast<IndexedColor>((i + column) % 8);
+                for (int k = column; k < column + 20; ++k)
+                    line[static_cast<size_t>(k)].setAttributes(attributes);
+            }
+        }
+    }
+
+    template <typename F>
+    double measure(F&& _f)
+    {
+        auto const start = chrono::steady_clock::now();
+        _f();
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main()
+{
+    cout << fmt::format("Snapshotting a {}x{} page with its scrollback.\n\n", PageColumns, PageLines);
+
+    for (int const historyLines: {1'000, 10'000, 100'000})
+    {
+        auto grid = Grid(PageSize{LineCount(PageLines), ColumnCount(PageColumns)}, true, nullopt);
+        fillHistory(grid, historyLines);
+
+        auto snapshot = stringstream{};
+        auto const writeTime = measure([&]() { grid.writeSnapshot(snapshot); });
+        auto const snapshotSize = snapshot.str().size();
+
+        auto restored = optional<Grid>{};
+        auto const readTime = measure([&]() { restored = Grid::readSnapshot(snapshot); });
+        if (!restored.has_value() || restored->historyLineCount() != grid.historyLineCount())
+        {
+            cerr << "Restoring the snapshot failed.\n";
+            return EXIT_FAILURE;
+        }
+
+        auto screenshotSize = size_t{0};
+        auto const screenshotTime = measure([&]() {
+            Screen::screenshot(grid, [&](char const*, size_t _size) { screenshotSize += _size; }, {});
+        });
+
+        cout << fmt::format("{:>8} lines: write {:>9.3f} ms, read {:>9.3f} ms ({:>6} KiB), "
+                            "VT screenshot {:>9.3f} ms ({:>6} KiB)\n",
+                            historyLines, writeTime, readTime, snapshotSize / 1024,
+                            screenshotTime, screenshotSize / 1024);
+    }
+
+    return EXIT_SUCCESS;
+}
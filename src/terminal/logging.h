@@ -14,6 +14,7 @@
 #pragma once
 
 #include <crispy/debuglog.h>
+#include <crispy/trace.h>
 
 namespace terminal {
 
@@ -29,4 +30,10 @@ auto const inline ScreenRawOutputTag = crispy::debugtag::make("vt.output", "Logs
 auto const inline VTParserTraceTag = crispy::debugtag::make("vt.trace", "Logs terminal parser instruction trace.");
 #endif
 
+// Structured trace events (see crispy/trace.h).
+auto const inline PtyReadTrace      = crispy::trace::make("pty.read", "PTY read; value: number of bytes read.");
+auto const inline VTExecuteTrace    = crispy::trace::make("vt.execute", "C0 control function executed; value: control code.");
+auto const inline VTSequenceTrace   = crispy::trace::make("vt.sequence", "VT sequence applied; value: function id, argument: apply result.");
+auto const inline VTUnknownTrace    = crispy::trace::make("vt.unknown", "Unknown VT sequence; value: category, argument: final character.");
+
 }
@@ -19,8 +19,7 @@
 #include <array>
 #include <cassert>
 #include <functional>
-#include <list>
-#include <map>
+#include <limits>
 #include <optional>
 #include <type_traits>
 #include <vector>
@@ -44,7 +43,7 @@ TextureAtlasAllocator::TextureAtlasAllocator(AtlasBackend& _atlasBackend,
     user_{ _user },
     name_{ std::move(_name) }
 {
-    getOrCreateNewAtlas();
+    createLayer();
 }
 
 TextureAtlasAllocator::~TextureAtlasAllocator()
@@ -55,93 +54,381 @@ TextureAtlasAllocator::~TextureAtlasAllocator()
         atlasBackend_.destroyAtlas(atlasID);
 }
 
+float TextureAtlasAllocator::occupancy() const noexcept
+{
+    auto const totalArea = static_cast<double>(layers_.size()) * unbox<double>(size_.width) * unbox<double>(size_.height);
+    return totalArea != 0.0 ? static_cast<float>(static_cast<double>(stats_.usedArea) / totalArea) : 0.0f;
+}
+
+void TextureAtlasAllocator::nextFrame()
+{
+    ++frame_;
+
+    if (compactionThreshold_ > 0.0f && frame_ % CompactionInterval == 0)
+        compact(compactionThreshold_);
+}
+
+size_t TextureAtlasAllocator::compact(float _maxOccupancy)
+{
+    auto const layerArea = unbox<double>(size_.width) * unbox<double>(size_.height);
+    auto evictionCount = size_t{0};
+
+    for (uint32_t layerIndex = 0; layerIndex < layers_.size(); ++layerIndex)
+    {
+        Layer const& layer = layers_[layerIndex];
+        if (layer.textureCount == 0 || static_cast<double>(layer.usedArea) / layerArea >= _maxOccupancy)
+            continue;
+
+        for (uint32_t slot = 0; slot < slots_.size() && layers_[layerIndex].textureCount != 0; ++slot)
+        {
+            Slot const& s = slots_[slot];
+            if (s.info.has_value() && s.layer == layerIndex && !s.pinned && s.lastUsed < frame_)
+            {
+                evict(slot);
+                ++evictionCount;
+            }
+        }
+    }
+
+    if (evictionCount)
+        debuglog(AtlasTag).write("Compacted atlas {}: evicted {} textures.", name_, evictionCount);
+
+    return evictionCount;
+}
+
 void TextureAtlasAllocator::clear()
 {
-    maxTextureHeightInCurrentRow_ = 0;
-    discarded_.clear();
+    for (uint32_t i = 0; i < slots_.size(); ++i)
+    {
+        Slot& slot = slots_[i];
+        if (slot.info.has_value())
+        {
+            slot.info.reset();
+            ++slot.generation;
+            freeSlots_.push_back(i);
+        }
+        slot.pinned = false;
+        slot.prev = Nil;
+        slot.next = Nil;
+    }
+    lruHead_ = Nil;
+    lruTail_ = Nil;
+
+    // Keep the first layer only, remaining ones are kept alive for later reuse.
+    for (size_t i = 1; i < layers_.size(); ++i)
+        unusedAtlasIDs_.push_back(layers_[i].atlas);
+    layers_.resize(1);
+    atlasIDs_.resize(1);
+    resetLayer(layers_.front());
+
+    stats_.textureCount = 0;
+    stats_.usedArea = 0;
+}
+
+void TextureAtlasAllocator::createLayer()
+{
+    AtlasID atlasID{};
+    if (unusedAtlasIDs_.empty())
+    {
+        atlasID = atlasBackend_.createAtlas(size_, format_, user_);
+    }
+    else
+    {
+        atlasID = unusedAtlasIDs_.back();
+        unusedAtlasIDs_.pop_back();
+    }
+    atlasIDs_.push_back(atlasID);
 
-    unusedAtlasIDs_.insert(
-        unusedAtlasIDs_.end(),
-        atlasIDs_.begin(),
-        prev(atlasIDs_.end()));
-    atlasIDs_.clear();
-    atlasIDs_.push_back(cursor_.atlas);
+    layers_.emplace_back(Layer{atlasID, {}, {}, 0, 0});
+    layers_.back().skyline.push_back(SkylineNode{0, 0, unbox<int>(size_.width)});
+}
 
-    cursor_.position.x = 0;
-    cursor_.position.y = 0;
+void TextureAtlasAllocator::resetLayer(Layer& _layer)
+{
+    _layer.skyline.clear();
+    _layer.skyline.push_back(SkylineNode{0, 0, unbox<int>(size_.width)});
+    _layer.freeRegions.clear();
+    _layer.textureCount = 0;
+    _layer.usedArea = 0;
 }
 
-optional<TextureAtlasAllocator::Cursor> TextureAtlasAllocator::getOffsetAndAdvance(ImageSize _size)
+void TextureAtlasAllocator::addFreeRegion(Layer& _layer, Region _region)
 {
-    if (!(cursor_.position.x + HorizontalGap + *_size.width < *size_.width))
+    // Coalesce with free neighbors sharing a full edge, such that released space
+    // can be reused by larger textures, too.
+    auto& regions = _layer.freeRegions;
+    for (size_t i = 0; i < regions.size(); )
     {
-        cursor_.position.x = 0;
-        cursor_.position.y += static_cast<int>(maxTextureHeightInCurrentRow_) + VerticalGap;
-        if (!(cursor_.position.y + *_size.height < *size_.height))
+        Region const& r = regions[i];
+        bool const horizontal = r.y == _region.y && r.height == _region.height
+                             && (r.x + r.width == _region.x || _region.x + _region.width == r.x);
+        bool const vertical = r.x == _region.x && r.width == _region.width
+                           && (r.y + r.height == _region.y || _region.y + _region.height == r.y);
+        if (horizontal)
+        {
+            _region.x = min(_region.x, r.x);
+            _region.width += r.width;
+        }
+        else if (vertical)
         {
-            cursor_.position.y = 0;
-            maxTextureHeightInCurrentRow_ = 0;
+            _region.y = min(_region.y, r.y);
+            _region.height += r.height;
+        }
+        else
+        {
+            ++i;
+            continue;
+        }
+        regions.erase(regions.begin() + static_cast<long>(i));
+        i = 0;
+    }
+    regions.push_back(_region);
+}
+
+optional<TextureAtlasAllocator::Placement> TextureAtlasAllocator::allocateInLayer(uint32_t _layer, ImageSize _size)
+{
+    // Skyline bottom-left packing: find the position that results into the lowest top edge,
+    // preferring narrower skyline segments on ties.
+    auto& skyline = layers_[_layer].skyline;
+    auto const width = unbox<int>(_size.width) + HorizontalGap;
+    auto const height = unbox<int>(_size.height) + VerticalGap;
+    auto const atlasWidth = unbox<int>(size_.width);
+    auto const atlasHeight = unbox<int>(size_.height);
+
+    auto bestIndex = skyline.size();
+    auto bestTop = numeric_limits<int>::max();
+    auto bestWidth = numeric_limits<int>::max();
+    auto bestY = 0;
+
+    for (size_t i = 0; i < skyline.size(); ++i)
+    {
+        if (skyline[i].x + width > atlasWidth)
+            break;
+
+        auto y = skyline[i].y;
+        auto remainingWidth = width;
+        for (size_t k = i; remainingWidth > 0; ++k)
+        {
+            y = max(y, skyline[k].y);
+            remainingWidth -= skyline[k].width;
+        }
+        if (y + height > atlasHeight)
+            continue;
+
+        if (y + height < bestTop || (y + height == bestTop && skyline[i].width < bestWidth))
+        {
+            bestIndex = i;
+            bestTop = y + height;
+            bestWidth = skyline[i].width;
+            bestY = y;
+        }
+    }
+
+    if (bestIndex == skyline.size())
+        return nullopt;
 
-            if (!(atlasIDs_.size() + 1 < maxInstances_))
+    auto const x = skyline[bestIndex].x;
+    skyline.insert(skyline.begin() + static_cast<long>(bestIndex), SkylineNode{x, bestY + height, width});
+
+    // Shrink (or drop) the segments now being covered by the newly inserted one.
+    for (size_t i = bestIndex + 1; i < skyline.size(); )
+    {
+        auto const right = skyline[i - 1].x + skyline[i - 1].width;
+        if (skyline[i].x >= right)
+            break;
+        auto const shrink = right - skyline[i].x;
+        skyline[i].x += shrink;
+        skyline[i].width -= shrink;
+        if (skyline[i].width > 0)
+            break;
+        skyline.erase(skyline.begin() + static_cast<long>(i));
+    }
+
+    // Merge neighboring segments of equal height.
+    for (size_t i = 0; i + 1 < skyline.size(); )
+    {
+        if (skyline[i].y == skyline[i + 1].y)
+        {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + static_cast<long>(i + 1));
+        }
+        else
+            ++i;
+    }
+
+    return Placement{_layer, Point{x, bestY}};
+}
+
+optional<TextureAtlasAllocator::Placement> TextureAtlasAllocator::allocateFromFreeRegions(ImageSize _size)
+{
+    auto const width = unbox<int>(_size.width);
+    auto const height = unbox<int>(_size.height);
+
+    // Best area fit across all layers.
+    auto bestLayer = Nil;
+    auto bestIndex = size_t{0};
+    auto bestArea = numeric_limits<int64_t>::max();
+    for (uint32_t layer = 0; layer < layers_.size(); ++layer)
+    {
+        auto const& regions = layers_[layer].freeRegions;
+        for (size_t i = 0; i < regions.size(); ++i)
+        {
+            auto const area = int64_t(regions[i].width) * int64_t(regions[i].height);
+            if (regions[i].width >= width && regions[i].height >= height && area < bestArea)
             {
-                cursor_.position.x = *size_.width;
-                cursor_.position.y = *size_.height;
-                return nullopt;
+                bestLayer = layer;
+                bestIndex = i;
+                bestArea = area;
             }
-            getOrCreateNewAtlas();
         }
     }
 
-    auto const result = cursor_;
-    cursor_.position.x += unbox<int>(_size.width) + HorizontalGap;
-    maxTextureHeightInCurrentRow_ = max(maxTextureHeightInCurrentRow_, *_size.height);
-    return result;
+    if (bestLayer == Nil)
+        return nullopt;
+
+    Layer& layer = layers_[bestLayer];
+    auto const region = layer.freeRegions[bestIndex];
+    layer.freeRegions.erase(layer.freeRegions.begin() + static_cast<long>(bestIndex));
+
+    // Guillotine split of the remainder, along the shorter leftover axis.
+    auto const remainingWidth = region.width - width;
+    auto const remainingHeight = region.height - height;
+    auto right = Region{region.x + width, region.y, remainingWidth, region.height};
+    auto bottom = Region{region.x, region.y + height, width, remainingHeight};
+    if (remainingWidth < remainingHeight)
+    {
+        right.height = height;
+        bottom.width = region.width;
+    }
+    if (right.width > 0 && right.height > 0)
+        layer.freeRegions.push_back(right);
+    if (bottom.width > 0 && bottom.height > 0)
+        layer.freeRegions.push_back(bottom);
+
+    return Placement{bestLayer, Point{region.x, region.y}};
+}
+
+optional<TextureAtlasAllocator::Placement> TextureAtlasAllocator::allocate(ImageSize _size)
+{
+    if (auto const placement = allocateFromFreeRegions(_size); placement.has_value())
+        return placement;
+
+    for (uint32_t layer = 0; layer < layers_.size(); ++layer)
+        if (auto const placement = allocateInLayer(layer, _size); placement.has_value())
+            return placement;
+
+    if (layers_.size() + 1 < maxInstances_)
+    {
+        createLayer();
+        return allocateInLayer(static_cast<uint32_t>(layers_.size() - 1), _size);
+    }
+
+    return nullopt;
+}
+
+bool TextureAtlasAllocator::evictionCanSucceed(ImageSize _size) const
+{
+    // Room is guaranteed once an evictable texture that is at least as large as the new one,
+    // or all textures of a single layer, have been evicted.
+    auto evictableCounts = vector<size_t>(layers_.size(), 0);
+    for (auto i = lruTail_; i != Nil && slots_[i].lastUsed < frame_; i = slots_[i].prev)
+    {
+        auto const& bitmapSize = slots_[i].info->bitmapSize;
+        if (bitmapSize.width >= _size.width && bitmapSize.height >= _size.height)
+            return true;
+        ++evictableCounts[slots_[i].layer];
+    }
+
+    for (size_t layer = 0; layer < layers_.size(); ++layer)
+        if (evictableCounts[layer] != 0 && evictableCounts[layer] == layers_[layer].textureCount)
+            return true;
+
+    return false;
+}
+
+optional<TextureAtlasAllocator::Placement> TextureAtlasAllocator::evictUntilFits(ImageSize _size)
+{
+    // Don't throw away textures for nothing.
+    if (!evictionCanSucceed(_size))
+        return nullopt;
+
+    // The LRU list is ordered by last use, so once its tail has been used in the current frame,
+    // there is nothing left that could be evicted safely.
+    while (lruTail_ != Nil && slots_[lruTail_].lastUsed < frame_)
+    {
+        evict(lruTail_);
+        if (auto const placement = allocate(_size); placement.has_value())
+            return placement;
+    }
+    return nullopt;
 }
 
 TextureInfo const* TextureAtlasAllocator::insert(ImageSize _bitmapSize,
                                                  ImageSize _targetSize,
                                                  Format _format,
                                                  Buffer _data,
-                                                 int _user)
+                                                 int _user,
+                                                 bool _pinned)
 {
-    // check free-map first
-    if (auto i = discarded_.find(_bitmapSize); i != end(discarded_))
-    {
-        std::vector<Cursor>& discardsForGivenSize = i->second;
-        if (!discardsForGivenSize.empty())
-        {
-            TextureInfo const& info = appendTextureInfo(_bitmapSize,
-                                                        _targetSize,
-                                                        discardsForGivenSize.back(),
-                                                        _user);
-
-            discardsForGivenSize.pop_back();
-            if (discardsForGivenSize.empty())
-                discarded_.erase(i);
-
-            atlasBackend_.uploadTexture(UploadTexture{
-                std::ref(info),
-                std::move(_data),
-                _format
-            });
-
-            return &info;
-        }
-    }
-
     // fail early if to-be-inserted texture is too large to fit a single page in the whole atlas
     if (_bitmapSize.height > size_.height || _bitmapSize.width > size_.width)
+    {
+        ++stats_.failures;
         return nullptr;
+    }
 
-    auto const targetOffset = getOffsetAndAdvance(_bitmapSize);
-    if (!targetOffset.has_value())
+    auto placement = allocate(_bitmapSize);
+    if (!placement.has_value())
+        placement = evictUntilFits(_bitmapSize);
+    if (!placement.has_value())
+    {
+        ++stats_.failures;
         return nullptr;
+    }
+
+    uint32_t slotIndex = 0;
+    if (!freeSlots_.empty())
+    {
+        slotIndex = freeSlots_.back();
+        freeSlots_.pop_back();
+    }
+    else
+    {
+        slotIndex = static_cast<uint32_t>(slots_.size());
+        slots_.emplace_back();
+    }
 
-    TextureInfo const& info = appendTextureInfo(_bitmapSize,
-                                                _targetSize,
-                                                *targetOffset,
-                                                _user);
+    Layer& layer = layers_[placement->layer];
+    auto const position = placement->position;
+    auto const area = uint64_t(unbox<int>(_bitmapSize.width)) * uint64_t(unbox<int>(_bitmapSize.height));
 
+    Slot& slot = slots_[slotIndex];
+    slot.info.emplace(TextureInfo{
+        layer.atlas,
+        name_,
+        position,
+        _bitmapSize,
+        _targetSize,
+        static_cast<float>(position.x) / unbox<float>(size_.width),
+        static_cast<float>(position.y) / unbox<float>(size_.height),
+        unbox<float>(_bitmapSize.width) / unbox<float>(size_.width),
+        unbox<float>(_bitmapSize.height) / unbox<float>(size_.height),
+        _user
+    });
+    slot.info->slot = slotIndex;
+    slot.layer = placement->layer;
+    slot.lastUsed = frame_;
+    slot.pinned = _pinned;
+    if (!_pinned)
+        linkFront(slotIndex);
+
+    ++layer.textureCount;
+    layer.usedArea += area;
+    ++stats_.textureCount;
+    stats_.usedArea += area;
+    ++stats_.insertions;
+
+    TextureInfo const& info = *slot.info;
     atlasBackend_.uploadTexture(UploadTexture{
         std::ref(info),
         std::move(_data),
@@ -152,41 +439,94 @@ TextureInfo const* TextureAtlasAllocator::insert(ImageSize _bitmapSize,
     return &info;
 }
 
+TextureInfo const* TextureAtlasAllocator::use(TextureHandle _handle) noexcept
+{
+    TextureInfo const* info = get(_handle);
+    if (!info)
+        return nullptr;
+
+    Slot& slot = slots_[_handle.slot];
+    slot.lastUsed = frame_;
+    if (!slot.pinned && lruHead_ != _handle.slot)
+    {
+        unlink(_handle.slot);
+        linkFront(_handle.slot);
+    }
+    ++stats_.hits;
+    return info;
+}
+
 void TextureAtlasAllocator::release(TextureInfo const& _info)
 {
-    auto i = std::find_if(begin(textureInfos_),
-                          end(textureInfos_),
-                          [&](TextureInfo const& ti) -> bool {
-                              return &ti == &_info;
-                          });
+    if (_info.slot < slots_.size() && slots_[_info.slot].info.has_value() && &*slots_[_info.slot].info == &_info)
+        releaseSlot(_info.slot);
+}
+
+void TextureAtlasAllocator::evict(uint32_t _slot)
+{
+    ++stats_.evictions;
+    releaseSlot(_slot);
+}
+
+void TextureAtlasAllocator::releaseSlot(uint32_t _slotIndex)
+{
+    Slot& slot = slots_[_slotIndex];
+    TextureInfo const& info = *slot.info;
+    Layer& layer = layers_[slot.layer];
+    auto const area = uint64_t(unbox<int>(info.bitmapSize.width)) * uint64_t(unbox<int>(info.bitmapSize.height));
+
+    if (!slot.pinned)
+        unlink(_slotIndex);
 
-    if (i != end(textureInfos_))
+    --layer.textureCount;
+    layer.usedArea -= area;
+    --stats_.textureCount;
+    stats_.usedArea -= area;
+
+    if (layer.textureCount == 0)
     {
-        std::vector<Cursor>& discardsForGivenSize = discarded_[_info.bitmapSize];
-        discardsForGivenSize.emplace_back(Cursor{_info.atlas, _info.offset});
-        textureInfos_.erase(i);
+        resetLayer(layer);
+        ++stats_.layerResets;
     }
+    else
+        addFreeRegion(layer, Region{info.offset.x,
+                                    info.offset.y,
+                                    unbox<int>(info.bitmapSize.width),
+                                    unbox<int>(info.bitmapSize.height)});
+
+    slot.info.reset();
+    slot.pinned = false;
+    ++slot.generation;
+    freeSlots_.push_back(_slotIndex);
 }
 
-TextureInfo const& TextureAtlasAllocator::appendTextureInfo(ImageSize _bitmapSize,
-                                                            ImageSize _targetSize,
-                                                            Cursor _offset,
-                                                            int _user)
+void TextureAtlasAllocator::linkFront(uint32_t _slot) noexcept
 {
-    textureInfos_.emplace_back(TextureInfo{
-        _offset.atlas,
-        name_,
-        _offset.position,
-        _bitmapSize,
-        _targetSize,
-        static_cast<float>(_offset.position.x) / unbox<float>(size_.width),
-        static_cast<float>(_offset.position.y) / unbox<float>(size_.height),
-        unbox<float>(_bitmapSize.width) / unbox<float>(size_.width),
-        unbox<float>(_bitmapSize.height) / unbox<float>(size_.height),
-        _user
-    });
+    Slot& slot = slots_[_slot];
+    slot.prev = Nil;
+    slot.next = lruHead_;
+    if (lruHead_ != Nil)
+        slots_[lruHead_].prev = _slot;
+    lruHead_ = _slot;
+    if (lruTail_ == Nil)
+        lruTail_ = _slot;
+}
+
+void TextureAtlasAllocator::unlink(uint32_t _slot) noexcept
+{
+    Slot& slot = slots_[_slot];
+    if (slot.prev != Nil)
+        slots_[slot.prev].next = slot.next;
+    else
+        lruHead_ = slot.next;
+
+    if (slot.next != Nil)
+        slots_[slot.next].prev = slot.prev;
+    else
+        lruTail_ = slot.prev;
 
-    return textureInfos_.back();
+    slot.prev = Nil;
+    slot.next = Nil;
 }
 
 } // end namespace
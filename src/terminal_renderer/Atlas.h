@@ -22,8 +22,10 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdint>
+#include <deque>
 #include <functional>
-#include <list>
+#include <limits>
 #include <map>
 #include <optional>
 #include <type_traits>
@@ -110,6 +112,16 @@ struct TextureInfo {
     float relativeWidth;            // width relative to Atlas::width_
     float relativeHeight;           // height relative to Atlas::height_
     int user;                       // some user defined value, in my case, whether or not this texture is colored or monochrome
+    uint32_t slot = 0;              // index into the owning TextureAtlasAllocator's texture table
+};
+
+/// Weak reference to a texture allocated by a TextureAtlasAllocator.
+///
+/// Unlike a plain TextureInfo pointer, a handle can be tested for validity,
+/// as the texture it refers to may have been evicted in the meantime.
+struct TextureHandle {
+    uint32_t slot;
+    uint32_t generation;
 };
 
 struct UploadTexture {
@@ -154,14 +166,25 @@ class AtlasBackend {
  * This Texture atlas stores textures with given dimension in a 3 dimensional array of atlases.
  * Thus, you may say a 4D atlas ;-)
  *
- * @param Key a comparable key (such as @c char or @c uint32_t) to use to store and access textures.
- * @param Metadata some optionally accessible metadata that is attached with each texture.
+ * Each atlas layer is packed using a skyline (bottom-left) strategy. Released regions are
+ * coalesced with their free neighbors and reused for any texture that fits into them.
+ *
+ * Once all layers are exhausted, textures that have not been used in the current frame
+ * are evicted in least-recently-used order (except pinned ones) to make room for new ones,
+ * unless no amount of evictions is guaranteed to make room, in which case nothing is evicted.
+ * A layer that runs empty is reset as a whole, and layers that have become sparsely populated
+ * can be reclaimed via compact().
  */
 class TextureAtlasAllocator {
   public:
-    struct Cursor {
-        AtlasID atlas;
-        crispy::Point position;
+    struct Statistics {
+        size_t textureCount = 0;    // number of currently allocated textures
+        uint64_t usedArea = 0;      // number of pixels covered by currently allocated textures
+        uint64_t insertions = 0;    // total number of inserted textures
+        uint64_t hits = 0;          // total number of successful texture lookups via use()
+        uint64_t evictions = 0;     // total number of textures evicted to make room for new ones
+        uint64_t layerResets = 0;   // total number of layers that ran empty and got reset
+        uint64_t failures = 0;      // total number of insertions that could not be satisfied
     };
 
     /**
@@ -196,27 +219,42 @@ class TextureAtlasAllocator {
     std::vector<AtlasID> const& activeAtlasTextures() const noexcept { return atlasIDs_; }
 
     /// @return number of internally used 3D texture atlases.
-    constexpr AtlasID currentInstance() const noexcept { return cursor_.atlas; }
+    size_t layerCount() const noexcept { return layers_.size(); }
 
-    /// @return current X offset into the current 3D texture atlas.
-    constexpr int currentX() const noexcept { return cursor_.position.x; }
+    Statistics const& statistics() const noexcept { return stats_; }
 
-    /// @return current Y offset into the current 3D texture atlas.
-    constexpr int currentY() const noexcept { return cursor_.position.y; }
+    /// @return ratio of used pixels to the total pixels of all layers currently in use.
+    float occupancy() const noexcept;
 
-    constexpr unsigned maxTextureHeightInCurrentRow() const noexcept { return maxTextureHeightInCurrentRow_; }
+    /// @return the current frame number, as advanced by nextFrame().
+    constexpr uint64_t currentFrame() const noexcept { return frame_; }
 
-    void clear();
+    /// Marks the beginning of a new frame.
+    ///
+    /// Textures that are inserted or used in the current frame are never evicted,
+    /// such that all TextureInfo references handed out for the current frame stay valid.
+    void nextFrame();
 
-    TextureInfo const& get(size_t _index) const
-    {
-        return *std::next(std::begin(textureInfos_), static_cast<long>(_index));
-    }
+    /// Enables periodic compaction when advancing frames (see compact()).
+    ///
+    /// @param _maxOccupancy layers below this occupancy ratio are reclaimed, or 0 to disable.
+    void setCompactionThreshold(float _maxOccupancy) noexcept { compactionThreshold_ = _maxOccupancy; }
+
+    /// Reclaims sparsely populated layers by evicting their remaining (evictable) textures,
+    /// making the full layer available for packing again.
+    ///
+    /// @returns number of evicted textures.
+    size_t compact(float _maxOccupancy);
+
+    void clear();
 
     // Configure some enforced horizontal/vertical gap between the subtextures.
     auto inline static constexpr HorizontalGap = 0;
     auto inline static constexpr VerticalGap = 0;
 
+    // Number of frames between two automatic compaction passes (if enabled).
+    auto inline static constexpr CompactionInterval = 256;
+
     /// Inserts a new texture into the atlas.
     ///
     /// @param _id       a unique identifier used for accessing this texture
@@ -225,43 +263,92 @@ class TextureAtlasAllocator {
     /// @param _format   data format
     /// @param _data     raw texture data to be inserted
     /// @param _user     user defined data that is supplied along with TexCoord's 4th component
+    /// @param _pinned   whether or not this texture must never be evicted
     ///
     /// @return index to the created TextureInfo or std::nullopt if failed.
     TextureInfo const* insert(ImageSize _bitmapSize,
                               ImageSize _targetSize,
                               Format _format,
                               Buffer _data,
-                              int _user = 0);
+                              int _user = 0,
+                              bool _pinned = false);
+
+    /// @return a handle that can be used to later on access the given texture.
+    TextureHandle handleOf(TextureInfo const& _info) const noexcept
+    {
+        return TextureHandle{_info.slot, slots_[_info.slot].generation};
+    }
+
+    /// @return the texture referred to by the given handle or nullptr if it has been evicted or released.
+    TextureInfo const* get(TextureHandle _handle) const noexcept
+    {
+        if (_handle.slot >= slots_.size())
+            return nullptr;
+        Slot const& slot = slots_[_handle.slot];
+        if (slot.generation != _handle.generation || !slot.info.has_value())
+            return nullptr;
+        return &*slot.info;
+    }
+
+    /// Same as get() but also marks the texture as being used in the current frame.
+    TextureInfo const* use(TextureHandle _handle) noexcept;
 
     /// Releases a given texture area the atlas for future reallocations.
     void release(TextureInfo const& _info);
 
-    constexpr Cursor cursor() const noexcept { return cursor_; }
-
   private:
-    std::optional<Cursor> getOffsetAndAdvance(ImageSize _bitmapSize);
+    static constexpr uint32_t Nil = std::numeric_limits<uint32_t>::max();
 
-    void getOrCreateNewAtlas()
-    {
-        if (unusedAtlasIDs_.empty())
-        {
-            cursor_.atlas = atlasBackend_.createAtlas(size_, format_, user_);
-        }
-        else
-        {
-            cursor_.atlas = unusedAtlasIDs_.back();
-            unusedAtlasIDs_.pop_back();
-        }
-        atlasIDs_.push_back(cursor_.atlas);
-        cursor_.position.x = 0;
-        cursor_.position.y = 0;
-    }
+    struct SkylineNode {
+        int x;
+        int y;
+        int width;
+    };
+
+    struct Region {
+        int x;
+        int y;
+        int width;
+        int height;
+    };
+
+    struct Layer {
+        AtlasID atlas;
+        std::vector<SkylineNode> skyline;
+        std::vector<Region> freeRegions; // released regions below the skyline, available for reuse
+        size_t textureCount = 0;
+        uint64_t usedArea = 0;
+    };
+
+    struct Placement {
+        uint32_t layer;
+        crispy::Point position;
+    };
+
+    struct Slot {
+        std::optional<TextureInfo> info;
+        uint32_t generation = 0;
+        uint32_t layer = 0;
+        uint64_t lastUsed = 0;
+        bool pinned = false;
+        uint32_t prev = Nil;    // LRU list link towards more recently used textures
+        uint32_t next = Nil;    // LRU list link towards less recently used textures
+    };
+
+    std::optional<Placement> allocate(ImageSize _bitmapSize);
+    std::optional<Placement> allocateInLayer(uint32_t _layer, ImageSize _bitmapSize);
+    std::optional<Placement> allocateFromFreeRegions(ImageSize _bitmapSize);
+    bool evictionCanSucceed(ImageSize _bitmapSize) const;
+    std::optional<Placement> evictUntilFits(ImageSize _bitmapSize);
 
-    TextureInfo const& appendTextureInfo(ImageSize _bitmapSize,
-                                         ImageSize _targetSize,
-                                         Cursor _offset,
-                                         int _user);
+    void createLayer();
+    void resetLayer(Layer& _layer);
+    void addFreeRegion(Layer& _layer, Region _region);
+    void evict(uint32_t _slot);
+    void releaseSlot(uint32_t _slot);
 
+    void linkFront(uint32_t _slot) noexcept;
+    void unlink(uint32_t _slot) noexcept;
 
     // private data fields
     //
@@ -273,22 +360,28 @@ class TextureAtlasAllocator {
     int const user_;               // user-defined arbitrary data that relates to this atlas.
     std::string const name_;       // atlas human readable name (only for debugging)
 
-    Cursor cursor_;                // current texture ID and cursor for the next sub texture
-    unsigned maxTextureHeightInCurrentRow_ = 0; // current maximum height in the current row (used to increment currentY_ to get to the next row)
-
-    // TODO: make this an unordered_map
-    std::map<ImageSize, std::vector<Cursor>> discarded_; // map of texture size to list of atlas texture offsets of regions that have been discarded and are available for reuse.
+    std::vector<Layer> layers_;
     std::vector<AtlasID> atlasIDs_;
     std::vector<AtlasID> unusedAtlasIDs_;
 
-    std::list<TextureInfo> textureInfos_;
+    // Texture table. A deque keeps TextureInfo addresses stable while growing.
+    std::deque<Slot> slots_;
+    std::vector<uint32_t> freeSlots_;
+    uint32_t lruHead_ = Nil;       // most recently used (evictable) texture
+    uint32_t lruTail_ = Nil;       // least recently used (evictable) texture
+
+    uint64_t frame_ = 1;
+    float compactionThreshold_ = 0.0f;
+    Statistics stats_;
 };
 
 template <typename Key, typename Metadata = int>
 class MetadataTextureAtlas {
   public:
-    explicit MetadataTextureAtlas(TextureAtlasAllocator& _allocator) :
-        atlas_{ _allocator }
+    /// @param _pinned whether or not textures inserted via this atlas must never be evicted.
+    explicit MetadataTextureAtlas(TextureAtlasAllocator& _allocator, bool _pinned = false) :
+        atlas_{ _allocator },
+        pinned_{ _pinned }
     {
     }
 
@@ -318,10 +411,22 @@ class MetadataTextureAtlas {
         metadata_.clear();
     }
 
+    /// Releases all textures of this atlas from the TextureAtlasAllocator (including pinned ones),
+    /// while textures of other atlases sharing the same allocator are kept.
+    void releaseAll()
+    {
+        for (auto const& [id, handle]: allocations_)
+            if (TextureInfo const* textureInfo = atlas_.get(handle); textureInfo)
+                atlas_.release(*textureInfo);
+
+        clear();
+    }
+
     /// Tests whether given sub-texture is being present in this texture atlas.
-    constexpr bool contains(Key const& _id) const
+    bool contains(Key const& _id) const
     {
-        return allocations_.find(_id) != allocations_.end();
+        auto const i = allocations_.find(_id);
+        return i != allocations_.end() && atlas_.get(i->second) != nullptr;
     }
 
     using DataRef = std::tuple<
@@ -346,31 +451,39 @@ class MetadataTextureAtlas {
                                   int _user = 0,
                                   Metadata _metadata = {})
     {
-        assert(allocations_.find(_id) == allocations_.end());
+        if (auto const i = allocations_.find(_id); i != allocations_.end())
+        {
+            // Only textures that have been evicted by the allocator may be re-inserted.
+            assert(atlas_.get(i->second) == nullptr);
+            allocations_.erase(i);
+            metadata_.erase(_id);
+        }
 
         TextureInfo const* textureInfo = atlas_.insert(_bitmapSize,
                                                        _targetSize,
                                                        atlas_.format(),
                                                        std::move(_data),
-                                                       _user);
+                                                       _user,
+                                                       pinned_);
         if (!textureInfo)
             return std::nullopt;
 
-        allocations_.emplace(_id, textureInfo);
+        allocations_.emplace(_id, atlas_.handleOf(*textureInfo));
 
-        if constexpr (!std::is_same_v<Metadata, void>)
-            metadata_.emplace(std::pair{_id, std::move(_metadata)});
-
-        return get(_id);
+        auto const m = metadata_.emplace(std::pair{_id, std::move(_metadata)}).first;
+        return DataRef{*textureInfo, m->second};
     }
 
     /// Retrieves TextureInfo and Metadata tuple if available, std::nullopt otherwise.
     [[nodiscard]] std::optional<DataRef> get(Key const& _id) const
     {
+        // The allocator may have evicted the texture in the meantime, in which case
+        // the stale entry is left behind and overwritten upon the next insert().
         if (auto const i = allocations_.find(_id); i != allocations_.end())
-            return DataRef{*i->second, metadata_.at(_id)};
-        else
-            return std::nullopt;
+            if (TextureInfo const* textureInfo = atlas_.use(i->second); textureInfo)
+                return DataRef{*textureInfo, metadata_.at(_id)};
+
+        return std::nullopt;
     }
 
     void release(Key const& _id)
@@ -380,8 +493,8 @@ class MetadataTextureAtlas {
 
         if (auto const i = allocations_.find(_id); i != allocations_.end())
         {
-            TextureInfo const& ti = *i->second;
-            atlas_.release(ti);
+            if (TextureInfo const* ti = atlas_.get(i->second); ti)
+                atlas_.release(*ti);
 
             allocations_.erase(i);
         }
@@ -389,8 +502,9 @@ class MetadataTextureAtlas {
 
   private:
     TextureAtlasAllocator& atlas_;
+    bool pinned_;
 
-    std::unordered_map<Key, TextureInfo const*> allocations_ = {};
+    std::unordered_map<Key, TextureHandle> allocations_ = {};
 
     // conditionally transform void to int as I can't conditionally enable/disable this member var.
     std::unordered_map<
@@ -514,12 +628,15 @@ namespace fmt { // {{{
         template <typename FormatContext>
         auto format(terminal::renderer::atlas::TextureAtlasAllocator const& _atlas, FormatContext& ctx)
         {
-            return format_to(ctx.out(), "TextureAtlasAllocator<cursor: {}/{} ({}x{}), rowHeight:{}>",
-                _atlas.cursor().atlas,
-                _atlas.cursor().position,
+            auto const& stats = _atlas.statistics();
+            return format_to(ctx.out(), "TextureAtlasAllocator<{} ({}x{}/{}), textures:{}, occupancy:{:.1f}%, evictions:{}>",
+                _atlas.name(),
                 _atlas.size(),
+                _atlas.layerCount(),
                 _atlas.maxInstances(),
-                _atlas.maxTextureHeightInCurrentRow()
+                stats.textureCount,
+                _atlas.occupancy() * 100.0f,
+                stats.evictions
             );
         }
     };
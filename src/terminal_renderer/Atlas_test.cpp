@@ -0,0 +1,315 @@
+/**
+ * This file is part of the "contour" project.
+ *   Copyright (c) 2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal_renderer/Atlas.h>
+#include <catch2/catch_all.hpp>
+
+#include <random>
+#include <vector>
+
+using namespace terminal;
+using namespace terminal::renderer::atlas;
+
+namespace
+{
+    class MockBackend: public AtlasBackend {
+      public:
+        AtlasID createAtlas(ImageSize, Format, int) override { return AtlasID{createCount++}; }
+        void uploadTexture(UploadTexture) override { ++uploadCount; }
+        void renderTexture(RenderTexture) override {}
+        void destroyAtlas(AtlasID) override {}
+
+        int createCount = 0;
+        int uploadCount = 0;
+    };
+
+    auto constexpr AtlasSize = ImageSize{Width(256), Height(256)};
+    auto constexpr GlyphSize = ImageSize{Width(16), Height(16)};
+
+    bool overlaps(TextureInfo const& a, TextureInfo const& b)
+    {
+        return a.atlas == b.atlas
+            && a.offset.x < b.offset.x + *b.bitmapSize.width && b.offset.x < a.offset.x + *a.bitmapSize.width
+            && a.offset.y < b.offset.y + *b.bitmapSize.height && b.offset.y < a.offset.y + *a.bitmapSize.height;
+    }
+}
+
+TEST_CASE("Atlas.skyline_packing", "[Atlas]")
+{
+    auto backend = MockBackend{};
+    auto allocator = TextureAtlasAllocator{backend, AtlasSize, 3, Format::Red, 0, "test"};
+
+    // Fill the atlas with textures of mixed sizes within a single frame, so nothing gets evicted.
+    auto rng = std::mt19937{1};
+    auto dimension = std::uniform_int_distribution<int>{4, 40};
+    auto textures = std::vector<TextureInfo const*>{};
+    while (true)
+    {
+        auto const size = ImageSize{Width(dimension(rng)), Height(dimension(rng))};
+        auto const* info = allocator.insert(size, size, Format::Red, Buffer{});
+        if (!info)
+            break;
+        textures.push_back(info);
+    }
+
+    CHECK(allocator.statistics().evictions == 0);
+    CHECK(allocator.statistics().failures == 1);
+    CHECK(allocator.layerCount() == 2);
+    CHECK(allocator.occupancy() > 0.6f);
+
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        TextureInfo const& a = *textures[i];
+        REQUIRE(a.offset.x + *a.bitmapSize.width <= *AtlasSize.width);
+        REQUIRE(a.offset.y + *a.bitmapSize.height <= *AtlasSize.height);
+        for (size_t k = i + 1; k < textures.size(); ++k)
+            REQUIRE_FALSE(overlaps(a, *textures[k]));
+    }
+}
+
+TEST_CASE("Atlas.release", "[Atlas]")
+{
+    auto backend = MockBackend{};
+    auto allocator = TextureAtlasAllocator{backend, AtlasSize, 3, Format::Red, 0, "test"};
+
+    auto const* a = allocator.insert(GlyphSize, GlyphSize, Format::Red, Buffer{});
+    auto const* b = allocator.insert(GlyphSize, GlyphSize, Format::Red, Buffer{});
+    REQUIRE(a != nullptr);
+    REQUIRE(b != nullptr);
+    auto const handleA = allocator.handleOf(*a);
+    auto const offsetA = a->offset;
+
+    allocator.release(*a);
+    CHECK(allocator.get(handleA) == nullptr);
+    CHECK(allocator.statistics().textureCount == 1);
+
+    // The released region is reused for a texture of the same size.
+    auto const* c = allocator.insert(GlyphSize, GlyphSize, Format::Red, Buffer{});
+    REQUIRE(c != nullptr);
+    CHECK(c->offset == offsetA);
+    CHECK(allocator.get(handleA) == nullptr);
+
+    // A layer that runs empty is reset as a whole.
+    allocator.release(*b);
+    allocator.release(*c);
+    CHECK(allocator.statistics().textureCount == 0);
+    CHECK(allocator.statistics().usedArea == 0);
+    CHECK(allocator.statistics().layerResets == 1);
+}
+
+TEST_CASE("Atlas.eviction", "[Atlas]")
+{
+    auto backend = MockBackend{};
+    auto allocator = TextureAtlasAllocator{backend, AtlasSize, 2, Format::Red, 0, "test"};
+    auto constexpr Capacity = 256; // (256 / 16) ^ 2 glyphs on a single layer
+
+    auto pinned = MetadataTextureAtlas<int, int>{allocator, true};
+    auto atlas = MetadataTextureAtlas<int, int>{allocator};
+
+    REQUIRE(pinned.insert(-1, GlyphSize, GlyphSize, Buffer{}).has_value());
+    for (int i = 1; i < Capacity; ++i)
+        REQUIRE(atlas.insert(i, GlyphSize, GlyphSize, Buffer{}).has_value());
+
+    // Everything has been used in the current frame, so nothing may be evicted.
+    CHECK_FALSE(atlas.insert(Capacity, GlyphSize, GlyphSize, Buffer{}).has_value());
+    CHECK(allocator.statistics().failures == 1);
+
+    // Next frame, with glyph 1 being used again, glyph 2 is the least recently used one.
+    allocator.nextFrame();
+    CHECK(atlas.get(1).has_value());
+    REQUIRE(atlas.insert(Capacity, GlyphSize, GlyphSize, Buffer{}).has_value());
+    CHECK(allocator.statistics().evictions == 1);
+    CHECK(atlas.contains(1));
+    CHECK_FALSE(atlas.contains(2));
+    CHECK_FALSE(atlas.get(2).has_value());
+
+    // Evicted textures can be inserted again, evicting the next least recently used one.
+    allocator.nextFrame();
+    REQUIRE(atlas.insert(2, GlyphSize, GlyphSize, Buffer{}, 0, 42).has_value());
+    CHECK(std::get<1>(*atlas.get(2)).get() == 42);
+    CHECK_FALSE(atlas.contains(3));
+
+    // Pinned textures are never evicted.
+    for (int i = 0; i < Capacity * 4; ++i)
+    {
+        allocator.nextFrame();
+        REQUIRE(atlas.insert(1000 + i, GlyphSize, GlyphSize, Buffer{}).has_value());
+    }
+    CHECK(pinned.contains(-1));
+    CHECK(allocator.statistics().textureCount == Capacity);
+}
+
+TEST_CASE("Atlas.eviction_of_other_sizes", "[Atlas]")
+{
+    auto backend = MockBackend{};
+    auto allocator = TextureAtlasAllocator{backend, AtlasSize, 2, Format::Red, 0, "test"};
+    auto atlas = MetadataTextureAtlas<int, int>{allocator};
+    auto constexpr Capacity = 256; // (256 / 16) ^ 2 glyphs on a single layer
+    auto constexpr LargeSize = ImageSize{Width(31), Height(29)};
+
+    for (int i = 0; i < Capacity; ++i)
+        REQUIRE(atlas.insert(i, GlyphSize, GlyphSize, Buffer{}).has_value());
+
+    // The space released by evicting smaller textures is coalesced until the larger one fits,
+    // which are the first two rows of the least recently used glyphs.
+    allocator.nextFrame();
+    auto const large = atlas.insert(-1, LargeSize, LargeSize, Buffer{});
+    REQUIRE(large.has_value());
+    CHECK(allocator.statistics().evictions == 32);
+    CHECK(allocator.statistics().failures == 0);
+    CHECK_FALSE(atlas.contains(31));
+    CHECK(atlas.contains(32));
+
+    auto const& largeInfo = std::get<0>(*large).get();
+    for (int i = 32; i < Capacity; ++i)
+        REQUIRE_FALSE(overlaps(largeInfo, std::get<0>(*atlas.get(i)).get()));
+
+    // The remainder of the released space is reused by textures of yet another size.
+    auto constexpr SmallSize = ImageSize{Width(20), Height(2)};
+    for (int i = 0; i < 10; ++i)
+        REQUIRE(atlas.insert(1000 + i, SmallSize, SmallSize, Buffer{}).has_value());
+    CHECK(allocator.statistics().evictions == 32);
+}
+
+TEST_CASE("Atlas.eviction_without_room", "[Atlas]")
+{
+    auto backend = MockBackend{};
+    auto allocator = TextureAtlasAllocator{backend, AtlasSize, 2, Format::Red, 0, "test"};
+    auto pinned = MetadataTextureAtlas<int, int>{allocator, true};
+    auto atlas = MetadataTextureAtlas<int, int>{allocator};
+    auto constexpr Capacity = 256; // (256 / 16) ^ 2 glyphs on a single layer
+    auto constexpr LargeSize = ImageSize{Width(31), Height(29)};
+
+    REQUIRE(pinned.insert(0, GlyphSize, GlyphSize, Buffer{}).has_value());
+    for (int i = 1; i < Capacity; ++i)
+        REQUIRE(atlas.insert(i, GlyphSize, GlyphSize, Buffer{}).has_value());
+
+    // With a pinned glyph on the only layer and no texture that is large enough,
+    // evicting is not guaranteed to make room, so nothing is evicted at all.
+    allocator.nextFrame();
+    CHECK_FALSE(atlas.insert(-1, LargeSize, LargeSize, Buffer{}).has_value());
+    CHECK(allocator.statistics().evictions == 0);
+    CHECK(allocator.statistics().failures == 1);
+    CHECK(allocator.statistics().textureCount == Capacity);
+
+    // Once a large enough texture is present, eviction succeeds.
+    atlas.release(Capacity - 1);
+    atlas.release(Capacity - 2);
+    atlas.release(Capacity - 17);
+    atlas.release(Capacity - 18);
+    auto constexpr MediumSize = ImageSize{Width(32), Height(32)};
+    REQUIRE(atlas.insert(Capacity, MediumSize, MediumSize, Buffer{}).has_value());
+    allocator.nextFrame();
+    REQUIRE(atlas.insert(-1, LargeSize, LargeSize, Buffer{}).has_value());
+    CHECK(allocator.statistics().failures == 1);
+    CHECK(pinned.contains(0));
+}
+
+TEST_CASE("Atlas.releaseAll", "[Atlas]")
+{
+    auto backend = MockBackend{};
+    auto allocator = TextureAtlasAllocator{backend, AtlasSize, 2, Format::Red, 0, "test"};
+
+    auto pinned = MetadataTextureAtlas<int, int>{allocator, true};
+    auto atlas = MetadataTextureAtlas<int, int>{allocator};
+
+    REQUIRE(pinned.insert(1, GlyphSize, GlyphSize, Buffer{}).has_value());
+    REQUIRE(pinned.insert(2, GlyphSize, GlyphSize, Buffer{}).has_value());
+    REQUIRE(atlas.insert(1, GlyphSize, GlyphSize, Buffer{}).has_value());
+
+    // Only the textures of the given atlas are released, even if pinned.
+    pinned.releaseAll();
+    CHECK(pinned.empty());
+    CHECK_FALSE(pinned.get(1).has_value());
+    CHECK(atlas.contains(1));
+    CHECK(allocator.statistics().textureCount == 1);
+    CHECK(allocator.statistics().evictions == 0);
+
+    REQUIRE(pinned.insert(1, GlyphSize, GlyphSize, Buffer{}).has_value());
+    CHECK(allocator.statistics().textureCount == 2);
+}
+
+TEST_CASE("Atlas.compact", "[Atlas]")
+{
+    auto backend = MockBackend{};
+    auto allocator = TextureAtlasAllocator{backend, AtlasSize, 3, Format::Red, 0, "test"};
+    auto atlas = MetadataTextureAtlas<int, int>{allocator};
+
+    // Spill over into the second layer, then drop most of the second layer's textures again.
+    for (int i = 0; i < 300; ++i)
+        REQUIRE(atlas.insert(i, GlyphSize, GlyphSize, Buffer{}).has_value());
+    REQUIRE(allocator.layerCount() == 2);
+    for (int i = 256; i < 290; ++i)
+        atlas.release(i);
+
+    // Nothing is being compacted while being in use in the current frame.
+    CHECK(allocator.compact(0.25f) == 0);
+
+    allocator.nextFrame();
+    CHECK(allocator.compact(0.25f) == 10);
+    CHECK(allocator.statistics().textureCount == 256);
+    CHECK(allocator.statistics().layerResets == 1);
+    CHECK(atlas.contains(0));
+    CHECK_FALSE(atlas.contains(299));
+}
+
+TEST_CASE("Atlas.cjk_stress", "[Atlas]")
+{
+    // Cycles through tens of thousands of distinct CJK glyphs with a bounded atlas,
+    // rendering a screenful of mostly recurring and some new glyphs each frame.
+    auto backend = MockBackend{};
+    auto allocator = TextureAtlasAllocator{backend, AtlasSize, 4, Format::Red, 0, "test"};
+    auto atlas = MetadataTextureAtlas<char32_t, int>{allocator};
+    allocator.setCompactionThreshold(0.25f);
+
+    auto constexpr GlyphCount = 40'000u;
+    auto constexpr GlyphsPerFrame = 200u;
+    auto constexpr WorkingSet = 50u;
+    auto constexpr FirstCodepoint = char32_t{0x4E00}; // CJK Unified Ideographs
+
+    auto rng = std::mt19937{42};
+    auto glyphSize = std::uniform_int_distribution<int>{14, 18};
+    auto next = char32_t{0};
+    auto misses = size_t{0};
+
+    while (next < GlyphCount)
+    {
+        allocator.nextFrame();
+        for (auto i = 0u; i < GlyphsPerFrame; ++i)
+        {
+            auto const codepoint = FirstCodepoint + (i < WorkingSet ? i : WorkingSet + next++);
+            if (atlas.get(codepoint).has_value())
+                continue;
+
+            ++misses;
+            auto const size = ImageSize{Width(glyphSize(rng)), Height(glyphSize(rng))};
+            REQUIRE(atlas.insert(codepoint, size, size, Buffer{}).has_value());
+        }
+
+        REQUIRE(allocator.layerCount() <= 3);
+    }
+
+    auto const& stats = allocator.statistics();
+    CHECK(stats.failures == 0);
+    CHECK(misses == next + WorkingSet);
+    CHECK(stats.insertions == misses);
+    CHECK(stats.evictions > GlyphCount / 2);
+    CHECK(stats.hits >= (GlyphCount / (GlyphsPerFrame - WorkingSet) - 1) * WorkingSet);
+    CHECK(allocator.occupancy() <= 1.0f);
+    CHECK(backend.createCount == 3);
+    CHECK(backend.uploadCount == static_cast<int>(misses));
+
+    // The working set survived all the eviction.
+    for (auto i = 0u; i < WorkingSet; ++i)
+        CHECK(atlas.contains(FirstCodepoint + i));
+}
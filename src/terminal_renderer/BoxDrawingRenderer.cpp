@@ -448,6 +448,12 @@ void BoxDrawingRenderer::clearCache()
     textureAtlas_ = std::make_unique<TextureAtlas>(renderTarget().monochromeAtlasAllocator());
 }
 
+void BoxDrawingRenderer::fontSizeChanged()
+{
+    if (textureAtlas_)
+        textureAtlas_->releaseAll();
+}
+
 bool BoxDrawingRenderer::render(LinePosition _line,
                                 ColumnPosition _column,
                                 uint8_t _id,
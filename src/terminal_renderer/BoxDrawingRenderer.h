@@ -34,6 +34,7 @@ class BoxDrawingRenderer : public Renderable {
 
     void setRenderTarget(RenderTarget& _renderTarget) override;
     void clearCache() override;
+    void fontSizeChanged() override;
 
     /// Renders boxdrawing character.
     ///
@@ -53,6 +53,12 @@ void CursorRenderer::clearCache()
     textureAtlas_ = std::make_unique<TextureAtlas>(renderTarget().monochromeAtlasAllocator());
 }
 
+void CursorRenderer::fontSizeChanged()
+{
+    if (textureAtlas_)
+        textureAtlas_->releaseAll();
+}
+
 void CursorRenderer::rebuild()
 {
     clearCache();
@@ -132,7 +138,8 @@ optional<CursorRenderer::DataRef> CursorRenderer::getDataRef(CursorShape _shape)
     if (optional<DataRef> const dataRef = textureAtlas_->get(_shape); dataRef.has_value())
         return dataRef;
 
-    if (textureAtlas_->empty())
+    // All shapes are created at once, so a missing one has been evicted from the atlas.
+    if (!textureAtlas_->contains(_shape))
         rebuild();
 
     if (optional<DataRef> const dataRef = textureAtlas_->get(_shape); dataRef.has_value())
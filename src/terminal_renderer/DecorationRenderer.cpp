@@ -75,7 +75,15 @@ void DecorationRenderer::setRenderTarget(RenderTarget& _renderTarget)
 
 void DecorationRenderer::clearCache()
 {
-    atlas_ = std::make_unique<Atlas>(monochromeAtlasAllocator());
+    // Pinned, as decorations are only ever created as a whole (see getDataRef()).
+    atlas_ = std::make_unique<Atlas>(monochromeAtlasAllocator(), true);
+}
+
+void DecorationRenderer::fontSizeChanged()
+{
+    // Released explicitly, as pinned textures would otherwise never be reclaimed.
+    if (atlas_)
+        atlas_->releaseAll();
 }
 
 namespace
@@ -66,6 +66,7 @@ class DecorationRenderer : public Renderable {
 
     void setRenderTarget(RenderTarget& _renderTarget) override;
     void clearCache() override;
+    void fontSizeChanged() override;
 
     void setHyperlinkDecoration(Decorator _normal, Decorator _hover)
     {
@@ -112,4 +112,12 @@ void ImageRenderer::clearCache()
     atlas_ = std::make_unique<TextureAtlas>(renderTarget().coloredAtlasAllocator());
 }
 
+void ImageRenderer::fontSizeChanged()
+{
+    // Image fragments are scaled to the grid cell size upon insertion.
+    imageFragmentsInUse_.clear();
+    if (atlas_)
+        atlas_->releaseAll();
+}
+
 } // end namespace
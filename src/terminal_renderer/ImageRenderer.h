@@ -83,6 +83,7 @@ class ImageRenderer : public Renderable
 
     void setRenderTarget(RenderTarget& _renderTarget) override;
     void clearCache() override;
+    void fontSizeChanged() override;
 
     /// Reconfigures the slicing properties of existing images.
     void setCellSize(ImageSize _cellSize);
@@ -84,6 +84,12 @@ class Renderable {
     virtual ~Renderable() = default;
 
     virtual void clearCache() {}
+
+    /// Invoked after the font size, and thus the grid cell size, has changed.
+    ///
+    /// Unlike clearCache(), only textures that depend on the grid cell size are to be released,
+    /// and the render target's atlases are kept.
+    virtual void fontSizeChanged() {}
     virtual void setRenderTarget(RenderTarget& _renderTarget) { renderTarget_ = &_renderTarget; }
     RenderTarget& renderTarget() { return *renderTarget_; }
     constexpr bool renderTargetAvailable() const noexcept { return renderTarget_; }
@@ -13,15 +13,18 @@
  */
 #include <terminal_renderer/Renderer.h>
 #include <terminal_renderer/TextRenderer.h>
+#include <terminal_renderer/utils.h>
 
 #include <text_shaper/open_shaper.h>
 #include <text_shaper/directwrite_shaper.h>
+#include <text_shaper/shared_shaper.h>
 
 #include <crispy/debuglog.h>
 
 #include <array>
 #include <functional>
 #include <memory>
+#include <utility>
 
 using std::array;
 using std::scoped_lock;
@@ -30,6 +33,7 @@ using std::make_unique;
 using std::move;
 using std::nullopt;
 using std::optional;
+using std::pair;
 using std::reference_wrapper;
 using std::tuple;
 using std::unique_ptr;
@@ -61,8 +65,28 @@ GridMetrics loadGridMetrics(text::font_key _font, PageSize _pageSize, text::shap
     return gm;
 }
 
-FontKeys loadFontKeys(FontDescriptions const& _fd, text::shaper& _shaper)
+namespace
 {
+    /// Font size difference between two zoom steps, as applied by the font size actions.
+    auto constexpr ZoomStep = text::font_size{1.0};
+
+    constexpr bool isValidFontSize(text::font_size _size) noexcept
+    {
+        return 5.0 <= _size.pt && _size.pt <= 200.0; // Let's not be crazy.
+    }
+
+    auto constexpr FontRoles = array{
+        &FontKeys::regular,
+        &FontKeys::bold,
+        &FontKeys::italic,
+        &FontKeys::boldItalic,
+        &FontKeys::emoji
+    };
+}
+
+FontKeys loadFontKeys(FontDescriptions const& _fd, text::shaper& _shaper, steady_clock::duration& _elapsed)
+{
+    auto const start = steady_clock::now();
     FontKeys output{};
 
     output.regular = _shaper.load_font(_fd.regular, _fd.size).value_or(text::font_key{});
@@ -71,6 +95,7 @@ FontKeys loadFontKeys(FontDescriptions const& _fd, text::shaper& _shaper)
     output.boldItalic = _shaper.load_font(_fd.boldItalic, _fd.size).value_or(text::font_key{});
     output.emoji = _shaper.load_font(_fd.emoji, _fd.size).value_or(text::font_key{});
 
+    _elapsed = steady_clock::now() - start;
     return output;
 }
 
@@ -81,14 +106,16 @@ Renderer::Renderer(PageSize _screenSize,
                    Decorator _hyperlinkNormal,
                    Decorator _hyperlinkHover):
     textShaper_{
-        #if defined(_WIN32)
-        make_unique<text::directwrite_shaper>(_fontDescriptions.dpi)
-        #else
-        make_unique<text::open_shaper>(_fontDescriptions.dpi)
-        #endif
+        make_unique<text::shared_shaper>(_fontDescriptions.dpi, [](crispy::Point _dpi) -> unique_ptr<text::shaper> {
+            #if defined(_WIN32)
+            return make_unique<text::directwrite_shaper>(_dpi);
+            #else
+            return make_unique<text::open_shaper>(_dpi);
+            #endif
+        })
     },
     fontDescriptions_{ _fontDescriptions },
-    fonts_{ loadFontKeys(fontDescriptions_, *textShaper_) },
+    fonts_{ loadFontKeys(fontDescriptions_, *textShaper_, fontLoadTime_) },
     gridMetrics_{ loadGridMetrics(fonts_.regular, _screenSize, *textShaper_) },
     backgroundOpacity_{ _backgroundOpacity },
     backgroundRenderer_{ gridMetrics_, _colorPalette.defaultBackground },
@@ -99,6 +126,11 @@ Renderer::Renderer(PageSize _screenSize,
 {
 }
 
+Renderer::~Renderer()
+{
+    stopPrerendering();
+}
+
 void Renderer::setRenderTarget(RenderTarget& _renderTarget)
 {
     renderTarget_ = &_renderTarget;
@@ -141,28 +173,93 @@ void Renderer::clearCache()
 
 void Renderer::setFonts(FontDescriptions _fontDescriptions)
 {
+    stopPrerendering();
+    textRenderer_.discardRasterizingGlyphs();
     textShaper_->clear_cache();
     textShaper_->set_dpi(_fontDescriptions.dpi);
     fontDescriptions_ = move(_fontDescriptions);
-    fonts_ = loadFontKeys(fontDescriptions_, *textShaper_);
+    fonts_ = loadFontKeys(fontDescriptions_, *textShaper_, fontLoadTime_);
     updateFontMetrics();
 }
 
 bool Renderer::setFontSize(text::font_size _fontSize)
 {
-    if (_fontSize.pt < 5.) // Let's not be crazy.
+    if (!isValidFontSize(_fontSize))
         return false;
 
-    if (_fontSize.pt > 200.)
-        return false;
+    stopPrerendering();
+
+    auto const previousFonts = fonts_;
+    auto const previousSize = fontDescriptions_.size;
 
     fontDescriptions_.size = _fontSize;
-    fonts_ = loadFontKeys(fontDescriptions_, *textShaper_);
-    updateFontMetrics();
+    fonts_ = loadFontKeys(fontDescriptions_, *textShaper_, fontLoadTime_);
+    gridMetrics_ = loadGridMetrics(fonts_.regular, gridMetrics_.pageSize, *textShaper_);
+    imageRenderer_.setCellSize(cellSize());
+
+    // Unlike updateFontMetrics(), the glyphs of other font sizes are kept in the texture atlases.
+    for (auto& renderable: renderables())
+        renderable.get().fontSizeChanged();
+
+    prerenderZoomSteps(previousFonts, textRenderer_.renderedGlyphs(previousSize));
 
     return true;
 }
 
+void Renderer::prerenderZoomSteps(FontKeys const& _fonts, vector<text::glyph_key> const& _glyphs)
+{
+    auto glyphs = vector<pair<text::font_key FontKeys::*, text::glyph_index>>{};
+    for (text::glyph_key const& glyph: _glyphs)
+        for (auto const role: FontRoles)
+            if (_fonts.*role == glyph.font)
+            {
+                glyphs.emplace_back(role, glyph.index);
+                break;
+            }
+
+    if (glyphs.empty())
+        return;
+
+    prerenderCanceled_ = false;
+    prerenderThread_ = std::thread([this, fontDescriptions = fontDescriptions_, glyphs = move(glyphs)]() {
+        auto const start = steady_clock::now();
+        auto count = size_t{0};
+
+        // Only the shared text shaper is used here, which is serializing all access to it.
+        for (auto const size: {fontDescriptions.size + ZoomStep, fontDescriptions.size - ZoomStep})
+        {
+            if (!isValidFontSize(size))
+                continue;
+
+            auto fd = fontDescriptions;
+            fd.size = size;
+            auto elapsed = steady_clock::duration{};
+            auto const fonts = loadFontKeys(fd, *textShaper_, elapsed);
+
+            for (auto const& [role, index]: glyphs)
+            {
+                if (prerenderCanceled_)
+                    return;
+                textShaper_->rasterize(text::glyph_key{fonts.*role, size, index}, fd.renderMode);
+                ++count;
+            }
+        }
+
+        debuglog(TextRendererTag).write("Prerendered {} glyphs of the neighboring zoom steps in {:.2f} ms.",
+                                        count,
+                                        std::chrono::duration<double, std::milli>(steady_clock::now() - start).count());
+    });
+}
+
+void Renderer::stopPrerendering()
+{
+    if (!prerenderThread_.joinable())
+        return;
+
+    prerenderCanceled_ = true;
+    prerenderThread_.join();
+}
+
 void Renderer::updateFontMetrics()
 {
     gridMetrics_ = loadGridMetrics(fonts_.regular, gridMetrics_.pageSize, *textShaper_);
@@ -196,6 +293,9 @@ uint64_t Renderer::render(Terminal& _terminal,
 
     executeImageDiscards();
 
+    for (auto* allocator: renderTarget().allAtlasAllocators())
+        allocator->nextFrame();
+
     #if !defined(LIBTERMINAL_PASSIVE_RENDER_BUFFER_UPDATE) // {{{
     // Windows 10 (ConPTY) workaround. ConPTY can't handle non-blocking I/O,
     // so we have to explicitly refresh the render buffer
@@ -209,6 +309,7 @@ uint64_t Renderer::render(Terminal& _terminal,
     {
         RenderBufferRef const renderBuffer = _terminal.renderBuffer();
         cursorOpt = renderBuffer.get().cursor;
+        lastFrameID_ = renderBuffer.get().frameID;
         renderCells(renderBuffer.get().screen);
     }
     textRenderer_.finish();
@@ -293,6 +394,7 @@ optional<RenderCursor> Renderer::renderCursor(Terminal const& _terminal)
 void Renderer::dumpState(std::ostream& _textOutput) const
 {
     textRenderer_.debugCache(_textOutput);
+    _textOutput << fmt::format("Shared text shapers: {}\n", text::shared_shaper::stats().summary());
 }
 
 } // end namespace
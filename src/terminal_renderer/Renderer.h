@@ -29,8 +29,10 @@
 
 #include <fmt/format.h>
 
+#include <atomic>
 #include <chrono>
 #include <memory>
+#include <thread>
 #include <vector>
 #include <utility>
 
@@ -60,6 +62,7 @@ class Renderer : public Renderable {
              Opacity _backgroundOpacity,
              Decorator _hyperlinkNormal,
              Decorator _hyperlinkHover);
+    ~Renderer();
 
     ImageSize cellSize() const noexcept { return gridMetrics_.cellSize; }
 
@@ -75,6 +78,9 @@ class Renderer : public Renderable {
     FontDescriptions const& fontDescriptions() const noexcept { return fontDescriptions_; }
     void setFonts(FontDescriptions _fontDescriptions);
 
+    /// @returns the time it took to resolve and load the fonts most recently.
+    std::chrono::steady_clock::duration fontLoadTime() const noexcept { return fontLoadTime_; }
+
     GridMetrics const& gridMetrics() const noexcept { return gridMetrics_; }
 
     void setHyperlinkDecoration(Decorator _normal, Decorator _hover)
@@ -103,6 +109,12 @@ class Renderer : public Renderable {
                     std::chrono::steady_clock::time_point _now,
                     bool _pressure);
 
+    /// @returns the ID of the render buffer frame that has been rendered last.
+    uint64_t lastFrameID() const noexcept { return lastFrameID_; }
+
+    /// @returns whether glyphs left blank by the last frame are being rasterized in the background.
+    bool rasterizingGlyphs() const noexcept { return textRenderer_.rasterizingGlyphs(); }
+
     // Converts given RGBColor with its given opacity to a 4D-vector of values between 0.0 and 1.0
     static constexpr std::array<float, 4> canonicalColor(RGBColor const& _rgb, Opacity _opacity = Opacity::Opaque)
     {
@@ -138,14 +150,27 @@ class Renderer : public Renderable {
 
     void executeImageDiscards();
 
+    /// Rasterizes the given glyphs at the next larger and smaller zoom step on a background
+    /// thread, so that zooming there only needs to upload the already rasterized glyphs.
+    ///
+    /// @param _fonts   the fonts the glyphs have been rendered with.
+    /// @param _glyphs  the glyphs to rasterize, whereas glyphs of fallback fonts are ignored.
+    void prerenderZoomSteps(FontKeys const& _fonts, std::vector<text::glyph_key> const& _glyphs);
+    void stopPrerendering();
+
     std::unique_ptr<text::shaper> textShaper_;
 
     FontDescriptions fontDescriptions_;
+    std::chrono::steady_clock::duration fontLoadTime_{};
     FontKeys fonts_;
 
     GridMetrics gridMetrics_;
 
     Opacity backgroundOpacity_;
+    uint64_t lastFrameID_ = 0;
+
+    std::thread prerenderThread_;
+    std::atomic<bool> prerenderCanceled_ = false;
 
     std::mutex imageDiscardLock_;               //!< Lock guard for accessing discardImageQueue_.
     std::vector<Image::Id> discardImageQueue_;  //!< List of images to be discarded.
@@ -0,0 +1,394 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal_renderer/SoftwareRenderer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using std::array;
+using std::clamp;
+using std::max;
+using std::min;
+using std::nullopt;
+using std::optional;
+
+namespace terminal::renderer {
+
+namespace // {{{ helper
+{
+    constexpr int MaxTextureSize = 1024;
+    constexpr int MaxInstanceCount = 24;
+
+    /// @returns round(_value / 255) for any value within [0, 255 * 255 + 127].
+    constexpr unsigned div255(unsigned _value) noexcept
+    {
+        _value += 128;
+        return (_value + (_value >> 8)) >> 8;
+    }
+
+    uint8_t toByte(float _value) noexcept
+    {
+        return static_cast<uint8_t>(std::lround(clamp(_value, 0.0f, 1.0f) * 255.0f));
+    }
+
+    // All blend functions below implement the OpenGLRenderer's blend function,
+    // that is glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE).
+
+    inline void blendPixel(uint8_t* _target, unsigned _r, unsigned _g, unsigned _b, unsigned _a) noexcept
+    {
+        _target[0] = static_cast<uint8_t>(div255(_r * _a + _target[0] * (255 - _a)));
+        _target[1] = static_cast<uint8_t>(div255(_g * _a + _target[1] * (255 - _a)));
+        _target[2] = static_cast<uint8_t>(div255(_b * _a + _target[2] * (255 - _a)));
+        _target[3] = static_cast<uint8_t>(min(255u, _target[3] + _a));
+    }
+
+    /// Blends the given color onto @p _count pixels, with the color's alpha being scaled
+    /// by the respective coverage value. Used for filled rectangles and monochrome glyphs.
+    void blendCoverage(uint8_t* _target, uint8_t const* _coverage, size_t _count, array<uint8_t, 4> _color) noexcept
+    {
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        // Processes 4 pixels at a time, with each channel widened to 16 bits.
+        __m128i const zero = _mm_setzero_si128();
+        __m128i const c128 = _mm_set1_epi16(128);
+        __m128i const c255 = _mm_set1_epi16(255);
+        __m128i const alphaMask = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+        __m128i const color = _mm_setr_epi16(_color[0], _color[1], _color[2], 0, _color[0], _color[1], _color[2], 0);
+        __m128i const colorAlpha = _mm_set1_epi16(_color[3]);
+
+        auto const div255v = [&](__m128i _value) {
+            _value = _mm_add_epi16(_value, c128);
+            return _mm_srli_epi16(_mm_add_epi16(_value, _mm_srli_epi16(_value, 8)), 8);
+        };
+
+        auto const blend = [&](__m128i _dst, __m128i _alpha) {
+            __m128i const rgb = div255v(_mm_add_epi16(_mm_mullo_epi16(color, _alpha),
+                                                      _mm_mullo_epi16(_dst, _mm_sub_epi16(c255, _alpha))));
+            __m128i const alpha = _mm_min_epi16(_mm_add_epi16(_dst, _alpha), c255);
+            return _mm_or_si128(_mm_andnot_si128(alphaMask, rgb), _mm_and_si128(alphaMask, alpha));
+        };
+
+        for (; i + 4 <= _count; i += 4)
+        {
+            int32_t coverage = 0;
+            std::memcpy(&coverage, _coverage + i, sizeof(coverage));
+
+            // broadcast each pixel's coverage to all of its four channels
+            __m128i alpha = _mm_cvtsi32_si128(coverage);
+            alpha = _mm_unpacklo_epi8(alpha, alpha);
+            alpha = _mm_unpacklo_epi16(alpha, alpha);
+            __m128i const alphaLo = div255v(_mm_mullo_epi16(_mm_unpacklo_epi8(alpha, zero), colorAlpha));
+            __m128i const alphaHi = div255v(_mm_mullo_epi16(_mm_unpackhi_epi8(alpha, zero), colorAlpha));
+
+            auto* target = reinterpret_cast<__m128i*>(_target + i * 4);
+            __m128i const dst = _mm_loadu_si128(target);
+            __m128i const lo = blend(_mm_unpacklo_epi8(dst, zero), alphaLo);
+            __m128i const hi = blend(_mm_unpackhi_epi8(dst, zero), alphaHi);
+            _mm_storeu_si128(target, _mm_packus_epi16(lo, hi));
+        }
+#endif
+
+        for (; i < _count; ++i)
+            blendPixel(_target + i * 4, _color[0], _color[1], _color[2], div255(_coverage[i] * _color[3]));
+    }
+
+    /// Blends RGBA texels (images and colored glyphs, such as Emoji).
+    void blendRGBA(uint8_t* _target, uint8_t const* _texels, size_t _count) noexcept
+    {
+        for (size_t i = 0; i < _count; ++i, _target += 4, _texels += 4)
+            blendPixel(_target, _texels[0], _texels[1], _texels[2], _texels[3]);
+    }
+
+    /// Blends LCD subpixel texels (RGB) the way the text shader's renderLcdGlyphSimple() does.
+    void blendLCD(uint8_t* _target, uint8_t const* _texels, size_t _count, array<uint8_t, 4> _color) noexcept
+    {
+        for (size_t i = 0; i < _count; ++i, _target += 4, _texels += 3)
+        {
+            auto const alpha = (unsigned(_texels[0]) + _texels[1] + _texels[2]) / 3;
+            blendPixel(_target,
+                       div255(_texels[0] * _color[0]),
+                       div255(_texels[1] * _color[1]),
+                       div255(_texels[2] * _color[2]),
+                       alpha);
+        }
+    }
+} // }}}
+
+SoftwareRenderer::SoftwareRenderer(ImageSize _size):
+    monochromeAtlasAllocator_{
+        *this,
+        ImageSize{Width(MaxTextureSize), Height(MaxTextureSize)},
+        MaxInstanceCount,
+        atlas::Format::Red,
+        0,
+        "monochromeAtlas"
+    },
+    coloredAtlasAllocator_{
+        *this,
+        ImageSize{Width(MaxTextureSize), Height(MaxTextureSize)},
+        MaxInstanceCount,
+        atlas::Format::RGBA,
+        1,
+        "colorAtlas"
+    },
+    lcdAtlasAllocator_{
+        *this,
+        ImageSize{Width(MaxTextureSize), Height(MaxTextureSize)},
+        MaxInstanceCount,
+        atlas::Format::RGB,
+        2,
+        "lcdAtlas"
+    }
+{
+    setRenderSize(_size);
+}
+
+void SoftwareRenderer::setRenderSize(ImageSize _size)
+{
+    size_ = _size;
+    framebuffer_.assign(unbox<size_t>(_size.width) * unbox<size_t>(_size.height) * 4, 0);
+}
+
+void SoftwareRenderer::scheduleScreenshot(ScreenshotCallback _callback)
+{
+    pendingScreenshotCallback_ = std::move(_callback);
+}
+
+void SoftwareRenderer::renderRectangle(int _x, int _y, int _width, int _height,
+                                       float _r, float _g, float _b, float _a)
+{
+    rectangles_.emplace_back(Rectangle{_x, _y, _width, _height, {toByte(_r), toByte(_g), toByte(_b), toByte(_a)}});
+}
+
+void SoftwareRenderer::clearCache()
+{
+    monochromeAtlasAllocator_.clear();
+    coloredAtlasAllocator_.clear();
+    lcdAtlasAllocator_.clear();
+}
+
+void SoftwareRenderer::clear(RGBAColor _color)
+{
+    auto const pixel = array<uint8_t, 4>{_color.red(), _color.green(), _color.blue(), _color.alpha()};
+    for (size_t i = 0; i < framebuffer_.size(); i += 4)
+        std::memcpy(&framebuffer_[i], pixel.data(), pixel.size());
+}
+
+RGBAColor SoftwareRenderer::pixel(int _x, int _y) const noexcept
+{
+    if (_x < 0 || _y < 0 || _x >= unbox<int>(size_.width) || _y >= unbox<int>(size_.height))
+        return RGBAColor{};
+
+    auto const* p = &framebuffer_[(static_cast<size_t>(_y) * unbox<size_t>(size_.width) + static_cast<size_t>(_x)) * 4];
+    return RGBAColor{p[0], p[1], p[2], p[3]};
+}
+
+void SoftwareRenderer::execute()
+{
+    // Same order as the OpenGLRenderer: filled rectangles first, then textures grouped by atlas.
+    for (Rectangle const& rect: rectangles_)
+        drawRectangle(rect);
+    rectangles_.clear();
+
+    for (AtlasTexture& atlas: atlases_)
+    {
+        for (atlas::RenderTexture const& render: atlas.renderTextures)
+            drawTexture(atlas, render);
+        atlas.renderTextures.clear();
+    }
+
+    if (pendingScreenshotCallback_)
+    {
+        pendingScreenshotCallback_.value()(framebuffer_, size_);
+        pendingScreenshotCallback_.reset();
+    }
+}
+
+void SoftwareRenderer::drawRectangle(Rectangle const& _rect)
+{
+    auto const x0 = max(_rect.x, 0);
+    auto const y0 = max(_rect.y, 0);
+    auto const x1 = min(_rect.x + _rect.width, unbox<int>(size_.width));
+    auto const y1 = min(_rect.y + _rect.height, unbox<int>(size_.height));
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    auto const count = static_cast<size_t>(x1 - x0);
+    auto const stride = unbox<size_t>(size_.width) * 4;
+    auto* row = &framebuffer_[static_cast<size_t>(y0) * stride + static_cast<size_t>(x0) * 4];
+
+    if (_rect.color[3] == 0xFF)
+    {
+        // opaque: blending degrades into a plain fill
+        for (int y = y0; y < y1; ++y, row += stride)
+            for (size_t i = 0; i < count; ++i)
+                std::memcpy(row + i * 4, _rect.color.data(), 4);
+        return;
+    }
+
+    scratch_.assign(count, 0xFF);
+    for (int y = y0; y < y1; ++y, row += stride)
+        blendCoverage(row, scratch_.data(), count, _rect.color);
+}
+
+void SoftwareRenderer::drawTexture(AtlasTexture const& _atlas, atlas::RenderTexture const& _render)
+{
+    atlas::TextureInfo const& texture = _render.texture.get();
+
+    auto const targetWidth = unbox<int>(texture.targetSize.width);
+    auto const targetHeight = unbox<int>(texture.targetSize.height);
+    auto const bitmapWidth = unbox<int>(texture.bitmapSize.width);
+    auto const bitmapHeight = unbox<int>(texture.bitmapSize.height);
+
+    auto const x0 = max(_render.x, 0);
+    auto const y0 = max(_render.y, 0);
+    auto const x1 = min(_render.x + targetWidth, unbox<int>(size_.width));
+    auto const y1 = min(_render.y + targetHeight, unbox<int>(size_.height));
+    if (x0 >= x1 || y0 >= y1 || _atlas.pixels.empty())
+        return;
+
+    auto const color = array<uint8_t, 4>{
+        toByte(_render.color[0]),
+        toByte(_render.color[1]),
+        toByte(_render.color[2]),
+        toByte(_render.color[3])
+    };
+    auto const texelSize = static_cast<size_t>(atlas::element_count(_atlas.format));
+    auto const atlasStride = unbox<size_t>(_atlas.size.width) * texelSize;
+    auto const count = static_cast<size_t>(x1 - x0);
+    auto const firstColumn = x0 - _render.x;
+    bool const scaled = bitmapWidth != targetWidth;
+    if (scaled)
+        scratch_.resize(count * texelSize);
+
+    // Nearest neighbor sampling at pixel centers (the atlas textures use GL_NEAREST, too).
+    // The texture's first row is mapped to the quad's bottom most row.
+    for (int y = y0; y < y1; ++y)
+    {
+        auto const j = y - _render.y;
+        auto const sourceRow = texture.offset.y + (bitmapHeight == targetHeight ? j : (2 * j + 1) * bitmapHeight / (2 * targetHeight));
+        uint8_t const* texels = &_atlas.pixels[static_cast<size_t>(sourceRow) * atlasStride + static_cast<size_t>(texture.offset.x) * texelSize];
+
+        if (!scaled)
+            texels += static_cast<size_t>(firstColumn) * texelSize;
+        else
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                auto const column = (2 * (firstColumn + static_cast<int>(i)) + 1) * bitmapWidth / (2 * targetWidth);
+                std::memcpy(&scratch_[i * texelSize], texels + static_cast<size_t>(column) * texelSize, texelSize);
+            }
+            texels = scratch_.data();
+        }
+
+        auto* target = &framebuffer_[(static_cast<size_t>(y) * unbox<size_t>(size_.width) + static_cast<size_t>(x0)) * 4];
+        switch (_atlas.format)
+        {
+            case atlas::Format::Red:
+                blendCoverage(target, texels, count, color);
+                break;
+            case atlas::Format::RGBA:
+                blendRGBA(target, texels, count);
+                break;
+            case atlas::Format::RGB:
+                blendLCD(target, texels, count, color);
+                break;
+        }
+    }
+}
+
+optional<AtlasTextureInfo> SoftwareRenderer::readAtlas(atlas::TextureAtlasAllocator const& _allocator, atlas::AtlasID _instanceId)
+{
+    if (_instanceId.value < 0 || static_cast<size_t>(_instanceId.value) >= atlases_.size())
+        return nullopt;
+
+    AtlasTexture const& atlas = atlases_[static_cast<size_t>(_instanceId.value)];
+    if (atlas.pixels.empty())
+        return nullopt;
+
+    // Mimmicks reading back the texture through a framebuffer object in RGBA format.
+    AtlasTextureInfo output{};
+    output.atlasName = _allocator.name();
+    output.atlasInstanceId = _instanceId.value;
+    output.size = atlas.size;
+    output.format = atlas::Format::RGBA;
+
+    auto const texelSize = static_cast<size_t>(atlas::element_count(atlas.format));
+    auto const texelCount = atlas.pixels.size() / texelSize;
+    output.buffer.resize(texelCount * 4);
+    for (size_t i = 0; i < texelCount; ++i)
+    {
+        uint8_t const* texel = &atlas.pixels[i * texelSize];
+        output.buffer[i * 4 + 0] = texel[0];
+        output.buffer[i * 4 + 1] = texelSize > 1 ? texel[1] : 0;
+        output.buffer[i * 4 + 2] = texelSize > 2 ? texel[2] : 0;
+        output.buffer[i * 4 + 3] = texelSize > 3 ? texel[3] : 0xFF;
+    }
+
+    return output;
+}
+
+// {{{ AtlasBackend
+atlas::AtlasID SoftwareRenderer::createAtlas(ImageSize _size, atlas::Format _format, int /*_user*/)
+{
+    auto const id = atlas::AtlasID{static_cast<int>(atlases_.size())};
+    auto const texelSize = static_cast<size_t>(atlas::element_count(_format));
+    atlases_.emplace_back(AtlasTexture{
+        _size,
+        _format,
+        std::vector<uint8_t>(unbox<size_t>(_size.width) * unbox<size_t>(_size.height) * texelSize, 0),
+        {}
+    });
+    return id;
+}
+
+void SoftwareRenderer::uploadTexture(atlas::UploadTexture _upload)
+{
+    atlas::TextureInfo const& texture = _upload.texture.get();
+    AtlasTexture& atlas = atlases_.at(static_cast<size_t>(texture.atlas.value));
+
+    auto const texelSize = static_cast<size_t>(atlas::element_count(atlas.format));
+    auto const rowSize = unbox<size_t>(texture.bitmapSize.width) * texelSize;
+    auto const rowCount = min(unbox<size_t>(texture.bitmapSize.height), rowSize ? _upload.data.size() / rowSize : 0);
+    auto const atlasStride = unbox<size_t>(atlas.size.width) * texelSize;
+
+    for (size_t row = 0; row < rowCount; ++row)
+        std::memcpy(&atlas.pixels[(static_cast<size_t>(texture.offset.y) + row) * atlasStride + static_cast<size_t>(texture.offset.x) * texelSize],
+                    &_upload.data[row * rowSize],
+                    rowSize);
+}
+
+void SoftwareRenderer::renderTexture(atlas::RenderTexture _render)
+{
+    atlases_.at(static_cast<size_t>(_render.texture.get().atlas.value)).renderTextures.emplace_back(_render);
+}
+
+void SoftwareRenderer::destroyAtlas(atlas::AtlasID _atlasID)
+{
+    if (_atlasID.value >= 0 && static_cast<size_t>(_atlasID.value) < atlases_.size())
+    {
+        AtlasTexture& atlas = atlases_[static_cast<size_t>(_atlasID.value)];
+        atlas.pixels = {};
+        atlas.renderTextures.clear();
+    }
+}
+// }}}
+
+} // end namespace
@@ -0,0 +1,120 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal_renderer/Atlas.h>
+#include <terminal_renderer/RenderTarget.h>
+
+#include <terminal/Color.h>
+
+#include <crispy/size.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace terminal::renderer {
+
+/**
+ * CPU rasterizing render target.
+ *
+ * Renders into an RGBA framebuffer in host memory, with the same geometry and blending
+ * semantics as the OpenGLRenderer (and its shaders) does, that is, the first row
+ * of the framebuffer is the bottom most one (just like glReadPixels() would return it).
+ *
+ * This is used for benchmarking the full render pipeline as well as pixel testing
+ * on machines without an OpenGL context.
+ */
+class SoftwareRenderer final :
+    public RenderTarget,
+    private atlas::AtlasBackend
+{
+  public:
+    explicit SoftwareRenderer(ImageSize _size);
+
+    void setRenderSize(ImageSize _size) override;
+    void setMargin(PageMargin _margin) noexcept override { margin_ = _margin; }
+
+    atlas::TextureAtlasAllocator& monochromeAtlasAllocator() noexcept override { return monochromeAtlasAllocator_; }
+    atlas::TextureAtlasAllocator& coloredAtlasAllocator() noexcept override { return coloredAtlasAllocator_; }
+    atlas::TextureAtlasAllocator& lcdAtlasAllocator() noexcept override { return lcdAtlasAllocator_; }
+
+    atlas::AtlasBackend& textureScheduler() override { return *this; }
+
+    void scheduleScreenshot(ScreenshotCallback _callback) override;
+
+    void renderRectangle(int _x, int _y, int _width, int _height,
+                         float _r, float _g, float _b, float _a) override;
+
+    void execute() override;
+
+    void clearCache() override;
+
+    std::optional<AtlasTextureInfo> readAtlas(atlas::TextureAtlasAllocator const& _allocator, atlas::AtlasID _instanceId) override;
+
+    /// Fills the whole framebuffer with the given color (like glClear() would do).
+    void clear(RGBAColor _color);
+
+    ImageSize size() const noexcept { return size_; }
+
+    /// @returns the RGBA framebuffer, bottom row first.
+    std::vector<uint8_t> const& framebuffer() const noexcept { return framebuffer_; }
+
+    /// @returns the RGBA value of the given pixel, with (0, 0) being the bottom left corner.
+    RGBAColor pixel(int _x, int _y) const noexcept;
+
+  private:
+    // AtlasBackend overrides
+    atlas::AtlasID createAtlas(ImageSize _size, atlas::Format _format, int _user) override;
+    void uploadTexture(atlas::UploadTexture _texture) override;
+    void renderTexture(atlas::RenderTexture _texture) override;
+    void destroyAtlas(atlas::AtlasID _atlasID) override;
+
+    struct Rectangle {
+        int x;
+        int y;
+        int width;
+        int height;
+        std::array<uint8_t, 4> color;
+    };
+
+    struct AtlasTexture {
+        ImageSize size;
+        atlas::Format format;
+        std::vector<uint8_t> pixels;
+        std::vector<atlas::RenderTexture> renderTextures; // pending render commands of the current frame
+    };
+
+    void drawRectangle(Rectangle const& _rect);
+    void drawTexture(AtlasTexture const& _atlas, atlas::RenderTexture const& _render);
+
+    // private data members
+    //
+    ImageSize size_;
+    PageMargin margin_{};
+    std::vector<uint8_t> framebuffer_;
+
+    std::vector<Rectangle> rectangles_;
+    std::vector<AtlasTexture> atlases_;     // indexed by AtlasID
+    std::vector<uint8_t> scratch_;          // row buffer for sampling scaled textures
+
+    std::optional<ScreenshotCallback> pendingScreenshotCallback_;
+
+    atlas::TextureAtlasAllocator monochromeAtlasAllocator_;
+    atlas::TextureAtlasAllocator coloredAtlasAllocator_;
+    atlas::TextureAtlasAllocator lcdAtlasAllocator_;
+};
+
+} // end namespace
@@ -0,0 +1,130 @@
+/**
+ * This file is part of the "contour" project.
+ *   Copyright (c) 2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal_renderer/BackgroundRenderer.h>
+#include <terminal_renderer/CursorRenderer.h>
+#include <terminal_renderer/DecorationRenderer.h>
+#include <terminal_renderer/GridMetrics.h>
+#include <terminal_renderer/SoftwareRenderer.h>
+#include <catch2/catch_all.hpp>
+
+#include <map>
+#include <string>
+
+using namespace terminal;
+using namespace terminal::renderer;
+
+namespace
+{
+    /// Renders the framebuffer into text, top row first, one character per pixel,
+    /// such that golden images can be compared (and reviewed) as plain text.
+    std::string toText(SoftwareRenderer const& _target, std::map<uint32_t, char> const& _palette)
+    {
+        auto text = std::string{};
+        for (int y = unbox<int>(_target.size().height) - 1; y >= 0; --y)
+        {
+            for (int x = 0; x < unbox<int>(_target.size().width); ++x)
+            {
+                auto const i = _palette.find(_target.pixel(x, y).value);
+                text += i != _palette.end() ? i->second : '?';
+            }
+            text += '\n';
+        }
+        return text;
+    }
+
+    GridMetrics makeGridMetrics()
+    {
+        auto gm = GridMetrics{};
+        gm.pageSize = PageSize{LineCount(2), ColumnCount(3)};
+        gm.cellSize = ImageSize{Width(4), Height(8)};
+        gm.baseline = 3;
+        gm.underline.position = 2;
+        gm.underline.thickness = 1;
+        return gm;
+    }
+}
+
+TEST_CASE("SoftwareRenderer.rectangles", "[SoftwareRenderer]")
+{
+    auto target = SoftwareRenderer{ImageSize{Width(13), Height(3)}};
+    target.clear(RGBAColor{0x00, 0x00, 0xFF, 0xFF});
+
+    // Opaque fill, partially clipped.
+    target.renderRectangle(-2, 0, 4, 1, 1.0f, 0.0f, 0.0f, 1.0f);
+
+    // Half transparent blending over odd widths, exercising vectorized and scalar code paths alike.
+    target.renderRectangle(0, 1, 13, 1, 1.0f, 1.0f, 1.0f, 0.5f);
+    target.execute();
+
+    CHECK(target.pixel(0, 0).value == RGBAColor(0xFF, 0x00, 0x00, 0xFF).value);
+    CHECK(target.pixel(1, 0).value == RGBAColor(0xFF, 0x00, 0x00, 0xFF).value);
+    CHECK(target.pixel(2, 0).value == RGBAColor(0x00, 0x00, 0xFF, 0xFF).value);
+    for (int x = 0; x < 13; ++x)
+        CHECK(target.pixel(x, 1).value == RGBAColor(0x80, 0x80, 0xFF, 0xFF).value);
+    CHECK(target.pixel(12, 2).value == RGBAColor(0x00, 0x00, 0xFF, 0xFF).value);
+}
+
+TEST_CASE("SoftwareRenderer.golden", "[SoftwareRenderer]")
+{
+    auto const gridMetrics = makeGridMetrics();
+    auto const defaultBackground = RGBColor{0, 0, 0};
+    auto const cursorColor = RGBColor{0xFF, 0xFF, 0xFF};
+
+    auto target = SoftwareRenderer{ImageSize{Width(12), Height(16)}};
+    auto background = BackgroundRenderer{gridMetrics, defaultBackground};
+    auto decoration = DecorationRenderer{gridMetrics, Decorator::DottedUnderline, Decorator::Underline};
+    auto cursor = CursorRenderer{gridMetrics, CursorShape::Bar, cursorColor};
+    background.setRenderTarget(target);
+    decoration.setRenderTarget(target);
+    cursor.setRenderTarget(target);
+
+    auto cell = RenderCell{};
+    cell.position = Coordinate{1, 2};
+    cell.backgroundColor = RGBColor{0xFF, 0, 0};
+    background.renderCell(cell);
+
+    decoration.renderDecoration(Decorator::Underline, gridMetrics.map(2, 2), 2, RGBColor{0, 0xFF, 0});
+    cursor.render(gridMetrics.map(1, 1), 1);
+
+    target.clear(RGBAColor{0, 0, 0, 0xFF});
+    target.execute();
+
+    auto const palette = std::map<uint32_t, char>{
+        {RGBAColor(0x00, 0x00, 0x00, 0xFF).value, '.'},
+        {RGBAColor(0xFF, 0x00, 0x00, 0xFF).value, 'R'},
+        {RGBAColor(0x00, 0xFF, 0x00, 0xFF).value, 'G'},
+        {RGBAColor(0xFF, 0xFF, 0xFF, 0xFF).value, 'W'},
+    };
+
+    // Cursor bar (top left), background (top middle) and underline across two cells (bottom right).
+    auto const expected = std::string{
+        "W...RRRR....\n"
+        "W...RRRR....\n"
+        "W...RRRR....\n"
+        "W...RRRR....\n"
+        "W...RRRR....\n"
+        "W...RRRR....\n"
+        "W...RRRR....\n"
+        "W...RRRR....\n"
+        "............\n"
+        "............\n"
+        "............\n"
+        "............\n"
+        "............\n"
+        "............\n"
+        "............\n"
+        "....GGGGGGGG\n"
+    };
+    CHECK(toText(target, palette) == expected);
+}
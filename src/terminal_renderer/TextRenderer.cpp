@@ -27,6 +27,9 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <algorithm>
+#include <chrono>
+
 using crispy::copy;
 using crispy::times;
 
@@ -67,6 +70,18 @@ namespace // {{{ helpers
         }
         return _fonts.regular;
     }
+
+    constexpr size_t styleIndex(TextStyle _style) noexcept
+    {
+        return static_cast<size_t>(_style) & 0x03;
+    }
+
+    vector<optional<text::rasterized_glyph>> rasterizeBatch(text::shaper& _shaper,
+                                                             vector<text::glyph_key> const& _glyphs,
+                                                             text::render_mode _mode)
+    {
+        return _shaper.rasterize_batch(crispy::span<text::glyph_key const>(_glyphs.data(), _glyphs.size()), _mode);
+    }
 } // }}}
 
 TextRenderer::TextRenderer(GridMetrics const& _gridMetrics,
@@ -76,6 +91,8 @@ TextRenderer::TextRenderer(GridMetrics const& _gridMetrics,
     gridMetrics_{ _gridMetrics },
     fontDescriptions_{ _fontDescriptions },
     fonts_{ _fonts },
+    currentSize_{ _fontDescriptions.size },
+    currentFonts_{ _fonts },
     textShaper_{ _textShaper },
     boxDrawingRenderer_{ _gridMetrics }
 {
@@ -114,9 +131,13 @@ void TextRenderer::setRenderTarget(RenderTarget& _renderTarget)
 
 void TextRenderer::clearCache()
 {
+    discardRasterizingGlyphs();
+
     monochromeAtlas_ = make_unique<TextureAtlas>(renderTarget().monochromeAtlasAllocator());
     colorAtlas_ = make_unique<TextureAtlas>(renderTarget().coloredAtlasAllocator());
     lcdAtlas_ = make_unique<TextureAtlas>(renderTarget().lcdAtlasAllocator());
+    clearDirectGlyphs();
+    sizeTiers_.clear(); // their direct glyphs are referring to the old atlases
 
     textRenderingEngine_->clearCache();
     boxDrawingRenderer_.clearCache();
@@ -124,7 +145,13 @@ void TextRenderer::clearCache()
 
 void TextRenderer::updateFontMetrics()
 {
+    discardRasterizingGlyphs();
+
     setTextShapingMethod(fontDescriptions_.textShapingMethod);
+    clearDirectGlyphs();
+    sizeTiers_.clear();
+    currentSize_ = fontDescriptions_.size;
+    currentFonts_ = fonts_;
 
     if (!renderTargetAvailable())
         return;
@@ -132,6 +159,48 @@ void TextRenderer::updateFontMetrics()
     clearCache();
 }
 
+void TextRenderer::fontSizeChanged()
+{
+    auto const size = fontDescriptions_.size;
+
+    sizeTiers_.emplace_front(SizeTier{currentSize_, currentFonts_, move(textRenderingEngine_), directGlyphs_});
+    currentSize_ = size;
+    currentFonts_ = fonts_;
+
+    // A tier is only reusable if the fonts have been reloaded into the very same font keys,
+    // as these are part of the cached glyph keys.
+    auto const tier = std::find_if(sizeTiers_.begin(), sizeTiers_.end(), [&](SizeTier const& _tier) {
+        return _tier.size.pt == size.pt && _tier.fonts == fonts_;
+    });
+    if (tier != sizeTiers_.end())
+    {
+        debuglog(TextRendererTag).write("Switching to font size {} (cached).", size);
+        textRenderingEngine_ = move(tier->textRenderingEngine);
+        directGlyphs_ = tier->directGlyphs;
+    }
+    else
+    {
+        debuglog(TextRendererTag).write("Switching to font size {}.", size);
+        setTextShapingMethod(fontDescriptions_.textShapingMethod);
+        clearDirectGlyphs();
+    }
+
+    sizeTiers_.remove_if([&](SizeTier const& _tier) { return _tier.size.pt == size.pt; });
+    while (sizeTiers_.size() > MaxSizeTiers)
+        sizeTiers_.pop_back();
+
+    boxDrawingRenderer_.fontSizeChanged();
+}
+
+vector<text::glyph_key> TextRenderer::renderedGlyphs(text::font_size _size) const
+{
+    auto glyphs = vector<text::glyph_key>{};
+    for (auto const& [glyph, format]: glyphToTextureMapping_)
+        if (glyph.size.pt == _size.pt)
+            glyphs.emplace_back(glyph);
+    return glyphs;
+}
+
 /// Should box drawing fall back to font based box drawing?
 // XXX #define BOXDRAWING_FONT_FALLBACK
 
@@ -166,16 +235,19 @@ void TextRenderer::renderCell(RenderCell const& _cell)
         if (couldRender)
 #endif
         {
-            if (!lastWasBoxDrawing_)
+            if (!lastWasDirect_)
                 textRenderingEngine_->endSequence();
-            lastWasBoxDrawing_ = true;
+            lastWasDirect_ = true;
             return;
         }
     }
 
-    if (lastWasBoxDrawing_ || (_cell.flags & CellFlags::CellSequenceStart))
+    if (renderDirect(_cell, style))
+        return;
+
+    if (lastWasDirect_ || (_cell.flags & CellFlags::CellSequenceStart))
     {
-        lastWasBoxDrawing_ = false;
+        lastWasDirect_ = false;
         textRenderingEngine_->setTextPosition(gridMetrics_.map(_cell.position));
     }
 
@@ -187,12 +259,14 @@ void TextRenderer::renderCell(RenderCell const& _cell)
 
 void TextRenderer::start()
 {
+    collectRasterizedGlyphs();
     textRenderingEngine_->beginFrame();
 }
 
 void TextRenderer::finish()
 {
     textRenderingEngine_->endSequence();
+    rasterizeMissingGlyphs();
 }
 
 void TextRenderer::renderRun(crispy::Point _pos,
@@ -204,13 +278,19 @@ void TextRenderer::renderRun(crispy::Point _pos,
 
     for (text::glyph_position const& gpos: _glyphPositions)
     {
-        if (optional<DataRef> const ti = getTextureInfo(gpos.glyph); ti.has_value())
+        if (optional<DataRef> const ti = cachedTextureInfo(gpos.glyph); ti.has_value())
         {
             renderTexture(pen,
                           _color,
                           get<0>(*ti).get(), // TextureInfo
                           get<1>(*ti).get(), // Metadata
-                          gpos);
+                          gpos,
+                          textShaper_.has_color(gpos.glyph.font));
+        }
+        else
+        {
+            deferredGlyphs_.emplace_back(DeferredGlyph{pen, _color, gpos});
+            missingGlyphs_.insert(gpos.glyph);
         }
 
         if (gpos.advance.x)
@@ -223,6 +303,84 @@ void TextRenderer::renderRun(crispy::Point _pos,
     }
 }
 
+// {{{ direct glyph table
+bool TextRenderer::renderDirect(RenderCell const& _cell, TextStyle _style)
+{
+    // Only the simple text shaper maps each cell to its glyph independently of its
+    // neighbors, whereas complex text shaping may form ligatures or apply kerning.
+    if (fontDescriptions_.textShapingMethod != TextShapingMethod::Simple)
+        return false;
+
+    if (_cell.codepoints.size() != 1 || !crispy::ascending(DirectGlyphFirst, _cell.codepoints[0], DirectGlyphLast))
+        return false;
+
+    auto const codepoint = _cell.codepoints[0];
+    auto const& entry = directGlyphs_[styleIndex(_style)][codepoint - DirectGlyphFirst];
+
+    // The texture may have been evicted from the atlas in the meantime.
+    atlas::TextureInfo const* textureInfo = entry.has_value()
+                                          ? entry->textureAtlas->allocator().use(entry->texture)
+                                          : nullptr;
+    if (!textureInfo)
+    {
+        DirectGlyph const* resolved = resolveDirectGlyph(_style, codepoint);
+        if (!resolved)
+            return false;
+        textureInfo = resolved->textureAtlas->allocator().get(resolved->texture);
+    }
+
+    if (!lastWasDirect_)
+        textRenderingEngine_->endSequence();
+    lastWasDirect_ = true;
+
+    renderTexture(gridMetrics_.map(_cell.position),
+                  _cell.foregroundColor,
+                  *textureInfo,
+                  entry->metrics,
+                  entry->glyphPosition,
+                  entry->colored);
+    return true;
+}
+
+TextRenderer::DirectGlyph const* TextRenderer::resolveDirectGlyph(TextStyle _style, char32_t _codepoint)
+{
+    auto& entry = directGlyphs_[styleIndex(_style)][_codepoint - DirectGlyphFirst];
+    entry.reset();
+
+    optional<text::glyph_position> const glyphPosition = textShaper_.shape(getFontForStyle(fonts_, _style), _codepoint);
+    if (!glyphPosition.has_value())
+        return nullptr;
+
+    optional<DataRef> const dataRef = getTextureInfo(glyphPosition->glyph);
+    if (!dataRef.has_value())
+        return nullptr;
+
+    // Mirrors the atlas selection of getTextureInfo().
+    bool const colored = textShaper_.has_color(glyphPosition->glyph.font);
+    TextureAtlas* targetAtlas = colored
+                              ? colorAtlas_.get()
+                              : atlasForBitmapFormat(glyphToTextureMapping_.at(glyphPosition->glyph));
+    if (!targetAtlas)
+        return nullptr;
+
+    atlas::TextureInfo const& textureInfo = get<0>(*dataRef).get();
+    entry = DirectGlyph{
+        *glyphPosition,
+        targetAtlas,
+        targetAtlas->allocator().handleOf(textureInfo),
+        get<1>(*dataRef).get(),
+        colored
+    };
+    return &*entry;
+}
+
+void TextRenderer::clearDirectGlyphs()
+{
+    for (auto& glyphs: directGlyphs_)
+        glyphs.fill(nullopt);
+}
+// }}}
+
 TextRenderer::TextureAtlas& TextRenderer::atlasForFont(text::font_key _font)
 {
     if (textShaper_.has_color(_font))
@@ -245,19 +403,118 @@ TextRenderer::TextureAtlas& TextRenderer::atlasForFont(text::font_key _font)
 }
 
 optional<TextRenderer::DataRef> TextRenderer::getTextureInfo(text::glyph_key const& _id)
+{
+    if (optional<DataRef> const dataRef = cachedTextureInfo(_id); dataRef.has_value())
+        return dataRef;
+
+    auto theGlyphOpt = textShaper_.rasterize(_id, fontDescriptions_.renderMode);
+    if (!theGlyphOpt.has_value())
+        return nullopt;
+
+    return insertGlyph(_id, move(theGlyphOpt.value()));
+}
+
+// {{{ glyph rasterization
+optional<TextRenderer::DataRef> TextRenderer::cachedTextureInfo(text::glyph_key const& _id)
 {
     if (auto i = glyphToTextureMapping_.find(_id); i != glyphToTextureMapping_.end())
         if (TextureAtlas* ta = atlasForBitmapFormat(i->second); ta != nullptr)
             if (optional<DataRef> const dataRef = ta->get(_id); dataRef.has_value())
                 return dataRef;
 
-    bool const colored = textShaper_.has_color(_id.font);
+    return nullopt;
+}
 
-    auto theGlyphOpt = textShaper_.rasterize(_id, fontDescriptions_.renderMode);
-    if (!theGlyphOpt.has_value())
-        return nullopt;
+void TextRenderer::insertGlyphs(RasterizedGlyphs _batch)
+{
+    for (size_t i = 0; i < _batch.glyphs.size(); ++i)
+        if (_batch.bitmaps[i].has_value())
+            insertGlyph(_batch.glyphs[i], move(_batch.bitmaps[i].value()));
+}
+
+void TextRenderer::rasterizeMissingGlyphs()
+{
+    if (missingGlyphs_.empty())
+        return;
+
+    auto batch = RasterizedGlyphs{};
+    batch.fontGeneration = fontGeneration_;
+    batch.glyphs.assign(missingGlyphs_.begin(), missingGlyphs_.end());
+    missingGlyphs_.clear();
+
+    switch (fontDescriptions_.glyphRasterization)
+    {
+        case GlyphRasterization::Wait:
+        {
+            auto const start = std::chrono::steady_clock::now();
+            batch.bitmaps = rasterizeBatch(textShaper_, batch.glyphs, fontDescriptions_.renderMode);
+            if (crispy::debugtag::enabled(TextRendererTag))
+                debuglog(TextRendererTag).write(
+                    "Rasterized {} missing glyphs in {:.2f} ms.",
+                    batch.glyphs.size(),
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            insertGlyphs(move(batch));
+
+            for (DeferredGlyph const& deferred: deferredGlyphs_)
+            {
+                if (optional<DataRef> const ti = cachedTextureInfo(deferred.glyphPosition.glyph); ti.has_value())
+                {
+                    renderTexture(deferred.pen,
+                                  deferred.color,
+                                  get<0>(*ti).get(),
+                                  get<1>(*ti).get(),
+                                  deferred.glyphPosition,
+                                  textShaper_.has_color(deferred.glyphPosition.glyph.font));
+                }
+            }
+            break;
+        }
+        case GlyphRasterization::Deferred:
+            // Glyphs missing while a batch is still in flight are picked up by a later frame.
+            // The text shaper is serializing concurrent access to it (see text::shared_shaper).
+            if (!rasterizingGlyphs_.valid())
+            {
+                auto const mode = fontDescriptions_.renderMode;
+                rasterizingGlyphs_ = std::async(std::launch::async, [&shaper = textShaper_, batch = move(batch), mode]() mutable {
+                    batch.bitmaps = rasterizeBatch(shaper, batch.glyphs, mode);
+                    return move(batch);
+                });
+            }
+            break;
+    }
+
+    deferredGlyphs_.clear();
+}
+
+void TextRenderer::collectRasterizedGlyphs()
+{
+    if (!rasterizingGlyphs_.valid())
+        return;
 
-    text::rasterized_glyph& glyph = theGlyphOpt.value();
+    if (rasterizingGlyphs_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    auto batch = rasterizingGlyphs_.get();
+    if (batch.fontGeneration != fontGeneration_)
+        return;
+
+    insertGlyphs(move(batch));
+}
+
+void TextRenderer::discardRasterizingGlyphs()
+{
+    ++fontGeneration_;
+
+    if (rasterizingGlyphs_.valid())
+        rasterizingGlyphs_.get();
+}
+// }}}
+
+optional<TextRenderer::DataRef> TextRenderer::insertGlyph(text::glyph_key const& _id, text::rasterized_glyph _glyph)
+{
+    bool const colored = textShaper_.has_color(_id.font);
+
+    text::rasterized_glyph& glyph = _glyph;
     auto const numCells = colored ? 2u : 1u; // is this the only case - with colored := Emoji presentation?
     // FIXME: this `2` is a hack of my bad knowledge. FIXME.
     // As I only know of emojis being colored fonts, and those take up 2 cell with units.
@@ -394,11 +651,10 @@ void TextRenderer::renderTexture(crispy::Point const& _pos,
                                  RGBAColor const& _color,
                                  atlas::TextureInfo const& _textureInfo,
                                  GlyphMetrics const& _glyphMetrics,
-                                 text::glyph_position const& _glyphPos)
+                                 text::glyph_position const& _glyphPos,
+                                 bool _colored)
 {
-    auto const colored = textShaper_.has_color(_glyphPos.glyph.font);
-
-    if (colored)
+    if (_colored)
     {
         auto const x = _pos.x
                      + _glyphMetrics.bearing.x
@@ -31,10 +31,14 @@
 
 #include <unicode/run_segmenter.h>
 
+#include <array>
 #include <functional>
+#include <future>
 #include <list>
 #include <memory>
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace terminal::renderer
@@ -144,6 +148,13 @@ enum class TextShapingMethod
     Simple,  //!< minimal text shaping for optimum performance butless features
 };
 
+/// Determines how frames deal with glyphs that have not been rasterized yet.
+enum class GlyphRasterization
+{
+    Wait,     //!< the frame waits for its missing glyphs to be rasterized
+    Deferred, //!< the frame leaves its missing glyphs blank and is re-rendered once they are rasterized
+};
+
 struct FontDescriptions
 {
     double dpiScale = 1.0;
@@ -156,6 +167,7 @@ struct FontDescriptions
     text::font_description emoji;
     text::render_mode renderMode;
     TextShapingMethod textShapingMethod;
+    GlyphRasterization glyphRasterization = GlyphRasterization::Wait;
     bool builtinBoxDrawing = true;
 };
 
@@ -183,6 +195,20 @@ struct FontKeys {
     text::font_key emoji;
 };
 
+inline bool operator==(FontKeys const& a, FontKeys const& b) noexcept
+{
+    return a.regular == b.regular
+        && a.bold == b.bold
+        && a.italic == b.italic
+        && a.boldItalic == b.boldItalic
+        && a.emoji == b.emoji;
+}
+
+inline bool operator!=(FontKeys const& a, FontKeys const& b) noexcept
+{
+    return !(a == b);
+}
+
 // {{{ TextShaper
 /// API to perform text shaping and glyph rasterization on terminal screen.
 class TextShaper
@@ -313,8 +339,28 @@ class TextRenderer : public Renderable {
 
     void updateFontMetrics();
 
+    /// Waits for the glyphs being rasterized in the background, if any, and drops them.
+    ///
+    /// This must be called before the text shaper is reconfigured, as they would be rasterized
+    /// with the previous configuration otherwise.
+    void discardRasterizingGlyphs();
+
+    /// Switches to the font size the fonts have just been reloaded with.
+    ///
+    /// The glyph atlases are kept, as glyph keys include the font size, and the text shaping
+    /// state of recently used font sizes is retained, so that zooming back to one of them
+    /// neither needs to shape nor to rasterize the visible text again.
+    void fontSizeChanged() override;
+
+    /// @returns the glyphs that have been rendered with the given font size so far.
+    std::vector<text::glyph_key> renderedGlyphs(text::font_size _size) const;
+
     void setPressure(bool _pressure) noexcept { pressure_ = _pressure; }
 
+    /// @returns whether glyphs left blank by a previous frame are being rasterized in the background,
+    ///          i.e. whether another frame should be rendered to show them.
+    bool rasterizingGlyphs() const noexcept { return rasterizingGlyphs_.valid(); }
+
     void start();
     void renderCell(RenderCell const& _cell);
     void finish();
@@ -344,13 +390,90 @@ class TextRenderer : public Renderable {
     using TextureAtlas = atlas::MetadataTextureAtlas<text::glyph_key, GlyphMetrics>;
     using DataRef = TextureAtlas::DataRef;
 
+    /// @returns the texture of the given glyph, rasterizing it if not in the texture atlas yet.
     std::optional<DataRef> getTextureInfo(GlyphId const& _id);
 
+    // {{{ glyph rasterization
+    // Glyphs missing in the texture atlases are not rasterized as they are encountered, but
+    // collected during the frame and rasterized as one batch at the end of it, which the text
+    // shaper may rasterize in parallel.
+
+    /// @returns the texture of the given glyph if it is in the texture atlas already.
+    std::optional<DataRef> cachedTextureInfo(GlyphId const& _id);
+
+    /// Inserts the rasterized glyph into its texture atlas.
+    std::optional<DataRef> insertGlyph(GlyphId const& _id, text::rasterized_glyph _glyph);
+
+    /// A glyph that could not be rendered yet, as it was missing in the texture atlases.
+    struct DeferredGlyph {
+        crispy::Point pen;
+        RGBColor color;
+        text::glyph_position glyphPosition;
+    };
+
+    struct RasterizedGlyphs {
+        uint64_t fontGeneration = 0;    // fontGeneration_ at the time the batch has been started
+        std::vector<text::glyph_key> glyphs;
+        std::vector<std::optional<text::rasterized_glyph>> bitmaps;
+    };
+
+    void insertGlyphs(RasterizedGlyphs _batch);
+
+    /// Rasterizes the glyphs missing in this frame, according to the configured GlyphRasterization.
+    void rasterizeMissingGlyphs();
+
+    /// Inserts the glyphs rasterized in the background, if done.
+    void collectRasterizedGlyphs();
+    // }}}
+
     void renderTexture(crispy::Point const& _pos,
                        RGBAColor const& _color,
                        atlas::TextureInfo const& _textureInfo,
                        GlyphMetrics const& _glyphMetrics,
-                       text::glyph_position const& _gpos);
+                       text::glyph_position const& _gpos,
+                       bool _colored);
+
+    // {{{ direct glyph table
+    // Single codepoint cells of the Latin-1 range (and thus ASCII) are resolved once
+    // into their glyph and texture and looked up by array index from then on,
+    // bypassing the text shaper and the hash lookups of the texture atlas.
+    static constexpr char32_t DirectGlyphFirst = 0x20;
+    static constexpr char32_t DirectGlyphLast = 0xFF;
+    static constexpr size_t DirectGlyphCount = DirectGlyphLast - DirectGlyphFirst + 1;
+
+    struct DirectGlyph {
+        text::glyph_position glyphPosition;
+        TextureAtlas* textureAtlas;
+        atlas::TextureHandle texture;
+        GlyphMetrics metrics;
+        bool colored;
+    };
+
+    using DirectGlyphTable = std::array<std::array<std::optional<DirectGlyph>, DirectGlyphCount>, 4>;
+
+    /// Renders a single codepoint cell via the direct glyph table.
+    ///
+    /// @returns false if the cell cannot be rendered this way and must go through the text shaper.
+    bool renderDirect(RenderCell const& _cell, TextStyle _style);
+
+    /// Resolves the glyph and texture of the given codepoint and style into the direct glyph table.
+    DirectGlyph const* resolveDirectGlyph(TextStyle _style, char32_t _codepoint);
+
+    void clearDirectGlyphs();
+    // }}}
+
+    // {{{ font size tiers
+    /// Text shaping state of a recently used font size.
+    struct SizeTier {
+        text::font_size size;
+        FontKeys fonts;
+        std::unique_ptr<TextShaper> textRenderingEngine;
+        DirectGlyphTable directGlyphs;
+    };
+
+    /// Maximum number of recently used font sizes (besides the current one) to retain.
+    static constexpr size_t MaxSizeTiers = 4;
+    // }}}
 
     TextureAtlas& atlasForFont(text::font_key _font);
 
@@ -377,8 +500,19 @@ class TextRenderer : public Renderable {
         }
     }
 
+    DirectGlyphTable directGlyphs_;
+
+    text::font_size currentSize_;       // font size of textRenderingEngine_ and directGlyphs_
+    FontKeys currentFonts_;             // fonts of textRenderingEngine_ and directGlyphs_
+    std::list<SizeTier> sizeTiers_;     // most recently used first
+
+    std::vector<DeferredGlyph> deferredGlyphs_;             // glyphs of this frame waiting for missingGlyphs_
+    std::unordered_set<text::glyph_key> missingGlyphs_;     // glyphs of this frame not rasterized yet
+    std::future<RasterizedGlyphs> rasterizingGlyphs_;       // glyphs being rasterized in the background
+    uint64_t fontGeneration_ = 0;                           // advanced whenever rasterized glyphs become stale
+
     BoxDrawingRenderer boxDrawingRenderer_;
-    bool lastWasBoxDrawing_ = false;
+    bool lastWasDirect_ = false; // last cell was rendered without the text shaper (box drawing or direct glyph)
 
     // target surface rendering
     //
@@ -0,0 +1,176 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal_renderer/Renderer.h>
+#include <terminal_renderer/SoftwareRenderer.h>
+
+#include <terminal/Terminal.h>
+#include <terminal/logging.h>
+#include <terminal/pty/MockViewPty.h>
+
+#include <crispy/debuglog.h>
+
+#include <libtermbench/termbench.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+using namespace std;
+using std::chrono::steady_clock;
+
+namespace
+{
+    class HeadlessRender: public terminal::Terminal::Events
+    {
+      public:
+        HeadlessRender(terminal::PageSize _pageSize, terminal::renderer::FontDescriptions const& _fonts);
+
+        terminal::MockViewPty& pty() noexcept { return *pty_; }
+        terminal::Terminal& terminal() noexcept { return vt_; }
+
+        /// Renders a single frame and returns the time it took, in milliseconds.
+        double renderFrame();
+
+      private:
+        std::unique_ptr<terminal::MockViewPty> pty_;
+        terminal::Terminal vt_;
+        terminal::renderer::Renderer renderer_;
+        terminal::renderer::SoftwareRenderer renderTarget_;
+    };
+
+    HeadlessRender::HeadlessRender(terminal::PageSize _pageSize, terminal::renderer::FontDescriptions const& _fonts):
+        pty_{std::make_unique<terminal::MockViewPty>(_pageSize)},
+        vt_{*pty_, 8192, *this, terminal::LineCount(10000)},
+        renderer_{
+            _pageSize,
+            _fonts,
+            vt_.screen().colorPalette(),
+            terminal::Opacity::Opaque,
+            terminal::renderer::Decorator::DottedUnderline,
+            terminal::renderer::Decorator::Underline
+        },
+        renderTarget_{
+            terminal::ImageSize{
+                terminal::Width(*_pageSize.columns * *renderer_.gridMetrics().cellSize.width),
+                terminal::Height(*_pageSize.lines * *renderer_.gridMetrics().cellSize.height)
+            }
+        }
+    {
+        vt_.screen().setMode(terminal::DECMode::AutoWrap, true);
+        renderer_.setRenderTarget(renderTarget_);
+    }
+
+    double HeadlessRender::renderFrame()
+    {
+        auto const start = steady_clock::now();
+
+        #if defined(LIBTERMINAL_PASSIVE_RENDER_BUFFER_UPDATE)
+        vt_.refreshRenderBuffer(start);
+        #endif
+
+        renderTarget_.clear(terminal::RGBAColor{vt_.screen().colorPalette().defaultBackground});
+        renderer_.render(vt_, start, false);
+        renderTarget_.execute();
+
+        return chrono::duration<double, milli>(steady_clock::now() - start).count();
+    }
+
+    void summarizeFrameTimes(ostream& _os, string const& _name, vector<double> _frameTimes)
+    {
+        if (_frameTimes.empty())
+            return;
+
+        sort(_frameTimes.begin(), _frameTimes.end());
+        auto const percentile = [&](double _p) {
+            return _frameTimes[static_cast<size_t>(_p * static_cast<double>(_frameTimes.size() - 1))];
+        };
+        auto const total = accumulate(_frameTimes.begin(), _frameTimes.end(), 0.0);
+
+        _os << fmt::format("{:>20}: {:>6} frames, avg {:>7.3f} ms, p50 {:>7.3f} ms, p99 {:>7.3f} ms, max {:>7.3f} ms\n",
+                           _name,
+                           _frameTimes.size(),
+                           total / static_cast<double>(_frameTimes.size()),
+                           percentile(0.5),
+                           percentile(0.99),
+                           _frameTimes.back());
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    crispy::debugtag::disable(terminal::VTParserTag);
+
+    auto fonts = terminal::renderer::FontDescriptions{};
+    fonts.dpi = crispy::Point{96, 96};
+    fonts.size = text::font_size{12.0};
+    fonts.regular = text::font_description::parse(argc > 1 ? argv[1] : "monospace");
+    fonts.regular.spacing = text::font_spacing::mono;
+    fonts.bold = fonts.regular;
+    fonts.bold.weight = text::font_weight::bold;
+    fonts.italic = fonts.regular;
+    fonts.italic.slant = text::font_slant::italic;
+    fonts.boldItalic = fonts.bold;
+    fonts.boldItalic.slant = text::font_slant::italic;
+    fonts.emoji = text::font_description::parse("emoji");
+    fonts.renderMode = text::render_mode::gray;
+    fonts.textShapingMethod = terminal::renderer::TextShapingMethod::Complex;
+
+    auto const pageSize = terminal::PageSize{terminal::LineCount(25), terminal::ColumnCount(80)};
+    auto hr = HeadlessRender{pageSize, fonts};
+
+    auto frameTimes = map<string, vector<double>>{};
+    auto currentTest = string{};
+
+    auto tbp = contour::termbench::Benchmark{
+        [&](char const* a, size_t b)
+        {
+            hr.pty().setReadData({a, b});
+            do hr.terminal().processInputOnce();
+            while (!hr.pty().stdoutBuffer().empty());
+
+            frameTimes[currentTest].push_back(hr.renderFrame());
+        },
+        4, // MB
+        *pageSize.columns,
+        *pageSize.lines,
+        [&](contour::termbench::Test const& _test)
+        {
+            currentTest = _test.name;
+            cout << fmt::format("Running test {} ...\n", _test.name);
+        }
+    };
+
+    tbp.add(contour::termbench::tests::many_lines());
+    tbp.add(contour::termbench::tests::long_lines());
+    tbp.add(contour::termbench::tests::sgr_fg_lines());
+    tbp.add(contour::termbench::tests::sgr_fgbg_lines());
+
+    tbp.runAll();
+
+    cout << '\n';
+    tbp.summarize(cout);
+
+    cout << "\nFrame times:\n";
+    for (auto const& [name, times]: frameTimes)
+        summarizeFrameTimes(cout, name, times);
+
+    return EXIT_SUCCESS;
+}
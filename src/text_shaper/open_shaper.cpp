@@ -16,6 +16,7 @@
 
 #include <crispy/algorithm.h>
 #include <crispy/debuglog.h>
+#include <crispy/stdfs.h>
 #include <crispy/times.h>
 #include <crispy/indexed.h>
 
@@ -32,18 +33,30 @@
 #include <harfbuzz/hb-ft.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
+using std::getline;
 using std::max;
 using std::move;
+using std::mutex;
 using std::nullopt;
 using std::optional;
 using std::pair;
 using std::runtime_error;
+using std::scoped_lock;
 using std::string;
 using std::string_view;
 using std::tuple;
@@ -57,15 +70,28 @@ using namespace std::string_literals;
 namespace
 {
 
-struct FontPathAndSize
+/// Identifies a font face by its file and the index of the face within that file
+/// (as font collection files contain multiple faces).
+struct FontSource
 {
     string path;
+    int index = 0;
+};
+
+bool operator==(FontSource const& a, FontSource const& b) noexcept
+{
+    return a.path == b.path && a.index == b.index;
+}
+
+struct FontPathAndSize
+{
+    FontSource source;
     text::font_size size;
 };
 
 bool operator==(FontPathAndSize const& a, FontPathAndSize const& b) noexcept
 {
-    return a.path == b.path && a.size.pt == b.size.pt;
+    return a.source == b.source && a.size.pt == b.size.pt;
 }
 
 }
@@ -82,7 +108,7 @@ namespace std
         std::size_t operator()(FontPathAndSize const& fd) const noexcept
         {
             auto fnv = crispy::FNV<char>();
-            return size_t(fnv(fnv(fd.path), to_string(fd.size.pt))); // SSO should kick in.
+            return size_t(fnv(fnv(fnv(fd.source.path), to_string(fd.source.index)), to_string(fd.size.pt))); // SSO should kick in.
         }
     };
 }
@@ -324,7 +350,7 @@ namespace // {{{ helper
     }
 #endif
 
-    static optional<tuple<string, vector<string>>> getFontFallbackPaths(font_description const& _fd)
+    static optional<tuple<FontSource, vector<FontSource>>> getFontFallbackPaths(font_description const& _fd)
     {
         debuglog(FontLoaderTag).write("Loading font chain for: {}", _fd);
         auto pat = unique_ptr<FcPattern, void(*)(FcPattern*)>(
@@ -368,7 +394,7 @@ namespace // {{{ helper
         if (!fs || result != FcResultMatch)
             return {};
 
-        vector<string> fallbackFonts;
+        vector<FontSource> fallbackFonts;
         for (int i = 0; i < fs->nfont; ++i)
         {
             FcPattern* font = fs->fonts[i];
@@ -400,31 +426,34 @@ namespace // {{{ helper
                 }
             }
 
-            fallbackFonts.emplace_back((char const*)(file));
-            // debuglog(FontFallbackTag).write("Found font: {}", fallbackFonts.back());
+            int index = 0;
+            FcPatternGetInteger(font, FC_INDEX, 0, &index);
+
+            fallbackFonts.emplace_back(FontSource{(char const*)(file), index});
+            // debuglog(FontFallbackTag).write("Found font: {}", fallbackFonts.back().path);
         }
 
         #if defined(_WIN32)
         #define FONTDIR "C:\\Windows\\Fonts\\"
         if (_fd.familyName == "emoji") {
-            fallbackFonts.emplace_back(FONTDIR "seguiemj.ttf");
-            fallbackFonts.emplace_back(FONTDIR "seguisym.ttf");
+            fallbackFonts.emplace_back(FontSource{FONTDIR "seguiemj.ttf"});
+            fallbackFonts.emplace_back(FontSource{FONTDIR "seguisym.ttf"});
         }
         else if (_fd.weight != font_weight::normal && _fd.slant != font_slant::normal) {
-            fallbackFonts.emplace_back(FONTDIR "consolaz.ttf");
-            fallbackFonts.emplace_back(FONTDIR "seguisbi.ttf");
+            fallbackFonts.emplace_back(FontSource{FONTDIR "consolaz.ttf"});
+            fallbackFonts.emplace_back(FontSource{FONTDIR "seguisbi.ttf"});
         }
         else if (_fd.weight != font_weight::normal) {
-            fallbackFonts.emplace_back(FONTDIR "consolab.ttf");
-            fallbackFonts.emplace_back(FONTDIR "seguisb.ttf");
+            fallbackFonts.emplace_back(FontSource{FONTDIR "consolab.ttf"});
+            fallbackFonts.emplace_back(FontSource{FONTDIR "seguisb.ttf"});
         }
         else if (_fd.slant != font_slant::normal) {
-            fallbackFonts.emplace_back(FONTDIR "consolai.ttf");
-            fallbackFonts.emplace_back(FONTDIR "seguisli.ttf");
+            fallbackFonts.emplace_back(FontSource{FONTDIR "consolai.ttf"});
+            fallbackFonts.emplace_back(FontSource{FONTDIR "seguisli.ttf"});
         }
         else {
-            fallbackFonts.emplace_back(FONTDIR "consola.ttf");
-            fallbackFonts.emplace_back(FONTDIR "seguisym.ttf");
+            fallbackFonts.emplace_back(FontSource{FONTDIR "consola.ttf"});
+            fallbackFonts.emplace_back(FontSource{FONTDIR "seguisym.ttf"});
         }
 
         #undef FONTDIR
@@ -433,7 +462,7 @@ namespace // {{{ helper
         if (fallbackFonts.empty())
             return nullopt;
 
-        string primary = fallbackFonts.front();
+        FontSource primary = fallbackFonts.front();
         fallbackFonts.erase(fallbackFonts.begin());
 
         return tuple{primary, fallbackFonts};
@@ -481,10 +510,11 @@ namespace // {{{ helper
         return best;
     }
 
-    optional<FtFacePtr> loadFace(string const& _path, font_size _fontSize, crispy::Point _dpi, FT_Library _ft)
+    optional<FtFacePtr> loadFace(FontSource const& _source, font_size _fontSize, crispy::Point _dpi, FT_Library _ft)
     {
+        auto const& _path = _source.path;
         FT_Face ftFace = nullptr;
-        auto ftErrorCode = FT_New_Face(_ft, _path.c_str(), 0, &ftFace);
+        auto ftErrorCode = FT_New_Face(_ft, _path.c_str(), _source.index, &ftFace);
         if (!ftFace)
         {
             debuglog(FontLoaderTag).write("Failed to load font from path {}. {}", _path, ftErrorStr(ftErrorCode));
@@ -530,14 +560,574 @@ namespace // {{{ helper
     }
 } // }}}
 
+namespace // {{{ font resolution cache
+{
+    using FontResolution = tuple<FontSource, vector<FontSource>>;
+
+    long long timeValue(std::time_t _time) noexcept { return static_cast<long long>(_time); }
+
+    template <typename Clock, typename Duration>
+    long long timeValue(std::chrono::time_point<Clock, Duration> _time) noexcept
+    {
+        return static_cast<long long>(_time.time_since_epoch().count());
+    }
+
+    /// @returns a fingerprint of the fontconfig version, its configuration and its font directories,
+    ///          changing whenever a configuration file or font is added, removed, or modified.
+    string fontconfigFingerprint()
+    {
+        auto const fnv = crispy::FNV<char>();
+        auto hash = fnv(fnv.basis(), std::to_string(FcGetVersion()));
+
+        auto const addFiles = [&](FcStrList* _files) {
+            if (!_files)
+                return;
+            while (FcChar8 const* file = FcStrListNext(_files))
+            {
+                auto const path = string((char const*) file);
+                auto ec = FileSystemError{};
+                auto const mtime = FileSystem::last_write_time(FileSystem::path(path), ec);
+                hash = fnv(hash, path);
+                if (!ec)
+                    hash = fnv(hash, std::to_string(timeValue(mtime)));
+            }
+            FcStrListDone(_files);
+        };
+        addFiles(FcConfigGetConfigFiles(nullptr));
+        addFiles(FcConfigGetConfigDirs(nullptr));
+        addFiles(FcConfigGetFontDirs(nullptr));
+
+        return fmt::format("{:016x}", static_cast<uint64_t>(hash));
+    }
+
+    /// Escapes backslashes, tabs and line feeds, such that @p _text can be stored as one field of a line.
+    string escapeField(string_view _text)
+    {
+        auto result = string{};
+        result.reserve(_text.size());
+        for (char const ch: _text)
+        {
+            switch (ch)
+            {
+                case '\\': result += "\\\\"; break;
+                case '\t': result += "\\t"; break;
+                case '\n': result += "\\n"; break;
+                default: result += ch; break;
+            }
+        }
+        return result;
+    }
+
+    /// Reverses escapeField().
+    string unescapeField(string_view _field)
+    {
+        auto result = string{};
+        result.reserve(_field.size());
+        for (size_t i = 0; i < _field.size(); ++i)
+        {
+            if (_field[i] != '\\' || i + 1 == _field.size())
+            {
+                result += _field[i];
+                continue;
+            }
+            switch (_field[++i])
+            {
+                case 't': result += '\t'; break;
+                case 'n': result += '\n'; break;
+                default: result += _field[i]; break;
+            }
+        }
+        return result;
+    }
+
+    vector<string_view> splitTabs(string_view _line)
+    {
+        auto fields = vector<string_view>{};
+        while (true)
+        {
+            auto const i = _line.find('\t');
+            fields.emplace_back(_line.substr(0, i));
+            if (i == _line.npos)
+                return fields;
+            _line.remove_prefix(i + 1);
+        }
+    }
+
+    /// Process-wide cache of font descriptions resolved into their font files via fontconfig.
+    ///
+    /// The cache is optionally persisted in a file, so that subsequent processes do not need to
+    /// query fontconfig at all. It is invalidated as soon as the fontconfig configuration
+    /// or any of the font directories change.
+    ///
+    /// New resolutions are not written one by one, as fonts are usually loaded in batches,
+    /// but once the batch is over, i.e. when a text shaper is destroyed, or at exit.
+    class FontResolutionCache
+    {
+      public:
+        static FontResolutionCache& get()
+        {
+            static FontResolutionCache instance;
+            return instance;
+        }
+
+        ~FontResolutionCache() { flush(); }
+
+        void setFilePath(string _path)
+        {
+            auto const _l = scoped_lock{lock_};
+            if (dirty_)
+                save();
+            filePath_ = move(_path);
+            entries_.clear();
+            persisted_.clear();
+            loaded_ = false;
+        }
+
+        optional<FontResolution> resolve(font_description const& _fd)
+        {
+            auto const _l = scoped_lock{lock_};
+
+            if (!loaded_)
+                load();
+
+            if (auto const i = entries_.find(_fd); i != entries_.end())
+            {
+                debuglog(FontLoaderTag).write("Using cached font chain for: {}", _fd);
+                return i->second;
+            }
+
+            auto resolution = getFontFallbackPaths(_fd);
+            if (!resolution.has_value())
+                return nullopt;
+
+            entries_.emplace(_fd, resolution.value());
+            dirty_ = true;
+
+            return resolution;
+        }
+
+        /// Writes the cache file if any new resolutions have been made since it was last written.
+        void flush()
+        {
+            auto const _l = scoped_lock{lock_};
+            if (dirty_)
+                save();
+        }
+
+        /// Drops the resolution of @p _fd if it was read from the cache file, e.g. because
+        /// its font files have vanished since.
+        ///
+        /// @retval true the resolution was dropped and should be resolved once more.
+        /// @retval false the resolution was freshly made by fontconfig, and thus not retried.
+        bool forget(font_description const& _fd)
+        {
+            auto const _l = scoped_lock{lock_};
+
+            if (!persisted_.erase(_fd))
+                return false;
+
+            entries_.erase(_fd);
+            return true;
+        }
+
+      private:
+        /// Version of the file format, to be incremented on every incompatible change.
+        static constexpr int Version = 2;
+
+        void load()
+        {
+            loaded_ = true;
+            fingerprint_ = fontconfigFingerprint();
+
+            if (filePath_.empty())
+                return;
+
+            auto file = std::ifstream(filePath_);
+            auto line = string{};
+            if (!file.good() || !getline(file, line) || line != header())
+            {
+                debuglog(FontLoaderTag).write("Font cache {} missing or outdated.", filePath_);
+                return;
+            }
+
+            try
+            {
+                // Each line: family, weight, slant, spacing, force_spacing, followed by
+                // the path and face index of the primary font and each fallback font.
+                while (getline(file, line))
+                {
+                    auto const fields = splitTabs(line);
+                    if (fields.size() < 7 || (fields.size() - 5) % 2 != 0)
+                        continue;
+
+                    auto fd = font_description{};
+                    fd.familyName = unescapeField(fields[0]);
+                    fd.weight = static_cast<font_weight>(std::stoi(string(fields[1])));
+                    fd.slant = static_cast<font_slant>(std::stoi(string(fields[2])));
+                    fd.spacing = static_cast<font_spacing>(std::stoi(string(fields[3])));
+                    fd.force_spacing = fields[4] == "1";
+
+                    auto sources = vector<FontSource>{};
+                    for (size_t i = 5; i < fields.size(); i += 2)
+                        sources.emplace_back(FontSource{unescapeField(fields[i]), std::stoi(string(fields[i + 1]))});
+
+                    auto const primary = sources.front();
+                    sources.erase(sources.begin());
+                    persisted_.emplace(fd);
+                    entries_.emplace(move(fd), FontResolution{primary, move(sources)});
+                }
+            }
+            catch (std::exception const& e)
+            {
+                debuglog(FontLoaderTag).write("Ignoring corrupted font cache {}. {}", filePath_, e.what());
+                entries_.clear();
+                persisted_.clear();
+                return;
+            }
+
+            debuglog(FontLoaderTag).write("Loaded {} font chains from font cache {}.", entries_.size(), filePath_);
+        }
+
+        void save()
+        {
+            dirty_ = false;
+            if (filePath_.empty())
+                return;
+
+            auto const path = FileSystem::path(filePath_);
+            auto ec = FileSystemError{};
+            FileSystem::create_directories(path.parent_path(), ec);
+
+            // Written to a temporary file first, so that concurrently starting processes
+            // never read a partially written cache.
+            auto const tempPath = FileSystem::path(filePath_ + ".tmp");
+            {
+                auto file = std::ofstream(tempPath.string(), std::ios::trunc);
+                file << header() << '\n';
+                for (auto const& [fd, resolution]: entries_)
+                {
+                    auto const& [primary, fallbacks] = resolution;
+                    file << fmt::format("{}\t{}\t{}\t{}\t{}\t{}\t{}",
+                                        escapeField(fd.familyName),
+                                        static_cast<int>(fd.weight),
+                                        static_cast<int>(fd.slant),
+                                        static_cast<int>(fd.spacing),
+                                        fd.force_spacing ? 1 : 0,
+                                        escapeField(primary.path),
+                                        primary.index);
+                    for (FontSource const& fallback: fallbacks)
+                        file << fmt::format("\t{}\t{}", escapeField(fallback.path), fallback.index);
+                    file << '\n';
+                }
+                if (!file.good())
+                {
+                    debuglog(FontLoaderTag).write("Failed to write font cache {}.", tempPath.string());
+                    return;
+                }
+            }
+
+            FileSystem::rename(tempPath, path, ec);
+            if (ec)
+                debuglog(FontLoaderTag).write("Failed to write font cache {}. {}", filePath_, ec.message());
+        }
+
+        string header() const
+        {
+            return fmt::format("contour-font-cache {} {}", Version, fingerprint_);
+        }
+
+        mutex lock_;
+        string filePath_;
+        string fingerprint_;
+        bool loaded_ = false;
+        bool dirty_ = false; // whether there are resolutions not yet written to the cache file
+        std::unordered_map<font_description, FontResolution> entries_;
+        std::unordered_set<font_description> persisted_; // entries read from the cache file
+    };
+} // }}}
+
+namespace // {{{ glyph rasterization
+{
+    optional<rasterized_glyph> rasterizeGlyph(FT_Library _ft, FT_Face _ftFace, glyph_index _glyphIndex, render_mode _mode)
+    {
+        auto const flags = static_cast<FT_Int32>(ftRenderFlag(_mode) | (FT_HAS_COLOR(_ftFace) ? FT_LOAD_COLOR : 0));
+
+        FT_Error ec = FT_Load_Glyph(_ftFace, _glyphIndex.value, flags);
+        if (ec != FT_Err_Ok)
+        {
+            auto const missingGlyph = FT_Get_Char_Index(_ftFace, MissingGlyphId);
+
+            if (missingGlyph)
+                ec = FT_Load_Glyph(_ftFace, missingGlyph, flags);
+
+            if (ec != FT_Err_Ok)
+            {
+                if (crispy::debugtag::enabled(TextShapingTag))
+                {
+                    debuglog(FontFallbackTag).write(
+                        "Error loading glyph index {} for font {} {}. {}",
+                        _glyphIndex.value,
+                        _ftFace->family_name,
+                        _ftFace->style_name,
+                        ftErrorStr(ec)
+                    );
+                }
+                return nullopt;
+            }
+        }
+
+        // NB: colored fonts are bitmap fonts, they do not need rendering
+        if (!FT_HAS_COLOR(_ftFace))
+        {
+            if (FT_Render_Glyph(_ftFace->glyph, ftRenderMode(_mode)) != FT_Err_Ok)
+                return nullopt;
+        }
+
+        rasterized_glyph output{};
+        output.size.width = crispy::Width(_ftFace->glyph->bitmap.width);
+        output.size.height = crispy::Height(_ftFace->glyph->bitmap.rows);
+        output.position.x = _ftFace->glyph->bitmap_left;
+        output.position.y = _ftFace->glyph->bitmap_top;
+
+        switch (_ftFace->glyph->bitmap.pixel_mode)
+        {
+            case FT_PIXEL_MODE_MONO:
+            {
+                auto const width = output.size.width;
+                auto const height = output.size.height;
+
+                // convert mono to gray
+                FT_Bitmap ftBitmap;
+                FT_Bitmap_Init(&ftBitmap);
+
+                auto const ec = FT_Bitmap_Convert(_ft, &_ftFace->glyph->bitmap, &ftBitmap, 1);
+                if (ec != FT_Err_Ok)
+                    return nullopt;
+
+                ftBitmap.num_grays = 256;
+
+                output.format = bitmap_format::alpha_mask;
+                output.bitmap.resize(*height * *width); // 8-bit channel (with values 0 or 255)
+
+                auto const pitch = static_cast<unsigned>(ftBitmap.pitch);
+                for (auto const i: iota(0u, ftBitmap.rows))
+                    for (auto const j: iota(0u, ftBitmap.width))
+                        output.bitmap[i * *width + j] = ftBitmap.buffer[(*height - 1 - i) * pitch + j] * 255;
+
+                FT_Bitmap_Done(_ft, &ftBitmap);
+                break;
+            }
+            case FT_PIXEL_MODE_GRAY:
+            {
+                output.format = bitmap_format::alpha_mask;
+                output.bitmap.resize(*output.size.height * *output.size.width);
+
+                auto const pitch = static_cast<unsigned>(_ftFace->glyph->bitmap.pitch);
+                auto const s = _ftFace->glyph->bitmap.buffer;
+                for (auto const i: iota(0u, *output.size.height))
+                    for (auto const j: iota(0u, *output.size.width))
+                        output.bitmap[i * *output.size.width + j] = s[(*output.size.height - 1 - i) * pitch + j];
+                break;
+            }
+            case FT_PIXEL_MODE_LCD:
+            {
+                auto const width = _ftFace->glyph->bitmap.width;
+                auto const height = _ftFace->glyph->bitmap.rows;
+
+                output.format = bitmap_format::rgb; // LCD
+                output.bitmap.resize(width * height);
+                output.size.width /= crispy::Width(3);
+
+                auto const pitch = static_cast<unsigned>(_ftFace->glyph->bitmap.pitch);
+                auto s = _ftFace->glyph->bitmap.buffer;
+                for (auto const i: iota(0u, _ftFace->glyph->bitmap.rows))
+                    for (auto const j: iota(0u, _ftFace->glyph->bitmap.width))
+                        output.bitmap[i * width + j] = s[(height - 1 - i) * pitch + j];
+                break;
+            }
+            case FT_PIXEL_MODE_BGRA:
+            {
+                auto const width = output.size.width;
+                auto const height = output.size.height;
+
+                output.format = bitmap_format::rgba;
+                output.bitmap.resize(*height * *width * 4);
+                auto t = output.bitmap.begin();
+
+                auto const pitch = static_cast<unsigned>(_ftFace->glyph->bitmap.pitch);
+                for (auto const i: iota(0u, *height))
+                {
+                    for (auto const j: iota(0u, *width))
+                    {
+                        auto const s = &_ftFace->glyph->bitmap.buffer[(*height - i - 1) * pitch + j * 4];
+
+                        // BGRA -> RGBA
+                        *t++ = s[2];
+                        *t++ = s[1];
+                        *t++ = s[0];
+                        *t++ = s[3];
+                    }
+                }
+                break;
+            }
+            default:
+                debuglog(GlyphRenderTag).write("Glyph requested that has an unsupported pixel_mode:{}", _ftFace->glyph->bitmap.pixel_mode);
+                return nullopt;
+        }
+
+        return output;
+    }
+
+
+    /// A glyph to be rasterized by the RasterizerPool, along with what is needed to load its font.
+    struct RasterizeJob
+    {
+        glyph_key glyph;
+        FontSource source;
+        crispy::Point dpi;
+        optional<rasterized_glyph> result{};
+    };
+
+    /// Rasterizes batches of glyphs in parallel.
+    ///
+    /// FreeType libraries and faces must not be used concurrently, so each worker owns its own
+    /// FreeType library and loads its own faces of the fonts it is asked to rasterize glyphs of.
+    class RasterizerPool
+    {
+      public:
+        explicit RasterizerPool(size_t _workerCount)
+        {
+            for (size_t i = 0; i < _workerCount; ++i)
+            {
+                auto worker = std::make_unique<Worker>();
+                if (FT_Init_FreeType(&worker->ft) != FT_Err_Ok)
+                    break;
+#if defined(FT_LCD_FILTER_DEFAULT)
+                FT_Library_SetLcdFilter(worker->ft, FT_LCD_FILTER_DEFAULT);
+#endif
+                worker->thread = std::thread(&RasterizerPool::work, this, std::ref(*worker));
+                workers_.emplace_back(move(worker));
+            }
+        }
+
+        ~RasterizerPool()
+        {
+            {
+                auto const _l = scoped_lock{lock_};
+                quit_ = true;
+            }
+            wakeup_.notify_all();
+
+            for (auto& worker: workers_)
+            {
+                worker->thread.join();
+                worker->faces.clear();
+                FT_Done_FreeType(worker->ft);
+            }
+        }
+
+        size_t size() const noexcept { return workers_.size(); }
+
+        /// Rasterizes the glyphs of all given jobs, returning as soon as all of them are done.
+        void run(vector<RasterizeJob>& _jobs, render_mode _mode)
+        {
+            assert(!workers_.empty() && "Nobody would run the jobs.");
+
+            auto _l = std::unique_lock{lock_};
+            jobs_ = &_jobs;
+            mode_ = _mode;
+            nextJob_ = 0;
+            busyWorkers_ = workers_.size();
+            ++batch_;
+            wakeup_.notify_all();
+
+            done_.wait(_l, [this]() { return busyWorkers_ == 0; });
+            jobs_ = nullptr;
+        }
+
+        /// Releases all font faces the workers have loaded so far.
+        void clear()
+        {
+            // Workers only access their faces while running a batch, which is never the case here.
+            auto const _l = scoped_lock{lock_};
+            for (auto& worker: workers_)
+                worker->faces.clear();
+        }
+
+      private:
+        struct Worker
+        {
+            FT_Library ft = nullptr;
+            std::unordered_map<font_key, FtFacePtr> faces;
+            std::thread thread;
+        };
+
+        void work(Worker& _worker)
+        {
+            auto batch = uint64_t{0};
+            for (;;)
+            {
+                auto _l = std::unique_lock{lock_};
+                wakeup_.wait(_l, [&]() { return quit_ || batch_ != batch; });
+                if (quit_)
+                    return;
+                batch = batch_;
+                auto& jobs = *jobs_;
+                auto const mode = mode_;
+                _l.unlock();
+
+                for (auto i = nextJob_++; i < jobs.size(); i = nextJob_++)
+                    jobs[i].result = rasterize(_worker, jobs[i], mode);
+
+                _l.lock();
+                if (--busyWorkers_ == 0)
+                    done_.notify_one();
+            }
+        }
+
+        static optional<rasterized_glyph> rasterize(Worker& _worker, RasterizeJob const& _job, render_mode _mode)
+        {
+            auto face = _worker.faces.find(_job.glyph.font);
+            if (face == _worker.faces.end())
+            {
+                auto ftFace = loadFace(_job.source, _job.glyph.size, _job.dpi, _worker.ft);
+                if (!ftFace.has_value())
+                    return nullopt;
+                face = _worker.faces.emplace(_job.glyph.font, move(ftFace.value())).first;
+            }
+
+            return rasterizeGlyph(_worker.ft, face->second.get(), _job.glyph.index, _mode);
+        }
+
+        vector<unique_ptr<Worker>> workers_;
+
+        mutex lock_;
+        std::condition_variable wakeup_;        // signals workers a new batch (or to quit)
+        std::condition_variable done_;          // signals the caller the batch has been completed
+        vector<RasterizeJob>* jobs_ = nullptr;
+        render_mode mode_ = render_mode::gray;
+        std::atomic<size_t> nextJob_ = 0;
+        size_t busyWorkers_ = 0;
+        uint64_t batch_ = 0;
+        bool quit_ = false;
+    };
+
+    /// Minimum number of glyphs to be worth being rasterized in parallel.
+    auto constexpr MinParallelBatchSize = size_t{4};
+
+    /// Maximum number of rasterizer threads per shaper.
+    auto constexpr MaxRasterizerThreads = 8u;
+} // }}}
+
 struct FontInfo
 {
-    string path;
+    FontSource source;
     font_size size;
+    crispy::Point dpi;
     FtFacePtr ftFace;
     HbFontPtr hbFont;
     font_description description{};
-    vector<string> fallbackFonts{};
+    vector<FontSource> fallbackFonts{};
 };
 
 struct open_shaper::Private // {{{
@@ -553,6 +1143,25 @@ struct open_shaper::Private // {{{
     std::unordered_map<glyph_key, rasterized_glyph> glyphs_;
     HbBufferPtr hb_buf_;
     font_key nextFontKey_;
+    unique_ptr<RasterizerPool> rasterizerPool_;
+
+    /// @returns the rasterizer pool (created on first use), or nullptr if not worth it on this machine
+    ///          or if none of its workers could be set up, i.e. glyphs are to be rasterized on the calling thread.
+    RasterizerPool* rasterizerPool()
+    {
+        if (!rasterizerPool_)
+        {
+            auto const threads = std::min(std::thread::hardware_concurrency(), MaxRasterizerThreads);
+            if (threads < 2)
+                return nullptr;
+            rasterizerPool_ = std::make_unique<RasterizerPool>(threads);
+            if (rasterizerPool_->size() != 0)
+                debuglog(GlyphRenderTag).write("Rasterizing glyphs on {} threads.", rasterizerPool_->size());
+            else
+                debuglog(GlyphRenderTag).write("freetype: Failed to initialize rasterizer threads. Rasterizing glyphs on the calling thread.");
+        }
+        return rasterizerPool_->size() != 0 ? rasterizerPool_.get() : nullptr;
+    }
 
     font_key create_font_key()
     {
@@ -561,12 +1170,12 @@ struct open_shaper::Private // {{{
         return result;
     }
 
-    optional<font_key> get_font_key_for(string _path, font_size _fontSize)
+    optional<font_key> get_font_key_for(FontSource _source, font_size _fontSize)
     {
-        if (auto i = fontPathSizeToKeys.find(FontPathAndSize{_path, _fontSize}); i != fontPathSizeToKeys.end())
+        if (auto i = fontPathSizeToKeys.find(FontPathAndSize{_source, _fontSize}); i != fontPathSizeToKeys.end())
             return i->second;
 
-        auto ftFacePtrOpt = loadFace(_path, _fontSize, dpi_, ft_);
+        auto ftFacePtrOpt = loadFace(_source, _fontSize, dpi_, ft_);
         if (!ftFacePtrOpt.has_value())
             return nullopt;
 
@@ -574,12 +1183,12 @@ struct open_shaper::Private // {{{
         auto hbFontPtr = HbFontPtr(hb_ft_font_create_referenced(ftFacePtr.get()),
                                    [](auto p) { hb_font_destroy(p); });
 
-        auto fontInfo = FontInfo{_path, _fontSize, move(ftFacePtr), move(hbFontPtr)};
+        auto fontInfo = FontInfo{_source, _fontSize, dpi_, move(ftFacePtr), move(hbFontPtr)};
 
         auto key = create_font_key();
         fonts_.emplace(pair{key, move(fontInfo)});
-        debuglog(FontLoaderTag).write("Loading font: key={}, path=\"{}\" size={} dpi={} {}", key, _path, _fontSize, dpi_, metrics(key));
-        fontPathSizeToKeys.emplace(pair{FontPathAndSize{move(_path), _fontSize}, key});
+        debuglog(FontLoaderTag).write("Loading font: key={}, path=\"{}\" index={} size={} dpi={} {}", key, _source.path, _source.index, _fontSize, dpi_, metrics(key));
+        fontPathSizeToKeys.emplace(pair{FontPathAndSize{move(_source), _fontSize}, key});
         return key;
     }
 
@@ -620,6 +1229,8 @@ struct open_shaper::Private // {{{
 
     ~Private()
     {
+        FontResolutionCache::get().flush();
+
         FT_Done_FreeType(ft_);
 
         FcFini();
@@ -630,6 +1241,11 @@ open_shaper::open_shaper(crispy::Point _dpi) : d(new Private(_dpi), [](Private*
 {
 }
 
+void open_shaper::set_font_cache_file(string _path)
+{
+    FontResolutionCache::get().setFilePath(move(_path));
+}
+
 void open_shaper::set_dpi(crispy::Point _dpi)
 {
     if (_dpi == crispy::Point{})
@@ -642,11 +1258,13 @@ void open_shaper::clear_cache()
 {
     d->fonts_.clear();
     d->fontPathSizeToKeys.clear();
+    if (d->rasterizerPool_)
+        d->rasterizerPool_->clear();
 }
 
 optional<font_key> open_shaper::load_font(font_description const& _description, font_size _size)
 {
-    auto fontPathsOpt = getFontFallbackPaths(_description);
+    auto fontPathsOpt = FontResolutionCache::get().resolve(_description);
     if (!fontPathsOpt.has_value())
         return nullopt;
 
@@ -654,7 +1272,11 @@ optional<font_key> open_shaper::load_font(font_description const& _description,
 
     optional<font_key> fontKeyOpt = d->get_font_key_for(move(primaryFont), _size);
     if (!fontKeyOpt.has_value())
+    {
+        if (FontResolutionCache::get().forget(_description))
+            return load_font(_description, _size);
         return nullopt;
+    }
 
     FontInfo& fontInfo = d->fonts_.at(fontKeyOpt.value());
     fontInfo.fallbackFonts = fallbackFonts;
@@ -775,7 +1397,7 @@ void open_shaper::shape(font_key _font,
         for (auto [i, codepoint] : crispy::indexed(_codepoints))
             logMessage.write(" {}:U+{:x}", _clusters[i], static_cast<unsigned>(codepoint));
         logMessage.write("\n");
-        logMessage.write("Using font: key={}, path=\"{}\"\n", _font, fontInfo.path);
+        logMessage.write("Using font: key={}, path=\"{}\"\n", _font, fontInfo.source.path);
     }
 
     if (tryShape(_font, fontInfo, hbBuf, hbFont, _script, _codepoints, _clusters, _result))
@@ -798,7 +1420,7 @@ void open_shaper::shape(font_key _font,
         }
 
         FontInfo& fallbackFontInfo = d->fonts_.at(fallbackKeyOpt.value());
-        debuglog(FontFallbackTag).write("Try fallback font: key={}, path=\"{}\"\n", fallbackKeyOpt.value(), fallbackFontInfo.path);
+        debuglog(FontFallbackTag).write("Try fallback font: key={}, path=\"{}\"\n", fallbackKeyOpt.value(), fallbackFontInfo.source.path);
         if (tryShape(fallbackKeyOpt.value(), fallbackFontInfo, hbBuf, fallbackFontInfo.hbFont.get(), _script, _codepoints, _clusters, _result))
             return;
     }
@@ -811,135 +1433,30 @@ void open_shaper::shape(font_key _font,
 
 optional<rasterized_glyph> open_shaper::rasterize(glyph_key _glyph, render_mode _mode)
 {
-    auto const font = _glyph.font;
-    auto ftFace = d->fonts_.at(font).ftFace.get();
-    auto const glyphIndex = _glyph.index;
-    auto const flags = static_cast<FT_Int32>(ftRenderFlag(_mode) | (has_color(font) ? FT_LOAD_COLOR : 0));
-
-    FT_Error ec = FT_Load_Glyph(ftFace, glyphIndex.value, flags);
-    if (ec != FT_Err_Ok)
-    {
-        auto const missingGlyph = FT_Get_Char_Index(ftFace, MissingGlyphId);
-
-        if (missingGlyph)
-            ec = FT_Load_Glyph(ftFace, missingGlyph, flags);
+    return rasterizeGlyph(d->ft_, d->fonts_.at(_glyph.font).ftFace.get(), _glyph.index, _mode);
+}
 
-        if (ec != FT_Err_Ok)
-        {
-            if (crispy::debugtag::enabled(TextShapingTag))
-            {
-                debuglog(FontFallbackTag).write(
-                    "Error loading glyph index {} for font {} {}. {}",
-                    glyphIndex.value,
-                    ftFace->family_name,
-                    ftFace->style_name,
-                    ftErrorStr(ec)
-                );
-            }
-            return nullopt;
-        }
-    }
+vector<optional<rasterized_glyph>> open_shaper::rasterize_batch(crispy::span<glyph_key const> _glyphs, render_mode _mode)
+{
+    RasterizerPool* pool = _glyphs.size() >= MinParallelBatchSize ? d->rasterizerPool() : nullptr;
+    if (!pool)
+        return shaper::rasterize_batch(_glyphs, _mode);
 
-    // NB: colored fonts are bitmap fonts, they do not need rendering
-    if (!FT_HAS_COLOR(ftFace))
+    auto jobs = vector<RasterizeJob>{};
+    jobs.reserve(_glyphs.size());
+    for (glyph_key const& glyph: _glyphs)
     {
-        if (FT_Render_Glyph(ftFace->glyph, ftRenderMode(_mode)) != FT_Err_Ok)
-            return nullopt;
+        FontInfo const& fontInfo = d->fonts_.at(glyph.font);
+        jobs.emplace_back(RasterizeJob{glyph, fontInfo.source, fontInfo.dpi});
     }
 
-    rasterized_glyph output{};
-    output.size.width = crispy::Width(ftFace->glyph->bitmap.width);
-    output.size.height = crispy::Height(ftFace->glyph->bitmap.rows);
-    output.position.x = ftFace->glyph->bitmap_left;
-    output.position.y = ftFace->glyph->bitmap_top;
-
-    switch (ftFace->glyph->bitmap.pixel_mode)
-    {
-        case FT_PIXEL_MODE_MONO:
-        {
-            auto const width = output.size.width;
-            auto const height = output.size.height;
-
-            // convert mono to gray
-            FT_Bitmap ftBitmap;
-            FT_Bitmap_Init(&ftBitmap);
-
-            auto const ec = FT_Bitmap_Convert(d->ft_, &ftFace->glyph->bitmap, &ftBitmap, 1);
-            if (ec != FT_Err_Ok)
-                return nullopt;
-
-            ftBitmap.num_grays = 256;
-
-            output.format = bitmap_format::alpha_mask;
-            output.bitmap.resize(*height * *width); // 8-bit channel (with values 0 or 255)
-
-            auto const pitch = static_cast<unsigned>(ftBitmap.pitch);
-            for (auto const i: iota(0u, ftBitmap.rows))
-                for (auto const j: iota(0u, ftBitmap.width))
-                    output.bitmap[i * *width + j] = ftBitmap.buffer[(*height - 1 - i) * pitch + j] * 255;
-
-            FT_Bitmap_Done(d->ft_, &ftBitmap);
-            break;
-        }
-        case FT_PIXEL_MODE_GRAY:
-        {
-            output.format = bitmap_format::alpha_mask;
-            output.bitmap.resize(*output.size.height * *output.size.width);
-
-            auto const pitch = static_cast<unsigned>(ftFace->glyph->bitmap.pitch);
-            auto const s = ftFace->glyph->bitmap.buffer;
-            for (auto const i: iota(0u, *output.size.height))
-                for (auto const j: iota(0u, *output.size.width))
-                    output.bitmap[i * *output.size.width + j] = s[(*output.size.height - 1 - i) * pitch + j];
-            break;
-        }
-        case FT_PIXEL_MODE_LCD:
-        {
-            auto const width = ftFace->glyph->bitmap.width;
-            auto const height = ftFace->glyph->bitmap.rows;
-
-            output.format = bitmap_format::rgb; // LCD
-            output.bitmap.resize(width * height);
-            output.size.width /= crispy::Width(3);
-
-            auto const pitch = static_cast<unsigned>(ftFace->glyph->bitmap.pitch);
-            auto s = ftFace->glyph->bitmap.buffer;
-            for (auto const i: iota(0u, ftFace->glyph->bitmap.rows))
-                for (auto const j: iota(0u, ftFace->glyph->bitmap.width))
-                    output.bitmap[i * width + j] = s[(height - 1 - i) * pitch + j];
-            break;
-        }
-        case FT_PIXEL_MODE_BGRA:
-        {
-            auto const width = output.size.width;
-            auto const height = output.size.height;
-
-            output.format = bitmap_format::rgba;
-            output.bitmap.resize(*height * *width * 4);
-            auto t = output.bitmap.begin();
-
-            auto const pitch = static_cast<unsigned>(ftFace->glyph->bitmap.pitch);
-            for (auto const i: iota(0u, *height))
-            {
-                for (auto const j: iota(0u, *width))
-                {
-                    auto const s = &ftFace->glyph->bitmap.buffer[(*height - i - 1) * pitch + j * 4];
-
-                    // BGRA -> RGBA
-                    *t++ = s[2];
-                    *t++ = s[1];
-                    *t++ = s[0];
-                    *t++ = s[3];
-                }
-            }
-            break;
-        }
-        default:
-            debuglog(GlyphRenderTag).write("Glyph requested that has an unsupported pixel_mode:{}", ftFace->glyph->bitmap.pixel_mode);
-            return nullopt;
-    }
+    pool->run(jobs, _mode);
 
-    return output;
+    auto result = vector<optional<rasterized_glyph>>{};
+    result.reserve(jobs.size());
+    for (RasterizeJob& job: jobs)
+        result.emplace_back(move(job.result));
+    return result;
 }
 
 } // end namespace
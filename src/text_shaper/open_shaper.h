@@ -17,6 +17,7 @@
 #include <text_shaper/shaper.h>
 
 #include <memory>
+#include <string>
 
 namespace text {
 
@@ -28,6 +29,10 @@ class open_shaper : public shaper {
   public:
     explicit open_shaper(crispy::Point _dpi);
 
+    /// Sets the file the fontconfig resolutions of font descriptions are persisted to,
+    /// so that they can be reused by later processes (or an empty path to not persist them).
+    static void set_font_cache_file(std::string _path);
+
     void set_dpi(crispy::Point _dpi) override;
 
     void clear_cache() override;
@@ -47,6 +52,11 @@ class open_shaper : public shaper {
 
     std::optional<rasterized_glyph> rasterize(glyph_key _glyph, render_mode _mode) override;
 
+    /// Rasterizes the glyphs in parallel on a pool of worker threads,
+    /// each using its own FreeType library and font faces.
+    std::vector<std::optional<rasterized_glyph>> rasterize_batch(crispy::span<glyph_key const> _glyphs,
+                                                                render_mode _mode) override;
+
     bool has_color(font_key _font) const override;
 
   private:
@@ -24,6 +24,7 @@
 using std::tuple;
 using std::min;
 using std::max;
+using std::optional;
 using std::vector;
 
 using ranges::views::iota;
@@ -34,6 +35,15 @@ namespace {
     auto FontScaleTag = crispy::debugtag::make("font.scaling", "Logs about font's glyph scaling metrics, if required.");
 }
 
+vector<optional<rasterized_glyph>> shaper::rasterize_batch(crispy::span<glyph_key const> _glyphs, render_mode _mode)
+{
+    auto result = vector<optional<rasterized_glyph>>{};
+    result.reserve(_glyphs.size());
+    for (glyph_key const& glyph: _glyphs)
+        result.emplace_back(rasterize(glyph, _mode));
+    return result;
+}
+
 tuple<rasterized_glyph, float> scale(rasterized_glyph const& _bitmap, crispy::ImageSize _newSize)
 {
     assert(_bitmap.format == bitmap_format::rgba);
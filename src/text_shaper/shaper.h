@@ -136,6 +136,14 @@ class shaper {
      */
     virtual std::optional<rasterized_glyph> rasterize(glyph_key _glyph, render_mode _mode) = 0;
 
+    /**
+     * Rasterizes multiple glyphs at once using the given render mode, possibly in parallel.
+     *
+     * @returns the rasterized glyphs in the order of @p _glyphs.
+     */
+    virtual std::vector<std::optional<rasterized_glyph>> rasterize_batch(crispy::span<glyph_key const> _glyphs,
+                                                                        render_mode _mode);
+
     virtual bool has_color(font_key _font) const = 0;
 };
 
@@ -0,0 +1,388 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <text_shaper/shared_shaper.h>
+
+#include <crispy/FNV.h>
+#include <crispy/debuglog.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using std::move;
+using std::mutex;
+using std::nullopt;
+using std::optional;
+using std::scoped_lock;
+using std::shared_ptr;
+using std::string;
+using std::u32string;
+using std::u32string_view;
+using std::unique_ptr;
+using std::unordered_map;
+using std::vector;
+
+namespace text {
+
+namespace // {{{ cache keys
+{
+    struct font_request
+    {
+        font_description description;
+        double size;
+
+        bool operator==(font_request const& _rhs) const noexcept
+        {
+            return description == _rhs.description && size == _rhs.size;
+        }
+    };
+
+    struct glyph_request
+    {
+        glyph_key glyph;
+        render_mode mode;
+
+        bool operator==(glyph_request const& _rhs) const noexcept
+        {
+            return glyph == _rhs.glyph && mode == _rhs.mode;
+        }
+    };
+
+    struct shape_request
+    {
+        font_key font;
+        unicode::Script script;
+        u32string text;
+        vector<unsigned> clusters;
+
+        bool operator==(shape_request const& _rhs) const noexcept
+        {
+            return font == _rhs.font
+                && script == _rhs.script
+                && text == _rhs.text
+                && clusters == _rhs.clusters;
+        }
+    };
+
+    struct request_hash
+    {
+        size_t operator()(font_request const& _request) const noexcept
+        {
+            auto fnv = crispy::FNV<size_t>{};
+            return fnv(fnv(std::hash<font_description>{}(_request.description)),
+                       static_cast<size_t>(_request.size * 64.0));
+        }
+
+        size_t operator()(glyph_request const& _request) const noexcept
+        {
+            auto fnv = crispy::FNV<size_t>{};
+            return fnv(fnv(fnv(fnv(_request.glyph.font.value),
+                               static_cast<size_t>(_request.glyph.size.pt * 64.0)),
+                           _request.glyph.index.value),
+                       static_cast<size_t>(_request.mode));
+        }
+
+        size_t operator()(shape_request const& _request) const noexcept
+        {
+            auto fnv = crispy::FNV<size_t>{};
+            auto hash = fnv(fnv(_request.font.value), static_cast<size_t>(_request.script));
+            for (auto const codepoint: _request.text)
+                hash = fnv(hash, codepoint);
+            for (auto const cluster: _request.clusters)
+                hash = fnv(hash, cluster);
+            return hash;
+        }
+    };
+
+    /// Upper bound of the memory used by cached glyph bitmaps per backend, after which they are
+    /// flushed, as rarely used glyphs are still held by the users' texture atlases anyways.
+    auto constexpr MaxGlyphCacheBytes = size_t{64 * 1024 * 1024};
+
+    /// Upper bound of the number of cached shaping results per backend.
+    auto constexpr MaxShapeCacheSize = size_t{64 * 1024};
+} // }}}
+
+struct shared_shaper::backend
+{
+    crispy::Point const dpi;
+    unique_ptr<text::shaper> const engine;
+    size_t users = 0; // guarded by the registry's lock
+
+    mutable mutex lock; // guards all of the below, including the use of the shaper
+    unordered_map<font_request, optional<font_key>, request_hash> fonts;
+    unordered_map<glyph_request, optional<rasterized_glyph>, request_hash> glyphs;
+    unordered_map<shape_request, shape_result, request_hash> shapes;
+    size_t glyphBytes = 0;
+
+    size_t fontHits = 0;
+    size_t glyphHits = 0;
+    size_t glyphMisses = 0;
+    size_t shapeHits = 0;
+    size_t shapeMisses = 0;
+
+    void cacheGlyph(glyph_request const& _request, optional<rasterized_glyph> const& _glyph)
+    {
+        auto const bytes = _glyph.has_value() ? _glyph.value().bitmap.size() : 0;
+
+        if (glyphBytes + bytes > MaxGlyphCacheBytes)
+        {
+            debuglog(GlyphRenderTag).write("Flushing {} shared glyphs ({} bytes).", glyphs.size(), glyphBytes);
+            glyphs.clear();
+            glyphBytes = 0;
+        }
+
+        glyphBytes += bytes;
+        glyphs.emplace(_request, _glyph);
+    }
+
+    void clear()
+    {
+        engine->clear_cache();
+        fonts.clear();
+        glyphs.clear();
+        shapes.clear();
+        glyphBytes = 0;
+    }
+};
+
+struct shared_shaper::registry
+{
+    mutex lock;
+    vector<shared_ptr<backend>> backends;
+};
+
+shared_shaper::registry& shared_shaper::globalRegistry()
+{
+    static registry instance;
+    return instance;
+}
+
+shared_ptr<shared_shaper::backend> shared_shaper::acquire(crispy::Point _dpi, factory const& _createShaper)
+{
+    auto& reg = globalRegistry();
+    auto const _l = scoped_lock{reg.lock};
+
+    auto i = std::find_if(reg.backends.begin(), reg.backends.end(),
+                          [&](shared_ptr<backend> const& b) { return b->dpi.x == _dpi.x && b->dpi.y == _dpi.y; });
+    if (i == reg.backends.end())
+    {
+        debuglog(FontLoaderTag).write("Creating shared text shaper for DPI {}.", _dpi);
+        reg.backends.emplace_back(new backend{_dpi, _createShaper(_dpi)});
+        i = std::prev(reg.backends.end());
+    }
+
+    ++(*i)->users;
+    return *i;
+}
+
+void shared_shaper::release(shared_ptr<backend>& _backend)
+{
+    if (!_backend)
+        return;
+
+    auto& reg = globalRegistry();
+    auto const _l = scoped_lock{reg.lock};
+
+    if (--_backend->users == 0)
+    {
+        debuglog(FontLoaderTag).write("Destroying shared text shaper for DPI {}.", _backend->dpi);
+        reg.backends.erase(std::find(reg.backends.begin(), reg.backends.end(), _backend));
+    }
+
+    _backend.reset();
+}
+
+shared_shaper::shared_shaper(crispy::Point _dpi, factory _createShaper):
+    createShaper_{ move(_createShaper) },
+    backend_{ acquire(_dpi, createShaper_) }
+{
+}
+
+shared_shaper::~shared_shaper()
+{
+    release(backend_);
+}
+
+void shared_shaper::set_dpi(crispy::Point _dpi)
+{
+    if (_dpi == crispy::Point{})
+        return;
+
+    if (_dpi.x == backend_->dpi.x && _dpi.y == backend_->dpi.y)
+        return;
+
+    auto newBackend = acquire(_dpi, createShaper_);
+    release(backend_);
+    backend_ = move(newBackend);
+}
+
+void shared_shaper::clear_cache()
+{
+    auto const _l = scoped_lock{globalRegistry().lock, backend_->lock};
+    if (backend_->users == 1)
+        backend_->clear();
+}
+
+optional<font_key> shared_shaper::load_font(font_description const& _description, font_size _size)
+{
+    auto const _l = scoped_lock{backend_->lock};
+
+    auto const request = font_request{_description, _size.pt};
+    if (auto const i = backend_->fonts.find(request); i != backend_->fonts.end())
+    {
+        ++backend_->fontHits;
+        return i->second;
+    }
+
+    auto fontKey = backend_->engine->load_font(_description, _size);
+    backend_->fonts.emplace(request, fontKey);
+    return fontKey;
+}
+
+font_metrics shared_shaper::metrics(font_key _key) const
+{
+    auto const _l = scoped_lock{backend_->lock};
+    return backend_->engine->metrics(_key);
+}
+
+void shared_shaper::shape(font_key _font,
+                          u32string_view _text,
+                          crispy::span<unsigned> _clusters,
+                          unicode::Script _script,
+                          shape_result& _result)
+{
+    auto request = shape_request{_font, _script, u32string(_text), vector<unsigned>(_clusters.begin(), _clusters.end())};
+
+    auto const _l = scoped_lock{backend_->lock};
+    if (auto const i = backend_->shapes.find(request); i != backend_->shapes.end())
+    {
+        ++backend_->shapeHits;
+        _result = i->second;
+        return;
+    }
+
+    ++backend_->shapeMisses;
+    backend_->engine->shape(_font, _text, _clusters, _script, _result);
+
+    if (backend_->shapes.size() >= MaxShapeCacheSize)
+        backend_->shapes.clear();
+    backend_->shapes.emplace(move(request), _result);
+}
+
+optional<glyph_position> shared_shaper::shape(font_key _font, char32_t _codepoint)
+{
+    auto const _l = scoped_lock{backend_->lock};
+    return backend_->engine->shape(_font, _codepoint);
+}
+
+optional<rasterized_glyph> shared_shaper::rasterize(glyph_key _glyph, render_mode _mode)
+{
+    auto const _l = scoped_lock{backend_->lock};
+
+    auto const request = glyph_request{_glyph, _mode};
+    if (auto const i = backend_->glyphs.find(request); i != backend_->glyphs.end())
+    {
+        ++backend_->glyphHits;
+        return i->second;
+    }
+
+    ++backend_->glyphMisses;
+    auto glyph = backend_->engine->rasterize(_glyph, _mode);
+    backend_->cacheGlyph(request, glyph);
+    return glyph;
+}
+
+vector<optional<rasterized_glyph>> shared_shaper::rasterize_batch(crispy::span<glyph_key const> _glyphs,
+                                                                 render_mode _mode)
+{
+    auto const _l = scoped_lock{backend_->lock};
+
+    auto result = vector<optional<rasterized_glyph>>(_glyphs.size());
+    auto misses = vector<glyph_key>{};
+    auto missIndices = vector<size_t>{};
+
+    for (size_t i = 0; i < _glyphs.size(); ++i)
+    {
+        auto const request = glyph_request{_glyphs[i], _mode};
+        if (auto const k = backend_->glyphs.find(request); k != backend_->glyphs.end())
+        {
+            ++backend_->glyphHits;
+            result[i] = k->second;
+        }
+        else
+        {
+            misses.emplace_back(_glyphs[i]);
+            missIndices.emplace_back(i);
+        }
+    }
+
+    if (misses.empty())
+        return result;
+
+    backend_->glyphMisses += misses.size();
+    auto glyphs = backend_->engine->rasterize_batch(crispy::span<glyph_key const>(misses.data(), misses.size()), _mode);
+    for (size_t i = 0; i < misses.size(); ++i)
+    {
+        backend_->cacheGlyph(glyph_request{misses[i], _mode}, glyphs[i]);
+        result[missIndices[i]] = move(glyphs[i]);
+    }
+
+    return result;
+}
+
+bool shared_shaper::has_color(font_key _font) const
+{
+    auto const _l = scoped_lock{backend_->lock};
+    return backend_->engine->has_color(_font);
+}
+
+shared_shaper_stats shared_shaper::stats()
+{
+    auto& reg = globalRegistry();
+    auto const _l = scoped_lock{reg.lock};
+
+    auto result = shared_shaper_stats{};
+    result.backends = reg.backends.size();
+    for (shared_ptr<backend> const& b: reg.backends)
+    {
+        auto const _bl = scoped_lock{b->lock};
+        result.shapers += b->users;
+        result.fonts += b->fonts.size();
+        result.font_hits += b->fontHits;
+        result.glyphs += b->glyphs.size();
+        result.glyph_bytes += b->glyphBytes;
+        result.glyph_hits += b->glyphHits;
+        result.glyph_misses += b->glyphMisses;
+        result.shape_hits += b->shapeHits;
+        result.shape_misses += b->shapeMisses;
+        result.saved_bytes += (b->users - 1) * b->glyphBytes;
+    }
+    return result;
+}
+
+string shared_shaper_stats::summary() const
+{
+    return fmt::format("{} shapers using {} backends, {} fonts ({} shared loads), "
+                       "{} glyphs in {} bytes ({} hits, {} misses), "
+                       "{} shaping hits, {} shaping misses, {} bytes saved",
+                       shapers, backends, fonts, font_hits,
+                       glyphs, glyph_bytes, glyph_hits, glyph_misses,
+                       shape_hits, shape_misses, saved_bytes);
+}
+
+} // end namespace
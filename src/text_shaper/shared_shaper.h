@@ -0,0 +1,107 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <text_shaper/font.h>
+#include <text_shaper/shaper.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace text {
+
+/// Process-wide statistics of all shared_shaper instances.
+struct shared_shaper_stats
+{
+    size_t shapers = 0;         //!< number of shared_shaper instances
+    size_t backends = 0;        //!< number of underlying shapers (one per DPI in use)
+    size_t fonts = 0;           //!< number of distinct font descriptions and sizes loaded
+    size_t font_hits = 0;       //!< font loads served without consulting the underlying shaper
+    size_t glyphs = 0;          //!< number of cached rasterized glyphs
+    size_t glyph_bytes = 0;     //!< memory used by cached glyph bitmaps
+    size_t glyph_hits = 0;      //!< glyphs served from the cache
+    size_t glyph_misses = 0;    //!< glyphs rasterized by the underlying shaper
+    size_t shape_hits = 0;      //!< text runs served from the shaping cache
+    size_t shape_misses = 0;    //!< text runs shaped by the underlying shaper
+    size_t saved_bytes = 0;     //!< glyph bitmap memory that would otherwise be held once per shaper
+
+    std::string summary() const;
+};
+
+/**
+ * Text shaper sharing loaded fonts, shaping results and rasterized glyphs with all other
+ * shared_shaper instances of the process that are using the same DPI.
+ *
+ * All instances with the same DPI share one underlying shaper (and thus one FreeType library
+ * with its font faces), which is destroyed along with the last instance using it.
+ * Access to the underlying shaper is serialized, so that instances may be used concurrently
+ * from different (render) threads.
+ *
+ * Rasterized glyphs are cached host-side only. Each user is still uploading them into its
+ * own GPU texture atlas, as these are bound to the user's rendering context.
+ */
+class shared_shaper : public shaper {
+  public:
+    using factory = std::function<std::unique_ptr<shaper>(crispy::Point _dpi)>;
+
+    /// @param _dpi           the DPI to shape and rasterize with.
+    /// @param _createShaper  creates the underlying shaper, if none is in use for @p _dpi yet.
+    shared_shaper(crispy::Point _dpi, factory _createShaper);
+    ~shared_shaper() override;
+
+    void set_dpi(crispy::Point _dpi) override;
+
+    /// Clears the shared caches, unless they are in use by other instances.
+    void clear_cache() override;
+
+    std::optional<font_key> load_font(font_description const& _description, font_size _size) override;
+
+    font_metrics metrics(font_key _key) const override;
+
+    void shape(font_key _font,
+               std::u32string_view _text,
+               crispy::span<unsigned> _clusters,
+               unicode::Script _script,
+               shape_result& _result) override;
+
+    std::optional<glyph_position> shape(font_key _font,
+                                        char32_t _codepoint) override;
+
+    std::optional<rasterized_glyph> rasterize(glyph_key _glyph, render_mode _mode) override;
+
+    /// Rasterizes the glyphs that are not cached yet in a single batch of the underlying shaper.
+    std::vector<std::optional<rasterized_glyph>> rasterize_batch(crispy::span<glyph_key const> _glyphs,
+                                                                render_mode _mode) override;
+
+    bool has_color(font_key _font) const override;
+
+    /// @returns the statistics of all shared_shaper instances of this process.
+    static shared_shaper_stats stats();
+
+  private:
+    struct backend;
+    struct registry;
+
+    static registry& globalRegistry();
+
+    /// @returns the backend for the given DPI, creating it if not in use yet.
+    static std::shared_ptr<backend> acquire(crispy::Point _dpi, factory const& _createShaper);
+    static void release(std::shared_ptr<backend>& _backend);
+
+    factory createShaper_;
+    std::shared_ptr<backend> backend_;
+};
+
+} // end namespace